@@ -29,6 +29,12 @@ bBuildXInitThreads=true
 
 bBuildDocumentation=false
 
+# Build and run the unit tests
+bBuildTests=false
+
+# Build and run the agent benchmarks
+bBuildBench=false
+
 # Generate zip file
 bZip=false
 
@@ -136,6 +142,10 @@ do
       ADDITIONAL_COMPILER_DEFINES_OVERRIDE="ADDITIONAL_COMPILER_DEFINES_FROM_BUILD_SCRIPT=$1 $SKIP_HSA_BUILD_DEFINE"
    elif [ "$1" = "doc" ]; then
       bBuildDocumentation=true
+   elif [ "$1" = "tests" ]; then
+      bBuildTests=true
+   elif [ "$1" = "bench" ]; then
+      bBuildBench=true
    fi
    shift
 done
@@ -170,6 +180,8 @@ HSAFDNPMC="$SRCDIR/HSAFdnPMC"
 HSAUTILS="$SRCDIR/HSAUtils"
 HSAFDNTRACE="$SRCDIR/HSAFdnTrace"
 PRELOADXINITTHREADS="$SRCDIR/PreloadXInitThreads"
+UNITTESTS="$SRCDIR/UnitTests"
+AGENTBENCH="$SRCDIR/AgentBench"
 ACTIVITYLOGGER="CXLActivityLogger"
 ACTIVITYLOGGERDIR="$COMMONSRC/AMDTActivityLogger/"
 GPA="$COMMON/Lib/AMD/GPUPerfAPI/3_3"
@@ -196,6 +208,8 @@ HSAPROFILEAGENTBIN="lib${GPU_PROFILER_LIB_PREFIX}HSAProfileAgent$DEBUG_SUFFIX.so
 HSATRACEAGENTBIN="lib${GPU_PROFILER_LIB_PREFIX}HSATraceAgent$DEBUG_SUFFIX.so"
 PRELOADXINITTHREADSBIN="lib${GPU_PROFILER_LIB_PREFIX}PreloadXInitThreads$DEBUG_SUFFIX.so"
 PROFILEDATAPARSERBIN="lib${GPU_PROFILER_LIB_PREFIX}ProfileDataParser$DEBUG_SUFFIX.so"
+UNITTESTSBIN="RCPUnitTests$DEBUG_SUFFIX"
+AGENTBENCHBIN="RCPAgentBench$DEBUG_SUFFIX"
 
 PRODUCTNAME=RadeonComputeProfiler
 
@@ -318,6 +332,14 @@ if ! ($bZipOnly) ; then
       BUILD_DIRS="$BUILD_DIRS $PRELOADXINITTHREADS"
    fi
 
+   if $bBuildTests; then
+      BUILD_DIRS="$BUILD_DIRS $UNITTESTS"
+   fi
+
+   if $bBuildBench; then
+      BUILD_DIRS="$BUILD_DIRS $AGENTBENCH"
+   fi
+
 
    for SUBDIR in $BUILD_DIRS; do
       BASENAME=`basename $SUBDIR`
@@ -352,6 +374,24 @@ if ! ($bZipOnly) ; then
       rm -rf "$PROFILER_OUTPUT"
    fi
 
+   if ($bBuildTests) && ! ($bCleanOnly); then
+      echo "Run unit tests" | tee -a "$LOGFILE"
+      "$PROFILER_OUTPUT/$UNITTESTSBIN" 2>&1 | tee -a "$LOGFILE"
+      if [ ${PIPESTATUS[0]} -ne 0 ]; then
+         echo "Unit tests failed"
+         exit 1
+      fi
+   fi
+
+   if ($bBuildBench) && ! ($bCleanOnly); then
+      echo "Run agent benchmarks" | tee -a "$LOGFILE"
+      "$PROFILER_OUTPUT/$AGENTBENCHBIN" 2>&1 | tee -a "$LOGFILE"
+      if [ ${PIPESTATUS[0]} -ne 0 ]; then
+         echo "Agent benchmarks failed"
+         exit 1
+      fi
+   fi
+
    if ($bBuildDocumentation); then
       echo "Build Documentation" | tee -a "$LOGFILE"
       if ! make -C "$DOCS" html >> "$LOGFILE" 2>&1; then
@@ -0,0 +1,107 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Benchmark registration and measurement of RCPAgentBench
+//==============================================================================
+
+#ifndef _AGENT_BENCH_H_
+#define _AGENT_BENCH_H_
+
+#include <string>
+
+#include "Defs.h"
+
+/// Benchmark function
+typedef void (*AgentBenchFunc)();
+
+/// Settings of the benchmarks, set from the command line of RCPAgentBench
+struct AgentBenchSettings
+{
+    unsigned int m_uiIterations;      ///< number of iterations of each benchmark loop
+    unsigned int m_uiThreads;         ///< number of threads of the multi-threaded benchmarks
+    unsigned int m_uiLatency;         ///< time in ns spent in each call of the stub OpenCL runtime
+    unsigned int m_uiPollsToComplete; ///< number of clGetEventInfo status queries before the stub runtime completes an event
+    std::string  m_strAgentDir;       ///< directory of the agent libraries
+    std::string  m_strScratchDir;     ///< directory in which the benchmarks create their output directories
+};
+
+/// Register a benchmark, called by the AGENT_BENCHMARK macro during static initialization
+/// \param szName the name of the benchmark
+/// \param func the benchmark function
+/// \return true
+bool RegisterAgentBenchmark(const char* szName, AgentBenchFunc func);
+
+/// Get the settings of the benchmarks
+/// \return the settings
+const AgentBenchSettings& GetAgentBenchSettings();
+
+/// Report a benchmark that could not run, the run fails
+/// \param strName the name of the benchmark
+/// \param strReason the description of the failure
+void ReportAgentBenchFailure(const std::string& strName, const std::string& strReason);
+
+/// Count a failure already reported by the child process running a benchmark, the run fails
+void CountAgentBenchFailure();
+
+/// Create an empty directory for the output files of a benchmark
+/// \param strName the name of the benchmark, part of the directory name
+/// \return the directory path, empty if it could not be created
+std::string CreateAgentBenchDir(const std::string& strName);
+
+/// Get the total size of the files of a directory and its sub-directories
+/// \param strDir the directory
+/// \return the size in bytes
+ULONGLONG GetAgentBenchDirSize(const std::string& strDir);
+
+/// Remove a directory created by CreateAgentBenchDir and its content
+/// \param strDir the directory
+void RemoveAgentBenchDir(const std::string& strDir);
+
+/// Define and register a benchmark
+#define AGENT_BENCHMARK(name)                                                    \
+    static void name();                                                          \
+    static const bool name##_registered = RegisterAgentBenchmark(#name, name);   \
+    static void name()
+
+//------------------------------------------------------------------------------------
+/// Measures the cost per call of a benchmark loop: the time, the heap allocations
+/// made by any thread, the bytes written to the output files and the write system
+/// calls made by the process between Start and Report
+//------------------------------------------------------------------------------------
+class AgentBenchMeasurement
+{
+public:
+    /// Constructor
+    /// \param strName the name printed with the results
+    AgentBenchMeasurement(const std::string& strName);
+
+    /// Start the measurement
+    void Start();
+
+    /// Stop the measurement
+    /// \param ullNumCalls the number of calls made since Start, by all threads
+    /// \param numThreads the number of threads that made the calls, the time per call is the time of one thread
+    void Stop(ULONGLONG ullNumCalls, unsigned int numThreads = 1);
+
+    /// Set the number of bytes written to the output files by the measured calls
+    /// \param ullBytes the number of bytes, written after Stop by a flush or a background thread are included
+    void SetBytesWritten(ULONGLONG ullBytes) { m_ullBytesWritten = ullBytes; }
+
+    /// Print the results per call
+    void Report() const;
+
+private:
+    std::string  m_strName;             ///< name printed with the results
+    ULONGLONG    m_ullStartNanos;       ///< time of Start
+    ULONGLONG    m_ullStartAllocations; ///< number of heap allocations at Start
+    ULONGLONG    m_ullStartBytes;       ///< number of bytes allocated from the heap at Start
+    ULONGLONG    m_ullStartWriteCalls;  ///< number of write system calls of the process at Start
+    ULONGLONG    m_ullThreadNanos;      ///< time between Start and Stop multiplied by the number of threads
+    ULONGLONG    m_ullAllocations;      ///< number of heap allocations between Start and Stop
+    ULONGLONG    m_ullAllocatedBytes;   ///< number of bytes allocated from the heap between Start and Stop
+    ULONGLONG    m_ullBytesWritten;     ///< number of bytes written to the output files
+    ULONGLONG    m_ullNumCalls;         ///< number of calls
+};
+
+#endif // _AGENT_BENCH_H_
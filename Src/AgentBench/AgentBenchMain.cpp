@@ -0,0 +1,237 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Entry point of RCPAgentBench, runs the registered benchmarks
+//==============================================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AgentBench.h"
+#include "FileUtils.h"
+
+/// Registered benchmark
+struct AgentBenchInfo
+{
+    const char*    m_szName;  ///< name of the benchmark
+    AgentBenchFunc m_func;    ///< benchmark function
+};
+
+/// Get the registered benchmarks, constructed on first use since the benchmarks register during static initialization
+/// \return the benchmarks
+static std::vector<AgentBenchInfo>& GetAgentBenchmarks()
+{
+    static std::vector<AgentBenchInfo> s_benchmarks;
+    return s_benchmarks;
+}
+
+/// Settings of the benchmarks
+static AgentBenchSettings s_settings;
+
+/// Number of benchmarks that could not run
+static unsigned int s_numFailures = 0;
+
+bool RegisterAgentBenchmark(const char* szName, AgentBenchFunc func)
+{
+    AgentBenchInfo info = { szName, func };
+    GetAgentBenchmarks().push_back(info);
+    return true;
+}
+
+const AgentBenchSettings& GetAgentBenchSettings()
+{
+    return s_settings;
+}
+
+void ReportAgentBenchFailure(const std::string& strName, const std::string& strReason)
+{
+    printf("[FAILED] %s: %s\n", strName.c_str(), strReason.c_str());
+    fflush(stdout);
+    CountAgentBenchFailure();
+}
+
+void CountAgentBenchFailure()
+{
+    s_numFailures++;
+}
+
+std::string CreateAgentBenchDir(const std::string& strName)
+{
+    std::string strTemplate = s_settings.m_strScratchDir + "/RCPAgentBench_" + strName + "_XXXXXX";
+
+    for (std::string::iterator it = strTemplate.begin() + s_settings.m_strScratchDir.size() + 1; it != strTemplate.end(); ++it)
+    {
+        if ('/' == *it || ',' == *it || '=' == *it)
+        {
+            *it = '_';
+        }
+    }
+
+    std::vector<char> path(strTemplate.begin(), strTemplate.end());
+    path.push_back('\0');
+
+    if (nullptr == mkdtemp(path.data()))
+    {
+        return std::string();
+    }
+
+    return std::string(path.data());
+}
+
+/// Total size of the files seen by AddFileSize
+static ULONGLONG s_ullDirSize = 0;
+
+/// nftw callback adding the size of a file to s_ullDirSize
+/// \param szPath the path of the file
+/// \param pStat the status of the file
+/// \param type the type of the entry
+/// \param pFTW the depth of the entry
+/// \return 0 to continue the walk
+static int AddFileSize(const char* szPath, const struct stat* pStat, int type, struct FTW* pFTW)
+{
+    SP_UNREFERENCED_PARAMETER(szPath);
+    SP_UNREFERENCED_PARAMETER(pFTW);
+
+    if (FTW_F == type)
+    {
+        s_ullDirSize += static_cast<ULONGLONG>(pStat->st_size);
+    }
+
+    return 0;
+}
+
+ULONGLONG GetAgentBenchDirSize(const std::string& strDir)
+{
+    s_ullDirSize = 0;
+    nftw(strDir.c_str(), AddFileSize, 16, FTW_PHYS);
+    return s_ullDirSize;
+}
+
+/// nftw callback removing a file or an empty directory
+/// \param szPath the path of the entry
+/// \param pStat the status of the entry
+/// \param type the type of the entry
+/// \param pFTW the depth of the entry
+/// \return 0 to continue the walk
+static int RemoveEntry(const char* szPath, const struct stat* pStat, int type, struct FTW* pFTW)
+{
+    SP_UNREFERENCED_PARAMETER(pStat);
+    SP_UNREFERENCED_PARAMETER(type);
+    SP_UNREFERENCED_PARAMETER(pFTW);
+
+    remove(szPath);
+    return 0;
+}
+
+void RemoveAgentBenchDir(const std::string& strDir)
+{
+    if (!strDir.empty())
+    {
+        nftw(strDir.c_str(), RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+}
+
+/// Print the command line options
+static void PrintUsage()
+{
+    printf("Usage: RCPAgentBench [options] [benchmark name filters]\n"
+           "  --iterations <n>  number of iterations of each benchmark loop (default %u)\n"
+           "  --threads <n>     number of threads of the multi-threaded benchmarks (default %u)\n"
+           "  --latency <ns>    time spent in each call of the stub OpenCL runtime (default %u)\n"
+           "  --polls <n>       number of status queries before the stub runtime completes an event (default %u)\n"
+           "  --agentdir <dir>  directory of the agent libraries (default: directory of RCPAgentBench)\n"
+           "  --dir <dir>       directory in which the output directories of the benchmarks are created (default /tmp)\n"
+           "Only the benchmarks whose name contains one of the filters run, all of them if there is none.\n",
+           s_settings.m_uiIterations, s_settings.m_uiThreads, s_settings.m_uiLatency, s_settings.m_uiPollsToComplete);
+}
+
+/// Runs all benchmarks, or the benchmarks whose name contains one of the non-option arguments
+/// \return the number of benchmarks that could not run, or 1 if the command line is invalid
+int main(int argc, char* argv[])
+{
+    s_settings.m_uiIterations = 100000;
+    s_settings.m_uiThreads = 4;
+    s_settings.m_uiLatency = 0;
+    s_settings.m_uiPollsToComplete = 8;
+    s_settings.m_strAgentDir = FileUtils::GetExePath();
+    s_settings.m_strScratchDir = "/tmp";
+
+    std::vector<const char*> filters;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool bHasValue = i + 1 < argc;
+
+        if (0 == strcmp(argv[i], "--iterations") && bHasValue)
+        {
+            s_settings.m_uiIterations = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (0 == strcmp(argv[i], "--threads") && bHasValue)
+        {
+            s_settings.m_uiThreads = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (0 == strcmp(argv[i], "--latency") && bHasValue)
+        {
+            s_settings.m_uiLatency = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (0 == strcmp(argv[i], "--polls") && bHasValue)
+        {
+            s_settings.m_uiPollsToComplete = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (0 == strcmp(argv[i], "--agentdir") && bHasValue)
+        {
+            s_settings.m_strAgentDir = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--dir") && bHasValue)
+        {
+            s_settings.m_strScratchDir = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--help"))
+        {
+            PrintUsage();
+            return 0;
+        }
+        else if ('-' == argv[i][0])
+        {
+            PrintUsage();
+            return 1;
+        }
+        else
+        {
+            filters.push_back(argv[i]);
+        }
+    }
+
+    if (0 == s_settings.m_uiIterations || 0 == s_settings.m_uiThreads)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    printf("%-56s %10s %10s %8s %10s %10s %8s\n", "benchmark", "calls", "ns/call", "allocs", "alloc B", "written B", "writes");
+    fflush(stdout);
+
+    for (std::vector<AgentBenchInfo>::const_iterator it = GetAgentBenchmarks().begin(); it != GetAgentBenchmarks().end(); ++it)
+    {
+        bool bSelected = filters.empty();
+
+        for (std::vector<const char*>::const_iterator itFilter = filters.begin(); itFilter != filters.end() && !bSelected; ++itFilter)
+        {
+            bSelected = strstr(it->m_szName, *itFilter) != nullptr;
+        }
+
+        if (bSelected)
+        {
+            it->m_func();
+        }
+    }
+
+    return static_cast<int>(s_numFailures);
+}
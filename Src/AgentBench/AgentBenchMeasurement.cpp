@@ -0,0 +1,162 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Measurement of the time, heap allocations and bytes written per call
+//==============================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "AgentBench.h"
+
+/// Number of heap allocations made through operator new by any module of the process
+static std::atomic<ULONGLONG> s_ullNumAllocations(0);
+
+/// Number of bytes allocated through operator new by any module of the process
+static std::atomic<ULONGLONG> s_ullAllocatedBytes(0);
+
+/// Allocate a block and count it
+/// \param size the size of the block
+/// \return the block or nullptr if out of memory
+static void* CountedAlloc(std::size_t size)
+{
+    s_ullNumAllocations.fetch_add(1, std::memory_order_relaxed);
+    s_ullAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    return malloc(0 == size ? 1 : size);
+}
+
+// The replacements are exported by the executable, so they also count the allocations of the agent libraries
+
+void* operator new(std::size_t size)
+{
+    void* p = CountedAlloc(size);
+
+    if (nullptr == p)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    free(p);
+}
+
+/// Get the current time
+/// \return the time in ns
+static ULONGLONG GetBenchTimeNanos()
+{
+    return static_cast<ULONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// Get the number of write system calls made by the process
+/// \return the number of calls, 0 if /proc/self/io can't be read
+static ULONGLONG GetWriteCalls()
+{
+    ULONGLONG ullWriteCalls = 0;
+    FILE* pFile = fopen("/proc/self/io", "r");
+
+    if (nullptr != pFile)
+    {
+        char szLine[128];
+
+        while (nullptr != fgets(szLine, sizeof(szLine), pFile))
+        {
+            if (0 == strncmp(szLine, "syscw:", 6))
+            {
+                ullWriteCalls = strtoull(szLine + 6, nullptr, 10);
+                break;
+            }
+        }
+
+        fclose(pFile);
+    }
+
+    return ullWriteCalls;
+}
+
+AgentBenchMeasurement::AgentBenchMeasurement(const std::string& strName) :
+    m_strName(strName),
+    m_ullStartNanos(0),
+    m_ullStartAllocations(0),
+    m_ullStartBytes(0),
+    m_ullStartWriteCalls(0),
+    m_ullThreadNanos(0),
+    m_ullAllocations(0),
+    m_ullAllocatedBytes(0),
+    m_ullBytesWritten(0),
+    m_ullNumCalls(0)
+{
+}
+
+void AgentBenchMeasurement::Start()
+{
+    m_ullStartAllocations = s_ullNumAllocations.load(std::memory_order_relaxed);
+    m_ullStartBytes = s_ullAllocatedBytes.load(std::memory_order_relaxed);
+    m_ullStartWriteCalls = GetWriteCalls();
+    m_ullStartNanos = GetBenchTimeNanos();
+}
+
+void AgentBenchMeasurement::Stop(ULONGLONG ullNumCalls, unsigned int numThreads)
+{
+    ULONGLONG ullNanos = GetBenchTimeNanos();
+    m_ullThreadNanos = (ullNanos - m_ullStartNanos) * numThreads;
+    m_ullAllocations = s_ullNumAllocations.load(std::memory_order_relaxed) - m_ullStartAllocations;
+    m_ullAllocatedBytes = s_ullAllocatedBytes.load(std::memory_order_relaxed) - m_ullStartBytes;
+    m_ullNumCalls = ullNumCalls;
+}
+
+void AgentBenchMeasurement::Report() const
+{
+    double dNumCalls = 0 == m_ullNumCalls ? 1.0 : static_cast<double>(m_ullNumCalls);
+
+    // the writes done after Stop by a flush or a background thread are included, like the bytes written
+    ULONGLONG ullWriteCalls = GetWriteCalls() - m_ullStartWriteCalls;
+
+    printf("%-56s %10llu %10.1f %8.2f %10.1f %10.1f %8.3f\n",
+           m_strName.c_str(),
+           m_ullNumCalls,
+           static_cast<double>(m_ullThreadNanos) / dNumCalls,
+           static_cast<double>(m_ullAllocations) / dNumCalls,
+           static_cast<double>(m_ullAllocatedBytes) / dNumCalls,
+           static_cast<double>(m_ullBytesWritten) / dNumCalls,
+           static_cast<double>(ullWriteCalls) / dNumCalls);
+    fflush(stdout);
+}
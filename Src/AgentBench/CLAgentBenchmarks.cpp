@@ -0,0 +1,546 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Benchmarks of the calls made through the CL agents
+//==============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <dlfcn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "AgentBench.h"
+#include "CLStubICD.h"
+#include "FileUtils.h"
+
+/// Number of kernel dispatches between two buffer writes in the enqueue scenario
+#define ENQUEUE_WRITE_INTERVAL 16
+
+/// Number of kernel dispatches between two clFinish calls in the enqueue scenario
+#define ENQUEUE_FINISH_INTERVAL 256
+
+/// Size of the buffer written in the enqueue scenario
+#define ENQUEUE_BUFFER_SIZE 4096
+
+/// Minimum number of threads of the largest run of the event manager contention benchmark
+#define CL_EVENT_BENCH_MIN_THREADS 16u
+
+/// Entry point of the agent libraries
+typedef cl_int(CL_CALLBACK* clAgent_OnLoad_type)(cl_agent* agent);
+
+/// Function called at process exit on Windows to write the output file of the agent
+typedef void (*OnExitProcess_type)();
+
+/// Benchmark loop run with the objects of one command queue
+/// \param table the dispatch table the application calls
+/// \param queue the command queue
+/// \param kernel the kernel
+/// \param buffer the buffer
+/// \param uiIterations the number of iterations
+/// \return the number of calls made
+typedef ULONGLONG (*CLBenchScenario)(const cl_icd_dispatch_table& table, cl_command_queue queue, cl_kernel kernel, cl_mem buffer, unsigned int uiIterations);
+
+/// OpenCL objects shared by the threads of a benchmark
+struct CLBenchObjects
+{
+    cl_context                    m_context; ///< context
+    cl_program                    m_program; ///< program
+    cl_kernel                     m_kernel;  ///< kernel
+    cl_mem                        m_buffer;  ///< buffer
+    std::vector<cl_command_queue> m_queues;  ///< one command queue per thread
+};
+
+/// Agent configuration of a benchmark
+struct CLAgentConfig
+{
+    const char* m_szName;              ///< configuration name printed with the results
+    const char* m_szAgentDLL;          ///< agent library, nullptr to call the stub runtime directly
+    bool        m_bStartDisabled;      ///< start with tracing disabled
+    bool        m_bStackTrace;         ///< record a stack trace for each API
+    bool        m_bTimeOutBasedOutput; ///< write the output from the timer thread instead of at exit
+};
+
+/// Dispatch kernels with two kernel args each, write a buffer every ENQUEUE_WRITE_INTERVAL kernels
+/// and finish the queue every ENQUEUE_FINISH_INTERVAL kernels
+static ULONGLONG RunEnqueueScenario(const cl_icd_dispatch_table& table, cl_command_queue queue, cl_kernel kernel, cl_mem buffer, unsigned int uiIterations)
+{
+    static const char s_data[ENQUEUE_BUFFER_SIZE] = { 0 };
+    size_t globalWorkSize = 65536;
+    size_t localWorkSize = 256;
+    cl_uint uiArg = 0;
+    ULONGLONG ullNumCalls = 0;
+
+    for (unsigned int i = 0; i < uiIterations; i++)
+    {
+        cl_event event = nullptr;
+        uiArg = i;
+        table.SetKernelArg(kernel, 0, sizeof(cl_mem), &buffer);
+        table.SetKernelArg(kernel, 1, sizeof(cl_uint), &uiArg);
+        table.EnqueueNDRangeKernel(queue, kernel, 1, nullptr, &globalWorkSize, &localWorkSize, 0, nullptr, &event);
+        table.ReleaseEvent(event);
+        ullNumCalls += 4;
+
+        if (0 == (i + 1) % ENQUEUE_WRITE_INTERVAL)
+        {
+            table.EnqueueWriteBuffer(queue, buffer, CL_FALSE, 0, sizeof(s_data), s_data, 0, nullptr, nullptr);
+            ullNumCalls++;
+        }
+
+        if (0 == (i + 1) % ENQUEUE_FINISH_INTERVAL)
+        {
+            table.Finish(queue);
+            ullNumCalls++;
+        }
+    }
+
+    table.Finish(queue);
+    return ullNumCalls + 1;
+}
+
+/// Dispatch kernels and poll the status of their event with clGetEventInfo until they complete
+static ULONGLONG RunEventPollScenario(const cl_icd_dispatch_table& table, cl_command_queue queue, cl_kernel kernel, cl_mem buffer, unsigned int uiIterations)
+{
+    size_t globalWorkSize = 65536;
+    ULONGLONG ullNumCalls = 0;
+
+    table.SetKernelArg(kernel, 0, sizeof(cl_mem), &buffer);
+    ullNumCalls++;
+
+    for (unsigned int i = 0; i < uiIterations; i++)
+    {
+        cl_event event = nullptr;
+        cl_int status = CL_QUEUED;
+        table.EnqueueNDRangeKernel(queue, kernel, 1, nullptr, &globalWorkSize, nullptr, 0, nullptr, &event);
+        ullNumCalls++;
+
+        do
+        {
+            if (CL_SUCCESS != table.GetEventInfo(event, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status, nullptr))
+            {
+                status = CL_COMPLETE;
+            }
+
+            ullNumCalls++;
+        }
+        while (CL_COMPLETE != status);
+
+        table.ReleaseEvent(event);
+        ullNumCalls++;
+    }
+
+    return ullNumCalls;
+}
+
+/// Create the objects of a benchmark through the dispatch table the application calls
+/// \param table the dispatch table
+/// \param numQueues the number of command queues to create
+/// \param[out] objects the objects
+/// \return true if all objects were created
+static bool CreateBenchObjects(const cl_icd_dispatch_table& table, unsigned int numQueues, CLBenchObjects& objects)
+{
+    static const char* s_szSource = "__kernel void BenchKernel(__global uint* pBuffer, uint value) { pBuffer[get_global_id(0)] = value; }";
+
+    cl_icd_dispatch_table stubTable;
+    CLStubICD::GetDispatchTable(stubTable);
+
+    // the agents don't always intercept clGetPlatformIDs, the ICD loader implements it
+    decltype(table.GetPlatformIDs) pGetPlatformIDs = nullptr != table.GetPlatformIDs ? table.GetPlatformIDs : stubTable.GetPlatformIDs;
+
+    cl_platform_id platform = nullptr;
+    cl_device_id device = nullptr;
+    cl_int status = pGetPlatformIDs(1, &platform, nullptr);
+
+    if (CL_SUCCESS == status)
+    {
+        status = table.GetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &device, nullptr);
+    }
+
+    if (CL_SUCCESS != status)
+    {
+        return false;
+    }
+
+    objects.m_context = table.CreateContext(nullptr, 1, &device, nullptr, nullptr, &status);
+
+    if (CL_SUCCESS != status)
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < numQueues && CL_SUCCESS == status; i++)
+    {
+        objects.m_queues.push_back(table.CreateCommandQueue(objects.m_context, device, CL_QUEUE_PROFILING_ENABLE, &status));
+    }
+
+    if (CL_SUCCESS == status)
+    {
+        objects.m_buffer = table.CreateBuffer(objects.m_context, CL_MEM_READ_WRITE, ENQUEUE_BUFFER_SIZE, nullptr, &status);
+    }
+
+    if (CL_SUCCESS == status)
+    {
+        objects.m_program = table.CreateProgramWithSource(objects.m_context, 1, &s_szSource, nullptr, &status);
+    }
+
+    if (CL_SUCCESS == status)
+    {
+        status = table.BuildProgram(objects.m_program, 1, &device, "", nullptr, nullptr);
+    }
+
+    if (CL_SUCCESS == status)
+    {
+        objects.m_kernel = table.CreateKernel(objects.m_program, "BenchKernel", &status);
+    }
+
+    return CL_SUCCESS == status;
+}
+
+/// Release the objects of a benchmark
+/// \param table the dispatch table the application calls
+/// \param objects the objects
+static void ReleaseBenchObjects(const cl_icd_dispatch_table& table, CLBenchObjects& objects)
+{
+    table.ReleaseKernel(objects.m_kernel);
+    table.ReleaseProgram(objects.m_program);
+    table.ReleaseMemObject(objects.m_buffer);
+
+    for (std::vector<cl_command_queue>::const_iterator it = objects.m_queues.begin(); it != objects.m_queues.end(); ++it)
+    {
+        table.Finish(*it);
+        table.ReleaseCommandQueue(*it);
+    }
+
+    table.ReleaseContext(objects.m_context);
+}
+
+/// Run a scenario on each command queue from its own thread
+/// \param table the dispatch table the application calls
+/// \param scenario the scenario
+/// \param objects the objects of the benchmark, with one command queue per thread
+/// \param uiIterations the number of iterations of each thread
+/// \param measurement the measurement, started when all threads are ready
+static void RunThreads(const cl_icd_dispatch_table& table, CLBenchScenario scenario, CLBenchObjects& objects, unsigned int uiIterations, AgentBenchMeasurement& measurement)
+{
+    std::atomic<bool> bStart(false);
+    std::atomic<ULONGLONG> ullNumCalls(0);
+    std::vector<std::thread> threads;
+
+    for (std::vector<cl_command_queue>::const_iterator it = objects.m_queues.begin(); it != objects.m_queues.end(); ++it)
+    {
+        cl_command_queue queue = *it;
+        threads.push_back(std::thread([&, queue]()
+        {
+            while (!bStart.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+
+            ullNumCalls.fetch_add(scenario(table, queue, objects.m_kernel, objects.m_buffer, uiIterations), std::memory_order_relaxed);
+        }));
+    }
+
+    measurement.Start();
+    bStart.store(true, std::memory_order_release);
+
+    for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+    {
+        it->join();
+    }
+
+    measurement.Stop(ullNumCalls.load(), static_cast<unsigned int>(threads.size()));
+}
+
+/// Load an agent against the stub runtime and run a scenario, in the child process of RunCLAgentBenchmark
+/// \param config the agent configuration
+/// \param scenario the scenario
+/// \param numThreads the number of threads running the scenario
+/// \param strName the benchmark name
+/// \return the exit code of the child process
+static int RunCLAgentScenario(const CLAgentConfig& config, CLBenchScenario scenario, unsigned int numThreads, const std::string& strName)
+{
+    const AgentBenchSettings& settings = GetAgentBenchSettings();
+    CLStubICD::SetLatency(settings.m_uiLatency);
+    CLStubICD::SetPollsToComplete(settings.m_uiPollsToComplete);
+
+    std::string strDir = CreateAgentBenchDir(strName);
+
+    if (strDir.empty())
+    {
+        ReportAgentBenchFailure(strName, "unable to create the output directory");
+        return 1;
+    }
+
+    // the agents write their parameter, log and temporary files to $HOME
+    setenv("HOME", strDir.c_str(), 1);
+
+    OnExitProcess_type pOnExitProcess = nullptr;
+    Parameters params;
+
+    if (nullptr != config.m_szAgentDLL)
+    {
+        std::string strAgent = settings.m_strAgentDir + "/" + config.m_szAgentDLL;
+        void* pAgentModule = dlopen(strAgent.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+        if (nullptr == pAgentModule)
+        {
+            ReportAgentBenchFailure(strName, dlerror());
+            RemoveAgentBenchDir(strDir);
+            return 1;
+        }
+
+        clAgent_OnLoad_type pOnLoad = reinterpret_cast<clAgent_OnLoad_type>(dlsym(pAgentModule, "clAgent_OnLoad"));
+        pOnExitProcess = reinterpret_cast<OnExitProcess_type>(dlsym(pAgentModule, "OnExitProcess"));
+
+        params.m_strOutputFile = strDir + "/bench.atp";
+        params.m_bTrace = true;
+        params.m_bPerfCounter = std::string(CL_PROFILE_AGENT_DLL) == config.m_szAgentDLL;
+        params.m_bKernelOccupancy = std::string(CL_OCCUPANCY_AGENT_DLL) == config.m_szAgentDLL;
+        params.m_bStartDisabled = config.m_bStartDisabled;
+        params.m_bStackTrace = config.m_bStackTrace;
+        params.m_bTimeOutBasedOutput = config.m_bTimeOutBasedOutput;
+        FileUtils::PassParametersByFile(params);
+
+        setenv(OCL_ENABLE_PROFILING_ENV_VAR, config.m_szAgentDLL, 1);
+
+        // the agents print their banner to std::cout
+        std::cout.setstate(std::ios::badbit);
+
+        if (nullptr == pOnLoad || CL_SUCCESS != pOnLoad(CLStubICD::GetAgent()) || !CLStubICD::IsDispatchTableReplaced())
+        {
+            ReportAgentBenchFailure(strName, "the agent did not install its dispatch table");
+            RemoveAgentBenchDir(strDir);
+            return 1;
+        }
+    }
+
+    const cl_icd_dispatch_table& table = CLStubICD::GetApplicationDispatchTable();
+    CLBenchObjects objects;
+
+    if (!CreateBenchObjects(table, numThreads, objects))
+    {
+        ReportAgentBenchFailure(strName, "unable to create the OpenCL objects");
+        RemoveAgentBenchDir(strDir);
+        return 1;
+    }
+
+    // warm up the agent, so that the measurement doesn't include the first use of its data structures
+    scenario(table, objects.m_queues[0], objects.m_kernel, objects.m_buffer, std::max(settings.m_uiIterations / 100, 1u));
+
+    ULONGLONG ullInitialSize = GetAgentBenchDirSize(strDir);
+    AgentBenchMeasurement measurement(strName);
+
+    if (1 == numThreads)
+    {
+        measurement.Start();
+        ULONGLONG ullNumCalls = scenario(table, objects.m_queues[0], objects.m_kernel, objects.m_buffer, settings.m_uiIterations);
+        measurement.Stop(ullNumCalls);
+    }
+    else
+    {
+        RunThreads(table, scenario, objects, settings.m_uiIterations / numThreads, measurement);
+    }
+
+    ReleaseBenchObjects(table, objects);
+
+    if (config.m_bTimeOutBasedOutput)
+    {
+        // let the timer thread write the remaining data
+        std::this_thread::sleep_for(std::chrono::milliseconds(3 * params.m_uiTimeOutInterval));
+    }
+    else if (nullptr != pOnExitProcess)
+    {
+        pOnExitProcess();
+    }
+
+    ULONGLONG ullSize = GetAgentBenchDirSize(strDir);
+    measurement.SetBytesWritten(ullSize > ullInitialSize ? ullSize - ullInitialSize : 0);
+    measurement.Report();
+
+    RemoveAgentBenchDir(strDir);
+    return 0;
+}
+
+/// Run a scenario for an agent configuration in a child process, as an agent can only be loaded once in a process
+/// \param config the agent configuration
+/// \param szScenario the scenario name
+/// \param scenario the scenario
+/// \param numThreads the number of threads running the scenario
+static void RunCLAgentBenchmark(const CLAgentConfig& config, const char* szScenario, CLBenchScenario scenario, unsigned int numThreads)
+{
+    std::stringstream ss;
+    ss << config.m_szName << "/" << szScenario;
+
+    if (1 < numThreads)
+    {
+        ss << "/threads=" << numThreads;
+    }
+
+    std::string strName = ss.str();
+    fflush(stdout);
+    pid_t pid = fork();
+
+    if (0 == pid)
+    {
+        int exitCode = RunCLAgentScenario(config, scenario, numThreads, strName);
+        fflush(stdout);
+
+        // skip the destructors of the agent, which expect the OpenCL runtime to be unloaded first
+        _exit(exitCode);
+    }
+
+    if (-1 == pid)
+    {
+        ReportAgentBenchFailure(strName, "unable to create the benchmark process");
+        return;
+    }
+
+    int status = 0;
+
+    if (pid != waitpid(pid, &status, 0))
+    {
+        ReportAgentBenchFailure(strName, "unable to wait for the benchmark process");
+    }
+    else if (WIFSIGNALED(status))
+    {
+        std::stringstream ssReason;
+        ssReason << "the benchmark process was terminated by signal " << WTERMSIG(status);
+        ReportAgentBenchFailure(strName, ssReason.str());
+    }
+    else if (WIFEXITED(status) && 0 != WEXITSTATUS(status))
+    {
+        // the child process already reported the failure
+        CountAgentBenchFailure();
+    }
+}
+
+/// Check whether the agent library of a configuration was built, the configuration is reported as skipped if it wasn't
+/// \param config the agent configuration
+/// \return true if the configuration can be run
+static bool IsCLAgentBuilt(const CLAgentConfig& config)
+{
+    if (nullptr != config.m_szAgentDLL)
+    {
+        std::string strAgent = GetAgentBenchSettings().m_strAgentDir + "/" + config.m_szAgentDLL;
+
+        if (0 != access(strAgent.c_str(), F_OK))
+        {
+            printf("[SKIPPED] %s: %s not found\n", config.m_szName, strAgent.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Run the enqueue, event polling and multi-threaded scenarios for agent configurations
+/// \param configs the agent configurations
+/// \param numConfigs the number of configurations
+static void RunCLAgentBenchmarks(const CLAgentConfig* configs, size_t numConfigs)
+{
+    const AgentBenchSettings& settings = GetAgentBenchSettings();
+
+    for (size_t i = 0; i < numConfigs; i++)
+    {
+        // the agents that were not built are skipped
+        if (!IsCLAgentBuilt(configs[i]))
+        {
+            continue;
+        }
+
+        RunCLAgentBenchmark(configs[i], "enqueue", RunEnqueueScenario, 1);
+        RunCLAgentBenchmark(configs[i], "eventpoll", RunEventPollScenario, 1);
+
+        if (1 < settings.m_uiThreads)
+        {
+            RunCLAgentBenchmark(configs[i], "enqueue", RunEnqueueScenario, settings.m_uiThreads);
+        }
+    }
+}
+
+AGENT_BENCHMARK(CLAgent_None)
+{
+    static const CLAgentConfig s_configs[] =
+    {
+        { "CLAgent_None", nullptr, false, false, false },
+    };
+
+    RunCLAgentBenchmarks(s_configs, sizeof(s_configs) / sizeof(s_configs[0]));
+}
+
+AGENT_BENCHMARK(CLTraceAgent)
+{
+    static const CLAgentConfig s_configs[] =
+    {
+        { "CLTraceAgent/trace,nostack,notimeout",   CL_TRACE_AGENT_DLL, false, false, false },
+        { "CLTraceAgent/trace,nostack,timeout",     CL_TRACE_AGENT_DLL, false, false, true },
+        { "CLTraceAgent/trace,stack,notimeout",     CL_TRACE_AGENT_DLL, false, true,  false },
+        { "CLTraceAgent/trace,stack,timeout",       CL_TRACE_AGENT_DLL, false, true,  true },
+        { "CLTraceAgent/notrace,nostack,notimeout", CL_TRACE_AGENT_DLL, true,  false, false },
+        { "CLTraceAgent/notrace,nostack,timeout",   CL_TRACE_AGENT_DLL, true,  false, true },
+        { "CLTraceAgent/notrace,stack,notimeout",   CL_TRACE_AGENT_DLL, true,  true,  false },
+        { "CLTraceAgent/notrace,stack,timeout",     CL_TRACE_AGENT_DLL, true,  true,  true },
+    };
+
+    RunCLAgentBenchmarks(s_configs, sizeof(s_configs) / sizeof(s_configs[0]));
+}
+
+AGENT_BENCHMARK(CLTraceAgent_EventManager)
+{
+    // each thread polls the events of its own queue, so the threads contend on the event map shards, not on the events
+    static const CLAgentConfig s_configs[] =
+    {
+        { "CLTraceAgent/trace,nostack,notimeout", CL_TRACE_AGENT_DLL, false, false, false },
+        { "CLTraceAgent/trace,nostack,timeout",   CL_TRACE_AGENT_DLL, false, false, true },
+    };
+
+    unsigned int numMaxThreads = std::max(GetAgentBenchSettings().m_uiThreads, CL_EVENT_BENCH_MIN_THREADS);
+
+    for (size_t i = 0; i < sizeof(s_configs) / sizeof(s_configs[0]); i++)
+    {
+        if (!IsCLAgentBuilt(s_configs[i]))
+        {
+            continue;
+        }
+
+        for (unsigned int numThreads = 2; numThreads < numMaxThreads; numThreads *= 2)
+        {
+            RunCLAgentBenchmark(s_configs[i], "eventpoll", RunEventPollScenario, numThreads);
+        }
+
+        RunCLAgentBenchmark(s_configs[i], "eventpoll", RunEventPollScenario, numMaxThreads);
+    }
+}
+
+AGENT_BENCHMARK(CLProfileAgent)
+{
+    // GPUPerfAPI can't be loaded without a GPU, the agent dispatches the kernels without collecting counters
+    static const CLAgentConfig s_configs[] =
+    {
+        { "CLProfileAgent/nocounters", CL_PROFILE_AGENT_DLL, false, false, false },
+    };
+
+    RunCLAgentBenchmarks(s_configs, sizeof(s_configs) / sizeof(s_configs[0]));
+}
+
+AGENT_BENCHMARK(CLOccupancyAgent)
+{
+    static const CLAgentConfig s_configs[] =
+    {
+        { "CLOccupancyAgent/trace,notimeout",   CL_OCCUPANCY_AGENT_DLL, false, false, false },
+        { "CLOccupancyAgent/trace,timeout",     CL_OCCUPANCY_AGENT_DLL, false, false, true },
+        { "CLOccupancyAgent/notrace,notimeout", CL_OCCUPANCY_AGENT_DLL, true,  false, false },
+        { "CLOccupancyAgent/notrace,timeout",   CL_OCCUPANCY_AGENT_DLL, true,  false, true },
+    };
+
+    RunCLAgentBenchmarks(s_configs, sizeof(s_configs) / sizeof(s_configs[0]));
+}
@@ -0,0 +1,1456 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Stub OpenCL runtime the agents are loaded against by RCPAgentBench
+//==============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <CL/internal/cl_kernel_info_amd.h>
+
+#include "Defs.h"
+#include "CLStubICD.h"
+
+/// Maximum number of pending commands of a queue, the oldest command completes when a new one exceeds it
+#define STUB_QUEUE_DEPTH 64
+
+/// Vendor reported by the stub platform and device, the agents look for the AMD platform
+#define STUB_VENDOR "Advanced Micro Devices, Inc."
+
+/// Reference counted object of the stub runtime
+struct StubObject
+{
+    /// Constructor, the creator holds the first reference
+    StubObject() : m_refCount(1)
+    {
+    }
+
+    std::atomic<cl_uint> m_refCount; ///< reference count
+};
+
+/// Stub platform, there is only one
+struct _cl_platform_id
+{
+    int m_unused; ///< unused
+};
+
+/// Stub GPU device, there is only one
+struct _cl_device_id
+{
+    int m_unused; ///< unused
+};
+
+/// Stub context
+struct _cl_context : public StubObject
+{
+};
+
+/// Stub command queue, the pending commands complete in order
+struct _cl_command_queue : public StubObject
+{
+    cl_context                  m_context;    ///< context of the queue
+    cl_command_queue_properties m_properties; ///< properties the queue was created with
+    std::mutex                  m_mtx;        ///< mutex protecting m_pending
+    std::deque<cl_event>        m_pending;    ///< commands that are not complete, the queue holds a reference to their events
+};
+
+/// Stub buffer
+struct _cl_mem : public StubObject
+{
+    cl_context   m_context; ///< context of the buffer
+    cl_mem_flags m_flags;   ///< flags the buffer was created with
+    size_t       m_size;    ///< size of the buffer
+};
+
+/// Stub program
+struct _cl_program : public StubObject
+{
+    cl_context m_context; ///< context of the program
+};
+
+/// Stub kernel
+struct _cl_kernel : public StubObject
+{
+    cl_program  m_program; ///< program of the kernel
+    std::string m_strName; ///< name of the kernel
+};
+
+/// Callback registered with clSetEventCallback
+struct StubEventCallback
+{
+    void (CL_CALLBACK* m_pfnNotify)(cl_event, cl_int, void*); ///< callback function
+    void* m_pUserData;                                       ///< user data passed to the callback
+};
+
+/// Stub event of a command
+struct _cl_event : public StubObject
+{
+    cl_command_queue               m_queue;        ///< queue of the command
+    cl_command_type                m_type;         ///< type of the command
+    std::atomic<cl_int>            m_status;       ///< execution status
+    std::atomic<unsigned int>      m_numPolls;     ///< number of status queries
+    cl_ulong                       m_ullQueued;    ///< time the command was queued
+    cl_ulong                       m_ullSubmitted; ///< time the command was submitted
+    cl_ulong                       m_ullStart;     ///< time the command started
+    cl_ulong                       m_ullEnd;       ///< time the command ended
+    std::mutex                     m_mtx;          ///< mutex protecting m_callbacks
+    std::vector<StubEventCallback> m_callbacks;    ///< callbacks called when the command completes
+};
+
+/// Time spent in each call of the stub runtime in ns
+static unsigned int s_uiLatency = 0;
+
+/// Number of status queries of an event before it completes
+static unsigned int s_uiPollsToComplete = 8;
+
+/// The stub platform
+static _cl_platform_id s_platform;
+
+/// The stub device
+static _cl_device_id s_device;
+
+/// The agent interface passed to clAgent_OnLoad
+static cl_agent s_agent;
+
+/// Event callbacks set by the agent
+static cl_agent_callbacks s_agentCallbacks;
+
+/// Dispatch table installed by the agent
+static cl_icd_dispatch_table s_agentDispatchTable;
+
+/// Flag indicating that the agent installed s_agentDispatchTable
+static bool s_bDispatchTableReplaced = false;
+
+/// Get the time of the stub device
+/// \return the time in ns
+static cl_ulong GetStubTime()
+{
+    return static_cast<cl_ulong>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// Wait for the latency of a stub runtime call
+static void WaitForLatency()
+{
+    if (0 != s_uiLatency)
+    {
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(s_uiLatency);
+
+        while (std::chrono::steady_clock::now() < end)
+        {
+        }
+    }
+}
+
+/// Return a value of an info query. The bytes of the buffer after the value are cleared, so
+/// that the callers passing a size_t for a cl_uint value get the value
+/// \param pValue the value
+/// \param valueSize the size of the value
+/// \param paramValueSize the size of the buffer of the caller
+/// \param pParamValue the buffer of the caller, can be nullptr
+/// \param pParamValueSizeRet the size of the value returned to the caller, can be nullptr
+/// \return CL_SUCCESS or CL_INVALID_VALUE if the buffer is too small
+static cl_int ReturnInfo(const void* pValue, size_t valueSize, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    if (nullptr != pParamValue)
+    {
+        if (paramValueSize < valueSize)
+        {
+            return CL_INVALID_VALUE;
+        }
+
+        memcpy(pParamValue, pValue, valueSize);
+        memset(static_cast<char*>(pParamValue) + valueSize, 0, paramValueSize - valueSize);
+    }
+
+    if (nullptr != pParamValueSizeRet)
+    {
+        *pParamValueSizeRet = valueSize;
+    }
+
+    return CL_SUCCESS;
+}
+
+/// Return a value of an info query
+/// \param value the value
+/// \param paramValueSize the size of the buffer of the caller
+/// \param pParamValue the buffer of the caller, can be nullptr
+/// \param pParamValueSizeRet the size of the value returned to the caller, can be nullptr
+/// \return CL_SUCCESS or CL_INVALID_VALUE if the buffer is too small
+template <typename T>
+static cl_int ReturnInfo(const T& value, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    return ReturnInfo(&value, sizeof(T), paramValueSize, pParamValue, pParamValueSizeRet);
+}
+
+/// Return a string of an info query
+/// \param szValue the string
+/// \param paramValueSize the size of the buffer of the caller
+/// \param pParamValue the buffer of the caller, can be nullptr
+/// \param pParamValueSizeRet the size of the string including the terminating null, can be nullptr
+/// \return CL_SUCCESS or CL_INVALID_VALUE if the buffer is too small
+static cl_int ReturnString(const char* szValue, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    return ReturnInfo(szValue, strlen(szValue) + 1, paramValueSize, pParamValue, pParamValueSizeRet);
+}
+
+/// Set an error code returned by a create function
+/// \param pErrCodeRet the error code of the caller, can be nullptr
+/// \param errCode the error code
+static void SetErrCode(cl_int* pErrCodeRet, cl_int errCode)
+{
+    if (nullptr != pErrCodeRet)
+    {
+        *pErrCodeRet = errCode;
+    }
+}
+
+/// Add a reference to an object
+/// \param pObject the object
+/// \param invalidObjectError the error code returned if the object is nullptr
+/// \return CL_SUCCESS or invalidObjectError
+static cl_int RetainObject(StubObject* pObject, cl_int invalidObjectError)
+{
+    WaitForLatency();
+
+    if (nullptr == pObject)
+    {
+        return invalidObjectError;
+    }
+
+    pObject->m_refCount.fetch_add(1, std::memory_order_relaxed);
+    return CL_SUCCESS;
+}
+
+/// Remove a reference to an object, the object is deleted with the last reference
+/// \param pObject the object
+/// \param invalidObjectError the error code returned if the object is nullptr
+/// \return CL_SUCCESS or invalidObjectError
+template <typename T>
+static cl_int ReleaseObject(T* pObject, cl_int invalidObjectError)
+{
+    WaitForLatency();
+
+    if (nullptr == pObject)
+    {
+        return invalidObjectError;
+    }
+
+    if (1 == pObject->m_refCount.fetch_sub(1, std::memory_order_acq_rel))
+    {
+        delete pObject;
+    }
+
+    return CL_SUCCESS;
+}
+
+/// Remove a reference to an event, the event is freed with the last reference
+/// \param event the event
+static void ReleaseEventReference(cl_event event)
+{
+    if (1 == event->m_refCount.fetch_sub(1, std::memory_order_acq_rel))
+    {
+        if (nullptr != s_agentCallbacks.EventFree)
+        {
+            s_agentCallbacks.EventFree(&s_agent, event);
+        }
+
+        delete event;
+    }
+}
+
+/// Change the status of an event and notify the agent
+/// \param event the event
+/// \param status the new status
+/// \param ullTime the time of the change
+static void SetEventStatus(cl_event event, cl_int status, cl_ulong ullTime)
+{
+    event->m_status.store(status, std::memory_order_release);
+
+    if (nullptr != s_agentCallbacks.EventStatusChanged)
+    {
+        s_agentCallbacks.EventStatusChanged(&s_agent, event, status, static_cast<cl_long>(ullTime));
+    }
+}
+
+/// Run a command: the event goes through the remaining states, then the queue releases its reference
+/// \param event the event of the command
+static void CompleteCommand(cl_event event)
+{
+    cl_ulong ullTime = GetStubTime();
+    event->m_ullSubmitted = ullTime;
+    event->m_ullStart = ullTime;
+    event->m_ullEnd = ullTime;
+    SetEventStatus(event, CL_SUBMITTED, ullTime);
+    SetEventStatus(event, CL_RUNNING, ullTime);
+    SetEventStatus(event, CL_COMPLETE, ullTime);
+
+    std::vector<StubEventCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(event->m_mtx);
+        callbacks.swap(event->m_callbacks);
+    }
+
+    for (std::vector<StubEventCallback>::const_iterator it = callbacks.begin(); it != callbacks.end(); ++it)
+    {
+        it->m_pfnNotify(event, CL_COMPLETE, it->m_pUserData);
+    }
+
+    ReleaseEventReference(event);
+}
+
+/// Complete the pending commands of a queue up to a command. The callbacks are called
+/// without holding the queue lock, as they can call back into the runtime
+/// \param queue the queue
+/// \param event the event of the last command to complete, nullptr to complete all the commands
+static void CompleteCommands(cl_command_queue queue, cl_event event)
+{
+    std::vector<cl_event> completed;
+    {
+        std::lock_guard<std::mutex> lock(queue->m_mtx);
+
+        if (nullptr != event && queue->m_pending.end() == std::find(queue->m_pending.begin(), queue->m_pending.end(), event))
+        {
+            // already completed
+            return;
+        }
+
+        while (!queue->m_pending.empty())
+        {
+            cl_event pending = queue->m_pending.front();
+            queue->m_pending.pop_front();
+            completed.push_back(pending);
+
+            if (pending == event)
+            {
+                break;
+            }
+        }
+    }
+
+    for (std::vector<cl_event>::const_iterator it = completed.begin(); it != completed.end(); ++it)
+    {
+        CompleteCommand(*it);
+    }
+}
+
+/// Add a command to a queue
+/// \param queue the queue
+/// \param type the type of the command
+/// \param bBlocking flag indicating that the command completes before the function returns
+/// \param pEvent the event returned to the caller, can be nullptr
+/// \return CL_SUCCESS, CL_INVALID_COMMAND_QUEUE or CL_OUT_OF_HOST_MEMORY
+static cl_int EnqueueCommand(cl_command_queue queue, cl_command_type type, bool bBlocking, cl_event* pEvent)
+{
+    if (nullptr == queue)
+    {
+        return CL_INVALID_COMMAND_QUEUE;
+    }
+
+    cl_event event = new(std::nothrow) _cl_event();
+
+    if (nullptr == event)
+    {
+        return CL_OUT_OF_HOST_MEMORY;
+    }
+
+    // the queue holds the first reference until the command completes
+    event->m_queue = queue;
+    event->m_type = type;
+    event->m_status.store(CL_QUEUED, std::memory_order_relaxed);
+    event->m_numPolls.store(0, std::memory_order_relaxed);
+    event->m_ullQueued = GetStubTime();
+    event->m_ullSubmitted = event->m_ullQueued;
+    event->m_ullStart = event->m_ullQueued;
+    event->m_ullEnd = event->m_ullQueued;
+
+    if (nullptr != pEvent)
+    {
+        event->m_refCount.fetch_add(1, std::memory_order_relaxed);
+        *pEvent = event;
+    }
+
+    if (nullptr != s_agentCallbacks.EventCreate)
+    {
+        s_agentCallbacks.EventCreate(&s_agent, event, type);
+    }
+
+    SetEventStatus(event, CL_QUEUED, event->m_ullQueued);
+
+    cl_event oldest = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(queue->m_mtx);
+        queue->m_pending.push_back(event);
+
+        if (STUB_QUEUE_DEPTH < queue->m_pending.size())
+        {
+            oldest = queue->m_pending.front();
+        }
+    }
+
+    if (nullptr != oldest)
+    {
+        CompleteCommands(queue, oldest);
+    }
+
+    if (bBlocking)
+    {
+        CompleteCommands(queue, event);
+    }
+
+    return CL_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------
+// Platform and device
+//------------------------------------------------------------------------------------
+
+static cl_int CL_API_CALL StubGetPlatformIDs(cl_uint numEntries, cl_platform_id* pPlatforms, cl_uint* pNumPlatforms)
+{
+    WaitForLatency();
+
+    if ((0 == numEntries && nullptr != pPlatforms) || (nullptr == pPlatforms && nullptr == pNumPlatforms))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    if (nullptr != pPlatforms)
+    {
+        pPlatforms[0] = &s_platform;
+    }
+
+    if (nullptr != pNumPlatforms)
+    {
+        *pNumPlatforms = 1;
+    }
+
+    return CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubGetPlatformInfo(cl_platform_id platform, cl_platform_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr != platform && &s_platform != platform)
+    {
+        return CL_INVALID_PLATFORM;
+    }
+
+    switch (paramName)
+    {
+        case CL_PLATFORM_PROFILE:
+            return ReturnString("FULL_PROFILE", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PLATFORM_VERSION:
+            return ReturnString("OpenCL 1.2 AMD-APP (stub)", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PLATFORM_NAME:
+            return ReturnString("AMD Accelerated Parallel Processing", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PLATFORM_VENDOR:
+            return ReturnString(STUB_VENDOR, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PLATFORM_EXTENSIONS:
+            return ReturnString("cl_khr_icd", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+static cl_int CL_API_CALL StubGetDeviceIDs(cl_platform_id platform, cl_device_type deviceType, cl_uint numEntries, cl_device_id* pDevices, cl_uint* pNumDevices)
+{
+    WaitForLatency();
+
+    if (nullptr != platform && &s_platform != platform)
+    {
+        return CL_INVALID_PLATFORM;
+    }
+
+    if ((0 == numEntries && nullptr != pDevices) || (nullptr == pDevices && nullptr == pNumDevices))
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    if (0 == (deviceType & CL_DEVICE_TYPE_GPU))
+    {
+        return CL_DEVICE_NOT_FOUND;
+    }
+
+    if (nullptr != pDevices)
+    {
+        pDevices[0] = &s_device;
+    }
+
+    if (nullptr != pNumDevices)
+    {
+        *pNumDevices = 1;
+    }
+
+    return CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubGetDeviceInfo(cl_device_id device, cl_device_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (&s_device != device)
+    {
+        return CL_INVALID_DEVICE;
+    }
+
+    // a Fiji device, known by the DeviceInfo tables used by the occupancy agent
+    switch (paramName)
+    {
+        case CL_DEVICE_TYPE:
+            return ReturnInfo(static_cast<cl_device_type>(CL_DEVICE_TYPE_GPU), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_VENDOR_ID:
+            return ReturnInfo(static_cast<cl_uint>(0x1002), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_MAX_COMPUTE_UNITS:
+            return ReturnInfo(static_cast<cl_uint>(64), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS:
+            return ReturnInfo(static_cast<cl_uint>(3), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_MAX_WORK_GROUP_SIZE:
+            return ReturnInfo(static_cast<size_t>(256), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_MAX_WORK_ITEM_SIZES:
+        {
+            size_t sizes[3] = { 256, 256, 256 };
+            return ReturnInfo(sizes, sizeof(sizes), paramValueSize, pParamValue, pParamValueSizeRet);
+        }
+
+        case CL_DEVICE_MAX_CLOCK_FREQUENCY:
+            return ReturnInfo(static_cast<cl_uint>(1050), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_ADDRESS_BITS:
+            return ReturnInfo(static_cast<cl_uint>(64), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_GLOBAL_MEM_SIZE:
+            return ReturnInfo(static_cast<cl_ulong>(4096) * 1024 * 1024, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_LOCAL_MEM_SIZE:
+            return ReturnInfo(static_cast<cl_ulong>(65536), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_PROFILING_TIMER_RESOLUTION:
+            return ReturnInfo(static_cast<size_t>(1), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_NAME:
+            return ReturnString("Fiji", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_VENDOR:
+            return ReturnString(STUB_VENDOR, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DRIVER_VERSION:
+            return ReturnString("stub", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_VERSION:
+            return ReturnString("OpenCL 1.2 AMD-APP (stub)", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_OPENCL_C_VERSION:
+            return ReturnString("OpenCL C 1.2 ", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_EXTENSIONS:
+            return ReturnString("", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_PLATFORM:
+            return ReturnInfo(static_cast<cl_platform_id>(&s_platform), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_BOARD_NAME_AMD:
+            return ReturnString("AMD Radeon R9 Fury X", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_PCIE_ID_AMD:
+            return ReturnInfo(static_cast<cl_uint>(0x7300), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_LOCAL_MEM_SIZE_PER_COMPUTE_UNIT_AMD:
+            return ReturnInfo(static_cast<cl_uint>(65536), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_GFXIP_MAJOR_AMD:
+            return ReturnInfo(static_cast<cl_uint>(8), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_DEVICE_GFXIP_MINOR_AMD:
+            return ReturnInfo(static_cast<cl_uint>(0), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+//------------------------------------------------------------------------------------
+// Context, queue, buffer, program and kernel
+//------------------------------------------------------------------------------------
+
+static cl_context CL_API_CALL StubCreateContext(const cl_context_properties* pProperties,
+                                                cl_uint numDevices,
+                                                const cl_device_id* pDevices,
+                                                void (CL_CALLBACK* pfnNotify)(const char*, const void*, size_t, void*),
+                                                void* pUserData,
+                                                cl_int* pErrCodeRet)
+{
+    SP_UNREFERENCED_PARAMETER(pProperties);
+    SP_UNREFERENCED_PARAMETER(pfnNotify);
+    SP_UNREFERENCED_PARAMETER(pUserData);
+
+    WaitForLatency();
+
+    if (1 != numDevices || nullptr == pDevices || &s_device != pDevices[0])
+    {
+        SetErrCode(pErrCodeRet, CL_INVALID_DEVICE);
+        return nullptr;
+    }
+
+    cl_context context = new(std::nothrow) _cl_context();
+    SetErrCode(pErrCodeRet, nullptr == context ? CL_OUT_OF_HOST_MEMORY : CL_SUCCESS);
+    return context;
+}
+
+static cl_int CL_API_CALL StubRetainContext(cl_context context)
+{
+    return RetainObject(context, CL_INVALID_CONTEXT);
+}
+
+static cl_int CL_API_CALL StubReleaseContext(cl_context context)
+{
+    return ReleaseObject(context, CL_INVALID_CONTEXT);
+}
+
+static cl_int CL_API_CALL StubGetContextInfo(cl_context context, cl_context_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == context)
+    {
+        return CL_INVALID_CONTEXT;
+    }
+
+    switch (paramName)
+    {
+        case CL_CONTEXT_REFERENCE_COUNT:
+            return ReturnInfo(context->m_refCount.load(std::memory_order_relaxed), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_CONTEXT_DEVICES:
+            return ReturnInfo(static_cast<cl_device_id>(&s_device), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_CONTEXT_NUM_DEVICES:
+            return ReturnInfo(static_cast<cl_uint>(1), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_CONTEXT_PROPERTIES:
+            return ReturnInfo(nullptr, 0, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+static cl_command_queue CL_API_CALL StubCreateCommandQueue(cl_context context, cl_device_id device, cl_command_queue_properties properties, cl_int* pErrCodeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == context)
+    {
+        SetErrCode(pErrCodeRet, CL_INVALID_CONTEXT);
+        return nullptr;
+    }
+
+    if (&s_device != device)
+    {
+        SetErrCode(pErrCodeRet, CL_INVALID_DEVICE);
+        return nullptr;
+    }
+
+    cl_command_queue queue = new(std::nothrow) _cl_command_queue();
+
+    if (nullptr == queue)
+    {
+        SetErrCode(pErrCodeRet, CL_OUT_OF_HOST_MEMORY);
+        return nullptr;
+    }
+
+    queue->m_context = context;
+    queue->m_properties = properties;
+    SetErrCode(pErrCodeRet, CL_SUCCESS);
+    return queue;
+}
+
+static cl_int CL_API_CALL StubRetainCommandQueue(cl_command_queue queue)
+{
+    return RetainObject(queue, CL_INVALID_COMMAND_QUEUE);
+}
+
+static cl_int CL_API_CALL StubReleaseCommandQueue(cl_command_queue queue)
+{
+    if (nullptr != queue && 1 == queue->m_refCount.load(std::memory_order_acquire))
+    {
+        // the pending commands complete before the queue is deleted
+        CompleteCommands(queue, nullptr);
+    }
+
+    return ReleaseObject(queue, CL_INVALID_COMMAND_QUEUE);
+}
+
+static cl_int CL_API_CALL StubGetCommandQueueInfo(cl_command_queue queue, cl_command_queue_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == queue)
+    {
+        return CL_INVALID_COMMAND_QUEUE;
+    }
+
+    switch (paramName)
+    {
+        case CL_QUEUE_CONTEXT:
+            return ReturnInfo(queue->m_context, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_QUEUE_DEVICE:
+            return ReturnInfo(static_cast<cl_device_id>(&s_device), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_QUEUE_REFERENCE_COUNT:
+            return ReturnInfo(queue->m_refCount.load(std::memory_order_relaxed), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_QUEUE_PROPERTIES:
+            return ReturnInfo(queue->m_properties, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+static cl_mem CL_API_CALL StubCreateBuffer(cl_context context, cl_mem_flags flags, size_t size, void* pHostPtr, cl_int* pErrCodeRet)
+{
+    SP_UNREFERENCED_PARAMETER(pHostPtr);
+
+    WaitForLatency();
+
+    if (nullptr == context)
+    {
+        SetErrCode(pErrCodeRet, CL_INVALID_CONTEXT);
+        return nullptr;
+    }
+
+    cl_mem buffer = new(std::nothrow) _cl_mem();
+
+    if (nullptr == buffer)
+    {
+        SetErrCode(pErrCodeRet, CL_OUT_OF_HOST_MEMORY);
+        return nullptr;
+    }
+
+    buffer->m_context = context;
+    buffer->m_flags = flags;
+    buffer->m_size = size;
+    SetErrCode(pErrCodeRet, CL_SUCCESS);
+    return buffer;
+}
+
+static cl_int CL_API_CALL StubRetainMemObject(cl_mem buffer)
+{
+    return RetainObject(buffer, CL_INVALID_MEM_OBJECT);
+}
+
+static cl_int CL_API_CALL StubReleaseMemObject(cl_mem buffer)
+{
+    return ReleaseObject(buffer, CL_INVALID_MEM_OBJECT);
+}
+
+static cl_int CL_API_CALL StubGetMemObjectInfo(cl_mem buffer, cl_mem_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == buffer)
+    {
+        return CL_INVALID_MEM_OBJECT;
+    }
+
+    switch (paramName)
+    {
+        case CL_MEM_TYPE:
+            return ReturnInfo(static_cast<cl_mem_object_type>(CL_MEM_OBJECT_BUFFER), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_MEM_FLAGS:
+            return ReturnInfo(buffer->m_flags, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_MEM_SIZE:
+            return ReturnInfo(buffer->m_size, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_MEM_REFERENCE_COUNT:
+            return ReturnInfo(buffer->m_refCount.load(std::memory_order_relaxed), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_MEM_CONTEXT:
+            return ReturnInfo(buffer->m_context, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+static cl_program CL_API_CALL StubCreateProgramWithSource(cl_context context, cl_uint count, const char** ppStrings, const size_t* pLengths, cl_int* pErrCodeRet)
+{
+    SP_UNREFERENCED_PARAMETER(pLengths);
+
+    WaitForLatency();
+
+    if (nullptr == context)
+    {
+        SetErrCode(pErrCodeRet, CL_INVALID_CONTEXT);
+        return nullptr;
+    }
+
+    if (0 == count || nullptr == ppStrings)
+    {
+        SetErrCode(pErrCodeRet, CL_INVALID_VALUE);
+        return nullptr;
+    }
+
+    cl_program program = new(std::nothrow) _cl_program();
+
+    if (nullptr == program)
+    {
+        SetErrCode(pErrCodeRet, CL_OUT_OF_HOST_MEMORY);
+        return nullptr;
+    }
+
+    program->m_context = context;
+    SetErrCode(pErrCodeRet, CL_SUCCESS);
+    return program;
+}
+
+static cl_int CL_API_CALL StubRetainProgram(cl_program program)
+{
+    return RetainObject(program, CL_INVALID_PROGRAM);
+}
+
+static cl_int CL_API_CALL StubReleaseProgram(cl_program program)
+{
+    return ReleaseObject(program, CL_INVALID_PROGRAM);
+}
+
+static cl_int CL_API_CALL StubBuildProgram(cl_program program,
+                                           cl_uint numDevices,
+                                           const cl_device_id* pDevices,
+                                           const char* szOptions,
+                                           void (CL_CALLBACK* pfnNotify)(cl_program, void*),
+                                           void* pUserData)
+{
+    SP_UNREFERENCED_PARAMETER(numDevices);
+    SP_UNREFERENCED_PARAMETER(pDevices);
+    SP_UNREFERENCED_PARAMETER(szOptions);
+
+    WaitForLatency();
+
+    if (nullptr == program)
+    {
+        return CL_INVALID_PROGRAM;
+    }
+
+    if (nullptr != pfnNotify)
+    {
+        pfnNotify(program, pUserData);
+    }
+
+    return CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubGetProgramInfo(cl_program program, cl_program_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == program)
+    {
+        return CL_INVALID_PROGRAM;
+    }
+
+    switch (paramName)
+    {
+        case CL_PROGRAM_REFERENCE_COUNT:
+            return ReturnInfo(program->m_refCount.load(std::memory_order_relaxed), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PROGRAM_CONTEXT:
+            return ReturnInfo(program->m_context, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PROGRAM_NUM_DEVICES:
+            return ReturnInfo(static_cast<cl_uint>(1), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PROGRAM_DEVICES:
+            return ReturnInfo(static_cast<cl_device_id>(&s_device), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+static cl_int CL_API_CALL StubGetProgramBuildInfo(cl_program program, cl_device_id device, cl_program_build_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == program)
+    {
+        return CL_INVALID_PROGRAM;
+    }
+
+    if (&s_device != device)
+    {
+        return CL_INVALID_DEVICE;
+    }
+
+    switch (paramName)
+    {
+        case CL_PROGRAM_BUILD_STATUS:
+            return ReturnInfo(static_cast<cl_build_status>(CL_BUILD_SUCCESS), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PROGRAM_BUILD_OPTIONS:
+        case CL_PROGRAM_BUILD_LOG:
+            return ReturnString("", paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+static cl_kernel CL_API_CALL StubCreateKernel(cl_program program, const char* szKernelName, cl_int* pErrCodeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == program)
+    {
+        SetErrCode(pErrCodeRet, CL_INVALID_PROGRAM);
+        return nullptr;
+    }
+
+    if (nullptr == szKernelName)
+    {
+        SetErrCode(pErrCodeRet, CL_INVALID_VALUE);
+        return nullptr;
+    }
+
+    cl_kernel kernel = new(std::nothrow) _cl_kernel();
+
+    if (nullptr == kernel)
+    {
+        SetErrCode(pErrCodeRet, CL_OUT_OF_HOST_MEMORY);
+        return nullptr;
+    }
+
+    kernel->m_program = program;
+    kernel->m_strName = szKernelName;
+    SetErrCode(pErrCodeRet, CL_SUCCESS);
+    return kernel;
+}
+
+static cl_int CL_API_CALL StubRetainKernel(cl_kernel kernel)
+{
+    return RetainObject(kernel, CL_INVALID_KERNEL);
+}
+
+static cl_int CL_API_CALL StubReleaseKernel(cl_kernel kernel)
+{
+    return ReleaseObject(kernel, CL_INVALID_KERNEL);
+}
+
+static cl_int CL_API_CALL StubSetKernelArg(cl_kernel kernel, cl_uint argIndex, size_t argSize, const void* pArgValue)
+{
+    SP_UNREFERENCED_PARAMETER(argIndex);
+    SP_UNREFERENCED_PARAMETER(argSize);
+    SP_UNREFERENCED_PARAMETER(pArgValue);
+
+    WaitForLatency();
+
+    return nullptr == kernel ? CL_INVALID_KERNEL : CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubGetKernelInfo(cl_kernel kernel, cl_kernel_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == kernel)
+    {
+        return CL_INVALID_KERNEL;
+    }
+
+    switch (paramName)
+    {
+        case CL_KERNEL_FUNCTION_NAME:
+            return ReturnString(kernel->m_strName.c_str(), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNEL_NUM_ARGS:
+            return ReturnInfo(static_cast<cl_uint>(2), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNEL_REFERENCE_COUNT:
+            return ReturnInfo(kernel->m_refCount.load(std::memory_order_relaxed), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNEL_CONTEXT:
+            return ReturnInfo(kernel->m_program->m_context, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNEL_PROGRAM:
+            return ReturnInfo(kernel->m_program, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+static cl_int CL_API_CALL StubGetKernelWorkGroupInfo(cl_kernel kernel, cl_device_id device, cl_kernel_work_group_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == kernel)
+    {
+        return CL_INVALID_KERNEL;
+    }
+
+    if (&s_device != device)
+    {
+        return CL_INVALID_DEVICE;
+    }
+
+    switch (paramName)
+    {
+        case CL_KERNEL_WORK_GROUP_SIZE:
+            return ReturnInfo(static_cast<size_t>(256), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNEL_COMPILE_WORK_GROUP_SIZE:
+        {
+            size_t sizes[3] = { 0, 0, 0 };
+            return ReturnInfo(sizes, sizeof(sizes), paramValueSize, pParamValue, pParamValueSizeRet);
+        }
+
+        case CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE:
+            return ReturnInfo(static_cast<size_t>(64), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNEL_LOCAL_MEM_SIZE:
+        case CL_KERNEL_PRIVATE_MEM_SIZE:
+            return ReturnInfo(static_cast<cl_ulong>(0), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+/// Stub of the clGetKernelInfoAMD extension queried by the occupancy agent
+static cl_int CL_API_CALL StubGetKernelInfoAMD(cl_kernel kernel, cl_device_id device, cl_kernel_info_amd paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == kernel)
+    {
+        return CL_INVALID_KERNEL;
+    }
+
+    if (&s_device != device)
+    {
+        return CL_INVALID_DEVICE;
+    }
+
+    switch (paramName)
+    {
+        case CL_KERNELINFO_SCRATCH_REGS:
+            return ReturnInfo(static_cast<size_t>(0), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNELINFO_WAVEFRONT_SIZE:
+            return ReturnInfo(static_cast<size_t>(64), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNELINFO_AVAILABLE_VGPRS:
+            return ReturnInfo(static_cast<size_t>(256), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNELINFO_USED_VGPRS:
+            return ReturnInfo(static_cast<size_t>(32), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNELINFO_AVAILABLE_SGPRS:
+            return ReturnInfo(static_cast<size_t>(102), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_KERNELINFO_USED_SGPRS:
+            return ReturnInfo(static_cast<size_t>(24), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+static void* CL_API_CALL StubGetExtensionFunctionAddress(const char* szFuncName)
+{
+    WaitForLatency();
+
+    if (nullptr != szFuncName && 0 == strcmp(szFuncName, "clGetKernelInfoAMD"))
+    {
+        return reinterpret_cast<void*>(StubGetKernelInfoAMD);
+    }
+
+    return nullptr;
+}
+
+static void* CL_API_CALL StubGetExtensionFunctionAddressForPlatform(cl_platform_id platform, const char* szFuncName)
+{
+    SP_UNREFERENCED_PARAMETER(platform);
+
+    return StubGetExtensionFunctionAddress(szFuncName);
+}
+
+//------------------------------------------------------------------------------------
+// Commands and events
+//------------------------------------------------------------------------------------
+
+static cl_int CL_API_CALL StubEnqueueNDRangeKernel(cl_command_queue queue,
+                                                   cl_kernel kernel,
+                                                   cl_uint workDim,
+                                                   const size_t* pGlobalWorkOffset,
+                                                   const size_t* pGlobalWorkSize,
+                                                   const size_t* pLocalWorkSize,
+                                                   cl_uint numEventsInWaitList,
+                                                   const cl_event* pEventWaitList,
+                                                   cl_event* pEvent)
+{
+    SP_UNREFERENCED_PARAMETER(workDim);
+    SP_UNREFERENCED_PARAMETER(pGlobalWorkOffset);
+    SP_UNREFERENCED_PARAMETER(pGlobalWorkSize);
+    SP_UNREFERENCED_PARAMETER(pLocalWorkSize);
+    SP_UNREFERENCED_PARAMETER(numEventsInWaitList);
+    SP_UNREFERENCED_PARAMETER(pEventWaitList);
+
+    WaitForLatency();
+
+    if (nullptr == kernel)
+    {
+        return CL_INVALID_KERNEL;
+    }
+
+    return EnqueueCommand(queue, CL_COMMAND_NDRANGE_KERNEL, false, pEvent);
+}
+
+static cl_int CL_API_CALL StubEnqueueWriteBuffer(cl_command_queue queue,
+                                                 cl_mem buffer,
+                                                 cl_bool blockingWrite,
+                                                 size_t offset,
+                                                 size_t size,
+                                                 const void* pData,
+                                                 cl_uint numEventsInWaitList,
+                                                 const cl_event* pEventWaitList,
+                                                 cl_event* pEvent)
+{
+    SP_UNREFERENCED_PARAMETER(pData);
+    SP_UNREFERENCED_PARAMETER(numEventsInWaitList);
+    SP_UNREFERENCED_PARAMETER(pEventWaitList);
+
+    WaitForLatency();
+
+    if (nullptr == buffer)
+    {
+        return CL_INVALID_MEM_OBJECT;
+    }
+
+    if (buffer->m_size < offset + size)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    return EnqueueCommand(queue, CL_COMMAND_WRITE_BUFFER, CL_FALSE != blockingWrite, pEvent);
+}
+
+static cl_int CL_API_CALL StubFlush(cl_command_queue queue)
+{
+    WaitForLatency();
+
+    return nullptr == queue ? CL_INVALID_COMMAND_QUEUE : CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubFinish(cl_command_queue queue)
+{
+    WaitForLatency();
+
+    if (nullptr == queue)
+    {
+        return CL_INVALID_COMMAND_QUEUE;
+    }
+
+    CompleteCommands(queue, nullptr);
+    return CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubWaitForEvents(cl_uint numEvents, const cl_event* pEventList)
+{
+    WaitForLatency();
+
+    if (0 == numEvents || nullptr == pEventList)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    for (cl_uint i = 0; i < numEvents; i++)
+    {
+        if (nullptr == pEventList[i])
+        {
+            return CL_INVALID_EVENT;
+        }
+
+        CompleteCommands(pEventList[i]->m_queue, pEventList[i]);
+    }
+
+    return CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubGetEventInfo(cl_event event, cl_event_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == event)
+    {
+        return CL_INVALID_EVENT;
+    }
+
+    switch (paramName)
+    {
+        case CL_EVENT_COMMAND_QUEUE:
+            return ReturnInfo(event->m_queue, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_EVENT_CONTEXT:
+            return ReturnInfo(event->m_queue->m_context, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_EVENT_COMMAND_TYPE:
+            return ReturnInfo(event->m_type, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_EVENT_REFERENCE_COUNT:
+            return ReturnInfo(event->m_refCount.load(std::memory_order_relaxed), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_EVENT_COMMAND_EXECUTION_STATUS:
+            if (CL_COMPLETE != event->m_status.load(std::memory_order_acquire) &&
+                s_uiPollsToComplete <= event->m_numPolls.fetch_add(1, std::memory_order_relaxed) + 1)
+            {
+                CompleteCommands(event->m_queue, event);
+            }
+
+            return ReturnInfo(event->m_status.load(std::memory_order_acquire), paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+static cl_int CL_API_CALL StubRetainEvent(cl_event event)
+{
+    return RetainObject(event, CL_INVALID_EVENT);
+}
+
+static cl_int CL_API_CALL StubReleaseEvent(cl_event event)
+{
+    WaitForLatency();
+
+    if (nullptr == event)
+    {
+        return CL_INVALID_EVENT;
+    }
+
+    ReleaseEventReference(event);
+    return CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubGetEventProfilingInfo(cl_event event, cl_profiling_info paramName, size_t paramValueSize, void* pParamValue, size_t* pParamValueSizeRet)
+{
+    WaitForLatency();
+
+    if (nullptr == event)
+    {
+        return CL_INVALID_EVENT;
+    }
+
+    if (CL_COMPLETE != event->m_status.load(std::memory_order_acquire))
+    {
+        return CL_PROFILING_INFO_NOT_AVAILABLE;
+    }
+
+    switch (paramName)
+    {
+        case CL_PROFILING_COMMAND_QUEUED:
+            return ReturnInfo(event->m_ullQueued, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PROFILING_COMMAND_SUBMIT:
+            return ReturnInfo(event->m_ullSubmitted, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PROFILING_COMMAND_START:
+            return ReturnInfo(event->m_ullStart, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        case CL_PROFILING_COMMAND_END:
+            return ReturnInfo(event->m_ullEnd, paramValueSize, pParamValue, pParamValueSizeRet);
+
+        default:
+            return CL_INVALID_VALUE;
+    }
+}
+
+static cl_int CL_API_CALL StubSetEventCallback(cl_event event, cl_int commandExecCallbackType, void (CL_CALLBACK* pfnNotify)(cl_event, cl_int, void*), void* pUserData)
+{
+    SP_UNREFERENCED_PARAMETER(commandExecCallbackType);
+
+    WaitForLatency();
+
+    if (nullptr == event)
+    {
+        return CL_INVALID_EVENT;
+    }
+
+    if (nullptr == pfnNotify)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    // the status goes from queued to complete at once, all the callbacks are called on completion
+    {
+        std::lock_guard<std::mutex> lock(event->m_mtx);
+
+        if (CL_COMPLETE != event->m_status.load(std::memory_order_acquire))
+        {
+            StubEventCallback callback = { pfnNotify, pUserData };
+            event->m_callbacks.push_back(callback);
+            return CL_SUCCESS;
+        }
+    }
+
+    pfnNotify(event, CL_COMPLETE, pUserData);
+    return CL_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------
+// Agent interface
+//------------------------------------------------------------------------------------
+
+static cl_int CL_API_CALL StubAgentSetCallbacks(cl_agent* pAgent, const cl_agent_callbacks* pCallbacks, size_t size)
+{
+    SP_UNREFERENCED_PARAMETER(pAgent);
+
+    if (nullptr == pCallbacks)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    memcpy(&s_agentCallbacks, pCallbacks, std::min(size, sizeof(s_agentCallbacks)));
+    return CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubAgentSetCapabilities(cl_agent* pAgent, const cl_agent_capabilities* pCapabilities, cl_agent_capability_action action)
+{
+    SP_UNREFERENCED_PARAMETER(pAgent);
+    SP_UNREFERENCED_PARAMETER(pCapabilities);
+    SP_UNREFERENCED_PARAMETER(action);
+
+    return CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubAgentGetICDDispatchTable(cl_agent* pAgent, cl_icd_dispatch_table* pTable, size_t size)
+{
+    SP_UNREFERENCED_PARAMETER(pAgent);
+
+    if (nullptr == pTable)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    cl_icd_dispatch_table table;
+    CLStubICD::GetDispatchTable(table);
+    memcpy(pTable, &table, std::min(size, sizeof(table)));
+    return CL_SUCCESS;
+}
+
+static cl_int CL_API_CALL StubAgentSetICDDispatchTable(cl_agent* pAgent, const cl_icd_dispatch_table* pTable, size_t size)
+{
+    SP_UNREFERENCED_PARAMETER(pAgent);
+
+    if (nullptr == pTable)
+    {
+        return CL_INVALID_VALUE;
+    }
+
+    memcpy(&s_agentDispatchTable, pTable, std::min(size, sizeof(s_agentDispatchTable)));
+    s_bDispatchTableReplaced = true;
+    return CL_SUCCESS;
+}
+
+void CLStubICD::SetLatency(unsigned int uiNanos)
+{
+    s_uiLatency = uiNanos;
+}
+
+void CLStubICD::SetPollsToComplete(unsigned int uiNumPolls)
+{
+    s_uiPollsToComplete = uiNumPolls;
+}
+
+void CLStubICD::GetDispatchTable(cl_icd_dispatch_table& table)
+{
+    // the functions the agents don't reach through the benchmarks stay nullptr
+    memset(&table, 0, sizeof(table));
+
+    table.GetPlatformIDs = StubGetPlatformIDs;
+    table.GetPlatformInfo = StubGetPlatformInfo;
+    table.GetDeviceIDs = StubGetDeviceIDs;
+    table.GetDeviceInfo = StubGetDeviceInfo;
+    table.CreateContext = StubCreateContext;
+    table.RetainContext = StubRetainContext;
+    table.ReleaseContext = StubReleaseContext;
+    table.GetContextInfo = StubGetContextInfo;
+    table.CreateCommandQueue = StubCreateCommandQueue;
+    table.RetainCommandQueue = StubRetainCommandQueue;
+    table.ReleaseCommandQueue = StubReleaseCommandQueue;
+    table.GetCommandQueueInfo = StubGetCommandQueueInfo;
+    table.CreateBuffer = StubCreateBuffer;
+    table.RetainMemObject = StubRetainMemObject;
+    table.ReleaseMemObject = StubReleaseMemObject;
+    table.GetMemObjectInfo = StubGetMemObjectInfo;
+    table.CreateProgramWithSource = StubCreateProgramWithSource;
+    table.RetainProgram = StubRetainProgram;
+    table.ReleaseProgram = StubReleaseProgram;
+    table.BuildProgram = StubBuildProgram;
+    table.GetProgramInfo = StubGetProgramInfo;
+    table.GetProgramBuildInfo = StubGetProgramBuildInfo;
+    table.CreateKernel = StubCreateKernel;
+    table.RetainKernel = StubRetainKernel;
+    table.ReleaseKernel = StubReleaseKernel;
+    table.SetKernelArg = StubSetKernelArg;
+    table.GetKernelInfo = StubGetKernelInfo;
+    table.GetKernelWorkGroupInfo = StubGetKernelWorkGroupInfo;
+    table.WaitForEvents = StubWaitForEvents;
+    table.GetEventInfo = StubGetEventInfo;
+    table.RetainEvent = StubRetainEvent;
+    table.ReleaseEvent = StubReleaseEvent;
+    table.GetEventProfilingInfo = StubGetEventProfilingInfo;
+    table.Flush = StubFlush;
+    table.Finish = StubFinish;
+    table.EnqueueWriteBuffer = StubEnqueueWriteBuffer;
+    table.EnqueueNDRangeKernel = StubEnqueueNDRangeKernel;
+    table.GetExtensionFunctionAddress = StubGetExtensionFunctionAddress;
+    table.SetEventCallback = StubSetEventCallback;
+    table.GetExtensionFunctionAddressForPlatform = StubGetExtensionFunctionAddressForPlatform;
+}
+
+cl_agent* CLStubICD::GetAgent()
+{
+    // the agents only use these functions of the agent interface
+    s_agent.SetCallbacks = StubAgentSetCallbacks;
+    s_agent.SetCapabilities = StubAgentSetCapabilities;
+    s_agent.GetICDDispatchTable = StubAgentGetICDDispatchTable;
+    s_agent.SetICDDispatchTable = StubAgentSetICDDispatchTable;
+    return &s_agent;
+}
+
+bool CLStubICD::IsDispatchTableReplaced()
+{
+    return s_bDispatchTableReplaced;
+}
+
+const cl_icd_dispatch_table& CLStubICD::GetApplicationDispatchTable()
+{
+    if (!s_bDispatchTableReplaced)
+    {
+        GetDispatchTable(s_agentDispatchTable);
+    }
+
+    return s_agentDispatchTable;
+}
@@ -0,0 +1,46 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Stub OpenCL runtime the agents are loaded against by RCPAgentBench
+//==============================================================================
+
+#ifndef _CL_STUB_ICD_H_
+#define _CL_STUB_ICD_H_
+
+#include <CL/opencl.h>
+#include <CL/internal/cl_agent_amd.h>
+
+/// The stub runtime has one platform with one GPU device. Its functions do no work
+/// besides an optional busy wait, so that the benchmarks run on machines without a GPU.
+/// Commands complete in order when the queue is finished or waited for, when the status
+/// of their event has been queried a number of times, or when too many are pending.
+/// Event status changes are reported to the agent callbacks like the runtime does.
+namespace CLStubICD
+{
+/// Set the time spent in each call of the stub runtime
+/// \param uiNanos the time in ns, 0 to return immediately
+void SetLatency(unsigned int uiNanos);
+
+/// Set the number of clGetEventInfo status queries of an event before it completes
+/// \param uiNumPolls the number of queries
+void SetPollsToComplete(unsigned int uiNumPolls);
+
+/// Get the dispatch table of the stub runtime
+/// \param[out] table the dispatch table
+void GetDispatchTable(cl_icd_dispatch_table& table);
+
+/// Get the agent interface passed to clAgent_OnLoad
+/// \return the agent interface
+cl_agent* GetAgent();
+
+/// Check whether an agent installed its dispatch table
+/// \return true if SetICDDispatchTable was called
+bool IsDispatchTableReplaced();
+
+/// Get the table the application calls, the table installed by the agent or the stub runtime table
+/// \return the dispatch table
+const cl_icd_dispatch_table& GetApplicationDispatchTable();
+} // CLStubICD
+
+#endif // _CL_STUB_ICD_H_
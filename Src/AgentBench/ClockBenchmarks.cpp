@@ -0,0 +1,73 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Benchmark of the cost of reading the timestamps of the traced calls
+//==============================================================================
+
+#include <cstdio>
+#include <time.h>
+
+#include "AgentBench.h"
+#include "OSUtils.h"
+#include "TSCClock.h"
+
+/// Number of clock reads per iteration
+#define CLOCK_BENCH_READS_PER_ITERATION 10
+
+/// Sum of the times read, printed so that the reads are not optimized out
+static volatile ULONGLONG s_ullTimeSum = 0;
+
+/// Read a clock CLOCK_BENCH_READS_PER_ITERATION times per iteration and report the cost per read
+/// \param szName the benchmark name
+/// \param readClock the function reading the clock
+template <typename ReadClockFunc>
+static void RunClockBenchmark(const char* szName, ReadClockFunc readClock)
+{
+    unsigned int uiIterations = GetAgentBenchSettings().m_uiIterations;
+    ULONGLONG ullSum = 0;
+
+    AgentBenchMeasurement measurement(szName);
+    measurement.Start();
+
+    for (unsigned int i = 0; i < uiIterations; i++)
+    {
+        for (unsigned int j = 0; j < CLOCK_BENCH_READS_PER_ITERATION; j++)
+        {
+            ullSum += readClock();
+        }
+    }
+
+    measurement.Stop(static_cast<ULONGLONG>(uiIterations) * CLOCK_BENCH_READS_PER_ITERATION);
+    s_ullTimeSum = s_ullTimeSum + ullSum;
+    measurement.Report();
+}
+
+AGENT_BENCHMARK(Clock_GetTimeNanos)
+{
+    RunClockBenchmark("Clock/clock_gettime(CLOCK_MONOTONIC)", []()
+    {
+        struct timespec tp;
+        clock_gettime(CLOCK_MONOTONIC, &tp);
+        return static_cast<ULONGLONG>(tp.tv_sec) * (1000ULL * 1000ULL * 1000ULL) + static_cast<ULONGLONG>(tp.tv_nsec);
+    });
+
+    // the default clock, the OSUtils instance is not set up to use the time stamp counter
+    RunClockBenchmark("Clock/OSUtils::GetTimeNanos", []()
+    {
+        return OSUtils::Instance()->GetTimeNanos();
+    });
+
+    TSCClock tscClock;
+
+    if (!tscClock.Init())
+    {
+        printf("[SKIPPED] Clock/TSCClock::GetTimeNanos: the time stamp counter is not invariant\n");
+        return;
+    }
+
+    RunClockBenchmark("Clock/TSCClock::GetTimeNanos", [&tscClock]()
+    {
+        return tscClock.GetTimeNanos();
+    });
+}
@@ -0,0 +1,103 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Benchmark of the timer flushes writing the tmp fragment files
+//==============================================================================
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "AgentBench.h"
+#include "FragmentWriterCache.h"
+
+/// Number of threads whose fragment files are written by each flush
+#define FRAGMENT_BENCH_THREADS 64
+
+/// Number of fragment files of each thread: trace, timestamp and stack
+#define FRAGMENT_BENCH_FILES_PER_THREAD 3
+
+/// Number of entries written to each file by each flush
+#define FRAGMENT_BENCH_ENTRIES 100
+
+/// Run timer flushes writing the fragment files of FRAGMENT_BENCH_THREADS threads
+/// \param szName the name of the configuration
+/// \param bufferSize the buffer size of the files, 0 to reopen the files on every flush
+/// \param bCompress flag indicating whether the files are compressed
+static void RunFragmentWriterBenchmark(const char* szName, size_t bufferSize, bool bCompress)
+{
+    const AgentBenchSettings& settings = GetAgentBenchSettings();
+    std::string strName = std::string("FragmentWriterCache/") + szName;
+    std::string strDir = CreateAgentBenchDir(strName);
+
+    if (strDir.empty())
+    {
+        ReportAgentBenchFailure(strName, "unable to create the output directory");
+        return;
+    }
+
+    static const char* s_szExtensions[FRAGMENT_BENCH_FILES_PER_THREAD] = { ".ocl", ".tstamp", ".st" };
+    std::vector<std::string> fileNames;
+
+    for (unsigned int i = 0; i < FRAGMENT_BENCH_THREADS; i++)
+    {
+        for (unsigned int j = 0; j < FRAGMENT_BENCH_FILES_PER_THREAD; j++)
+        {
+            std::stringstream ss;
+            ss << strDir << "/1234_" << 5000 + i << s_szExtensions[j];
+            fileNames.push_back(ss.str());
+        }
+    }
+
+    // entries similar to the lines of an API trace
+    std::stringstream ssEntries;
+
+    for (unsigned int i = 0; i < FRAGMENT_BENCH_ENTRIES; i++)
+    {
+        ssEntries << "clEnqueueNDRangeKernel = CL_SUCCESS ( 0x0000000001A2B3C4;0x0000000001A2B3D0;1;NULL;[65536];[256];0;NULL;0x00007FFF5A6B7C8" << i % 10 << " )\n";
+    }
+
+    std::string strEntries = ssEntries.str();
+
+    // one flush per 1000 iterations, 100 flushes by default
+    unsigned int numFlushes = std::max(settings.m_uiIterations / 1000, 1u);
+
+    FragmentWriterCache writers;
+    writers.SetBufferSize(bufferSize);
+    writers.SetCompression(bCompress);
+
+    AgentBenchMeasurement measurement(strName);
+    measurement.Start();
+
+    for (unsigned int i = 0; i < numFlushes; i++)
+    {
+        for (std::vector<std::string>::const_iterator it = fileNames.begin(); it != fileNames.end(); ++it)
+        {
+            std::ostream* pWriter = writers.GetWriter(*it);
+
+            if (nullptr != pWriter)
+            {
+                pWriter->write(strEntries.data(), strEntries.size());
+            }
+        }
+
+        writers.EndFlush(true);
+    }
+
+    writers.CloseAll();
+
+    // one call is the flush of one file
+    measurement.Stop(static_cast<ULONGLONG>(numFlushes) * fileNames.size());
+    measurement.SetBytesWritten(GetAgentBenchDirSize(strDir));
+    measurement.Report();
+
+    RemoveAgentBenchDir(strDir);
+}
+
+AGENT_BENCHMARK(FragmentWriterCache_Flush)
+{
+    RunFragmentWriterBenchmark("reopen", 0, false);
+    RunFragmentWriterBenchmark("keepopen", DEFAULT_FRAGMENT_BUFFER_SIZE * 1024, false);
+    RunFragmentWriterBenchmark("keepopen,compressed", DEFAULT_FRAGMENT_BUFFER_SIZE * 1024, true);
+}
@@ -0,0 +1,110 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Benchmark of the merge of the tmp fragment files into the output file
+//==============================================================================
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "AgentBench.h"
+#include "FileUtils.h"
+
+/// Process id used as the prefix of the fragment files
+#define MERGE_BENCH_PID "1234"
+
+/// Extension of the fragment files
+#define MERGE_BENCH_EXT ".ocl"
+
+/// Write the fragment files of numFragments threads
+/// \param strDir the directory the fragment files are written to
+/// \param numFragments the number of fragment files
+/// \param strEntries the entries written to each fragment file
+/// \return true if all fragment files were written
+static bool WriteMergeBenchFragments(const std::string& strDir, unsigned int numFragments, const std::string& strEntries)
+{
+    for (unsigned int i = 0; i < numFragments; i++)
+    {
+        std::stringstream ss;
+        ss << strDir << "/" << MERGE_BENCH_PID << "_" << 5000 + i << MERGE_BENCH_EXT;
+
+        std::ofstream fout(ss.str().c_str(), std::ios::binary);
+        fout.write(strEntries.data(), strEntries.size());
+
+        if (fout.fail())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Merge the fragment files of numFragments threads into one output file
+/// \param numFragments the number of fragment files
+static void RunMergeBenchmark(unsigned int numFragments)
+{
+    const AgentBenchSettings& settings = GetAgentBenchSettings();
+    std::stringstream ssName;
+    ssName << "MergeTmpTraceFiles/fragments=" << numFragments;
+    std::string strName = ssName.str();
+    std::string strDir = CreateAgentBenchDir(strName);
+
+    if (strDir.empty())
+    {
+        ReportAgentBenchFailure(strName, "unable to create the output directory");
+        return;
+    }
+
+    // one line per 1000 iterations, 100 lines per fragment by default
+    unsigned int numEntries = std::max(settings.m_uiIterations / 1000, 1u);
+    std::stringstream ssEntries;
+
+    for (unsigned int i = 0; i < numEntries; i++)
+    {
+        ssEntries << "4    clEnqueueNDRangeKernel    " << 1000000 + i * 100 << "    " << 1000000 + i * 100 + 40 << "    0x0000000001A2B3C4    Kernel" << i % 10 << "\n";
+    }
+
+    if (!WriteMergeBenchFragments(strDir, numFragments, ssEntries.str()))
+    {
+        ReportAgentBenchFailure(strName, "unable to write the fragment files");
+        RemoveAgentBenchDir(strDir);
+        return;
+    }
+
+    // the output file is written next to the fragment directory so that only its size is counted as written
+    std::string strOutputFile = strDir + ".atp";
+
+    AgentBenchMeasurement measurement(strName);
+    measurement.Start();
+
+    bool bMerged = FileUtils::MergeTmpTraceFiles(strOutputFile, strDir + "/", MERGE_BENCH_PID, MERGE_BENCH_EXT, "=====OpenCL Timestamp Output=====");
+
+    // one call is the merge of one fragment file
+    measurement.Stop(numFragments);
+
+    if (!bMerged)
+    {
+        ReportAgentBenchFailure(strName, "unable to merge the fragment files");
+    }
+    else
+    {
+        std::ifstream fin(strOutputFile.c_str(), std::ios::binary | std::ios::ate);
+        measurement.SetBytesWritten(fin.good() ? static_cast<ULONGLONG>(fin.tellg()) : 0);
+        measurement.Report();
+    }
+
+    remove(strOutputFile.c_str());
+    RemoveAgentBenchDir(strDir);
+}
+
+AGENT_BENCHMARK(FileUtils_MergeTmpTraceFiles)
+{
+    RunMergeBenchmark(16);
+    RunMergeBenchmark(256);
+    RunMergeBenchmark(1024);
+}
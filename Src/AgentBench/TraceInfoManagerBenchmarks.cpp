@@ -0,0 +1,146 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Benchmark of the contention of the threads adding trace entries
+//==============================================================================
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "AgentBench.h"
+#include "GlobalSettings.h"
+#include "TraceInfoManager.h"
+
+/// Trace entry added by the benchmark threads
+class BenchTraceEntry : public ITraceEntry
+{
+public:
+    /// Get the string written to the trace file, the benchmark doesn't write the entries
+    /// \return an empty string
+    std::string ToString() override
+    {
+        return std::string();
+    }
+};
+
+/// Trace info manager whose flush deletes the entries, so that only adding the entries is measured
+class BenchTraceInfoManager : public TraceInfoManager
+{
+public:
+    /// Delete the entries of the non-active map
+    /// \param bForceFlush unused
+    void FlushTraceData(bool bForceFlush = false) override
+    {
+        SP_UNREFERENCED_PARAMETER(bForceFlush);
+        std::lock_guard<std::mutex> lock(m_mtxFlush);
+        TraceInfoMap& nonActiveMap = m_TraceInfoMap[ 1 - m_iActiveMap ];
+
+        for (TraceInfoMap::iterator mapIt = nonActiveMap.begin(); mapIt != nonActiveMap.end(); ++mapIt)
+        {
+            for (std::list<ITraceEntry*>::iterator listIt = mapIt->second.begin(); listIt != mapIt->second.end(); ++listIt)
+            {
+                delete *listIt;
+            }
+
+            mapIt->second.clear();
+        }
+    }
+};
+
+/// Manager flushed by BenchTimerThread
+static BenchTraceInfoManager* s_pBenchManager = nullptr;
+
+/// Timer thread flushing s_pBenchManager
+/// \param params unused
+static void BenchTimerThread(void* params)
+{
+    SP_UNREFERENCED_PARAMETER(params);
+
+    while (s_pBenchManager->WaitForFlush())
+    {
+        s_pBenchManager->TrySwapBuffer();
+        s_pBenchManager->FlushTraceData();
+    }
+}
+
+/// Add entries from 1 to N threads while the timer thread flushes them
+/// \param szName the name of the trace buffer backend
+/// \param bThreadTraceBuffer flag indicating whether the entries are added to per-thread buffers or to the shared map
+static void RunTraceInfoManagerBenchmark(const char* szName, bool bThreadTraceBuffer)
+{
+    const AgentBenchSettings& settings = GetAgentBenchSettings();
+    Parameters& params = GlobalSettings::GetInstance()->m_params;
+    bool bSavedThreadTraceBuffer = params.m_bThreadTraceBuffer;
+    params.m_bThreadTraceBuffer = bThreadTraceBuffer;
+
+    BenchTraceInfoManager manager;
+    s_pBenchManager = &manager;
+    manager.SetInterval(params.m_uiTimeOutInterval);
+
+    if (!manager.StartTimer(BenchTimerThread))
+    {
+        ReportAgentBenchFailure(szName, "unable to start the timer thread");
+        params.m_bThreadTraceBuffer = bSavedThreadTraceBuffer;
+        return;
+    }
+
+    std::vector<unsigned int> threadCounts;
+
+    for (unsigned int numThreads = 1; numThreads < settings.m_uiThreads; numThreads *= 2)
+    {
+        threadCounts.push_back(numThreads);
+    }
+
+    threadCounts.push_back(settings.m_uiThreads);
+
+    for (std::vector<unsigned int>::const_iterator it = threadCounts.begin(); it != threadCounts.end(); ++it)
+    {
+        std::stringstream ss;
+        ss << szName << "/threads=" << *it;
+        AgentBenchMeasurement measurement(ss.str());
+
+        std::atomic<bool> bStart(false);
+        std::vector<std::thread> threads;
+
+        for (unsigned int i = 0; i < *it; i++)
+        {
+            threads.push_back(std::thread([&]()
+            {
+                while (!bStart.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+
+                for (unsigned int j = 0; j < settings.m_uiIterations; j++)
+                {
+                    manager.AddTraceInfoEntry(new BenchTraceEntry());
+                }
+            }));
+        }
+
+        measurement.Start();
+        bStart.store(true, std::memory_order_release);
+
+        for (std::vector<std::thread>::iterator itThread = threads.begin(); itThread != threads.end(); ++itThread)
+        {
+            itThread->join();
+        }
+
+        measurement.Stop(static_cast<ULONGLONG>(settings.m_uiIterations) * *it, *it);
+        measurement.Report();
+    }
+
+    manager.StopTimer();
+    manager.Release();
+    s_pBenchManager = nullptr;
+    params.m_bThreadTraceBuffer = bSavedThreadTraceBuffer;
+}
+
+AGENT_BENCHMARK(TraceInfoManager_AddTraceInfoEntry)
+{
+    RunTraceInfoManagerBenchmark("TraceInfoManager/threadbuffers", true);
+    RunTraceInfoManagerBenchmark("TraceInfoManager/sharedmap", false);
+}
@@ -39,15 +39,17 @@ void InitRealCLFunctions(cl_icd_dispatch_table* pRealTable)
 {
     static OpenCLModule g_OpenCLModule;
 
-    if (g_OpenCLModule.OpenCLLoaded() == OpenCLModule::OpenCL_None)
-    {
-        return;
-    }
+    bool isOpenCLLoaded = g_OpenCLModule.OpenCLLoaded() != OpenCLModule::OpenCL_None;
 
     // if thisModuleName is empty, then we are not initializing the real dispatch table with
     // an agent's original dispatch table. Thus, we load the entry points from opencl.dll or libopencl.so
     if (nullptr == pRealTable)
     {
+        if (!isOpenCLLoaded)
+        {
+            return;
+        }
+
         g_realDispatchTable.GetPlatformInfo = g_OpenCLModule.GetPlatformInfo;
         g_realDispatchTable.GetDeviceIDs = g_OpenCLModule.GetDeviceIDs;
         g_realDispatchTable.GetDeviceInfo = g_OpenCLModule.GetDeviceInfo;
@@ -215,8 +217,12 @@ void InitRealCLFunctions(cl_icd_dispatch_table* pRealTable)
         memcpy(&g_realDispatchTable, pRealTable, sizeof(g_realDispatchTable));
     }
 
-    // Always use GetPlatformIDs from OpenCL ICD lib, as it is never assigned in the agent's dispatch table
-    g_realDispatchTable.GetPlatformIDs = g_OpenCLModule.GetPlatformIDs;
+    // Use GetPlatformIDs from OpenCL ICD lib, as it is never assigned in the agent's dispatch table.
+    // The agent's table is kept when there is no ICD lib, as when the agent is loaded by RCPAgentBench
+    if (isOpenCLLoaded)
+    {
+        g_realDispatchTable.GetPlatformIDs = g_OpenCLModule.GetPlatformIDs;
+    }
 }
 
 CL_FUNC_TYPE InitExtensionFunction(const char* pFuncName, void* pFuncPtr)
@@ -48,32 +48,11 @@ void TimerThread(void* params)
 {
     SP_UNREFERENCED_PARAMETER(params);
 
-    unsigned int interval = OccupancyInfoManager::Instance()->GetInterval();
-
-    if (interval == 0)
+    // flush when a thread reaches the flush watermark or when the timer interval expires
+    while (OccupancyInfoManager::Instance()->WaitForFlush())
     {
-        interval = 1; // safety net in case interval is zero (it shouldn't be...)
-    }
-
-    const unsigned int sleepInterval = interval < 10 ? interval : 10; // sleep at most 10 ms at a time
-    const unsigned int sleepsBeforeFlush = sleepInterval == 0 ? 1 : interval / sleepInterval;
-
-    unsigned int iterationNum = 1;
-
-    while (OccupancyInfoManager::Instance()->IsRunning())
-    {
-        OSUtils::Instance()->SleepMillisecond(sleepInterval);
-
-        if (iterationNum == sleepsBeforeFlush)
-        {
-            iterationNum = 1;
-            OccupancyInfoManager::Instance()->TrySwapBuffer();
-            OccupancyInfoManager::Instance()->FlushTraceData();
-        }
-        else
-        {
-            iterationNum++;
-        }
+        OccupancyInfoManager::Instance()->TrySwapBuffer();
+        OccupancyInfoManager::Instance()->FlushTraceData();
     }
 }
 
@@ -230,13 +209,13 @@ clAgent_OnLoad(cl_agent* agent)
 }
 
 
-#ifdef _WIN32
-
+// Also exported on Linux, where RCPAgentBench calls it to write the output file
 extern "C" DLL_PUBLIC void OnExitProcess()
 {
     DumpOccupancy();
 }
 
+#ifdef _WIN32
 // On Windows, we can't dump data in OnUnload() because of ocl runtime bug
 BOOL APIENTRY DllMain(HMODULE,
                       DWORD   ul_reason_for_call,
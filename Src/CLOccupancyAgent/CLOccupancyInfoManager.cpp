@@ -314,6 +314,8 @@ void OccupancyInfoManager::SetOutputFile(const string& strFileName)
 
 void OccupancyInfoManager::SaveToOccupancyFile()
 {
+    DrainThreadTraceBuffers(m_TraceInfoMap[0]);
+
     TraceInfoMap& activeMap = m_TraceInfoMap[ 0 ];
 
     if (!activeMap.empty())
@@ -301,6 +301,9 @@ bool CLGPAProfiler::Init(const Parameters& params, string& strErrorOut)
     // Set list separator
     KernelProfileResultManager::Instance()->SetListSeparator(params.m_cOutputSeparator);
 
+    // Compress the kernel profile output
+    KernelProfileResultManager::Instance()->SetCompression(params.m_bCompressOutput);
+
     // Get platform info
     if (!CLUtils::GetPlatformInfo(m_platformList))
     {
@@ -14,16 +14,12 @@ using namespace GPULogger;
 
 #ifndef WIN32
 // On Linux, the search heuristic is simple, the first module that is not profiler nor libOpenCL is the application.
-void CLAPIBase::CreateStackEntry()
+StackEntry* CLAPIBase::CreateStackEntry(std::vector<StackEntry>& stack)
 {
     m_strName = CLStringUtils::GetCLAPINameString(m_type);
+    StackEntry* pStackEntry = NULL;
 
-    if (m_pStackEntry != NULL)
-    {
-        return;
-    }
-
-    for (vector<StackEntry>::iterator it = m_stack.begin(); it != m_stack.end(); ++it)
+    for (vector<StackEntry>::iterator it = stack.begin(); it != stack.end(); ++it)
     {
         if (it->m_strModName.empty())
         {
@@ -35,16 +31,18 @@ void CLAPIBase::CreateStackEntry()
         {
             // found
             StackTracer::Instance()->GetSymbolName(it->m_dwAddress, *it);
-            m_pStackEntry = new(nothrow) StackEntry(*it);
+            pStackEntry = new(nothrow) StackEntry(*it);
 
-            if (m_pStackEntry != NULL)
+            if (pStackEntry != NULL)
             {
-                m_pStackEntry->m_strSymName = "NA";
+                pStackEntry->m_strSymName = "NA";
             }
 
             break;
         }
     }
+
+    return pStackEntry;
 }
 #else
 
@@ -56,14 +54,10 @@ bool CLAPIBase::IsValidStackEntry(const std::string& strSymName, const std::stri
             strModName.find(GPU_PROFILER_LIBRARY_NAME_PREFIX "CLTraceAgent") == string::npos);
 }
 
-void CLAPIBase::CreateStackEntry()
+StackEntry* CLAPIBase::CreateStackEntry(std::vector<StackEntry>& stack)
 {
     m_strName = CLStringUtils::GetCLAPINameString(m_type);
-
-    if (m_pStackEntry != NULL)
-    {
-        return;
-    }
+    StackEntry* pStackEntry = NULL;
 
 #ifdef DEBUG_ST
     stringstream ss;
@@ -73,7 +67,7 @@ void CLAPIBase::CreateStackEntry()
     unsigned int nIdx = (unsigned int) - 1;
     unsigned int i = 0;
 
-    for (vector<StackEntry>::iterator it = m_stack.begin(); it != m_stack.end(); ++it)
+    for (vector<StackEntry>::iterator it = stack.begin(); it != stack.end(); ++it)
     {
         StackTracer::Instance()->GetSymbolName(it->m_dwAddress, *it);
         string symStr = it->m_strSymName;
@@ -123,20 +117,20 @@ void CLAPIBase::CreateStackEntry()
 
 #ifndef DEBUG_ST
 
-    if (nIdx < m_stack.size())
+    if (nIdx < stack.size())
     {
         if (!bRetrievedAllSymbols)
         {
-            StackTracer::Instance()->GetSymbolName(m_stack[nIdx].m_dwAddress, m_stack[nIdx]);
+            StackTracer::Instance()->GetSymbolName(stack[nIdx].m_dwAddress, stack[nIdx]);
         }
 
-        StackEntry stackEntry = m_stack[nIdx];
+        StackEntry stackEntry = stack[nIdx];
 
         // if the calling stack frame does not have debug info (file is an empty string),
         // then keep going up the stack to see if a frame with debug info is found
-        if (m_stack[nIdx].m_strFile.empty() && (nIdx < m_stack.size() - 1))
+        if (stack[nIdx].m_strFile.empty() && (nIdx < stack.size() - 1))
         {
-            for (vector<StackEntry>::iterator it = m_stack.begin() + nIdx; it != m_stack.end(); ++it)
+            for (vector<StackEntry>::iterator it = stack.begin() + nIdx; it != stack.end(); ++it)
             {
                 if (!bRetrievedAllSymbols)
                 {
@@ -151,19 +145,21 @@ void CLAPIBase::CreateStackEntry()
             }
         }
 
-        m_pStackEntry = new(nothrow) StackEntry(stackEntry);
+        pStackEntry = new(nothrow) StackEntry(stackEntry);
     }
 
 #else
-    m_pStackEntry = new(nothrow) StackEntry();
+    pStackEntry = new(nothrow) StackEntry();
 
-    if (m_pStackEntry != NULL)
+    if (pStackEntry != NULL)
     {
-        m_pStackEntry->m_dwLineNum = 0;
-        m_pStackEntry->m_strSymName = ss.str();
+        pStackEntry->m_dwLineNum = 0;
+        pStackEntry->m_strSymName = ss.str();
     }
 
 #endif
+
+    return pStackEntry;
 }
 #endif
 
@@ -244,8 +240,9 @@ bool CLEnqueueAPIBase::WriteTimestampEntry(std::ostream& sout, bool bTimeout)
 #else
         en->Unmap();
 #endif
-        sout << left << setw(8) << en->m_clCommandType;
-        sout << left << setw(40) << CLStringUtils::GetCommandTypeString(en->m_clCommandType);
+        cl_command_type commandType = en->GetCommandType();
+        sout << left << setw(8) << commandType;
+        sout << left << setw(40) << CLStringUtils::GetCommandTypeString(commandType);
 
 #ifdef NON_BLOCKING_TIMEOUT
 
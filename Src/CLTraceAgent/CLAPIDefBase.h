@@ -55,20 +55,9 @@ public:
     }
 
     /// Search for OpenCL API call stack frame
-    void CreateStackEntry();
-
-    /// Write stack entry
-    /// \param sout output stream
-    void WriteStackEntry(std::ostream& sout) override
-    {
-        if (nullptr == m_pStackEntry)
-        {
-            // Search for OpenCL API call stack frame lazily
-            CreateStackEntry();
-        }
-
-        APIBase::WriteStackEntry(sout);
-    }
+    /// \param stack the stack trace of the call site
+    /// \return a new stack entry or NULL if none was found
+    StackEntry* CreateStackEntry(std::vector<StackEntry>& stack) override;
 
     /// Write timestamp entry
     /// \param sout output stream
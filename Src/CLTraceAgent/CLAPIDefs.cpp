@@ -18,8 +18,6 @@ std::mutex CLAPI_clCreateContextBase::ms_mtx;
 cl_uint CLAPI_clCreateCommandQueueBase::ms_NumInstance = 0;
 std::mutex CLAPI_clCreateCommandQueueBase::ms_mtx;
 
-bool CLAPI_clGetEventInfo::ms_collapseCalls = true;
-
 void CLAPI_clCreateContextBase::AddToInfoManager(cl_context context)
 {
     if (nullptr != context)
@@ -4363,9 +4363,6 @@ private:
 class CLAPI_clGetEventInfo : public CLAPIBase
 {
 public:
-    static bool ms_collapseCalls;    ///< flag indicating whether or not consecutive identical CLAPI_clGetEventInfo instances should be collapsed
-    size_t      m_consecutiveCount;  ///< number of consectuive identical calls to this API
-
     /// Constructor
     CLAPI_clGetEventInfo()
     {
@@ -4400,12 +4397,6 @@ public:
            << m_param_value_size << s_strParamSeparator
            << CLStringUtils::GetEventInfoValueString(m_param_name, m_param_value, m_retVal) << s_strParamSeparator
            << CLStringUtils::GetSizeString(REPLACEDNULLVAL(m_replaced_null_param, m_param_value_size_ret), m_param_value_size_retVal);
-
-        if (m_consecutiveCount > 1)
-        {
-            ss << " /*" << m_consecutiveCount << " consecutive calls*/";
-        }
-
         return ss.str();
     }
 
@@ -4439,7 +4430,6 @@ public:
         m_param_value_size_ret = param_value_size_ret;
         m_replaced_null_param = replaced_null_param;
         m_param_value_size_retVal = *param_value_size_ret;
-        m_consecutiveCount = 1;
 
         if (nullptr != param_value)
         {
@@ -4464,6 +4454,21 @@ public:
                 m_param_value_size_retVal == obj->m_param_value_size_retVal);
     }
 
+    /// Applications poll the execution status of their events with clGetEventInfo
+    /// \return true
+    bool IsPollable() const override
+    {
+        return true;
+    }
+
+    /// Check whether the call repeats a previous clGetEventInfo call
+    /// \param pPrevious the previous call
+    /// \return true if the parameters and the returned value are the same
+    bool IsRepeatOf(const APIBase* pPrevious) const override
+    {
+        return SameParameters(dynamic_cast<const CLAPI_clGetEventInfo*>(pPrevious));
+    }
+
 private:
     /// Disable copy constructor
     /// \param[in] obj  the input object
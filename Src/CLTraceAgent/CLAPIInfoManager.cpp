@@ -43,39 +43,26 @@ void TimerThread(void* param)
 {
     SP_UNREFERENCED_PARAMETER(param);
 
-    unsigned int interval = CLAPIInfoManager::Instance()->GetInterval();
-
-    if (interval == 0)
-    {
-        interval = 1; // safety net in case interval is zero (it shouldn't be...)
-    }
-
-    const unsigned int sleepInterval = interval < 10 ? interval : 10; // sleep at most 10 ms at a time
-    const unsigned int sleepsBeforeFlush = sleepInterval == 0 ? 1 : interval / sleepInterval;
-
-    unsigned int iterationNum = 1;
-
-    while (CLAPIInfoManager::Instance()->IsRunning())
+    // flush when a thread reaches the flush watermark or when the timer interval expires
+    while (CLAPIInfoManager::Instance()->WaitForFlush())
     {
-        OSUtils::Instance()->SleepMillisecond(sleepInterval);
-
-        if (iterationNum == sleepsBeforeFlush)
-        {
-            iterationNum = 1;
-            CLAPIInfoManager::Instance()->TrySwapBuffer();
-            CLAPIInfoManager::Instance()->FlushTraceData();
+        CLAPIInfoManager::Instance()->TrySwapBuffer();
+        CLAPIInfoManager::Instance()->FlushTraceData();
 #ifdef NON_BLOCKING_TIMEOUT
-            CLEventManager::Instance()->TrySwapBuffer();
-            CLEventManager::Instance()->FlushTraceData();
+        CLEventManager::Instance()->TrySwapBuffer();
+        CLEventManager::Instance()->FlushTraceData();
 #endif
-        }
-        else
-        {
-            iterationNum++;
-        }
     }
 }
 
+/// Get the name of a CL API type, used by the API statistics
+/// \param uiAPIType the API type
+/// \return the API name
+static std::string GetCLAPIStatisticsName(unsigned int uiAPIType)
+{
+    return CLStringUtils::GetCLAPINameString(static_cast<CL_FUNC_TYPE>(uiAPIType));
+}
+
 CLAPIInfoManager::CLAPIInfoManager(void) :
     APIInfoManagerBase()
 {
@@ -88,6 +75,8 @@ CLAPIInfoManager::CLAPIInfoManager(void) :
     m_mustInterceptAPIs.insert(CL_FUNC_TYPE_clReleaseContext);
     m_uiLineNum = 0;
     m_strTraceModuleName = "ocl";
+    m_apiStatistics.Init(CL_FUNC_TYPE_Unknown, GetCLAPIStatisticsName);
+    m_apiSampler.Init(CL_FUNC_TYPE_Unknown, GetCLAPIStatisticsName);
     m_bDelayStartEnabled = false;
     m_bProfilerDurationEnabled = false;
     m_delayInMilliseconds = 0ul;
@@ -114,12 +103,18 @@ CLAPIInfoManager::~CLAPIInfoManager(void)
 void CLAPIInfoManager::FlushTraceData(bool bForceFlush)
 {
     SP_UNREFERENCED_PARAMETER(bForceFlush);
+    WriteAPIStatistics();
     m_mtxFlush.lock();
     osProcessId pid = osGetCurrentProcessId();
     TraceInfoMap& nonActiveMap = m_TraceInfoMap[ 1 - m_iActiveMap ];
 
     for (TraceInfoMap::iterator mapIt = nonActiveMap.begin(); mapIt != nonActiveMap.end(); mapIt++)
     {
+        if (mapIt->second.empty())
+        {
+            continue;
+        }
+
         osThreadId tid = mapIt->first;
         stringstream ss;
         string path;
@@ -133,32 +128,27 @@ void CLAPIInfoManager::FlushTraceData(bool bForceFlush)
             path = FileUtils::GetTempFragFilePath();
         }
 
-        // File name: pid_tid.ocl.apitrace
-
-        ss << path << pid << "_" << tid << "." << m_strTraceModuleName << TMP_TRACE_EXT;
-        string tmpTraceFile = ss.str();
-        ss.str("");
-        ss << path << pid << "_" << tid << "." << m_strTraceModuleName << TMP_TIME_STAMP_EXT;
-        string tmpTimestampFile = ss.str();
-
         bool bEnableStackTrace = GlobalSettings::GetInstance()->m_params.m_bStackTrace && StackTracer::Instance()->IsInitialized();
-        string tmpStackTraceFile;
-        ofstream foutST;
+        ostream* pFoutST = nullptr;
 
         if (bEnableStackTrace)
         {
             ss.str("");
             ss << path << pid << "_" << tid << "." << m_strTraceModuleName << TMP_TRACE_STACK_EXT;
-            tmpStackTraceFile = ss.str();
-            foutST.open(tmpStackTraceFile.c_str(), fstream::out | fstream::app);
-            bEnableStackTrace = !foutST.fail();
+            pFoutST = m_fragmentWriters.GetWriter(ss.str());
+            bEnableStackTrace = nullptr != pFoutST;
         }
 
-        // Open file for append
-        ofstream foutTrace(tmpTraceFile.c_str(), fstream::out | fstream::app);
-        ofstream foutTS(tmpTimestampFile.c_str(), fstream::out | fstream::app);
+        // Get the files, they stay open between flushes (see FragmentWriterCache)
+        // File name: pid_tid.ocl.apitrace
+        ss.str("");
+        ss << path << pid << "_" << tid << "." << m_strTraceModuleName << TMP_TRACE_EXT;
+        ostream* pFoutTrace = m_fragmentWriters.GetWriter(ss.str());
+        ss.str("");
+        ss << path << pid << "_" << tid << "." << m_strTraceModuleName << TMP_TIME_STAMP_EXT;
+        ostream* pFoutTS = m_fragmentWriters.GetWriter(ss.str());
 
-        if (foutTrace.fail() || foutTS.fail())
+        if (nullptr == pFoutTrace || nullptr == pFoutTS)
         {
             continue;
         }
@@ -167,22 +157,11 @@ void CLAPIInfoManager::FlushTraceData(bool bForceFlush)
         {
             CLAPIBase* item = dynamic_cast<CLAPIBase*>(mapIt->second.front());
 
-            m_mtxPreviousGEI.lock();
-
-            // don't flush an item if it is the previous clGetEventInfo item for this thread
-            // this is necessary so that consecutive api collapsing/accumulating works
-            PreviousGEIMap::iterator iter = m_previousGEIMap.find(tid);
-
-            if (iter != m_previousGEIMap.end() && (iter->second == item))
-            {
-                m_mtxPreviousGEI.unlock();
-                break;
-            }
-
-            m_mtxPreviousGEI.unlock();
+            // the thread's following identical calls start a new entry
+            m_repeatedCalls.CloseRun(tid, item);
 
 #ifdef NON_BLOCKING_TIMEOUT
-            item->WriteTimestampEntry(foutTS, m_bTimeOutMode);
+            item->WriteTimestampEntry(*pFoutTS, m_bTimeOutMode);
 
             // append event handle to the line
             if ((item->m_apiType & CL_ENQUEUE_BASE_API) > 1)
@@ -191,13 +170,13 @@ void CLAPIInfoManager::FlushTraceData(bool bForceFlush)
 
                 if (pEnqAPI->GetAPISucceeded() && pEnqAPI->GetEvent() != NULL)
                 {
-                    foutTS << setw(25) << pEnqAPI->GetEvent()->m_clEventString;
+                    *pFoutTS << setw(25) << pEnqAPI->GetEvent()->GetEventString();
                 }
             }
 
-            foutTS << endl;
+            *pFoutTS << '\n';
 #else
-            bool isReady = item->WriteTimestampEntry(foutTS, m_bTimeOutMode);
+            bool isReady = item->WriteTimestampEntry(*pFoutTS, m_bTimeOutMode);
 
             if (!isReady)
             {
@@ -206,19 +185,19 @@ void CLAPIInfoManager::FlushTraceData(bool bForceFlush)
             }
             else
             {
-                foutTS << endl;
+                *pFoutTS << '\n';
             }
 
 #endif
 
             // If isReady, write API entry as well
-            item->WriteAPIEntry(foutTrace);
-            foutTrace << endl;
+            item->WriteAPIEntry(*pFoutTrace);
+            *pFoutTrace << '\n';
 
             if (bEnableStackTrace)
             {
-                item->WriteStackEntry(foutST);
-                foutST << endl;
+                item->WriteStackEntry(*pFoutST);
+                *pFoutST << '\n';
             }
 
             mapIt->second.pop_front();
@@ -234,14 +213,14 @@ void CLAPIInfoManager::FlushTraceData(bool bForceFlush)
                 delete item;
             }
         }
+    }
 
-        foutTrace.close();
-        foutTS.close();
+    m_fragmentWriters.EndFlush(m_bIsRunning);
 
-        if (bEnableStackTrace)
-        {
-            foutST.close();
-        }
+    if (GlobalSettings::GetInstance()->m_params.m_bStackTrace)
+    {
+        // the module map must list the modules referred to by the stack entries written so far
+        StackTracer::Instance()->WriteModuleMap(GetModuleMapFileName());
     }
 
     m_mtxFlush.unlock();
@@ -256,7 +235,27 @@ void CLAPIInfoManager::AddAPIInfoEntry(APIBase* api)
         return;
     }
 
-    if (IsCapReached())
+    bool bAPIStatisticsOnly = GlobalSettings::GetInstance()->m_params.m_bAPIStatisticsOnly;
+    bool bSampled = true;
+
+    if (m_apiSampler.IsEnabled())
+    {
+        // clCreateCommandQueue* and clCreateContext* calls are always recorded, the context summary depends on them
+        bSampled = CL_FUNC_TYPE_clCreateCommandQueue == en->m_type ||
+                   CL_FUNC_TYPE_clCreateCommandQueueWithProperties == en->m_type ||
+                   CL_FUNC_TYPE_clCreateContext == en->m_type ||
+                   CL_FUNC_TYPE_clCreateContextFromType == en->m_type ||
+                   m_apiSampler.ShouldRecord(en->m_type, en->m_ullStart, en->m_ullEnd);
+    }
+
+    if ((bAPIStatisticsOnly || m_apiSampler.IsEnabled()) && IsTracing())
+    {
+        m_apiStatistics.AddCall(en->m_type, en->m_ullStart, en->m_ullEnd);
+    }
+
+    // entries that are only counted in the API statistics, left out by the sampling policy, or dropped because
+    // of the pending entry limit, are handled the same way as entries past the cap
+    if (bAPIStatisticsOnly || !bSampled || IsCapReached() || (IsTracing() && !CheckPendingEntryLimit()))
     {
         // don't free clCreateCommandQueue, clCreateCommandQueueWithProperties, clCreateContext, and clCreateContextFromType since they may be referenced by future enqueue commands (in CLEnqueueAPIBase::GetContextInfo)
         if (nullptr != en &&
@@ -273,56 +272,16 @@ void CLAPIInfoManager::AddAPIInfoEntry(APIBase* api)
 
     en->m_tid = osGetUniqueCurrentThreadId();
 
-    // if the user has asked to collapse clGetEventInfo calls, track the previous API called and special case the clGetEventInfo calls
-    if (CLAPI_clGetEventInfo::ms_collapseCalls)
+    // if we're tracing, add the api
+    if (IsTracing())
     {
-        std::lock_guard<std::mutex> lock(m_mtxPreviousGEI);
-        PreviousGEIMap::iterator iter = m_previousGEIMap.find(en->m_tid);
-        bool bThreadFound = iter != m_previousGEIMap.end();
-
-        if (CL_FUNC_TYPE_clGetEventInfo == en->m_type)
+        // consecutive identical calls to a pollable API (clGetEventInfo) are collapsed into the entry of the first one
+        if (CollapseRepeatedCall(en))
         {
-            CLAPI_clGetEventInfo* clGetEventInfoAPI = static_cast<CLAPI_clGetEventInfo*>(en);
-
-            if (bThreadFound)
-            {
-                // do the parameters of the current call match the parameters of the previous call?
-                CLAPI_clGetEventInfo* prevEntry = iter->second;
-
-                SP_TODO("if in test mode, then collapse ALL consecutive calls, regardless of their parameters");
-
-                if (prevEntry->SameParameters(clGetEventInfoAPI))
-                {
-                    // increment the consecutive call count
-                    prevEntry->m_consecutiveCount++;
-                    // update the previous entry's end timestamp to match this entry's end timestamp
-                    prevEntry->m_ullEnd = en->m_ullEnd;
-                    // throw out this entry
-                    delete en;
-
-
-                    return;
-                }
-
-                // a clGetEventInfo call was made with different parameters -- update the previous call item in m_PreviousGEIMap
-                iter->second = clGetEventInfoAPI;
-            }
-            else
-            {
-                m_previousGEIMap.insert(PreviousGEIMapPair(en->m_tid, clGetEventInfoAPI));
-            }
-        }
-        else if (bThreadFound)
-        {
-            // a non-clGetEventInfo call was made -- erase the previous call item in the m_PreviousGEIMap
-            m_previousGEIMap.erase(iter->first);
+            delete en;
+            return;
         }
 
-    }
-
-    // if we're tracing, add the api
-    if (IsTracing())
-    {
         APIInfoManagerBase::AddTraceInfoEntry(en);
         m_uiLineNum++;
     }
@@ -342,99 +301,105 @@ void CLAPIInfoManager::AddAPIInfoEntry(APIBase* api)
 
 void CLAPIInfoManager::AddToCommandQueueMap(const cl_command_queue cmdQueue, const CLAPI_clCreateCommandQueueBase* cmdQueueAPIObj)
 {
-    SP_TODO("add scope lock")
-    CLCommandQueueMap::iterator it = m_clCommandQueueMap.find(cmdQueue);
-
-    if (it != m_clCommandQueueMap.end())
     {
-        it->second.push_back(cmdQueueAPIObj);
-        return;
+        std::lock_guard<std::mutex> lock(m_mtxCreateAPIs);
+        m_createCommandQueueAPIs.push_back(cmdQueueAPIObj);
     }
 
-    list<const CLAPI_clCreateCommandQueueBase*> queueList;
-    queueList.push_back(cmdQueueAPIObj);
-    m_clCommandQueueMap.insert(CLCommandQueueMapPair(cmdQueue, queueList));
+    // A command queue released by the application may share the pointer of a new one, the last one is used
+    if (!m_clCommandQueueMap.Set(cmdQueue, cmdQueueAPIObj))
+    {
+        Log(logERROR, "Failed to add command queue pair\n");
+    }
 }
 
 void CLAPIInfoManager::AddToContextMap(const cl_context context, const CLAPI_clCreateContextBase* contextAPIObj)
 {
-    //-----------------
-    CLContextMap::iterator it = m_clContextMap.find(context);
+    {
+        std::lock_guard<std::mutex> lock(m_mtxCreateAPIs);
+        m_createContextAPIs.push_back(contextAPIObj);
+    }
 
-    if (it != m_clContextMap.end())
+    if (!m_clContextMap.Set(context, contextAPIObj))
     {
-        it->second.push_back(contextAPIObj);
-        return;
+        Log(logERROR, "Failed to add context pair\n");
     }
+}
+
+void CLAPIInfoManager::RemoveFromCommandQueueMap(const cl_command_queue cmdQueue)
+{
+    // the clCreateCommandQueue object is kept for the output files, only the handle is removed
+    m_clCommandQueueMap.Remove(cmdQueue);
+}
 
-    list<const CLAPI_clCreateContextBase*> l;
-    l.push_back(contextAPIObj);
-    m_clContextMap.insert(CLContextMapPair(context, l));
+void CLAPIInfoManager::RemoveFromContextMap(const cl_context context)
+{
+    m_clContextMap.Remove(context);
 }
 
 const CLAPI_clCreateContextBase* CLAPIInfoManager::GetCreateContextAPIObj(const cl_context context)
 {
-    CLContextMap::iterator it = m_clContextMap.find(context);
+    const CLAPI_clCreateContextBase* contextAPIObj = NULL;
 
-    if (it != m_clContextMap.end() && it->second.size() > 0)
-    {
-        return it->second.back();
-    }
-    else
+    if (!m_clContextMap.Find(context, contextAPIObj) || NULL == contextAPIObj)
     {
         Log(logERROR, "Context pair not found\n");
         return NULL;
     }
+
+    return contextAPIObj;
 }
 
 const CLAPI_clCreateCommandQueueBase* CLAPIInfoManager::GetCreateCommandQueueAPIObj(const cl_command_queue cmdQueue)
 {
-    CLCommandQueueMap::iterator it = m_clCommandQueueMap.find(cmdQueue);
+    const CLAPI_clCreateCommandQueueBase* cmdQueueAPIObj = NULL;
 
-    if (it != m_clCommandQueueMap.end() && it->second.size() > 0)
-    {
-        return it->second.back();
-    }
-    else
+    if (!m_clCommandQueueMap.Find(cmdQueue, cmdQueueAPIObj) || NULL == cmdQueueAPIObj)
     {
         Log(logERROR, "Command queue pair not found\n");
         return NULL;
     }
+
+    return cmdQueueAPIObj;
 }
 
 void CLAPIInfoManager::AddToKernelMap(const cl_kernel kernel, const char* szName)
 {
-    CLKernelMap::iterator it = m_clKernelMap.find(kernel);
-
-    if (it != m_clKernelMap.end())
+    // Old kernel got deleted, new one shares the same pointer, the old one is replaced
+    if (!m_clKernelMap.Set(kernel, m_kernelNames.Intern(szName)))
     {
-        // Old kernel got deleted, new one shares the same pointer, replace the old one
-        m_clKernelMap[ kernel ] = szName;
-        return;
+        Log(logERROR, "Failed to add kernel pair\n");
     }
-
-    m_clKernelMap.insert(CLKernelMapPair(kernel, szName));
 }
 
+void CLAPIInfoManager::RemoveFromKernelMap(const cl_kernel kernel)
+{
+    m_clKernelMap.Remove(kernel);
+}
 
-std::string& CLAPIInfoManager::GetKernelName(const cl_kernel kernel)
+unsigned int CLAPIInfoManager::GetKernelNameID(const cl_kernel kernel)
 {
-    CLKernelMap::iterator it = m_clKernelMap.find(kernel);
+    unsigned int uiKernelNameID = INTERNED_STRING_EMPTY_ID;
 
-    if (it != m_clKernelMap.end())
-    {
-        return it->second;
-    }
-    else
+    if (!m_clKernelMap.Find(kernel, uiKernelNameID))
     {
         Log(logERROR, "Kernel pair not found\n");
-        static std::string emptyStr = "";
-        return emptyStr;
     }
+
+    return uiKernelNameID;
 }
 
 void CLAPIInfoManager::SaveToOutputFile()
 {
+    // the spill files are read by the Write*ToStream functions
+    StopSpillThread();
+
+    // non-timeout mode only uses m_TraceInfoMap[0]
+    DrainThreadTraceBuffers(m_TraceInfoMap[0]);
+    m_repeatedCalls.CloseRuns();
+
+    std::lock_guard<std::mutex> lock(m_mtxFlush);
+
     //*********************Atp file format*************************
     // TraceFileVersion=*.*
     // Application=
@@ -458,6 +423,7 @@ void CLAPIInfoManager::SaveToOutputFile()
     {
         Log(logWARNING, "Failed to open file: %s.\n", m_strOutputFile.c_str());
         cout << "Failed to generate .atp file: " << m_strOutputFile << ". Make sure you have permission to write to the path you specified." << endl;
+        RemoveSpillFiles();
         return;
     }
     else
@@ -477,18 +443,93 @@ void CLAPIInfoManager::SaveToOutputFile()
         {
             Log(logWARNING, "Failed to open file: %s.\n", stackFile.c_str());
             cout << "Failed to generate .atp file: " << stackFile << ". Make sure you have permission to write to the path you specified." << endl;
-            return;
         }
         else
         {
             WriteStackTraceDataToStream(fout1);
             fout1.close();
+            StackTracer::Instance()->WriteModuleMap(GetModuleMapFileName());
         }
     }
+
+    RemoveSpillFiles();
+}
+
+bool CLAPIInfoManager::ReleaseEvictedEntry(osThreadId tid, ITraceEntry* en)
+{
+    CLAPIBase* item = dynamic_cast<CLAPIBase*>(en);
+
+    m_repeatedCalls.CloseRun(tid, item);
+
+    // clCreateCommandQueue* and clCreateContext* entries are released with the command queue and context maps
+    if (nullptr != item &&
+        CL_FUNC_TYPE_clCreateCommandQueue != item->m_type &&
+        CL_FUNC_TYPE_clCreateCommandQueueWithProperties != item->m_type &&
+        CL_FUNC_TYPE_clCreateContext != item->m_type &&
+        CL_FUNC_TYPE_clCreateContextFromType != item->m_type)
+    {
+        delete item;
+    }
+
+    return true;
+}
+
+bool CLAPIInfoManager::CanSpillEntry(osThreadId tid, APIBase* pEntry)
+{
+    SP_UNREFERENCED_PARAMETER(tid);
+    CLAPIBase* item = dynamic_cast<CLAPIBase*>(pEntry);
+
+    if (nullptr == item)
+    {
+        return false;
+    }
+
+    CLEnqueueAPIBase* pEnqueueAPI = dynamic_cast<CLEnqueueAPIBase*>(item);
+
+    // the GPU timestamps of an enqueue command are set when its event completes
+    if (nullptr != pEnqueueAPI && pEnqueueAPI->GetAPISucceeded() && !pEnqueueAPI->IsReady())
+    {
+        return false;
+    }
+
+    return true;
+}
+
+void CLAPIInfoManager::ReleaseSpilledEntry(APIBase* pEntry)
+{
+    // clCreateCommandQueue* and clCreateContext* entries are released with the command queue and context maps
+    if (!IsQueueOrContextCreateAPI(pEntry))
+    {
+        delete pEntry;
+    }
+}
+
+bool CLAPIInfoManager::IsQueueOrContextCreateAPI(const ITraceEntry* pEntry)
+{
+    const CLAPIBase* item = dynamic_cast<const CLAPIBase*>(pEntry);
+
+    return nullptr != item &&
+           (item->m_type == CL_FUNC_TYPE_clCreateCommandQueue ||
+            item->m_type == CL_FUNC_TYPE_clCreateCommandQueueWithProperties ||
+            item->m_type == CL_FUNC_TYPE_clCreateContext ||
+            item->m_type == CL_FUNC_TYPE_clCreateContextFromType);
 }
 
 void CLAPIInfoManager::Release()
 {
+    m_mtxFlush.lock();
+    m_fragmentWriters.CloseAll();
+    m_mtxFlush.unlock();
+
+    ReportDroppedEntries();
+    LogAPISamplingSummary();
+
+    DrainThreadTraceBuffers(m_TraceInfoMap[0]);
+    ReleaseFlightRecorderWindows(m_TraceInfoMap[0]);
+
+    // entries written to the spill files are released like flushed entries in timeout mode
+    bool bKeepCreateAPIs = m_bTimeOutMode || !m_spilledEntries.empty();
+
     for (int i = 0; i < 2; i++)
     {
         for (TraceInfoMap::iterator mapIt = m_TraceInfoMap[i].begin(); mapIt != m_TraceInfoMap[i].end(); mapIt++)
@@ -497,12 +538,7 @@ void CLAPIInfoManager::Release()
             {
                 CLAPIBase* item = dynamic_cast<CLAPIBase*>(*listIt);
 
-                if ((!m_bTimeOutMode) ||
-                    (nullptr != item &&
-                     item->m_type != CL_FUNC_TYPE_clCreateCommandQueue &&
-                     item->m_type != CL_FUNC_TYPE_clCreateCommandQueueWithProperties &&
-                     item->m_type != CL_FUNC_TYPE_clCreateContext &&
-                     item->m_type != CL_FUNC_TYPE_clCreateContextFromType))
+                if ((!bKeepCreateAPIs) || (nullptr != item && !IsQueueOrContextCreateAPI(item)))
                 {
                     // if in timeout mode, don't delete clCreateCommandQueue* and clCreateContext* here
                     SAFE_DELETE(item);
@@ -511,37 +547,42 @@ void CLAPIInfoManager::Release()
         }
     }
 
-    if (m_bTimeOutMode)
+    if (bKeepCreateAPIs)
     {
+        std::lock_guard<std::mutex> lock(m_mtxCreateAPIs);
+
         // In time out mode, we keep clCreateCommandQueue API Object so that we can retrieve device name and etc
         // we need to remove all clCreateCommandQueue* API Object
-        for (CLCommandQueueMap::iterator it = m_clCommandQueueMap.begin(); it != m_clCommandQueueMap.end(); it++)
+        m_clCommandQueueMap.Clear();
+
+        for (list<const CLAPI_clCreateCommandQueueBase*>::iterator it = m_createCommandQueueAPIs.begin(); it != m_createCommandQueueAPIs.end(); it++)
         {
-            for (list<const CLAPI_clCreateCommandQueueBase*>::iterator lit = it->second.begin(); lit != it->second.end(); lit++)
-            {
-                SAFE_DELETE(*lit);
-            }
+            SAFE_DELETE(*it);
         }
 
-        m_clCommandQueueMap.clear();
+        m_createCommandQueueAPIs.clear();
 
         // In time out mode, we keep clCreateContext API Object so that we can retrieve device name and etc
         // we need to remove all clCreateContext API Object
-        for (CLContextMap::iterator it = m_clContextMap.begin(); it != m_clContextMap.end(); it++)
+        m_clContextMap.Clear();
+
+        for (list<const CLAPI_clCreateContextBase*>::iterator it = m_createContextAPIs.begin(); it != m_createContextAPIs.end(); it++)
         {
-            for (list<const CLAPI_clCreateContextBase*>::iterator lit = it->second.begin(); lit != it->second.end(); lit++)
-            {
-                SAFE_DELETE(*lit);
-            }
+            SAFE_DELETE(*it);
         }
 
-        m_clContextMap.clear();
+        m_createContextAPIs.clear();
     }
-    else
+
+    if (!m_bTimeOutMode)
     {
         for (list<ITraceEntry*>::iterator it = m_mustInterceptAPIList.begin(); it != m_mustInterceptAPIList.end(); ++it)
         {
-            SAFE_DELETE(*it);
+            // the create entries were released with the maps above if some entries were spilled
+            if (!bKeepCreateAPIs || !IsQueueOrContextCreateAPI(*it))
+            {
+                SAFE_DELETE(*it);
+            }
         }
     }
 
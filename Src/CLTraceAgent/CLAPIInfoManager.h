@@ -24,15 +24,12 @@
 #include "../CLCommon/CLFunctionDefs.h"
 #include "../Common/GlobalSettings.h"
 #include "../Common/ProfilerTimer.h"
+#include "../Common/ConcurrentHashMap.h"
+#include "../Common/InternedStringTable.h"
 
-typedef std::map<osThreadId, CLAPI_clGetEventInfo*> PreviousGEIMap;
-typedef std::pair<osThreadId, CLAPI_clGetEventInfo*> PreviousGEIMapPair;
-typedef std::map<const cl_command_queue, std::list<const CLAPI_clCreateCommandQueueBase*> > CLCommandQueueMap;
-typedef std::pair<const cl_command_queue, std::list<const CLAPI_clCreateCommandQueueBase*> > CLCommandQueueMapPair;
-typedef std::map<const cl_context, std::list<const CLAPI_clCreateContextBase*> > CLContextMap;
-typedef std::pair<const cl_context, std::list<const CLAPI_clCreateContextBase*> > CLContextMapPair;
-typedef std::map<const cl_kernel, std::string> CLKernelMap;
-typedef std::pair<const cl_kernel, std::string> CLKernelMapPair;
+typedef ConcurrentHashMap<cl_command_queue, const CLAPI_clCreateCommandQueueBase*> CLCommandQueueMap;
+typedef ConcurrentHashMap<cl_context, const CLAPI_clCreateContextBase*> CLContextMap;
+typedef ConcurrentHashMap<cl_kernel, unsigned int> CLKernelMap;
 typedef std::vector<cl_kernel> EnqueuedTaskList;
 
 /// Handle the response on the end of the timer
@@ -84,6 +81,14 @@ public:
     /// \param contextAPIObj CLAPI_clCreateContextBase pointer
     void AddToContextMap(const cl_context context, const CLAPI_clCreateContextBase* contextAPIObj);
 
+    /// Remove a command queue from m_clCommandQueueMap once the application released it for the last time
+    /// \param cmdQueue OpenCL command queue object
+    void RemoveFromCommandQueueMap(const cl_command_queue cmdQueue);
+
+    /// Remove a context from m_clContextMap once the application released it for the last time
+    /// \param context OpenCL context
+    void RemoveFromContextMap(const cl_context context);
+
     /// Get clCreateCommandQueueAPIObj from OpenCL command queue object
     /// \param cmdQueue OpenCL command queue object
     /// \return CLAPI_clCreateCommandQueueBase pointer
@@ -94,15 +99,35 @@ public:
     /// \return CLAPI_clCreateContextBase pointer
     const CLAPI_clCreateContextBase* GetCreateContextAPIObj(const cl_context context);
 
-    /// Add cl_kernel, name string pair to m_CLCommandQueueMap
+    /// Add cl_kernel, name string pair to m_clKernelMap, the name is interned
     /// \param kernel OpenCL kernel object
     /// \param szName kernel name string
     void AddToKernelMap(const cl_kernel kernel, const char* szName);
 
+    /// Remove a kernel from m_clKernelMap once the application released it for the last time
+    /// \param kernel OpenCL kernel object
+    void RemoveFromKernelMap(const cl_kernel kernel);
+
+    /// Get the interned kernel name ID from cl_kernel object
+    /// \param kernel OpenCL kernel object
+    /// \return kernel name ID, INTERNED_STRING_EMPTY_ID if the kernel is unknown
+    unsigned int GetKernelNameID(const cl_kernel kernel);
+
     /// Get kernel name string from cl_kernel object
     /// \param kernel OpenCL kernel object
     /// \return kernel name string
-    std::string& GetKernelName(const cl_kernel kernel);
+    const std::string& GetKernelName(const cl_kernel kernel)
+    {
+        return GetKernelNameFromID(GetKernelNameID(kernel));
+    }
+
+    /// Get kernel name string from an interned kernel name ID
+    /// \param uiKernelNameID kernel name ID returned by GetKernelNameID
+    /// \return kernel name string
+    const std::string& GetKernelNameFromID(unsigned int uiKernelNameID) const
+    {
+        return m_kernelNames.GetString(uiKernelNameID);
+    }
 
     /// Save to Atp File
     void SaveToOutputFile() override;
@@ -172,11 +197,32 @@ protected:
     /// \param strAPIName the name of the API to add to the filter
     void AddAPIToFilter(const std::string& strAPIName) override;
 
+    /// Release an entry dropped from a flight recorder window, clCreateCommandQueue* and clCreateContext* entries are kept
+    /// \param tid the thread id of the window
+    /// \param en the entry
+    /// \return true, the entry has been released
+    bool ReleaseEvictedEntry(osThreadId tid, ITraceEntry* en) override;
+
+    /// Check whether an entry can be written to the spill files
+    /// \param tid the thread id
+    /// \param pEntry the entry
+    /// \return false for enqueue commands that haven't completed
+    bool CanSpillEntry(osThreadId tid, APIBase* pEntry) override;
+
+    /// Release a spilled entry, clCreateCommandQueue* and clCreateContext* entries are kept for the enqueue commands that reference them
+    /// \param pEntry the entry
+    void ReleaseSpilledEntry(APIBase* pEntry) override;
+
 private:
 
     /// Constructor
     CLAPIInfoManager();
 
+    /// Check whether an entry is a clCreateCommandQueue* or clCreateContext* entry, these are also referenced by m_clCommandQueueMap and m_clContextMap
+    /// \param pEntry the entry
+    /// \return true if the entry creates a command queue or a context
+    static bool IsQueueOrContextCreateAPI(const ITraceEntry* pEntry);
+
     /// Update m_ullStart, m_ullEnd from m_APITimeInfoMap
     void Update() = delete;
 
@@ -190,12 +236,14 @@ private:
     CLAPIInfoManager& operator = (const CLAPIInfoManager& obj) = delete;
 
     unsigned int            m_uiLineNum;                ///< number of lines output to file
-    PreviousGEIMap          m_previousGEIMap;           ///< stl map that contains the previous CLAPI_clGetEventInfo instance for each thread
-    CLCommandQueueMap       m_clCommandQueueMap;        ///< stl map that maps from cl_command_queue to CLAPI_clCreateCommandQueue*
-    CLContextMap            m_clContextMap;             ///< stl map that maps from cl_context to CLAPI_clCreateContextBase*
-    CLKernelMap             m_clKernelMap;              ///< stl map that maps from cl_kernel to string
+    CLCommandQueueMap       m_clCommandQueueMap;        ///< registry that maps from cl_command_queue to the last CLAPI_clCreateCommandQueue* that returned it, looked up without lock by the enqueue APIs
+    CLContextMap            m_clContextMap;             ///< registry that maps from cl_context to the last CLAPI_clCreateContextBase* that returned it
+    CLKernelMap             m_clKernelMap;              ///< registry that maps from cl_kernel to interned kernel name ID
+    InternedStringTable     m_kernelNames;              ///< kernel names referenced by m_clKernelMap
+    std::list<const CLAPI_clCreateCommandQueueBase*> m_createCommandQueueAPIs; ///< all clCreateCommandQueue* API objects added to m_clCommandQueueMap, released in timeout mode
+    std::list<const CLAPI_clCreateContextBase*> m_createContextAPIs;           ///< all clCreateContext* API objects added to m_clContextMap, released in timeout mode
+    std::mutex              m_mtxCreateAPIs;            ///< mutex protecting m_createCommandQueueAPIs and m_createContextAPIs
     EnqueuedTaskList        m_enqueuedTasks;            ///< stl vector containing the clEnqueueTask apis
-    std::mutex              m_mtxPreviousGEI;           ///< mutex used to lock access to m_PreviousGEIMap
     std::mutex              m_mtxEnqueuedTask;          ///< mutex used to lock access to m_enqueuedTasks
     std::set<CL_FUNC_TYPE>  m_filterAPIs;               ///< OpenCL APIs that are disabled in the trace, if API is not in m_MustInterceptAPIs list, the API will not be intercept, otherwise, API is intercepted but it won't show up in trace file.
     std::set<CL_FUNC_TYPE>  m_mustInterceptAPIs;        ///< Some of the APIs like clCreateContext, clCreateCommandQueue and etc are not able to be disabled.
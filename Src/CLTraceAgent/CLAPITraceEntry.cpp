@@ -31,10 +31,9 @@ bool g_bQueryRetStat = false;
 /// \return the address of the CL_API_TRACE_ version for the specified extension function
 void* AssignExtensionFunctionPointer(const char* pFuncName, void* pRealFuncPtr);
 
-void SetGlobalTraceFlags(bool queryRetStat, bool collapseClGetEventInfo)
+void SetGlobalTraceFlags(bool queryRetStat)
 {
     g_bQueryRetStat = queryRetStat;
-    CLAPI_clGetEventInfo::ms_collapseCalls = collapseClGetEventInfo;
 }
 
 cl_int CL_API_CALL CL_API_TRACE_clGetPlatformIDs(
@@ -357,12 +356,21 @@ cl_int CL_API_CALL CL_API_TRACE_clReleaseContext(cl_context  context)
 {
     CLAPI_clReleaseContext* pAPIInfo = new(nothrow) CLAPI_clReleaseContext();
 
+    // the last release destroys the context, a new one may then get the same handle
+    cl_uint uiRefCount = 0;
+    bool bLastRelease = CL_SUCCESS == g_nextDispatchTable.GetContextInfo(context, CL_CONTEXT_REFERENCE_COUNT, sizeof(cl_uint), &uiRefCount, NULL) && 1 == uiRefCount;
+
     ULONGLONG ullStart = CLAPIInfoManager::Instance()->GetTimeNanosStart(pAPIInfo);
 
     cl_int ret = g_nextDispatchTable.ReleaseContext(context);
 
     ULONGLONG ullEnd = CLAPIInfoManager::Instance()->GetTimeNanosEnd(pAPIInfo);
 
+    if (CL_SUCCESS == ret && bLastRelease)
+    {
+        CLAPIInfoManager::Instance()->RemoveFromContextMap(context);
+    }
+
     SpAssertRet(pAPIInfo != NULL) ret;
 
     pAPIInfo->Create(ullStart,
@@ -531,12 +539,21 @@ cl_int CL_API_CALL CL_API_TRACE_clReleaseCommandQueue(cl_command_queue  command_
 {
     CLAPI_clReleaseCommandQueue* pAPIInfo = new(nothrow) CLAPI_clReleaseCommandQueue();
 
+    // the last release destroys the command queue, a new one may then get the same handle
+    cl_uint uiRefCount = 0;
+    bool bLastRelease = CL_SUCCESS == g_nextDispatchTable.GetCommandQueueInfo(command_queue, CL_QUEUE_REFERENCE_COUNT, sizeof(cl_uint), &uiRefCount, NULL) && 1 == uiRefCount;
+
     ULONGLONG ullStart = CLAPIInfoManager::Instance()->GetTimeNanosStart(pAPIInfo);
 
     cl_int ret = g_nextDispatchTable.ReleaseCommandQueue(command_queue);
 
     ULONGLONG ullEnd = CLAPIInfoManager::Instance()->GetTimeNanosEnd(pAPIInfo);
 
+    if (CL_SUCCESS == ret && bLastRelease)
+    {
+        CLAPIInfoManager::Instance()->RemoveFromCommandQueueMap(command_queue);
+    }
+
     SpAssertRet(pAPIInfo != NULL) ret;
 
     pAPIInfo->Create(ullStart,
@@ -1566,12 +1583,21 @@ cl_int CL_API_CALL CL_API_TRACE_clReleaseKernel(cl_kernel    kernel)
 {
     CLAPI_clReleaseKernel* pAPIInfo = new(nothrow) CLAPI_clReleaseKernel();
 
+    // the last release destroys the kernel, a new one may then get the same handle
+    cl_uint uiRefCount = 0;
+    bool bLastRelease = CL_SUCCESS == g_nextDispatchTable.GetKernelInfo(kernel, CL_KERNEL_REFERENCE_COUNT, sizeof(cl_uint), &uiRefCount, NULL) && 1 == uiRefCount;
+
     ULONGLONG ullStart = CLAPIInfoManager::Instance()->GetTimeNanosStart(pAPIInfo);
 
     cl_int ret = g_nextDispatchTable.ReleaseKernel(kernel);
 
     ULONGLONG ullEnd = CLAPIInfoManager::Instance()->GetTimeNanosEnd(pAPIInfo);
 
+    if (CL_SUCCESS == ret && bLastRelease)
+    {
+        CLAPIInfoManager::Instance()->RemoveFromKernelMap(kernel);
+    }
+
     SpAssertRet(pAPIInfo != NULL) ret;
 
     pAPIInfo->Create(ullStart,
@@ -19,7 +19,7 @@
 #include <string>
 
 void CreateAPITraceDispatchTable(cl_icd_dispatch_table& dispatchTable);
-void SetGlobalTraceFlags(bool queryRetStat, bool collapseClGetEventInfo);
+void SetGlobalTraceFlags(bool queryRetStat);
 
 // @}
 
@@ -22,6 +22,7 @@
 #include <Defs.h>
 #include <ATPFileUtils.h>
 #include <ProfilerOutputFileDefs.h>
+#include <CompressedStream.h>
 // CL Common
 #include <CLFunctionEnumDefs.h>
 #include <CLUtils.h>
@@ -555,7 +556,7 @@ bool CLAtpFilePart::LoadGPUTimestampRaw(const string& strFile, EventMap& vTimest
     return true;
 }
 
-CLAtpFilePart::CLAtpFilePart(const Config& config, bool shouldReleaseMemory) : IAtpFilePart(config, shouldReleaseMemory)
+CLAtpFilePart::CLAtpFilePart(const Config& config, bool shouldReleaseMemory) : IAtpFilePart(config, shouldReleaseMemory), m_bAPISampled(false)
 {
     m_strPartName = CL_PART_NAME;
     m_sections.push_back(CL_PART_NAME ATP_API_TRACE_OUTPUT);
@@ -596,7 +597,7 @@ CLAtpFilePart::~CLAtpFilePart(void)
 bool CLAtpFilePart::MergeTimestamp(const string& strFile, EventMap& vTimestamps, vector<CLAPIInfo*>& apis)
 {
     char buf[BUFSIZE];
-    ifstream fin(strFile.c_str());
+    InputFileStream fin(strFile.c_str());
 
     if (!fin.is_open())
     {
@@ -797,6 +798,11 @@ void CLAtpFilePart::WriteHeaderSection(SP_fileStream& sout)
     ReadExcludedAPIs(m_config.strAPIFilterFile, excludedAPIs);
     WriteExcludedAPIs(sout, "CL", excludedAPIs);
 
+    if (HasAPISamplingDirectives(m_config.strAPIFilterFile))
+    {
+        sout << "CL" << FILE_HEADER_API_SAMPLING << "=True" << std::endl;
+    }
+
     // Write platforms
     CLPlatformSet platformInfo;
 
@@ -1033,6 +1039,7 @@ bool CLAtpFilePart::Parse(std::istream& in, std::string& outErrorMsg)
                                 // There is one space between the last argument and comment
                                 SP_TODO("When Qt client is in place, revisit this issue.");
                                 pAPIInfo->m_strComment = pAPIInfo->m_strComment.substr(0, commentStart) + ")";
+                                pAPIInfo->ParseRepeatedCallComment(pAPIInfo->m_strComment);
 
                                 // Remove the comment from the API string:
                                 apiTraceStr = apiTraceStr.substr(0, commentStart) + ")";
@@ -1144,6 +1151,10 @@ bool CLAtpFilePart::ParseHeader(const std::string& strKey, const std::string& st
         m_excludedAPIs.clear();
         StringUtils::Split(m_excludedAPIs, strVal, string(","), true, true);
     }
+    else if (string::npos != strKey.find("CL" FILE_HEADER_API_SAMPLING))
+    {
+        m_bAPISampled = strVal.find("True") != string::npos;
+    }
 
     return true;
 }
@@ -88,6 +88,10 @@ public:
     /// \return True if succeeded
     bool ParseHeader(const std::string& strKey, const std::string& strVal);
 
+    /// Check whether calls were left out of the trace by an API sampling policy
+    /// \return true if the API summary has to be built from the API statistics file
+    bool IsAPISampled() const { return m_bAPISampled; }
+
 private:
     /// Update tmp timestamp file
     /// \param strTmpFilePath Tmp file path
@@ -107,6 +111,7 @@ private:
 
     std::vector<std::string> m_excludedAPIs;  ///< excluded APIs
     CLAPIInfoMap m_CLAPIInfoMap;              ///< API Map key = threadID
+    bool m_bAPISampled;                       ///< flag indicating whether the trace was recorded with an API sampling policy
 };
 
 // The following functions to be factored into CLAtpFilePart::Parse()
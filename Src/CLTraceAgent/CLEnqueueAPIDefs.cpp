@@ -1760,11 +1760,16 @@ cl_int CLAPI_clEnqueueNDRangeKernel::Create(
     }
 
     // get kernel name
-    m_strKernelName = CLAPIInfoManager::Instance()->GetKernelName(m_kernel);
+    m_uiKernelNameID = CLAPIInfoManager::Instance()->GetKernelNameID(m_kernel);
 
     return m_retVal;
 }
 
+const std::string& CLAPI_clEnqueueNDRangeKernel::GetKernelName() const
+{
+    return CLAPIInfoManager::Instance()->GetKernelNameFromID(m_uiKernelNameID);
+}
+
 bool CLAPI_clEnqueueNDRangeKernel::WriteTimestampEntry(std::ostream& sout, bool bTimeout)
 {
     bool bRet = CLEnqueueAPIBase::WriteTimestampEntry(sout, bTimeout);
@@ -1887,6 +1892,9 @@ cl_int CLAPI_clEnqueueTask::Create(
         m_pEvent = CLEventManager::Instance()->UpdateEvent(*pTmpEvent, bUserEvent, this);
     }
 
+    // get kernel name
+    m_uiKernelNameID = CLAPIInfoManager::Instance()->GetKernelNameID(m_kernel);
+
     return m_retVal;
 }
 
@@ -1906,9 +1914,8 @@ bool CLAPI_clEnqueueTask::WriteTimestampEntry(std::ostream& sout, bool bTimeout)
 
     // print out kernel name and kernel handle
     const cl_kernel kernel = GetKernel();
-    std::string strKernelName = CLAPIInfoManager::Instance()->GetKernelName(kernel);
     sout << setw(25) << StringUtils::ToHexString(kernel);
-    sout << strKernelName;
+    sout << CLAPIInfoManager::Instance()->GetKernelNameFromID(m_uiKernelNameID);
 
     // output {1} for both global and local work size
     sout << "      {1}     {1}        ";
@@ -20,6 +20,7 @@
 #include "CLTraceAgent.h"
 #include "../CLCommon/CLFunctionDefs.h"
 #include "../Common/StringUtils.h"
+#include "../Common/InternedStringTable.h"
 
 #ifdef CL_TRACE_TEST
     #include "../../../RCP-Internal/Src/Tests/CLAPITraceTest/CLAPITraceTest.h"
@@ -1700,6 +1701,7 @@ public:
         m_global_work_offset = nullptr;
         m_global_work_size = nullptr;
         m_local_work_size = nullptr;
+        m_uiKernelNameID = INTERNED_STRING_EMPTY_ID;
     }
 
     /// Destructor
@@ -1795,10 +1797,9 @@ public:
         return m_local_work_size;
     }
 
-    std::string GetKernelName() const
-    {
-        return m_strKernelName;
-    }
+    /// Get the name of the kernel
+    /// \return the kernel name
+    const std::string& GetKernelName() const;
 
     bool WriteTimestampEntry(std::ostream& sout, bool bTimeout) override;
 
@@ -1819,7 +1820,7 @@ private:
     size_t*     m_local_work_size;               ///< parameter for clEnqueueNDRangeKernel
     cl_event    m_event;                         ///< parameter for clEnqueueNDRangeKernel
     cl_int      m_retVal;                        ///< return value
-    std::string m_strKernelName;                 ///< kernel name
+    unsigned int m_uiKernelNameID;               ///< interned kernel name ID (see CLAPIInfoManager::GetKernelNameFromID)
 };
 
 //------------------------------------------------------------------------------------
@@ -1829,7 +1830,10 @@ class CLAPI_clEnqueueTask : public CLEnqueueAPIBase
 {
 public:
     /// Constructor
-    CLAPI_clEnqueueTask() = default;
+    CLAPI_clEnqueueTask()
+    {
+        m_uiKernelNameID = INTERNED_STRING_EMPTY_ID;
+    }
 
     /// Destructor
     ~CLAPI_clEnqueueTask()
@@ -1896,9 +1900,10 @@ private:
     /// \return a reference of the object
     CLAPI_clEnqueueTask& operator = (const CLAPI_clEnqueueTask& obj) = delete;
 
-    cl_kernel m_kernel; ///< parameter for clEnqueueTask
-    cl_event  m_event;  ///< parameter for clEnqueueTask
-    cl_int    m_retVal; ///< return value
+    cl_kernel    m_kernel;         ///< parameter for clEnqueueTask
+    cl_event     m_event;          ///< parameter for clEnqueueTask
+    cl_int       m_retVal;         ///< return value
+    unsigned int m_uiKernelNameID; ///< interned kernel name ID, the kernel may be released before the entry is written
 };
 
 //------------------------------------------------------------------------------------
@@ -96,6 +96,9 @@ static void CL_CALLBACK EventStatusChanged(cl_agent* agent, cl_event event, cl_i
             case CL_COMPLETE:
                 clEvent->m_ullComplete = ts;
                 clEvent->m_bIsReady = true;
+
+                // The command type is written with the timestamps, query it while the event is still valid
+                clEvent->GetCommandType();
                 clEvent->m_pEvent = nullptr;
 
                 // If no owner is set it's a blocking event, it will be removed in CLEventManager::UpdateEvent
@@ -46,13 +46,10 @@ void CLEvent::Unmap()
 
 CLEventManager::CLEventManager(void)
 {
-    m_pMtx = new(nothrow) std::recursive_mutex();
-    SpAssert(m_pMtx != NULL);
 }
 
 CLEventManager::~CLEventManager(void)
 {
-    SAFE_DELETE(m_pMtx);
 }
 
 void CLEventManager::FlushTraceData(bool bForceFlush)
@@ -97,9 +94,14 @@ void CLEventManager::FlushTraceData(bool bForceFlush)
 
 CLEventRawInfo* CLEventManager::AddEventRawInfo(cl_event event, cl_int status, cl_long ts)
 {
-    if (CLAPIInfoManager::Instance()->IsCapReached())
+    if (CLAPIInfoManager::Instance()->IsCapReached() || GlobalSettings::GetInstance()->m_params.m_bAPIStatisticsOnly)
+    {
+        // Do not allocate more memory if max number of APIs are traced or if the API calls are only counted.
+        return nullptr;
+    }
+
+    if (!CheckPendingEntryLimit())
     {
-        // Do not allocate more memory if max number of APIs are traced.
         return nullptr;
     }
 
@@ -116,31 +118,35 @@ CLEventRawInfo* CLEventManager::AddEventRawInfo(cl_event event, cl_int status, c
 
 CLEventPtr CLEventManager::AddEvent(cl_event event)
 {
-    std::lock_guard<std::recursive_mutex> lock(*m_pMtx);
-
     if (nullptr != event)
     {
-        CLEventMap::iterator it = m_clEventMap.find(event);
+        EventMapShard& shard = GetShard(event);
+        std::unique_lock<std::mutex> lock(shard.m_mtx);
+
+        CLEventMap::iterator it = shard.m_clEventMap.find(event);
 
-        if (it != m_clEventMap.end())
+        if (it != shard.m_clEventMap.end())
         {
+            CLEventPtr en = it->second;
+            lock.unlock();
+
             cl_uint refC;
             GetRealDispatchTable()->GetEventInfo(event, CL_EVENT_REFERENCE_COUNT, sizeof(cl_uint), &refC, nullptr);
-            Log(logWARNING, "Event(0x%p) is already in EventManager. Ref = %d. IsUserEvent = %s. \n", event, refC, (it->second->m_bIsUserEvent ? "True" : "False"));
-            return it->second;
+            Log(logWARNING, "Event(0x%p) is already in EventManager. Ref = %d. IsUserEvent = %s. \n", event, refC, (en->m_bIsUserEvent ? "True" : "False"));
+            return en;
         }
-        else
-        {
-            CLEventPtr en(new(std::nothrow) CLEvent);
-            en->SetClEvent(event);
-            m_clEventMap.insert(CLEventMapPair(event, en));
 
-            // User events need to be retained.
-            // Non user events are over incremented here, they are released in UpdateEvent
-            GetRealDispatchTable()->RetainEvent(event);
-        }
+        CLEventPtr en(new(std::nothrow) CLEvent);
+        SpAssertRet(nullptr != en) nullptr;
+
+        en->SetClEvent(event);
+        shard.m_clEventMap.insert(CLEventMapPair(event, en));
 
-        return m_clEventMap[event];
+        // User events need to be retained.
+        // Non user events are over incremented here, they are released in UpdateEvent
+        GetRealDispatchTable()->RetainEvent(event);
+
+        return en;
     }
     else
     {
@@ -151,66 +157,82 @@ CLEventPtr CLEventManager::AddEvent(cl_event event)
 
 void CLEventManager::RemoveEvent(cl_event event)
 {
-    std::lock_guard<std::recursive_mutex> lock(*m_pMtx);
+    EventMapShard& shard = GetShard(event);
+    bool bRemoved = false;
 
-    CLEventMap::iterator eventIter = m_clEventMap.find(event);
+    {
+        std::lock_guard<std::mutex> lock(shard.m_mtx);
+        bRemoved = shard.m_clEventMap.erase(event) > 0;
+    }
 
-    if (m_clEventMap.end() != eventIter)
+    if (bRemoved)
     {
         GetRealDispatchTable()->ReleaseEvent(event);
-        m_clEventMap.erase(eventIter);
     }
 }
 
 CLEventPtr CLEventManager::UpdateEvent(cl_event event, bool isUserEvent, CLEnqueueAPIBase* owner)
 {
-    std::lock_guard<std::recursive_mutex> lock(*m_pMtx);
-
     CLEventPtr clEvent(nullptr);
 
     if (nullptr != event)
     {
-        CLEventMap::iterator it = m_clEventMap.find(event);
+        EventMapShard& shard = GetShard(event);
+        int numReleases = 0;
 
-        if (it != m_clEventMap.end())
         {
-            // Update CLEvent
-            clEvent = it->second;
-            clEvent->m_pOwner = owner;
-            clEvent->m_bIsUserEvent = isUserEvent;
+            std::lock_guard<std::mutex> lock(shard.m_mtx);
 
-            if (false == isUserEvent)
-            {
-                // Non user events are over incremented in AddEVent, release it here
-                GetRealDispatchTable()->ReleaseEvent(event);
-            }
+            CLEventMap::iterator it = shard.m_clEventMap.find(event);
 
-            // If the event is ready, it's a blocking event, it needs to be removed from the event manager
-            if (clEvent->m_bIsReady)
+            if (it != shard.m_clEventMap.end())
             {
-                RemoveEvent(event);
+                // Update CLEvent
+                clEvent = it->second;
+                clEvent->m_pOwner = owner;
+                clEvent->m_bIsUserEvent = isUserEvent;
+
+                if (false == isUserEvent)
+                {
+                    // Non user events are over incremented in AddEVent, release it here
+                    numReleases++;
+                }
+
+                // If the event is ready, it's a blocking event, it needs to be removed from the event manager
+                if (clEvent->m_bIsReady)
+                {
+                    shard.m_clEventMap.erase(it);
+                    numReleases++;
+                }
             }
-        }
-        else // event hasn't been added using AddEvent
-        {
-            // Event should be added to event managed in cl callback
-            Log(logWARNING, "Event(0x%p) not managed by EventManager.\n Added to EventManager now\n", event);
-            clEvent = std::move(CLEventPtr(new(std::nothrow) CLEvent));
-            clEvent->m_bIsUserEvent = isUserEvent;
-            clEvent->SetClEvent(event);
-            clEvent->m_pOwner = owner;
-
-            if (isUserEvent)
+            else // event hasn't been added using AddEvent
             {
-                // add ref counter by one so that user can't release it
-                GetRealDispatchTable()->RetainEvent(event);
+                // Event should be added to event managed in cl callback
+                Log(logWARNING, "Event(0x%p) not managed by EventManager.\n Added to EventManager now\n", event);
+                clEvent = std::move(CLEventPtr(new(std::nothrow) CLEvent));
+                SpAssertRet(nullptr != clEvent) nullptr;
+
+                clEvent->m_bIsUserEvent = isUserEvent;
+                clEvent->SetClEvent(event);
+                clEvent->m_pOwner = owner;
+
+                if (isUserEvent)
+                {
+                    // add ref counter by one so that user can't release it
+                    GetRealDispatchTable()->RetainEvent(event);
+                }
+
+                // If the event is ready, it's a blocking event, no need to track it in the event manager
+                if (false == clEvent->m_bIsReady)
+                {
+                    shard.m_clEventMap.insert(CLEventMapPair(event, clEvent));
+                }
             }
+        }
 
-            // If the event is ready, it's a blocking event, no need to track it in the event manager
-            if (false == clEvent->m_bIsReady)
-            {
-                m_clEventMap.insert(CLEventMapPair(event, clEvent));
-            }
+        for (int i = 0; i < numReleases; i++)
+        {
+            GetRealDispatchTable()->ReleaseEvent(event);
         }
     }
     else
@@ -223,11 +245,12 @@ CLEventPtr CLEventManager::UpdateEvent(cl_event event, bool isUserEvent, CLEnque
 
 CLEventPtr CLEventManager::GetCLEvent(cl_event event)
 {
-    std::lock_guard<std::recursive_mutex> lock(*m_pMtx);
+    EventMapShard& shard = GetShard(event);
+    std::lock_guard<std::mutex> lock(shard.m_mtx);
 
-    CLEventMap::iterator it = m_clEventMap.find(event);
+    CLEventMap::iterator it = shard.m_clEventMap.find(event);
 
-    if (it != m_clEventMap.end())
+    if (it != shard.m_clEventMap.end())
     {
         return it->second;
     }
@@ -240,16 +263,22 @@ CLEventPtr CLEventManager::GetCLEvent(cl_event event)
 
 void CLEventManager::Release()
 {
-    for (CLEventMap::iterator it = m_clEventMap.begin(); it != m_clEventMap.end(); ++it)
+    for (int i = 0; i < CL_EVENT_MAP_NUM_SHARDS; i++)
     {
-        if ((nullptr != it->second->m_pEvent) && (nullptr != it->second->m_pOwner))
-        {
-            // If pOwner == NULL, we never retain it or this event is not created by us
-            cl_int res = GetRealDispatchTable()->ReleaseEvent(it->second->m_pEvent);
+        EventMapShard& shard = m_eventMapShards[i];
+        std::lock_guard<std::mutex> lock(shard.m_mtx);
 
-            if (CL_SUCCESS != res)
+        for (CLEventMap::iterator it = shard.m_clEventMap.begin(); it != shard.m_clEventMap.end(); ++it)
+        {
+            if ((nullptr != it->second->m_pEvent) && (nullptr != it->second->m_pOwner))
             {
-                Log(logWARNING, "CLEventManager::Release() failed\n");
+                // If pOwner == NULL, we never retain it or this event is not created by us
+                cl_int res = GetRealDispatchTable()->ReleaseEvent(it->second->m_pEvent);
+
+                if (CL_SUCCESS != res)
+                {
+                    Log(logWARNING, "CLEventManager::Release() failed\n");
+                }
             }
         }
     }
@@ -261,25 +290,30 @@ void CLEventManager::Debug(std::string& strFileName)
 {
     ofstream fout(strFileName.c_str());
 
-    for (CLEventMap::iterator it = m_clEventMap.begin(); it != m_clEventMap.end(); ++it)
+    for (int i = 0; i < CL_EVENT_MAP_NUM_SHARDS; i++)
     {
-        if (!it->second->m_ullRunning == 0)
-        {
-            //fout << it->second.
-            cl_command_type cmd_type;
-            GetRealDispatchTable()->GetEventInfo(it->second->m_pEvent, CL_EVENT_COMMAND_TYPE, sizeof(cl_command_type), &cmd_type, nullptr);
-            fout << cmd_type << "   ";
-            fout << CLStringUtils::GetCommandTypeString(cmd_type) << "   ";
-            fout << it->second->m_ullQueued << "   ";
-            fout << it->second->m_ullSubmitted << "   ";
-            fout << it->second->m_ullRunning << "   ";
-            fout << it->second->m_ullComplete << "   " << endl;
-        }
-        else
+        EventMapShard& shard = m_eventMapShards[i];
+        std::lock_guard<std::mutex> lock(shard.m_mtx);
+
+        for (CLEventMap::iterator it = shard.m_clEventMap.begin(); it != shard.m_clEventMap.end(); ++it)
         {
-            Log(logWARNING, "Event(0x%p) callback never triggered. API Type: %s\n",
-                it->second->m_pEvent,
-                CLStringUtils::GetCLAPINameString(it->second->m_pOwner->m_type).c_str());
+            if (!it->second->m_ullRunning == 0)
+            {
+                //fout << it->second.
+                cl_command_type cmd_type = it->second->GetCommandType();
+                fout << cmd_type << "   ";
+                fout << CLStringUtils::GetCommandTypeString(cmd_type) << "   ";
+                fout << it->second->m_ullQueued << "   ";
+                fout << it->second->m_ullSubmitted << "   ";
+                fout << it->second->m_ullRunning << "   ";
+                fout << it->second->m_ullComplete << "   " << endl;
+            }
+            else
+            {
+                Log(logWARNING, "Event(0x%p) callback never triggered. API Type: %s\n",
+                    it->second->m_pEvent,
+                    CLStringUtils::GetCLAPINameString(it->second->m_pOwner->m_type).c_str());
+            }
         }
     }
 
@@ -20,6 +20,7 @@
 #include <string>
 #include <unordered_map>
 #include <mutex>
+#include <atomic>
 #include <CL/opencl.h>
 #include "../Common/Defs.h"
 #include "../Common/LocalTSingleton.h"
@@ -42,8 +43,8 @@ struct CLEvent
     ULONGLONG m_ullCPUQueued; ///< CPU timestamp: got from callback func
     CLEnqueueAPIBase* m_pOwner; ///< Owner
     bool m_bIsReady; ///< Is this command finished
-    cl_command_type m_clCommandType; ///< The OpenCL command type
-    std::string m_clEventString; ///< The string representation of the OpenCL event
+    cl_event m_clEventHandle; ///< cl_event obj pointer, unlike m_pEvent it is kept once the command has completed
+    std::atomic<cl_command_type> m_clCommandType; ///< The OpenCL command type, 0 until it is queried (see GetCommandType)
 
     /// Default constructor
     CLEvent()
@@ -79,8 +80,8 @@ struct CLEvent
         m_ullCPUQueued = obj.m_ullCPUQueued;
         m_pOwner = obj.m_pOwner;
         m_bIsReady = obj.m_bIsReady;
-        m_clCommandType = obj.m_clCommandType;
-        m_clEventString = obj.m_clEventString;
+        m_clEventHandle = obj.m_clEventHandle;
+        m_clCommandType.store(obj.m_clCommandType.load(std::memory_order_relaxed), std::memory_order_relaxed);
     }
 
     /// Assignment operator
@@ -99,32 +100,49 @@ struct CLEvent
             m_ullCPUQueued = obj.m_ullCPUQueued;
             m_pOwner = obj.m_pOwner;
             m_bIsReady = obj.m_bIsReady;
-            m_clCommandType = obj.m_clCommandType;
-            m_clEventString = obj.m_clEventString;
+            m_clEventHandle = obj.m_clEventHandle;
+            m_clCommandType.store(obj.m_clCommandType.load(std::memory_order_relaxed), std::memory_order_relaxed);
         }
 
         return *this;
     }
 
+    /// Set the cl_event obj, the command type is only queried when it is needed
+    /// \param clEvent cl_event obj
     void SetClEvent(cl_event clEvent)
     {
         m_pEvent = clEvent;
+        m_clEventHandle = clEvent;
+        m_clCommandType.store(0, std::memory_order_relaxed);
+    }
 
-        if (NULL == m_pEvent)
-        {
-            m_clCommandType = 0;
-        }
-        else
+    /// Get the OpenCL command type, it is queried from the runtime the first time while the command hasn't completed
+    /// \return the command type, 0 if it is unknown
+    cl_command_type GetCommandType()
+    {
+        cl_command_type commandType = m_clCommandType.load(std::memory_order_relaxed);
+        cl_event clEvent = m_pEvent;
+
+        if (0 == commandType && NULL != clEvent)
         {
-            GetRealDispatchTable()->GetEventInfo(
-                clEvent,
-                CL_EVENT_COMMAND_TYPE,
-                sizeof(cl_command_type),
-                &(m_clCommandType),
-                nullptr);
+            if (CL_SUCCESS == GetRealDispatchTable()->GetEventInfo(clEvent, CL_EVENT_COMMAND_TYPE, sizeof(cl_command_type), &commandType, nullptr))
+            {
+                m_clCommandType.store(commandType, std::memory_order_relaxed);
+            }
+            else
+            {
+                commandType = 0;
+            }
         }
 
-        m_clEventString = StringUtils::ToHexString(m_pEvent);
+        return commandType;
+    }
+
+    /// Get the string representation of the OpenCL event
+    /// \return the event handle as a hex string
+    std::string GetEventString() const
+    {
+        return StringUtils::ToHexString(m_clEventHandle);
     }
 };
 
@@ -145,8 +163,14 @@ public:
 typedef std::unordered_map<cl_event, CLEventPtr> CLEventMap;
 typedef CLEventMap::value_type CLEventMapPair;
 
+/// Number of shards of the event map (a power of two), the events are spread over the shards by their address
+#define CL_EVENT_MAP_NUM_SHARDS 64
+
 //------------------------------------------------------------------------------------
 /// This class keeps trace of OpenCL events. It maintains any event dependencies.
+/// The events are kept in a sharded map: the application threads and the runtime
+/// callbacks only contend when they access events of the same shard, and the
+/// runtime is never called with a shard locked, except to retain an event.
 //------------------------------------------------------------------------------------
 class CLEventManager : public TraceInfoManager, public TSingleton<CLEventManager>
 {
@@ -211,8 +235,25 @@ private:
     /// \return lhs
     CLEventManager& operator= (const CLEventManager& obj) = delete;
 
-    CLEventMap m_clEventMap;                  ///< events map
-    std::recursive_mutex* m_pMtx;             ///< mutex for m_clEventMap
+    /// Shard of the events map
+    struct EventMapShard
+    {
+        CLEventMap m_clEventMap;              ///< events of the shard
+        std::mutex m_mtx;                     ///< mutex protecting m_clEventMap
+    };
+
+    /// Get the shard of an event
+    /// \param event cl_event obj
+    /// \return the shard the event belongs to
+    EventMapShard& GetShard(cl_event event)
+    {
+        // cl_event objects are heap allocated, the low bits of their addresses are always the same
+        size_t hash = reinterpret_cast<size_t>(event);
+        hash ^= hash >> 17;
+        return m_eventMapShards[(hash >> 4) & (CL_EVENT_MAP_NUM_SHARDS - 1)];
+    }
+
+    EventMapShard m_eventMapShards[CL_EVENT_MAP_NUM_SHARDS]; ///< events map
 };
 
 // @}
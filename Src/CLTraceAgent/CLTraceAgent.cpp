@@ -20,6 +20,7 @@
 #include "../Common/Version.h"
 #include "../Common/OSUtils.h"
 #include "../Common/StackTracer.h"
+#include "../Common/TraceEntryAllocator.h"
 
 using namespace std;
 using namespace GPULogger;
@@ -35,18 +36,30 @@ void DumpTrace()
     {
         alreadyDumped = true;
 
-        if (!CLAPIInfoManager::Instance()->IsTimeOutMode())
+        if (GlobalSettings::GetInstance()->m_params.m_bAPIStatisticsOnly)
+        {
+            CLAPIInfoManager::Instance()->WriteAPIStatistics();
+        }
+        else if (!CLAPIInfoManager::Instance()->IsTimeOutMode())
         {
             CLAPIInfoManager::Instance()->SaveToOutputFile();
         }
 
         CLEventManager::Instance()->Release();
         CLAPIInfoManager::Instance()->Release();
+        TraceEntryAllocator::LogStatistics();
+        OSUtils::Instance()->LogTSCTimerStatistics();
     }
 }
 
 extern "C" DLL_PUBLIC void amdtCodeXLStopProfiling()
 {
+    if (CLAPIInfoManager::Instance()->IsFlightRecorderMode())
+    {
+        // write the calls that led up to this point
+        TraceInfoManager::TriggerFlightRecorderDump();
+    }
+
     CLAPIInfoManager::Instance()->StopTracing();
 }
 
@@ -55,6 +68,13 @@ extern "C" DLL_PUBLIC void amdtCodeXLResumeProfiling()
     CLAPIInfoManager::Instance()->ResumeTracing();
 }
 
+// On Windows, we can't dump data in OnUnload() because of ocl runtime bug.
+// Also exported on Linux, where RCPAgentBench calls it to write the output file
+extern "C" DLL_PUBLIC void OnExitProcess()
+{
+    DumpTrace();
+}
+
 #ifdef _WIN32
     #include <windows.h>
 #endif
@@ -76,12 +96,6 @@ LONG CALLBACK TestModeExceptionHandler(PEXCEPTION_POINTERS except_info)
     return EXCEPTION_CONTINUE_SEARCH;
 }
 
-// On Windows, we can't dump data in OnUnload() because of ocl runtime bug
-extern "C" DLL_PUBLIC void OnExitProcess()
-{
-    DumpTrace();
-}
-
 BOOL APIENTRY DllMain(HMODULE,
                       DWORD   ul_reason_for_call,
                       LPVOID)
@@ -213,11 +227,13 @@ clAgent_OnLoad(cl_agent* agent)
     }
 
     OSUtils::Instance()->SetupUserTimer(params);
+    OSUtils::Instance()->SetupTSCTimer(params);
 
     StackTracer::Instance()->InitSymPath();
+    StackTracer::Instance()->SetOfflineSymbols(params.m_bOfflineSymbols);
     CLAPIInfoManager::Instance()->SetOutputFile(params.m_strOutputFile);
     GlobalSettings::GetInstance()->m_params = params;
-    SetGlobalTraceFlags(params.m_bQueryRetStat, params.m_bCollapseClGetEventInfo);
+    SetGlobalTraceFlags(params.m_bQueryRetStat);
 
     if (!params.m_strAPIFilterFile.empty())
     {
@@ -10,11 +10,14 @@
 
 // std
 #include <string>
+#include <cstdlib>
+#include <cstring>
 
 // Common
 #include <AMDTOSWrappers/Include/osOSDefinitions.h>
 
 #include "Defs.h"
+#include "ProfilerOutputFileDefs.h"
 
 //------------------------------------------------------------------------------------
 /// API Info
@@ -27,6 +30,43 @@ public:
 
     /// Virtual destructor
     virtual ~APIInfo(void) {}
+
+    /// Parse the comment of an entry that collapses a run of identical calls ("<number of calls> consecutive calls, <total time> ns")
+    /// \param strComment the comment, without the comment delimiters
+    /// \return true if the comment is a repeated call comment, m_uiRepeatCount and m_ullRepeatTime are then set
+    bool ParseRepeatedCallComment(const std::string& strComment)
+    {
+        size_t pos = strComment.find(ATP_REPEATED_CALLS_COMMENT_COUNT);
+
+        if (std::string::npos == pos || 0 == pos)
+        {
+            return false;
+        }
+
+        m_uiRepeatCount = static_cast<unsigned int>(strtoul(strComment.c_str(), nullptr, 10));
+        pos += strlen(ATP_REPEATED_CALLS_COMMENT_COUNT);
+
+        // clGetEventInfo entries of older traces only have the number of calls
+        if (0 == strComment.compare(pos, strlen(ATP_REPEATED_CALLS_COMMENT_TIME), ATP_REPEATED_CALLS_COMMENT_TIME))
+        {
+            m_ullRepeatTime = strtoull(strComment.c_str() + pos + strlen(ATP_REPEATED_CALLS_COMMENT_TIME), nullptr, 10);
+        }
+
+        return m_uiRepeatCount > 0;
+    }
+
+    /// Get the total time of the calls of the entry
+    /// \return the time of the call, or of all calls of a collapsed run
+    ULONGLONG GetTotalTime() const
+    {
+        if (m_uiRepeatCount > 1 && m_ullRepeatTime > 0)
+        {
+            return m_ullRepeatTime;
+        }
+
+        return m_ullEnd > m_ullStart ? m_ullEnd - m_ullStart : 0;
+    }
+
 public:
     ULONGLONG m_ullStart = 0;               ///< Start time stamp
     ULONGLONG m_ullEnd = 0;                 ///< End time stamp
@@ -37,6 +77,8 @@ public:
     std::string m_strRet;                   ///< Return value string
     std::string m_strName;                  ///< API Name
     std::string m_argList;                  ///< Argument List
+    unsigned int m_uiRepeatCount = 1;       ///< Number of identical consecutive calls collapsed into this entry, m_ullEnd is the end of the last one
+    ULONGLONG m_ullRepeatTime = 0;          ///< Total time of the calls collapsed into this entry, 0 if unknown
 };
 
 #endif // _API_INFO_H_
@@ -14,6 +14,9 @@
 #include <sstream>
 #include <iomanip>
 #include <mutex>
+#include <set>
+#include <algorithm>
+#include <cstdio>
 #include <math.h>
 
 #include <AMDTOSWrappers/Include/osProcess.h>
@@ -28,6 +31,7 @@
 #include "StackTracer.h"
 #include "ATPFileUtils.h"
 #include "ProfilerOutputFileDefs.h"
+#include "TraceEntryAllocator.h"
 
 using namespace std;
 using namespace GPULogger;
@@ -36,7 +40,32 @@ void APIBase::WriteAPIEntry(std::ostream& sout)
 {
     sout << GetRetString() << " = ";
     sout << m_strName << " ( ";
-    sout << ToString() << " )";
+    sout << GetArgString() << " )";
+}
+
+std::string APIBase::GetArgString()
+{
+    if (m_uiRepeatCount <= 1)
+    {
+        return ToString();
+    }
+
+    std::ostringstream ss;
+    ss << ToString() << " /*" << m_uiRepeatCount << ATP_REPEATED_CALLS_COMMENT_COUNT
+       << ATP_REPEATED_CALLS_COMMENT_TIME << m_ullRepeatTime << ATP_REPEATED_CALLS_COMMENT_TIME_UNIT << "*/";
+    return ss.str();
+}
+
+void APIBase::AddRepeatedCall(const APIBase* pRepeat)
+{
+    if (1 == m_uiRepeatCount)
+    {
+        m_ullRepeatTime = m_ullEnd > m_ullStart ? m_ullEnd - m_ullStart : 0;
+    }
+
+    m_uiRepeatCount++;
+    m_ullRepeatTime += pRepeat->m_ullEnd > pRepeat->m_ullStart ? pRepeat->m_ullEnd - pRepeat->m_ullStart : 0;
+    m_ullEnd = pRepeat->m_ullEnd;
 }
 
 bool APIBase::WriteTimestampEntry(std::ostream& sout, bool bTimeout)
@@ -56,38 +85,104 @@ bool APIBase::WriteTimestampEntry(std::ostream& sout, bool bTimeout)
 
 void APIBase::WriteStackEntry(std::ostream& sout)
 {
-    if (m_pStackEntry == NULL)
+    CallSite* pCallSite = CallSiteTable::Instance()->GetCallSite(m_uiCallSiteID);
+
+    if (pCallSite == NULL)
     {
         // place holder
         sout << m_strName;
         return;
     }
 
-    sout << m_strName << "\t";
+    std::lock_guard<std::mutex> lock(pCallSite->m_mtx);
+
+    if (!pCallSite->m_bStackEntryCreated)
+    {
+        pCallSite->m_pStackEntry = CreateStackEntry(pCallSite->m_stack);
+        pCallSite->m_bStackEntryCreated = true;
+    }
 
-    if (m_pStackEntry->m_strSymName.empty())
+    const StackEntry* pStackEntry = pCallSite->m_pStackEntry;
+
+    if (pStackEntry == NULL)
+    {
+        // place holder
+        sout << m_strName;
+        return;
+    }
+
+    sout << m_strName << "\t" << CALL_SITE_ID_PREFIX << m_uiCallSiteID;
+
+    // the stack entry is written once per thread, the thread's next APIs from the same call site only refer to it
+    if (!pCallSite->m_writtenTids.insert(m_tid).second)
+    {
+        return;
+    }
+
+    sout << "\t";
+
+    std::string strRawAddress;
+
+    if (StackTracer::Instance()->GetRawAddress(pStackEntry->m_dwAddress, strRawAddress))
+    {
+        // offline symbolization mode, rcprof replaces the raw address by the symbol info
+        sout << strRawAddress;
+    }
+    else if (pStackEntry->m_strSymName.empty())
     {
-        sout << m_pStackEntry->m_strSymAddr << "+";
-        sout << StringUtils::ToHexString(m_pStackEntry->m_dwDisplacement);
+        sout << pStackEntry->m_strSymAddr << "+";
+        sout << StringUtils::ToHexString(pStackEntry->m_dwDisplacement);
     }
     else
     {
-        string newSymName = StringUtils::Replace(m_pStackEntry->m_strSymName, " ", string(SPACE));
+        string newSymName = StringUtils::Replace(pStackEntry->m_strSymName, " ", string(SPACE));
         sout << newSymName << "\t";
-        sout << m_pStackEntry->m_dwLineNum << "\t";
-        string newFileName = StringUtils::Replace(m_pStackEntry->m_strFile, " ", string(SPACE));
+        sout << pStackEntry->m_dwLineNum << "\t";
+        string newFileName = StringUtils::Replace(pStackEntry->m_strFile, " ", string(SPACE));
         sout << newFileName;
     }
 }
 
+void* APIBase::operator new(size_t size)
+{
+    void* p = TraceEntryAllocator::Allocate(size);
+
+    if (nullptr == p)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void* APIBase::operator new(size_t size, const std::nothrow_t&) throw()
+{
+    return TraceEntryAllocator::Allocate(size);
+}
+
+void APIBase::operator delete(void* p)
+{
+    TraceEntryAllocator::Free(p);
+}
+
+void APIBase::operator delete(void* p, const std::nothrow_t&) throw()
+{
+    TraceEntryAllocator::Free(p);
+}
+
 APIInfoManagerBase::APIInfoManagerBase(void) :
-    TraceInfoManager()
+    TraceInfoManager(),
+    m_llSpillThreshold(0),
+    m_tidSpill(0),
+    m_bSpillRequested(false),
+    m_bSpillThreadStopped(false)
 {
     m_strTraceModuleName.clear();
 }
 
 APIInfoManagerBase::~APIInfoManagerBase(void)
 {
+    StopSpillThread();
 }
 
 std::string APIInfoManagerBase::GetTempFileName(const osProcessId& pid, const osThreadId& tid, const std::string& strExtension)
@@ -121,36 +216,61 @@ std::string APIInfoManagerBase::GetTempFileName(const osProcessId& pid, const os
     return ss.str();
 }
 
+std::string APIInfoManagerBase::GetModuleMapFileName()
+{
+    if (!m_bTimeOutMode)
+    {
+        return FileUtils::GetBaseFileName(m_strOutputFile) + MODULE_MAP_EXT;
+    }
+
+    // File name: pid.modname.modmap, next to the stack trace fragments
+    stringstream ss;
+
+    if (GlobalSettings::GetInstance()->m_params.m_strOutputFile.empty())
+    {
+        ss << FileUtils::GetDefaultOutputPath();
+    }
+    else
+    {
+        ss << FileUtils::GetTempFragFilePath();
+    }
+
+    ss << osGetCurrentProcessId() << "." << m_strTraceModuleName << MODULE_MAP_EXT;
+
+    return ss.str();
+}
+
 void APIInfoManagerBase::FlushTraceData(bool bForceFlush)
 {
     SP_UNREFERENCED_PARAMETER(bForceFlush);
+    WriteAPIStatistics();
     m_mtxFlush.lock();
     osProcessId pid = osGetCurrentProcessId();
     TraceInfoMap& nonActiveMap = m_TraceInfoMap[ 1 - m_iActiveMap ];
 
     for (TraceInfoMap::iterator mapIt = nonActiveMap.begin(); mapIt != nonActiveMap.end(); mapIt++)
     {
-        osThreadId tid = mapIt->first;
+        if (mapIt->second.empty())
+        {
+            continue;
+        }
 
-        string tmpTraceFile = GetTempFileName(pid, tid, TMP_TRACE_EXT);
-        string tmpTimestampFile = GetTempFileName(pid, tid, TMP_TIME_STAMP_EXT);
+        osThreadId tid = mapIt->first;
 
         bool bEnableStackTrace = GlobalSettings::GetInstance()->m_params.m_bStackTrace && StackTracer::Instance()->IsInitialized();
-        string tmpStackTraceFile;
-        ofstream foutST;
+        ostream* pFoutST = nullptr;
 
         if (bEnableStackTrace)
         {
-            tmpStackTraceFile = GetTempFileName(pid, tid, TMP_TRACE_STACK_EXT);
-            foutST.open(tmpStackTraceFile.c_str(), fstream::out | fstream::app);
-            bEnableStackTrace = !foutST.fail();
+            pFoutST = m_fragmentWriters.GetWriter(GetTempFileName(pid, tid, TMP_TRACE_STACK_EXT));
+            bEnableStackTrace = nullptr != pFoutST;
         }
 
-        // Open file for append
-        ofstream foutTrace(tmpTraceFile.c_str(), fstream::out | fstream::app);
-        ofstream foutTS(tmpTimestampFile.c_str(), fstream::out | fstream::app);
+        // Get the files, they stay open between flushes (see FragmentWriterCache)
+        ostream* pFoutTrace = m_fragmentWriters.GetWriter(GetTempFileName(pid, tid, TMP_TRACE_EXT));
+        ostream* pFoutTS = m_fragmentWriters.GetWriter(GetTempFileName(pid, tid, TMP_TIME_STAMP_EXT));
 
-        if (foutTrace.fail() || foutTS.fail())
+        if (nullptr == pFoutTrace || nullptr == pFoutTS)
         {
             continue;
         }
@@ -159,43 +279,56 @@ void APIInfoManagerBase::FlushTraceData(bool bForceFlush)
         {
             APIBase* item =  dynamic_cast<APIBase*>(mapIt->second.front());
 
+            // the thread's following identical calls start a new entry
+            m_repeatedCalls.CloseRun(tid, item);
+
+            // lines end with '\n' rather than endl so that the stream buffers aren't flushed for every entry
             //WriteTimestampEntry(foutTS, item, !bForceFlush);
-            item->WriteTimestampEntry(foutTS, m_bTimeOutMode);
-            foutTS << endl;
+            item->WriteTimestampEntry(*pFoutTS, m_bTimeOutMode);
+            *pFoutTS << '\n';
 
             // If isReady, write API entry as well
             //WriteAPIEntry(foutTrace, item);
-            item->WriteAPIEntry(foutTrace);
-            foutTrace << endl;
+            item->WriteAPIEntry(*pFoutTrace);
+            *pFoutTrace << '\n';
 
             if (bEnableStackTrace)
             {
                 //WriteStackEntry(foutST, item);
-                item->WriteStackEntry(foutST);
-                foutST << endl;
+                item->WriteStackEntry(*pFoutST);
+                *pFoutST << '\n';
             }
 
             mapIt->second.pop_front();
 
             delete item;
         }
-
-        foutTrace.close();
-        foutTS.close();
-
-        if (bEnableStackTrace)
-        {
-            foutST.close();
-        }
     }
 
     FlushNonAPITimestampData(pid);
 
+    m_fragmentWriters.EndFlush(m_bIsRunning);
+
+    if (GlobalSettings::GetInstance()->m_params.m_bStackTrace)
+    {
+        // the module map must list the modules referred to by the stack entries written so far
+        StackTracer::Instance()->WriteModuleMap(GetModuleMapFileName());
+    }
+
     m_mtxFlush.unlock();
 }
 
 void APIInfoManagerBase::SaveToOutputFile()
 {
+    // the spill files are read by the Write*ToStream functions
+    StopSpillThread();
+
+    // non-timeout mode only uses m_TraceInfoMap[0]
+    DrainThreadTraceBuffers(m_TraceInfoMap[0]);
+    m_repeatedCalls.CloseRuns();
+
+    std::lock_guard<std::mutex> lock(m_mtxFlush);
+
     //*********************Atp file format*************************
     // TraceFileVersion=*.*
     // Application=
@@ -219,6 +352,7 @@ void APIInfoManagerBase::SaveToOutputFile()
     {
         Log(logWARNING, "Failed to open file: %s.\n", m_strOutputFile.c_str());
         cout << "Failed to generate .atp file: " << m_strOutputFile << ". Make sure you have permission to write to the path you specified." << endl;
+        RemoveSpillFiles();
         return;
     }
     else
@@ -238,14 +372,309 @@ void APIInfoManagerBase::SaveToOutputFile()
         {
             Log(logWARNING, "Failed to open file: %s.\n", stackFile.c_str());
             cout << "Failed to generate .atp file: " << stackFile << ". Make sure you have permission to write to the path you specified." << endl;
-            return;
         }
         else
         {
             WriteStackTraceDataToStream(fout1);
             fout1.close();
+            StackTracer::Instance()->WriteModuleMap(GetModuleMapFileName());
         }
     }
+
+    RemoveSpillFiles();
+}
+
+void APIInfoManagerBase::WriteAPIStatistics()
+{
+    if (GlobalSettings::GetInstance()->m_params.m_bAPIStatisticsOnly || m_apiSampler.IsEnabled())
+    {
+        std::lock_guard<std::mutex> lock(m_mtxFlush);
+
+        // <base>.<modName>.atp -> <base>.<modName>.apistats
+        m_apiStatistics.WriteToFile(FileUtils::GetBaseFileName(m_strOutputFile) + "." + API_STATISTICS_EXT, m_strTraceModuleName);
+    }
+}
+
+void APIInfoManagerBase::AddTraceInfoEntry(ITraceEntry* en)
+{
+    unsigned int uiLatencyTrigger = GlobalSettings::GetInstance()->m_params.m_uiFlightRecorderLatencyTrigger;
+    bool bTriggerDump = false;
+
+    if (0 != uiLatencyTrigger && IsFlightRecorderMode())
+    {
+        // the entry can be flushed by the timer thread once it is added
+        APIBase* pAPI = static_cast<APIBase*>(en);
+        bTriggerDump = pAPI->m_ullEnd > pAPI->m_ullStart && (pAPI->m_ullEnd - pAPI->m_ullStart) / 1000 > uiLatencyTrigger;
+    }
+
+    TraceInfoManager::AddTraceInfoEntry(en);
+
+    if (bTriggerDump)
+    {
+        TriggerFlightRecorderDump();
+    }
+
+    long long llSpillEntries = static_cast<long long>(GlobalSettings::GetInstance()->m_params.m_uiSpillEntryThreshold);
+
+    if (!m_bTimeOutMode && 0 != llSpillEntries && GetNumPendingEntries() >= std::max(llSpillEntries, m_llSpillThreshold.load(std::memory_order_relaxed)))
+    {
+        RequestSpill();
+    }
+}
+
+void APIInfoManagerBase::RequestSpill()
+{
+    // the flag stays set until the spill is done, the threads adding entries in the meantime don't lock the mutex
+    if (m_bSpillRequested.exchange(true))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mtxSpillRequest);
+
+    if (m_bSpillThreadStopped)
+    {
+        return;
+    }
+
+    if (0 == m_tidSpill)
+    {
+        m_tidSpill = OSUtils::Instance()->CreateThread(SpillThreadFunc, this);
+
+        if (0 == m_tidSpill)
+        {
+            // the flag is left set, the entries are kept in memory
+            Log(logERROR, "APIInfoManager: unable to create the spill thread, all entries are kept in memory\n");
+            return;
+        }
+    }
+
+    m_cvSpillRequest.notify_one();
+}
+
+void APIInfoManagerBase::StopSpillThread()
+{
+    THREADHANDLE tidSpill = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtxSpillRequest);
+        m_bSpillThreadStopped = true;
+        tidSpill = m_tidSpill;
+        m_tidSpill = 0;
+    }
+
+    m_cvSpillRequest.notify_all();
+
+    if (0 != tidSpill)
+    {
+        OSUtils::Instance()->Join(tidSpill);
+    }
+}
+
+void APIInfoManagerBase::SpillThreadFunc(void* pParam)
+{
+    APIInfoManagerBase* pThis = static_cast<APIInfoManagerBase*>(pParam);
+    std::unique_lock<std::mutex> lock(pThis->m_mtxSpillRequest);
+
+    while (true)
+    {
+        pThis->m_cvSpillRequest.wait(lock, [pThis]()
+        {
+            return pThis->m_bSpillRequested.load() || pThis->m_bSpillThreadStopped;
+        });
+
+        if (pThis->m_bSpillThreadStopped)
+        {
+            break;
+        }
+
+        lock.unlock();
+        pThis->SpillTraceData();
+
+        // the spill threshold has been raised, the next request comes once it is reached
+        pThis->m_bSpillRequested = false;
+        lock.lock();
+    }
+}
+
+void APIInfoManagerBase::SpillTraceData()
+{
+    std::lock_guard<std::mutex> lockFlush(m_mtxFlush);
+
+    // take the entries whose data is final out of the trace map, keeping the order of each thread's entries
+    TraceInfoMap spillMap;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtxTracemap);
+        DrainThreadTraceBuffers(m_TraceInfoMap[0]);
+
+        for (TraceInfoMap::iterator mapIt = m_TraceInfoMap[0].begin(); mapIt != m_TraceInfoMap[0].end(); ++mapIt)
+        {
+            list<ITraceEntry*>::iterator listIt = mapIt->second.begin();
+
+            while (listIt != mapIt->second.end() && CanSpillEntry(mapIt->first, dynamic_cast<APIBase*>(*listIt)))
+            {
+                m_repeatedCalls.CloseRun(mapIt->first, dynamic_cast<APIBase*>(*listIt));
+                ++listIt;
+            }
+
+            if (listIt != mapIt->second.begin())
+            {
+                list<ITraceEntry*>& spillList = spillMap[mapIt->first];
+                spillList.splice(spillList.end(), mapIt->second, mapIt->second.begin(), listIt);
+            }
+        }
+    }
+
+    osProcessId pid = osGetCurrentProcessId();
+    bool bStackTrace = GlobalSettings::GetInstance()->m_params.m_bStackTrace;
+    size_t numSpilled = 0;
+
+    for (TraceInfoMap::iterator mapIt = spillMap.begin(); mapIt != spillMap.end(); ++mapIt)
+    {
+        osThreadId tid = mapIt->first;
+        ostream* pFoutTrace = m_fragmentWriters.GetWriter(GetTempFileName(pid, tid, TMP_SPILL_TRACE_EXT));
+        ostream* pFoutTS = m_fragmentWriters.GetWriter(GetTempFileName(pid, tid, TMP_SPILL_TIME_STAMP_EXT));
+        ostream* pFoutST = bStackTrace ? m_fragmentWriters.GetWriter(GetTempFileName(pid, tid, TMP_SPILL_STACK_EXT)) : nullptr;
+
+        if (nullptr == pFoutTrace || nullptr == pFoutTS || (bStackTrace && nullptr == pFoutST))
+        {
+            // keep the entries in memory, in front of the entries added since they were taken out
+            std::lock_guard<std::mutex> lock(m_mtxTracemap);
+            list<ITraceEntry*>& threadEntries = m_TraceInfoMap[0][tid];
+            threadEntries.splice(threadEntries.begin(), mapIt->second);
+            continue;
+        }
+
+        m_spilledEntries[tid] += mapIt->second.size();
+        numSpilled += mapIt->second.size();
+
+        for (list<ITraceEntry*>::iterator listIt = mapIt->second.begin(); listIt != mapIt->second.end(); ++listIt)
+        {
+            // same lines as the Write*ToStream functions
+            APIBase* item = dynamic_cast<APIBase*>(*listIt);
+            item->WriteAPIEntry(*pFoutTrace);
+            *pFoutTrace << '\n';
+            item->WriteTimestampEntry(*pFoutTS, m_bTimeOutMode);
+            *pFoutTS << '\n';
+
+            if (bStackTrace)
+            {
+                item->WriteStackEntry(*pFoutST);
+                *pFoutST << '\n';
+            }
+
+            ReleaseSpilledEntry(item);
+        }
+
+        mapIt->second.clear();
+    }
+
+    m_fragmentWriters.EndFlush(false);
+    RemovePendingEntries(numSpilled);
+
+    // entries that can't be spilled yet don't count towards the next spill
+    long long llSpillEntries = static_cast<long long>(GlobalSettings::GetInstance()->m_params.m_uiSpillEntryThreshold);
+    m_llSpillThreshold = GetNumPendingEntries() + llSpillEntries;
+
+    Log(logMESSAGE, "APIInfoManager: %llu entries written to the spill files, %lld entries kept in memory\n",
+        static_cast<unsigned long long>(numSpilled), GetNumPendingEntries());
+}
+
+bool APIInfoManagerBase::CanSpillEntry(osThreadId tid, APIBase* pEntry)
+{
+    SP_UNREFERENCED_PARAMETER(tid);
+    return nullptr != pEntry;
+}
+
+void APIInfoManagerBase::ReleaseSpilledEntry(APIBase* pEntry)
+{
+    SAFE_DELETE(pEntry);
+}
+
+bool APIInfoManagerBase::ReleaseEvictedEntry(osThreadId tid, ITraceEntry* en)
+{
+    m_repeatedCalls.CloseRun(tid, dynamic_cast<APIBase*>(en));
+    return TraceInfoManager::ReleaseEvictedEntry(tid, en);
+}
+
+bool APIInfoManagerBase::CollapseRepeatedCall(APIBase* pEntry)
+{
+    if (!GlobalSettings::GetInstance()->m_params.m_bCollapseClGetEventInfo)
+    {
+        return false;
+    }
+
+    return m_repeatedCalls.AddCall(pEntry);
+}
+
+std::set<osThreadId> APIInfoManagerBase::GetTraceThreadIds(const TraceInfoMap& traceInfoMap) const
+{
+    std::set<osThreadId> threadIds;
+
+    for (TraceInfoMap::const_iterator mapIt = traceInfoMap.begin(); mapIt != traceInfoMap.end(); ++mapIt)
+    {
+        threadIds.insert(mapIt->first);
+    }
+
+    for (std::map<osThreadId, size_t>::const_iterator it = m_spilledEntries.begin(); it != m_spilledEntries.end(); ++it)
+    {
+        threadIds.insert(it->first);
+    }
+
+    return threadIds;
+}
+
+size_t APIInfoManagerBase::GetNumThreadEntries(const TraceInfoMap& traceInfoMap, osThreadId tid) const
+{
+    size_t numEntries = 0;
+    TraceInfoMap::const_iterator mapIt = traceInfoMap.find(tid);
+
+    if (mapIt != traceInfoMap.end())
+    {
+        numEntries += mapIt->second.size();
+    }
+
+    std::map<osThreadId, size_t>::const_iterator it = m_spilledEntries.find(tid);
+
+    if (it != m_spilledEntries.end())
+    {
+        numEntries += it->second;
+    }
+
+    return numEntries;
+}
+
+void APIInfoManagerBase::CopySpillFile(std::ostream& sout, osThreadId tid, const std::string& strExtension)
+{
+    if (m_spilledEntries.find(tid) == m_spilledEntries.end())
+    {
+        return;
+    }
+
+    string strFileName = GetTempFileName(osGetCurrentProcessId(), tid, strExtension);
+    ifstream fin(strFileName.c_str(), fstream::in | fstream::binary);
+
+    // copying an empty file would set the failbit of the output stream
+    if (fin.fail() || ifstream::traits_type::eof() == fin.peek())
+    {
+        Log(logWARNING, "Failed to read spill file: %s\n", strFileName.c_str());
+        return;
+    }
+
+    sout << fin.rdbuf();
+}
+
+void APIInfoManagerBase::RemoveSpillFiles()
+{
+    osProcessId pid = osGetCurrentProcessId();
+
+    for (std::map<osThreadId, size_t>::const_iterator it = m_spilledEntries.begin(); it != m_spilledEntries.end(); ++it)
+    {
+        remove(GetTempFileName(pid, it->first, TMP_SPILL_TRACE_EXT).c_str());
+        remove(GetTempFileName(pid, it->first, TMP_SPILL_TIME_STAMP_EXT).c_str());
+        remove(GetTempFileName(pid, it->first, TMP_SPILL_STACK_EXT).c_str());
+    }
 }
 
 void APIInfoManagerBase::LoadAPIFilterFile(const std::string& strFileName)
@@ -256,8 +685,18 @@ void APIInfoManagerBase::LoadAPIFilterFile(const std::string& strFileName)
     for (vector<string>::iterator it = tmpArr.begin(); it != tmpArr.end(); ++it)
     {
         string name = StringUtils::Trim(*it);
-        AddAPIToFilter(name);
+
+        if (APISampler::IsDirective(name))
+        {
+            m_apiSampler.AddDirective(name);
+        }
+        else
+        {
+            AddAPIToFilter(name);
+        }
     }
+
+    m_apiSampler.ApplyPolicies();
 }
 
 void APIInfoManagerBase::WriteTimestampToStream(std::ostream& sout)
@@ -274,14 +713,21 @@ void APIInfoManagerBase::WriteTimestampToStream(std::ostream& sout)
     TraceInfoMap& activeMap = m_TraceInfoMap[ 0 ];
     sout << ATP_SECTION_HEADER_START_END << m_strTraceModuleName << ATP_TIMESSTAMP_OUTPUT ATP_SECTION_HEADER_START_END << endl;
 
-    for (TraceInfoMap::iterator mapIt = activeMap.begin(); mapIt != activeMap.end(); ++mapIt)
+    std::set<osThreadId> threadIds = GetTraceThreadIds(activeMap);
+
+    for (std::set<osThreadId>::const_iterator tidIt = threadIds.begin(); tidIt != threadIds.end(); ++tidIt)
     {
         // Thread ID
-        sout << mapIt->first << endl;
+        sout << *tidIt << endl;
         // Number of APIs
-        sout << mapIt->second.size() << endl;
+        sout << GetNumThreadEntries(activeMap, *tidIt) << endl;
 
-        for (list<ITraceEntry*>::iterator listIt = mapIt->second.begin(); listIt != mapIt->second.end(); ++listIt)
+        // entries spilled to disk come first
+        CopySpillFile(sout, *tidIt, TMP_SPILL_TIME_STAMP_EXT);
+
+        list<ITraceEntry*>& entries = activeMap[*tidIt];
+
+        for (list<ITraceEntry*>::iterator listIt = entries.begin(); listIt != entries.end(); ++listIt)
         {
             APIBase* en = dynamic_cast<APIBase*>(*listIt);
             en->WriteTimestampEntry(sout, m_bTimeOutMode);
@@ -296,14 +742,20 @@ void APIInfoManagerBase::WriteAPITraceDataToStream(std::ostream& sout)
     TraceInfoMap& activeMap = m_TraceInfoMap[ 0 ];
     sout << ATP_SECTION_HEADER_START_END << m_strTraceModuleName << ATP_API_TRACE_OUTPUT ATP_SECTION_HEADER_START_END << endl;
 
-    for (TraceInfoMap::iterator mapIt = activeMap.begin(); mapIt != activeMap.end(); ++mapIt)
+    std::set<osThreadId> threadIds = GetTraceThreadIds(activeMap);
+
+    for (std::set<osThreadId>::const_iterator tidIt = threadIds.begin(); tidIt != threadIds.end(); ++tidIt)
     {
         // Thread ID
-        sout << mapIt->first << endl;
+        sout << *tidIt << endl;
         // Number of APIs
-        sout << mapIt->second.size() << endl;
+        sout << GetNumThreadEntries(activeMap, *tidIt) << endl;
 
-        for (list<ITraceEntry*>::iterator listIt = mapIt->second.begin(); listIt != mapIt->second.end(); ++listIt)
+        CopySpillFile(sout, *tidIt, TMP_SPILL_TRACE_EXT);
+
+        list<ITraceEntry*>& entries = activeMap[*tidIt];
+
+        for (list<ITraceEntry*>::iterator listIt = entries.begin(); listIt != entries.end(); ++listIt)
         {
             APIBase* en = dynamic_cast<APIBase*>(*listIt);
             en->WriteAPIEntry(sout);
@@ -332,14 +784,15 @@ void APIInfoManagerBase::WriteStackTraceDataToStream(std::ostream& sout)
     }
 
     int fakeTID = 0;
+    std::set<osThreadId> threadIds = GetTraceThreadIds(activeMap);
 
-    for (TraceInfoMap::iterator mapIt = activeMap.begin(); mapIt != activeMap.end(); ++mapIt)
+    for (std::set<osThreadId>::const_iterator tidIt = threadIds.begin(); tidIt != threadIds.end(); ++tidIt)
     {
 
         if (!GlobalSettings::GetInstance()->m_params.m_bTestMode)
         {
             // Thread ID
-            sout << mapIt->first << endl;
+            sout << *tidIt << endl;
         }
         else
         {
@@ -348,9 +801,13 @@ void APIInfoManagerBase::WriteStackTraceDataToStream(std::ostream& sout)
         }
 
         // Number of APIs
-        sout << mapIt->second.size() << endl;
+        sout << GetNumThreadEntries(activeMap, *tidIt) << endl;
 
-        for (list<ITraceEntry*>::iterator listIt = mapIt->second.begin(); listIt != mapIt->second.end(); ++listIt)
+        CopySpillFile(sout, *tidIt, TMP_SPILL_STACK_EXT);
+
+        list<ITraceEntry*>& entries = activeMap[*tidIt];
+
+        for (list<ITraceEntry*>::iterator listIt = entries.begin(); listIt != entries.end(); ++listIt)
         {
             APIBase* en = dynamic_cast<APIBase*>(*listIt);
             en->WriteStackEntry(sout);
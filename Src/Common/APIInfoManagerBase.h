@@ -15,11 +15,16 @@
 /// \ingroup CLTraceAgent
 // @{
 #include <ostream>
+#include <new>
 #include "TraceInfoManager.h"
+#include "APIStatistics.h"
+#include "APISampler.h"
+#include "CallSiteTable.h"
+#include "RepeatedCallCollapser.h"
 
-#define RECORD_STACK_TRACE_FOR_API(p)  if (GlobalSettings::GetInstance()->m_params.m_bStackTrace && p->m_pStackEntry == NULL) \
+#define RECORD_STACK_TRACE_FOR_API(p)  if (GlobalSettings::GetInstance()->m_params.m_bStackTrace && p->m_uiCallSiteID == INVALID_CALL_SITE_ID) \
     { \
-        StackTracer::Instance()->GetStackTrace(p->m_stack, false); \
+        p->m_uiCallSiteID = CallSiteTable::Instance()->GetCurrentCallSiteID(); \
     }
 
 typedef void (*TimerFunc)(void* param);
@@ -31,7 +36,7 @@ class APIBase : public ITraceEntry
 {
 public:
     /// Constructor
-    APIBase() : m_ullStart(0), m_ullEnd(0), m_pStackEntry(nullptr)
+    APIBase() : m_ullStart(0), m_ullEnd(0), m_uiCallSiteID(INVALID_CALL_SITE_ID), m_uiRepeatCount(1), m_ullRepeatTime(0)
     {
         m_strName.clear();
     }
@@ -39,7 +44,6 @@ public:
     /// Virtual destructor
     virtual ~APIBase()
     {
-        SAFE_DELETE(m_pStackEntry);
     }
 
     /// Pure virtual to string
@@ -54,22 +58,74 @@ public:
     /// \param sout output stream
     virtual void WriteAPIEntry(std::ostream& sout);
 
+    /// Get the argument list written to the API entry: ToString, followed by the repeated
+    /// call comment if the entry collapses a run of identical calls
+    /// \return the argument list
+    std::string GetArgString();
+
     /// Write timestamp entry
     /// \param sout output stream
     /// \param bTimeout a flag indicating output mode
     /// \return True if timestamps are ready
     virtual bool WriteTimestampEntry(std::ostream& sout, bool bTimeout);
 
+    /// Check whether applications call the API in polling loops. The consecutive identical calls
+    /// of a thread to such an API are collapsed into one entry (see RepeatedCallCollapser)
+    /// \return true if the API is pollable
+    virtual bool IsPollable() const { return false; }
+
+    /// Check whether the call repeats a previous call of the same thread, called for pollable APIs only
+    /// \param pPrevious the first entry of the thread's current run of identical calls
+    /// \return true if pPrevious is a call to the same API with the same parameters and results
+    virtual bool IsRepeatOf(const APIBase* pPrevious) const
+    {
+        SP_UNREFERENCED_PARAMETER(pPrevious);
+        return false;
+    }
+
+    /// Add a call repeating this one to the run of identical calls this entry collapses
+    /// \param pRepeat the repeated call, it is not added to the trace
+    void AddRepeatedCall(const APIBase* pRepeat);
+
     /// Write stack trace entry
     /// \param sout output stream
     virtual void WriteStackEntry(std::ostream& sout);
 
+    /// Search the stack trace of the API's call site for the frame written as its stack entry.
+    /// Called once per call site, for the first API written
+    /// \param stack the stack trace, symbols can be resolved in place
+    /// \return a new stack entry or NULL if none was found
+    virtual StackEntry* CreateStackEntry(std::vector<StackEntry>& stack)
+    {
+        SP_UNREFERENCED_PARAMETER(stack);
+        return nullptr;
+    }
+
+    /// Allocate API entries from the per-thread slab arenas (see TraceEntryAllocator)
+    /// \param size object size
+    /// \return pointer to the allocated memory
+    static void* operator new(size_t size);
+
+    /// Allocate API entries from the per-thread slab arenas (see TraceEntryAllocator)
+    /// \param size object size
+    /// \return pointer to the allocated memory or nullptr if out of memory
+    static void* operator new(size_t size, const std::nothrow_t&) throw();
+
+    /// Return API entry memory to its slab
+    /// \param p pointer to the memory
+    static void operator delete(void* p);
+
+    /// Return API entry memory to its slab, called if a constructor throws from a nothrow new
+    /// \param p pointer to the memory
+    static void operator delete(void* p, const std::nothrow_t&) throw();
+
 public:
     ULONGLONG m_ullStart;            ///< api start timestamp
     ULONGLONG m_ullEnd;              ///< api end timestamp
-    StackEntry* m_pStackEntry;       ///< Stack entry
+    unsigned int m_uiCallSiteID;     ///< ID of the stack trace in the CallSiteTable, INVALID_CALL_SITE_ID if none was recorded
+    unsigned int m_uiRepeatCount;    ///< number of identical consecutive calls collapsed into this entry, m_ullEnd is the end of the last one
+    ULONGLONG m_ullRepeatTime;       ///< total time of the calls collapsed into this entry, only set if m_uiRepeatCount > 1
     std::string m_strName;           ///< API name
-    std::vector<StackEntry> m_stack; ///< stack trace
 
 private:
     /// Disable copy constructor
@@ -105,13 +161,27 @@ public:
     /// \param bForceFlush Force to write all data out no matter it's ready or not - used in Detach() only
     virtual void FlushTraceData(bool bForceFlush = false) override;
 
+    /// Add an API entry, triggers a flight recorder dump if the call took longer than m_uiFlightRecorderLatencyTrigger
+    /// \param en the APIBase entry
+    virtual void AddTraceInfoEntry(ITraceEntry* en) override;
+
     /// Save to Atp File
     virtual void SaveToOutputFile();
 
-    /// Load API filter file if specified
+    /// Stop the spill thread (non-timeout mode), waits for a spill in progress.
+    /// Called before the output files are written, no spill is done afterwards
+    void StopSpillThread();
+
+    /// Load API filter file if specified, lines with a '=' are API sampling directives
     /// \param strFileName API filter file
     void LoadAPIFilterFile(const std::string& strFileName);
 
+    /// Write the per-API statistics to <output file base name>.apistats, only used when m_bAPIStatisticsOnly is set or API sampling is enabled
+    void WriteAPIStatistics();
+
+    /// Log the number of calls left out of the trace by the API sampling policy
+    void LogAPISamplingSummary() const { m_apiSampler.LogSummary(); }
+
 protected:
     /// Disable copy constructor
     /// \param obj obj
@@ -134,6 +204,56 @@ protected:
     /// \param sout output stream
     void WriteStackTraceDataToStream(std::ostream& sout);
 
+    /// Non-timeout mode: wake the spill thread, starting it on the first request. Called by the thread adding
+    /// an entry once m_uiSpillEntryThreshold entries are pending, the entries are written by the spill thread
+    void RequestSpill();
+
+    /// Non-timeout mode: write the entries whose data is final to per-thread spill files, only called by the spill thread.
+    /// The Write*ToStream functions copy the spill files of a thread before its in-memory entries
+    void SpillTraceData();
+
+    /// Check whether an entry can be written to the spill files by SpillTraceData
+    /// \param tid the thread id
+    /// \param pEntry the entry
+    /// \return false if the entry can still change, it then stays in memory with all newer entries of the thread
+    virtual bool CanSpillEntry(osThreadId tid, APIBase* pEntry);
+
+    /// Called once an entry has been written to the spill files
+    /// \param pEntry the entry
+    virtual void ReleaseSpilledEntry(APIBase* pEntry);
+
+    /// Called when the flight recorder drops the oldest entry of a thread's window, closes the entry's run of repeated calls
+    /// \param tid the thread id
+    /// \param en the entry
+    /// \return true, the entry has been released
+    virtual bool ReleaseEvictedEntry(osThreadId tid, ITraceEntry* en) override;
+
+    /// Collapse a call repeating the thread's previous call to a pollable API into the entry of that call,
+    /// called by the subclasses before adding an entry, nothing is collapsed unless m_bCollapseClGetEventInfo is set
+    /// \param pEntry the entry
+    /// \return true if the entry has been collapsed and must not be added
+    bool CollapseRepeatedCall(APIBase* pEntry);
+
+    /// Get the ids of the threads that have entries in memory or in the spill files
+    /// \param traceInfoMap the in-memory entries
+    /// \return the thread ids, in the order of the trace map
+    std::set<osThreadId> GetTraceThreadIds(const TraceInfoMap& traceInfoMap) const;
+
+    /// Get the number of entries of a thread
+    /// \param traceInfoMap the in-memory entries
+    /// \param tid the thread id
+    /// \return the number of entries in memory and in the spill files
+    size_t GetNumThreadEntries(const TraceInfoMap& traceInfoMap, osThreadId tid) const;
+
+    /// Copy the spill file of a thread to a stream
+    /// \param sout output stream
+    /// \param tid the thread id
+    /// \param strExtension the spill file extension of the section being written
+    void CopySpillFile(std::ostream& sout, osThreadId tid, const std::string& strExtension);
+
+    /// Delete the spill files once the output files have been written
+    void RemoveSpillFiles();
+
     /// Write non-API timing data to stream
     /// \param pid the process id of the profiled process
     virtual void FlushNonAPITimestampData(const osProcessId& pid);
@@ -149,11 +269,31 @@ protected:
     /// \return the full path of the temp file name
     std::string GetTempFileName(const osProcessId& pid, const osThreadId& tid, const std::string& strExtension);
 
+    /// Gets the name of the module map file the raw stack trace addresses refer to (offline symbolization mode)
+    /// \return the full path of the module map file
+    std::string GetModuleMapFileName();
+
 protected:
     ULONGLONG     m_ullStart;            ///< first time stamp of the whole program
     ULONGLONG     m_ullEnd;              ///< end time stamp of the whole program
     std::string   m_strOutputFile;       ///< Output file
     std::string   m_strTraceModuleName;  ///< Trace module name, this is used to identify trace module when doing merging in rcprof
+    APIStatistics m_apiStatistics;       ///< Per-API statistics collected instead of the trace entries when m_bAPIStatisticsOnly is set, or for all calls when API sampling is enabled
+    APISampler    m_apiSampler;          ///< Decides which calls are recorded when a sampling policy is specified in the API filter file
+    std::map<osThreadId, size_t> m_spilledEntries; ///< Number of entries of each thread written to the spill files (non-timeout mode), locked by m_mtxFlush
+    std::atomic<long long> m_llSpillThreshold;     ///< Number of in-memory entries that triggers the next spill, raised when entries that can't be spilled yet stay in memory
+    RepeatedCallCollapser  m_repeatedCalls;        ///< Runs of identical calls to the pollable APIs, the run of an entry is closed before the entry is written
+
+private:
+    /// Spill thread function, calls SpillTraceData each time a spill is requested until StopSpillThread is called
+    /// \param pParam the manager
+    static void SpillThreadFunc(void* pParam);
+
+    THREADHANDLE            m_tidSpill;            ///< Spill thread, 0 until the first spill request
+    std::atomic<bool>       m_bSpillRequested;     ///< Flag indicating that a spill has been requested and is not done yet, set by the threads adding entries
+    bool                    m_bSpillThreadStopped; ///< Flag indicating that StopSpillThread has been called, locked by m_mtxSpillRequest
+    std::mutex              m_mtxSpillRequest;     ///< mutex used with m_cvSpillRequest, also protects m_tidSpill
+    std::condition_variable m_cvSpillRequest;      ///< signaled when a spill is requested or the spill thread is stopped
 };
 
 // @}
@@ -0,0 +1,216 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class decides which API calls are recorded in the trace when
+///        a sampling policy is specified in the API filter file.
+//==============================================================================
+
+#include <new>
+#include <vector>
+
+#include "APISampler.h"
+#include "StringUtils.h"
+#include "Defs.h"
+#include "Logger.h"
+
+using namespace std;
+using namespace GPULogger;
+
+/// Sampling state of one API, shared by all threads
+struct APISamplingState
+{
+    /// Constructor
+    APISamplingState() :
+        m_ullNumCalls(0),
+        m_ullWindow(0),
+        m_uiWindowCalls(0)
+    {
+    }
+
+    atomic<unsigned long long> m_ullNumCalls;    ///< number of calls
+    atomic<unsigned long long> m_ullWindow;      ///< index of the current budget window
+    atomic<unsigned int>       m_uiWindowCalls;  ///< number of calls recorded in the current budget window
+};
+
+APISampler::APISampler() :
+    m_uiNumAPITypes(0),
+    m_getAPIName(nullptr),
+    m_bEnabled(false),
+    m_pPolicies(nullptr),
+    m_pStates(nullptr),
+    m_uiFirstCalls(DEFAULT_API_SAMPLING_FIRST_CALLS),
+    m_ullLatencyThreshold(0),
+    m_ullSkippedCalls(0)
+{
+}
+
+APISampler::~APISampler()
+{
+    delete[] m_pPolicies;
+    delete[] m_pStates;
+}
+
+APISamplingPolicy& APISampler::GetNamedPolicy(const std::string& strAPIName)
+{
+    return m_namedPolicies[strAPIName];
+}
+
+bool APISampler::AddDirective(const std::string& strLine)
+{
+    size_t idx = strLine.find('=');
+    string strKey = StringUtils::Trim(strLine.substr(0, idx));
+    vector<string> values;
+    StringUtils::Split(values, strLine.substr(idx + 1), string(","), true, true);
+
+    bool ret = false;
+
+    if (strKey == API_SAMPLING_RATE && 2 == values.size())
+    {
+        unsigned int uiRate = 0;
+        ret = StringUtils::Parse(values[1], uiRate) && 0 != uiRate;
+
+        if (ret)
+        {
+            GetNamedPolicy(values[0]).m_uiRate = uiRate;
+        }
+    }
+    else if (strKey == API_SAMPLING_BUDGET && (2 == values.size() || 3 == values.size()))
+    {
+        unsigned int uiBudget = 0;
+        unsigned int uiBudgetWindow = DEFAULT_API_SAMPLING_BUDGET_WINDOW;
+        ret = StringUtils::Parse(values[1], uiBudget) && (2 == values.size() || (StringUtils::Parse(values[2], uiBudgetWindow) && 0 != uiBudgetWindow));
+
+        if (ret)
+        {
+            APISamplingPolicy& policy = GetNamedPolicy(values[0]);
+            policy.m_uiBudget = uiBudget;
+            policy.m_uiBudgetWindow = uiBudgetWindow;
+        }
+    }
+    else if (strKey == API_SAMPLING_LATENCY && 1 == values.size())
+    {
+        unsigned int uiLatency = 0;
+        ret = StringUtils::Parse(values[0], uiLatency);
+
+        if (ret)
+        {
+            m_ullLatencyThreshold = uiLatency * 1000ULL;
+        }
+    }
+    else if (strKey == API_SAMPLING_FIRST_CALLS && 1 == values.size())
+    {
+        ret = StringUtils::Parse(values[0], m_uiFirstCalls);
+    }
+
+    if (!ret)
+    {
+        Log(logWARNING, "Invalid API sampling directive: %s\n", strLine.c_str());
+    }
+
+    return ret;
+}
+
+void APISampler::ApplyPolicies()
+{
+    if (m_namedPolicies.empty() || 0 == m_uiNumAPITypes || nullptr == m_getAPIName)
+    {
+        return;
+    }
+
+    SAFE_DELETE_ARRAY(m_pPolicies);
+    SAFE_DELETE_ARRAY(m_pStates);
+
+    m_pPolicies = new(nothrow) APISamplingPolicy[m_uiNumAPITypes];
+    m_pStates = new(nothrow) APISamplingState[m_uiNumAPITypes];
+
+    if (nullptr == m_pPolicies || nullptr == m_pStates)
+    {
+        Log(logERROR, "APISampler: failed to allocate the sampling state, all calls are recorded\n");
+        return;
+    }
+
+    NamedPolicyMap::const_iterator defaultIt = m_namedPolicies.find(API_SAMPLING_ALL_APIS);
+    size_t numMatched = 0;
+
+    for (unsigned int i = 0; i < m_uiNumAPITypes; i++)
+    {
+        NamedPolicyMap::const_iterator it = m_namedPolicies.find(m_getAPIName(i));
+
+        if (it != m_namedPolicies.end())
+        {
+            m_pPolicies[i] = it->second;
+            numMatched++;
+        }
+        else if (defaultIt != m_namedPolicies.end())
+        {
+            m_pPolicies[i] = defaultIt->second;
+        }
+
+        m_bEnabled |= m_pPolicies[i].m_uiRate > 1 || m_pPolicies[i].m_uiBudget > 0;
+    }
+
+    if (numMatched + (defaultIt != m_namedPolicies.end() ? 1 : 0) != m_namedPolicies.size())
+    {
+        // the filter file can be shared by the CL and HSA agents, so names of the other API set are expected
+        Log(logMESSAGE, "APISampler: %llu sampling policies don't match any API\n",
+            static_cast<unsigned long long>(m_namedPolicies.size() - numMatched - (defaultIt != m_namedPolicies.end() ? 1 : 0)));
+    }
+}
+
+bool APISampler::ShouldRecord(unsigned int uiAPIType, unsigned long long ullStart, unsigned long long ullEnd)
+{
+    if (!m_bEnabled || uiAPIType >= m_uiNumAPITypes)
+    {
+        return true;
+    }
+
+    APISamplingState& state = m_pStates[uiAPIType];
+    const APISamplingPolicy& policy = m_pPolicies[uiAPIType];
+
+    unsigned long long ullCall = state.m_ullNumCalls.fetch_add(1, memory_order_relaxed);
+
+    if (ullCall < m_uiFirstCalls)
+    {
+        return true;
+    }
+
+    if (0 != m_ullLatencyThreshold && ullEnd > ullStart && ullEnd - ullStart >= m_ullLatencyThreshold)
+    {
+        return true;
+    }
+
+    if (policy.m_uiRate > 1 && 0 != (ullCall - m_uiFirstCalls) % policy.m_uiRate)
+    {
+        m_ullSkippedCalls.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    if (0 != policy.m_uiBudget)
+    {
+        unsigned long long ullWindow = ullStart / (policy.m_uiBudgetWindow * 1000000ULL);
+        unsigned long long ullCurrentWindow = state.m_ullWindow.load(memory_order_relaxed);
+
+        // the thread that moves the state to a new window resets the count, calls racing with it may be counted in either window
+        if (ullWindow > ullCurrentWindow && state.m_ullWindow.compare_exchange_strong(ullCurrentWindow, ullWindow))
+        {
+            state.m_uiWindowCalls.store(0, memory_order_relaxed);
+        }
+
+        if (state.m_uiWindowCalls.fetch_add(1, memory_order_relaxed) >= policy.m_uiBudget)
+        {
+            m_ullSkippedCalls.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void APISampler::LogSummary() const
+{
+    if (m_bEnabled)
+    {
+        Log(logMESSAGE, "APISampler: %llu calls left out of the trace\n", m_ullSkippedCalls.load());
+    }
+}
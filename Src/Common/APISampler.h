@@ -0,0 +1,144 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class decides which API calls are recorded in the trace when
+///        a sampling policy is specified in the API filter file.
+//==============================================================================
+
+#ifndef _API_SAMPLER_H_
+#define _API_SAMPLER_H_
+
+/// \defgroup APISampler APISampler
+/// This module implements the API sampling policies
+///
+/// \ingroup Common
+// @{
+
+#include <string>
+#include <map>
+#include <atomic>
+
+#include "APIStatistics.h"
+
+/// API filter file directive: SampleRate=<API name or *>,<N> records one in N calls of the API
+#define API_SAMPLING_RATE "SampleRate"
+
+/// API filter file directive: SampleBudget=<API name or *>,<calls>[,<window in ms>] records at most <calls> calls of the API per time window
+#define API_SAMPLING_BUDGET "SampleBudget"
+
+/// API filter file directive: SampleLatency=<us> always records calls that took at least the specified time
+#define API_SAMPLING_LATENCY "SampleLatency"
+
+/// API filter file directive: SampleFirstCalls=<N> always records the first N calls of each API, so that rare APIs are never dropped
+#define API_SAMPLING_FIRST_CALLS "SampleFirstCalls"
+
+/// API name used in a directive to set the policy of all APIs without a policy of their own
+#define API_SAMPLING_ALL_APIS "*"
+
+/// Default budget window in ms
+#define DEFAULT_API_SAMPLING_BUDGET_WINDOW 1000
+
+/// Default number of calls of each API that are always recorded
+#define DEFAULT_API_SAMPLING_FIRST_CALLS 10
+
+/// Sampling policy of one API
+struct APISamplingPolicy
+{
+    /// Constructor
+    APISamplingPolicy() :
+        m_uiRate(1),
+        m_uiBudget(0),
+        m_uiBudgetWindow(DEFAULT_API_SAMPLING_BUDGET_WINDOW)
+    {
+    }
+
+    unsigned int m_uiRate;          ///< one in m_uiRate calls is recorded
+    unsigned int m_uiBudget;        ///< maximum number of calls recorded per window, 0 for no budget
+    unsigned int m_uiBudgetWindow;  ///< budget window in ms
+};
+
+struct APISamplingState;
+
+//------------------------------------------------------------------------------------
+/// Per-API sampling: 1 in N calls, a budget of calls per time window, and calls that
+/// are always recorded (the first calls of each API and calls above a latency threshold).
+/// The calls left out of the trace are still counted in the API statistics, which
+/// sanalyze uses for the API summary of a sampled trace.
+//------------------------------------------------------------------------------------
+class APISampler
+{
+public:
+    /// Constructor
+    APISampler();
+
+    /// Destructor
+    ~APISampler();
+
+    /// Set the API types, must be called before ApplyPolicies
+    /// \param uiNumAPITypes the number of API types (API type values are in [0, uiNumAPITypes))
+    /// \param getAPIName function returning the name of an API type, used to match the API names of the directives
+    void Init(unsigned int uiNumAPITypes, APINameFunc getAPIName)
+    {
+        m_uiNumAPITypes = uiNumAPITypes;
+        m_getAPIName = getAPIName;
+    }
+
+    /// Check whether a line of the API filter file is a sampling directive rather than an API name
+    /// \param strLine the trimmed line
+    /// \return true if the line is a directive
+    static bool IsDirective(const std::string& strLine) { return std::string::npos != strLine.find('='); }
+
+    /// Parse a sampling directive
+    /// \param strLine the trimmed line of the API filter file
+    /// \return false if the directive is invalid
+    bool AddDirective(const std::string& strLine);
+
+    /// Resolve the API names of the directives and enable sampling if any API is sampled
+    void ApplyPolicies();
+
+    /// Check whether sampling is enabled
+    /// \return true if some calls can be left out of the trace
+    bool IsEnabled() const { return m_bEnabled; }
+
+    /// Decide whether a call is recorded in the trace, called once for every call
+    /// \param uiAPIType the API type
+    /// \param ullStart start timestamp in ns
+    /// \param ullEnd end timestamp in ns
+    /// \return true if the call is recorded
+    bool ShouldRecord(unsigned int uiAPIType, unsigned long long ullStart, unsigned long long ullEnd);
+
+    /// Log the number of calls left out of the trace
+    void LogSummary() const;
+
+private:
+    /// Get the policy of an API name, creating it if needed
+    /// \param strAPIName the API name or API_SAMPLING_ALL_APIS
+    /// \return the policy
+    APISamplingPolicy& GetNamedPolicy(const std::string& strAPIName);
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    APISampler(const APISampler& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    APISampler& operator=(const APISampler& obj) = delete;
+
+    typedef std::map<std::string, APISamplingPolicy> NamedPolicyMap;
+
+    unsigned int                     m_uiNumAPITypes;       ///< number of API types
+    APINameFunc                      m_getAPIName;          ///< function returning the name of an API type
+    bool                             m_bEnabled;            ///< flag indicating whether any API is sampled
+    NamedPolicyMap                   m_namedPolicies;       ///< policies read from the directives, by API name
+    APISamplingPolicy*               m_pPolicies;           ///< policies indexed by API type
+    APISamplingState*                m_pStates;             ///< sampling state indexed by API type
+    unsigned int                     m_uiFirstCalls;        ///< number of calls of each API that are always recorded
+    unsigned long long               m_ullLatencyThreshold; ///< calls that took at least this time in ns are always recorded, 0 to disable
+    std::atomic<unsigned long long>  m_ullSkippedCalls;     ///< number of calls left out of the trace
+};
+
+// @}
+
+#endif //_API_SAMPLER_H_
@@ -0,0 +1,437 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class collects per-API call statistics (call count, total, min,
+///        max time and a latency histogram) instead of a full API trace.
+//==============================================================================
+
+#include <new>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <climits>
+
+#include "APIStatistics.h"
+#include "ProfilerOutputFileDefs.h"
+#include "StringUtils.h"
+#include "Version.h"
+#include "Defs.h"
+#include "Logger.h"
+
+using namespace std;
+using namespace GPULogger;
+
+/// Number of tables cached per thread (one per APIStatistics the thread adds calls to)
+#define API_STATISTICS_TABLE_CACHE_SIZE 4
+
+/// Statistics of one API in one thread.
+/// Only the owning thread writes the counters; relaxed atomics let the thread writing the
+/// file read them at any time at the cost of plain loads and stores.
+struct alignas(API_STATISTICS_CACHE_LINE_SIZE) APIStatisticsCounter
+{
+    /// Constructor
+    APIStatisticsCounter() :
+        m_ullNumCalls(0),
+        m_ullTotalTime(0),
+        m_ullMinTime(ULLONG_MAX),
+        m_ullMaxTime(0)
+    {
+        for (int i = 0; i < API_STATISTICS_HISTOGRAM_BINS; i++)
+        {
+            m_histogram[i].store(0, memory_order_relaxed);
+        }
+    }
+
+    atomic<unsigned long long> m_ullNumCalls;                              ///< number of calls
+    atomic<unsigned long long> m_ullTotalTime;                             ///< cumulative time in ns
+    atomic<unsigned long long> m_ullMinTime;                               ///< shortest non-zero call in ns
+    atomic<unsigned long long> m_ullMaxTime;                               ///< longest call in ns
+    atomic<unsigned long long> m_histogram[API_STATISTICS_HISTOGRAM_BINS]; ///< number of calls in each latency bin
+};
+
+/// Add a value to a counter owned by the calling thread
+/// \param counter the counter
+/// \param ullValue the value to add
+static inline void AddToCounter(atomic<unsigned long long>& counter, unsigned long long ullValue)
+{
+    counter.store(counter.load(memory_order_relaxed) + ullValue, memory_order_relaxed);
+}
+
+/// Get the histogram bin of a call duration
+/// \param ullDuration the call duration in ns
+/// \return the bin index
+static inline unsigned int GetHistogramBin(unsigned long long ullDuration)
+{
+    unsigned int uiBin = 0;
+
+#if defined (_LINUX) || defined (LINUX)
+
+    if (0 != ullDuration)
+    {
+        uiBin = 64 - static_cast<unsigned int>(__builtin_clzll(ullDuration));
+    }
+
+#else
+
+    while (0 != ullDuration && uiBin < API_STATISTICS_HISTOGRAM_BINS)
+    {
+        ullDuration >>= 1;
+        uiBin++;
+    }
+
+#endif
+
+    return uiBin < API_STATISTICS_HISTOGRAM_BINS ? uiBin : API_STATISTICS_HISTOGRAM_BINS - 1;
+}
+
+//------------------------------------------------------------------------------------
+/// Counters of all APIs for one thread, stored in cache line aligned memory
+//------------------------------------------------------------------------------------
+class APIStatisticsThreadTable
+{
+public:
+    /// Constructor
+    /// \param uiNumAPITypes number of API types
+    explicit APIStatisticsThreadTable(unsigned int uiNumAPITypes) :
+        m_uiNumAPITypes(uiNumAPITypes),
+        m_pStorage(nullptr),
+        m_pCounters(nullptr)
+    {
+        size_t size = uiNumAPITypes * sizeof(APIStatisticsCounter) + API_STATISTICS_CACHE_LINE_SIZE;
+        m_pStorage = new(nothrow) char[size];
+
+        if (nullptr != m_pStorage)
+        {
+            void* pAligned = m_pStorage;
+
+            if (nullptr != align(API_STATISTICS_CACHE_LINE_SIZE, uiNumAPITypes * sizeof(APIStatisticsCounter), pAligned, size))
+            {
+                m_pCounters = static_cast<APIStatisticsCounter*>(pAligned);
+
+                for (unsigned int i = 0; i < uiNumAPITypes; i++)
+                {
+                    new(&m_pCounters[i]) APIStatisticsCounter();
+                }
+            }
+        }
+    }
+
+    /// Destructor
+    ~APIStatisticsThreadTable()
+    {
+        if (nullptr != m_pCounters)
+        {
+            for (unsigned int i = 0; i < m_uiNumAPITypes; i++)
+            {
+                m_pCounters[i].~APIStatisticsCounter();
+            }
+        }
+
+        delete[] m_pStorage;
+    }
+
+    /// Check whether the counters could be allocated
+    /// \return true if the table can be used
+    bool IsValid() const { return nullptr != m_pCounters; }
+
+    /// Add a call, called by the owning thread only
+    /// \param uiAPIType the API type
+    /// \param ullDuration the call duration in ns
+    void AddCall(unsigned int uiAPIType, unsigned long long ullDuration)
+    {
+        APIStatisticsCounter& counter = m_pCounters[uiAPIType];
+
+        AddToCounter(counter.m_ullNumCalls, 1);
+        AddToCounter(counter.m_ullTotalTime, ullDuration);
+        AddToCounter(counter.m_histogram[GetHistogramBin(ullDuration)], 1);
+
+        // zero durations are left out of the minimum, as in the API summary page
+        if (0 != ullDuration && ullDuration < counter.m_ullMinTime.load(memory_order_relaxed))
+        {
+            counter.m_ullMinTime.store(ullDuration, memory_order_relaxed);
+        }
+
+        if (ullDuration > counter.m_ullMaxTime.load(memory_order_relaxed))
+        {
+            counter.m_ullMaxTime.store(ullDuration, memory_order_relaxed);
+        }
+    }
+
+    /// Get the counters of an API
+    /// \param uiAPIType the API type
+    /// \return the counters
+    const APIStatisticsCounter& GetCounter(unsigned int uiAPIType) const { return m_pCounters[uiAPIType]; }
+
+private:
+    /// Disable copy constructor
+    /// \param obj the input object
+    APIStatisticsThreadTable(const APIStatisticsThreadTable& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    APIStatisticsThreadTable& operator=(const APIStatisticsThreadTable& obj) = delete;
+
+    unsigned int          m_uiNumAPITypes;  ///< number of counters
+    char*                 m_pStorage;       ///< allocated memory, large enough to align the counters
+    APIStatisticsCounter* m_pCounters;      ///< counters indexed by API type
+};
+
+/// Per-thread cache entry mapping an APIStatistics object to the calling thread's table
+struct APIStatisticsTableCacheEntry
+{
+    const APIStatistics*      m_pOwner;  ///< the object the table is registered with
+    APIStatisticsThreadTable* m_pTable;  ///< the calling thread's table
+};
+
+/// Tables registered by the calling thread, looked up without taking any lock
+static thread_local APIStatisticsTableCacheEntry s_apiStatisticsTableCache[API_STATISTICS_TABLE_CACHE_SIZE] = {};
+
+APIStatistics::APIStatistics() :
+    m_uiNumAPITypes(0),
+    m_getAPIName(nullptr),
+    m_ullNumCallsWritten(0)
+{
+}
+
+APIStatistics::~APIStatistics()
+{
+    lock_guard<mutex> lock(m_mtxThreadTables);
+
+    for (list<APIStatisticsThreadTable*>::iterator it = m_threadTables.begin(); it != m_threadTables.end(); ++it)
+    {
+        SAFE_DELETE(*it);
+    }
+
+    m_threadTables.clear();
+}
+
+void APIStatistics::AddCall(unsigned int uiAPIType, unsigned long long ullStart, unsigned long long ullEnd)
+{
+    if (uiAPIType >= m_uiNumAPITypes)
+    {
+        return;
+    }
+
+    APIStatisticsThreadTable* pTable = GetThreadTable();
+
+    if (nullptr != pTable)
+    {
+        pTable->AddCall(uiAPIType, ullEnd > ullStart ? ullEnd - ullStart : 0);
+    }
+}
+
+APIStatisticsThreadTable* APIStatistics::GetThreadTable()
+{
+    for (int i = 0; i < API_STATISTICS_TABLE_CACHE_SIZE; i++)
+    {
+        if (s_apiStatisticsTableCache[i].m_pOwner == this)
+        {
+            return s_apiStatisticsTableCache[i].m_pTable;
+        }
+    }
+
+    APIStatisticsThreadTable* pTable = new(nothrow) APIStatisticsThreadTable(m_uiNumAPITypes);
+
+    if (nullptr != pTable && !pTable->IsValid())
+    {
+        SAFE_DELETE(pTable);
+    }
+
+    if (nullptr == pTable)
+    {
+        Log(logERROR, "APIStatistics: failed to allocate thread table\n");
+        return nullptr;
+    }
+
+    {
+        lock_guard<mutex> lock(m_mtxThreadTables);
+        m_threadTables.push_back(pTable);
+    }
+
+    for (int i = 0; i < API_STATISTICS_TABLE_CACHE_SIZE; i++)
+    {
+        if (nullptr == s_apiStatisticsTableCache[i].m_pOwner)
+        {
+            s_apiStatisticsTableCache[i].m_pOwner = this;
+            s_apiStatisticsTableCache[i].m_pTable = pTable;
+            break;
+        }
+    }
+
+    return pTable;
+}
+
+bool APIStatistics::WriteToFile(const std::string& strFileName, const std::string& strModuleName)
+{
+    if (nullptr == m_getAPIName)
+    {
+        return false;
+    }
+
+    vector<APIStatisticsRecord> records(m_uiNumAPITypes);
+    unsigned long long ullNumCalls = 0;
+    size_t numThreads = 0;
+
+    {
+        lock_guard<mutex> lock(m_mtxThreadTables);
+        numThreads = m_threadTables.size();
+
+        for (list<APIStatisticsThreadTable*>::const_iterator it = m_threadTables.begin(); it != m_threadTables.end(); ++it)
+        {
+            for (unsigned int uiAPIType = 0; uiAPIType < m_uiNumAPITypes; uiAPIType++)
+            {
+                const APIStatisticsCounter& counter = (*it)->GetCounter(uiAPIType);
+                unsigned long long ullThreadCalls = counter.m_ullNumCalls.load(memory_order_relaxed);
+
+                if (0 == ullThreadCalls)
+                {
+                    continue;
+                }
+
+                APIStatisticsRecord& record = records[uiAPIType];
+                unsigned long long ullMinTime = counter.m_ullMinTime.load(memory_order_relaxed);
+                unsigned long long ullMaxTime = counter.m_ullMaxTime.load(memory_order_relaxed);
+
+                if (ULLONG_MAX != ullMinTime && (0 == record.m_ullMinTime || ullMinTime < record.m_ullMinTime))
+                {
+                    record.m_ullMinTime = ullMinTime;
+                }
+
+                if (ullMaxTime > record.m_ullMaxTime)
+                {
+                    record.m_ullMaxTime = ullMaxTime;
+                }
+
+                record.m_ullNumCalls += ullThreadCalls;
+                record.m_ullTotalTime += counter.m_ullTotalTime.load(memory_order_relaxed);
+
+                for (int i = 0; i < API_STATISTICS_HISTOGRAM_BINS; i++)
+                {
+                    record.m_histogram[i] += counter.m_histogram[i].load(memory_order_relaxed);
+                }
+
+                ullNumCalls += ullThreadCalls;
+            }
+        }
+    }
+
+    if (ullNumCalls == m_ullNumCallsWritten)
+    {
+        return false;
+    }
+
+    ofstream fout(strFileName.c_str(), fstream::out | fstream::trunc);
+
+    if (fout.fail())
+    {
+        Log(logWARNING, "Failed to open file: %s\n", strFileName.c_str());
+        return false;
+    }
+
+    fout << API_STATISTICS_HEADER_FILE_VERSION << EQUAL_SIGN_STR << API_STATISTICS_FILE_VERSION << '\n';
+    fout << FILE_HEADER_PROFILER_VERSION << EQUAL_SIGN_STR << RCP_MAJOR_VERSION << "." << RCP_MINOR_VERSION << "." << RCP_BUILD_NUMBER << '\n';
+    fout << FILE_HEADER_API << EQUAL_SIGN_STR << strModuleName << '\n';
+    fout << API_STATISTICS_HEADER_NUM_THREADS << EQUAL_SIGN_STR << numThreads << '\n';
+    fout << API_STATISTICS_HEADER_HISTOGRAM_BINS << EQUAL_SIGN_STR << API_STATISTICS_HISTOGRAM_BINS << '\n';
+
+    // one line per API: name, number of calls, total, min and max time, histogram bins
+    for (unsigned int uiAPIType = 0; uiAPIType < m_uiNumAPITypes; uiAPIType++)
+    {
+        const APIStatisticsRecord& record = records[uiAPIType];
+
+        if (0 == record.m_ullNumCalls)
+        {
+            continue;
+        }
+
+        fout << m_getAPIName(uiAPIType) << ' ' << record.m_ullNumCalls << ' ' << record.m_ullTotalTime << ' ' << record.m_ullMinTime << ' ' << record.m_ullMaxTime;
+
+        for (int i = 0; i < API_STATISTICS_HISTOGRAM_BINS; i++)
+        {
+            fout << ' ' << record.m_histogram[i];
+        }
+
+        fout << '\n';
+    }
+
+    fout.close();
+    m_ullNumCallsWritten = ullNumCalls;
+    return true;
+}
+
+bool APIStatistics::ReadFromFile(const std::string& strFileName, std::string& strModuleName, std::vector<APIStatisticsRecord>& records)
+{
+    ifstream fin(strFileName.c_str());
+
+    if (fin.fail())
+    {
+        return false;
+    }
+
+    unsigned int uiNumBins = 0;
+    bool bVersionFound = false;
+    string line;
+
+    while (getline(fin, line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+
+        size_t idx = line.find(EQUAL_SIGN_STR);
+
+        if (string::npos != idx)
+        {
+            string strKey = line.substr(0, idx);
+            string strValue = line.substr(idx + 1);
+
+            if (strKey == API_STATISTICS_HEADER_FILE_VERSION)
+            {
+                // only the major version has to match
+                bVersionFound = strValue.substr(0, strValue.find('.')) == string(API_STATISTICS_FILE_VERSION).substr(0, 1);
+            }
+            else if (strKey == FILE_HEADER_API)
+            {
+                strModuleName = strValue;
+            }
+            else if (strKey == API_STATISTICS_HEADER_HISTOGRAM_BINS)
+            {
+                StringUtils::Parse(strValue, uiNumBins);
+            }
+
+            continue;
+        }
+
+        if (!bVersionFound)
+        {
+            Log(logWARNING, "Unsupported API statistics file: %s\n", strFileName.c_str());
+            return false;
+        }
+
+        istringstream ss(line);
+        APIStatisticsRecord record;
+        ss >> record.m_strName >> record.m_ullNumCalls >> record.m_ullTotalTime >> record.m_ullMinTime >> record.m_ullMaxTime;
+
+        for (unsigned int i = 0; i < uiNumBins; i++)
+        {
+            unsigned long long ullCount = 0;
+            ss >> ullCount;
+
+            // a file written with more bins adds its longer calls to the last bin
+            record.m_histogram[i < API_STATISTICS_HISTOGRAM_BINS ? i : API_STATISTICS_HISTOGRAM_BINS - 1] += ullCount;
+        }
+
+        if (ss.fail())
+        {
+            Log(logWARNING, "Invalid API statistics line in %s: %s\n", strFileName.c_str(), line.c_str());
+            continue;
+        }
+
+        records.push_back(record);
+    }
+
+    return bVersionFound;
+}
@@ -0,0 +1,133 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class collects per-API call statistics (call count, total, min,
+///        max time and a latency histogram) instead of a full API trace.
+//==============================================================================
+
+#ifndef _API_STATISTICS_H_
+#define _API_STATISTICS_H_
+
+/// \defgroup APIStatistics APIStatistics
+/// This module collects and reads API statistics
+///
+/// \ingroup Common
+// @{
+
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <atomic>
+
+#include <AMDTOSWrappers/Include/osOSDefinitions.h>
+
+/// API statistics file format version
+#define API_STATISTICS_FILE_VERSION "1.0"
+
+/// Number of latency histogram bins. Bin 0 counts calls that took 0 ns, bin i (i > 0)
+/// counts calls that took [2^(i-1), 2^i) ns; the last bin also counts all longer calls
+#define API_STATISTICS_HISTOGRAM_BINS 32
+
+/// Size of a cache line, the per-thread tables don't share cache lines
+#define API_STATISTICS_CACHE_LINE_SIZE 64
+
+class APIStatisticsThreadTable;
+
+/// Function that returns the name of an API type
+typedef std::string(*APINameFunc)(unsigned int uiAPIType);
+
+/// Merged statistics of one API
+struct APIStatisticsRecord
+{
+    /// Constructor
+    APIStatisticsRecord() :
+        m_ullNumCalls(0),
+        m_ullTotalTime(0),
+        m_ullMinTime(0),
+        m_ullMaxTime(0),
+        m_histogram(API_STATISTICS_HISTOGRAM_BINS, 0)
+    {
+    }
+
+    std::string                     m_strName;       ///< API name
+    unsigned long long              m_ullNumCalls;   ///< number of calls
+    unsigned long long              m_ullTotalTime;  ///< cumulative time in ns
+    unsigned long long              m_ullMinTime;    ///< shortest call in ns
+    unsigned long long              m_ullMaxTime;    ///< longest call in ns
+    std::vector<unsigned long long> m_histogram;     ///< number of calls in each latency bin
+};
+
+//------------------------------------------------------------------------------------
+/// Per-API statistics kept in per-thread tables indexed by API type.
+/// A thread updates its own table without locking; the tables are merged when the
+/// statistics file is written, so the file size only depends on the number of APIs.
+//------------------------------------------------------------------------------------
+class APIStatistics
+{
+public:
+    /// Constructor
+    APIStatistics();
+
+    /// Destructor
+    ~APIStatistics();
+
+    /// Set the API types, must be called before the first call to AddCall
+    /// \param uiNumAPITypes the number of API types (API type values are in [0, uiNumAPITypes))
+    /// \param getAPIName function returning the name of an API type, used when the file is written
+    void Init(unsigned int uiNumAPITypes, APINameFunc getAPIName)
+    {
+        m_uiNumAPITypes = uiNumAPITypes;
+        m_getAPIName = getAPIName;
+    }
+
+    /// Add a call to the calling thread's table
+    /// \param uiAPIType the API type
+    /// \param ullStart start timestamp
+    /// \param ullEnd end timestamp
+    void AddCall(unsigned int uiAPIType, unsigned long long ullStart, unsigned long long ullEnd);
+
+    /// Merge the tables of all threads and write them to the statistics file.
+    /// The file is rewritten by every call, nothing is written if no call was added since the previous call
+    /// \param strFileName the statistics file name
+    /// \param strModuleName the API module name (CL_PART_NAME or HSA_PART_NAME)
+    /// \return true if the file was written
+    bool WriteToFile(const std::string& strFileName, const std::string& strModuleName);
+
+    /// Read a statistics file
+    /// \param strFileName the statistics file name
+    /// \param[out] strModuleName the API module name
+    /// \param[out] records the statistics of each API
+    /// \return true if the file was read
+    static bool ReadFromFile(const std::string& strFileName, std::string& strModuleName, std::vector<APIStatisticsRecord>& records);
+
+    /// Get the lower bound of a histogram bin
+    /// \param uiBin the bin index
+    /// \return the shortest duration in ns counted in the bin
+    static unsigned long long GetHistogramBinStart(unsigned int uiBin) { return 0 == uiBin ? 0 : 1ULL << (uiBin - 1); }
+
+private:
+    /// Get the calling thread's table, registering a new one if needed
+    /// \return the table or nullptr if it could not be allocated
+    APIStatisticsThreadTable* GetThreadTable();
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    APIStatistics(const APIStatistics& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    APIStatistics& operator=(const APIStatistics& obj) = delete;
+
+    unsigned int                          m_uiNumAPITypes;        ///< number of API types
+    APINameFunc                           m_getAPIName;           ///< function returning the name of an API type
+    std::list<APIStatisticsThreadTable*>  m_threadTables;         ///< tables of all threads
+    std::mutex                            m_mtxThreadTables;      ///< mutex used to lock m_threadTables
+    unsigned long long                    m_ullNumCallsWritten;   ///< number of calls when the file was last written
+};
+
+// @}
+
+#endif //_API_STATISTICS_H_
@@ -14,6 +14,7 @@
 #include "StringUtils.h"
 
 #include "ATPFileUtils.h"
+#include "APISampler.h"
 
 void ReadExcludedAPIs(const std::string& strAPIFilterFile, std::set<std::string>& excludedAPIs)
 {
@@ -30,13 +31,34 @@ void ReadExcludedAPIs(const std::string& strAPIFilterFile, std::set<std::string>
         // use set for better lookup performance
         std::string name = StringUtils::Trim(*it);
 
-        if (!name.empty())
+        if (!name.empty() && !APISampler::IsDirective(name))
         {
             excludedAPIs.insert(name);
         }
     }
 }
 
+bool HasAPISamplingDirectives(const std::string& strAPIFilterFile)
+{
+    if (strAPIFilterFile.empty())
+    {
+        return false;
+    }
+
+    std::vector<std::string> tmpArr;
+    FileUtils::ReadFile(strAPIFilterFile, tmpArr, true);
+
+    for (std::vector<std::string>::iterator it = tmpArr.begin(); it != tmpArr.end(); ++it)
+    {
+        if (APISampler::IsDirective(StringUtils::Trim(*it)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void WriteExcludedAPIs(SP_fileStream& sout, const char* pPrefix, std::set<std::string> excludedAPIs)
 {
     // Write excluded APIs
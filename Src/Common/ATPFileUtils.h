@@ -23,6 +23,11 @@
 /// \param[out] excludedAPIs List of excluded APIs
 void ReadExcludedAPIs(const std::string& strAPIFilterFile, std::set<std::string>& excludedAPIs);
 
+/// Check whether the API filter file contains API sampling directives
+/// \param strAPIFilterFile API filter file
+/// \return true if some API calls may be left out of the trace
+bool HasAPISamplingDirectives(const std::string& strAPIFilterFile);
+
 /// Write excluded APIs to stream
 /// \param sout stream used for writing
 /// \param pPrefix the prefix to prepend before the key in the file header
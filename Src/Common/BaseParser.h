@@ -13,6 +13,7 @@
 #include <string>
 #include <AMDTBaseTools/Include/gtASCIIString.h>
 #include "IParserListener.h"
+#include "CompressedStream.h"
 
 
 #define READLINE(line) bError = !ReadLine(in, line); \
@@ -169,7 +170,7 @@ public:
     /// Destructor
     virtual ~BaseFileParser() {}
 
-    /// Load File
+    /// Load File, compressed files are decompressed while they are parsed
     /// \param szFileName File name
     /// \return true if succeed
     bool LoadFile(const char* szFileName)
@@ -209,7 +210,7 @@ protected:
         return BaseParser<T>::ReadLine(fin, line);
     }
 
-    std::ifstream fin;                                 ///< ifstream
+    InputFileStream fin;                               ///< input file stream
     std::string m_strFileName;                         ///< File name
     bool m_bFileOpen;                                  ///< Flag indicating whether files is opened or not
 };
@@ -18,6 +18,7 @@
 #include "FileUtils.h"
 #include "Logger.h"
 #include "ProfilerOutputFileDefs.h"
+#include "CompressedStream.h"
 
 using namespace std;
 
@@ -142,6 +143,7 @@ CSVFileWriter::CSVFileWriter(const std::string& fileName)
 {
     m_strFilename = fileName;
     m_bWrittenHeaderAndColumnRow = false;
+    m_bCompress = false;
 
     if (FileUtils::FileExist(m_strFilename))
     {
@@ -167,7 +169,18 @@ bool CSVFileWriter::Flush()
     std::lock_guard<std::mutex> lock(g_mtx);
 
     ofstream fout;
-    fout.open(m_strFilename.c_str(), fstream::out | ios::app);
+    CompressedOutputBuffer compressedBuffer;
+
+    if (m_bCompress)
+    {
+        // each flush appends its rows as new blocks
+        fout.open(m_strFilename.c_str(), fstream::out | ios::app | ios::binary);
+        compressedBuffer.Attach(fout);
+    }
+    else
+    {
+        fout.open(m_strFilename.c_str(), fstream::out | ios::app);
+    }
 
     if (fout.fail())
     {
@@ -222,6 +235,7 @@ bool CSVFileWriter::Flush()
 
     m_rows.clear();
 
+    fout.flush();
     fout.close();
 
     return true;
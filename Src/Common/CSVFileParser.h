@@ -204,9 +204,14 @@ public:
     /// Add row
     /// \return row pointer
     CSVRow* AddRow();
+
+    /// Set compression
+    /// \param bCompress true to write the rows as compressed blocks (CompressedOutputBuffer)
+    void SetCompression(bool bCompress) { m_bCompress = bCompress; }
 private:
     std::string m_strFilename;          ///< Output file name
     bool m_bWrittenHeaderAndColumnRow;  ///< A flag indicating whether or not header and column has been written
+    bool m_bCompress;                   ///< A flag indicating whether or not the file is compressed
     std::set<std::string> m_columnSet;  ///< Used internally to enable quick lookup
 };
 
@@ -0,0 +1,98 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class interns the stack traces recorded for the API calls, an
+///        API entry only stores the ID of its call site.
+//==============================================================================
+
+#include "CallSiteTable.h"
+#include "Logger.h"
+
+using namespace std;
+using namespace GPULogger;
+
+CallSiteTable::CallSiteTable()
+{
+}
+
+CallSiteTable::~CallSiteTable()
+{
+    for (vector<CallSite*>::iterator it = m_callSites.begin(); it != m_callSites.end(); ++it)
+    {
+        SAFE_DELETE(*it);
+    }
+
+    m_callSites.clear();
+}
+
+unsigned int CallSiteTable::GetCurrentCallSiteID()
+{
+    // reused by all the calls of a thread so that recording a known stack trace doesn't allocate memory
+    static thread_local vector<StackEntry> s_stack;
+    static thread_local CallSiteKey s_key;
+
+    s_stack.clear();
+
+    if (!StackTracer::Instance()->GetStackTrace(s_stack, false) || s_stack.empty())
+    {
+        return INVALID_CALL_SITE_ID;
+    }
+
+    s_key.clear();
+
+    for (vector<StackEntry>::const_iterator it = s_stack.begin(); it != s_stack.end(); ++it)
+    {
+#ifdef _WIN32
+        s_key.push_back(it->m_dwAddress);
+#else
+        s_key.push_back(reinterpret_cast<uintptr_t>(it->m_dwAddress));
+#endif
+    }
+
+    CallSiteShard& shard = m_shards[CallSiteKeyHash()(s_key) % CALL_SITE_TABLE_SHARDS];
+    std::lock_guard<std::mutex> lock(shard.m_mtx);
+
+    unordered_map<CallSiteKey, unsigned int, CallSiteKeyHash>::const_iterator it = shard.m_callSiteIDs.find(s_key);
+
+    if (it != shard.m_callSiteIDs.end())
+    {
+        return it->second;
+    }
+
+    // new call site, the module names are only looked up once per stack trace
+    CallSite* pCallSite = new(nothrow) CallSite();
+
+    if (pCallSite == nullptr)
+    {
+        Log(logERROR, "Failed to allocate a call site\n");
+        return INVALID_CALL_SITE_ID;
+    }
+
+    pCallSite->m_stack = s_stack;
+    StackTracer::Instance()->GetModuleNames(pCallSite->m_stack);
+
+    unsigned int uiCallSiteID;
+
+    {
+        std::lock_guard<std::mutex> lockCallSites(m_mtxCallSites);
+        uiCallSiteID = static_cast<unsigned int>(m_callSites.size());
+        m_callSites.push_back(pCallSite);
+    }
+
+    shard.m_callSiteIDs.insert(make_pair(s_key, uiCallSiteID));
+
+    return uiCallSiteID;
+}
+
+CallSite* CallSiteTable::GetCallSite(unsigned int uiCallSiteID)
+{
+    std::lock_guard<std::mutex> lock(m_mtxCallSites);
+
+    if (uiCallSiteID >= m_callSites.size())
+    {
+        return nullptr;
+    }
+
+    return m_callSites[uiCallSiteID];
+}
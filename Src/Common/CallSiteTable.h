@@ -0,0 +1,126 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class interns the stack traces recorded for the API calls, an
+///        API entry only stores the ID of its call site.
+//==============================================================================
+
+#ifndef _CALL_SITE_TABLE_H_
+#define _CALL_SITE_TABLE_H_
+
+/// \defgroup CallSiteTable CallSiteTable
+/// This module interns the recorded stack traces
+///
+/// \ingroup Common
+// @{
+
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <mutex>
+
+#include "StackTracer.h"
+
+/// Call site ID of an API entry without stack trace
+#define INVALID_CALL_SITE_ID 0xffffffff
+
+/// Number of independently locked parts of the call site table
+#define CALL_SITE_TABLE_SHARDS 64
+
+/// Prefix of the call site IDs in the stack trace output. An API line is "name\t#id", the
+/// first line of each thread referring to a call site also contains its stack entry ("name\t#id\tsymbol...")
+#define CALL_SITE_ID_PREFIX '#'
+
+/// Raw frame addresses of a stack trace
+typedef std::vector<ULONGLONG> CallSiteKey;
+
+/// Hash of the frame addresses of a stack trace
+struct CallSiteKeyHash
+{
+    /// Hash a stack trace
+    /// \param key the frame addresses
+    /// \return the hash value
+    size_t operator()(const CallSiteKey& key) const
+    {
+        ULONGLONG ullHash = 14695981039346656037ULL;
+
+        for (CallSiteKey::const_iterator it = key.begin(); it != key.end(); ++it)
+        {
+            ullHash = (ullHash ^ *it) * 1099511628211ULL;
+        }
+
+        return static_cast<size_t>(ullHash ^ (ullHash >> 32));
+    }
+};
+
+/// Unique stack trace
+struct CallSite
+{
+    /// Constructor
+    CallSite() : m_pStackEntry(nullptr), m_bStackEntryCreated(false)
+    {
+    }
+
+    /// Destructor
+    ~CallSite()
+    {
+        SAFE_DELETE(m_pStackEntry);
+    }
+
+    std::vector<StackEntry> m_stack;                ///< stack trace, symbols are resolved when the stack entry is created
+    StackEntry*             m_pStackEntry;          ///< stack entry written for the APIs called from this call site, NULL if none was found
+    bool                    m_bStackEntryCreated;   ///< flag indicating that m_pStackEntry has been searched for
+    std::set<osThreadId>    m_writtenTids;          ///< threads whose stack trace output already contains the stack entry
+    std::mutex              m_mtx;                  ///< mutex protecting the stack entry and the written thread set
+};
+
+//------------------------------------------------------------------------------------
+/// Table of the unique stack traces recorded for the API calls. Most calls are made
+/// from a few call sites: each stack trace is stored (and its symbols resolved) once,
+/// and the API entries only keep a 32 bit call site ID.
+//------------------------------------------------------------------------------------
+class CallSiteTable : public TSingleton<CallSiteTable>
+{
+    friend class TSingleton<CallSiteTable>;
+public:
+    /// Destructor
+    ~CallSiteTable();
+
+    /// Record the stack trace of the calling thread
+    /// \return the ID of the call site, INVALID_CALL_SITE_ID if the stack trace could not be recorded
+    unsigned int GetCurrentCallSiteID();
+
+    /// Get a call site
+    /// \param uiCallSiteID the call site ID
+    /// \return the call site or NULL if the ID is not valid
+    CallSite* GetCallSite(unsigned int uiCallSiteID);
+
+private:
+    /// Constructor
+    CallSiteTable();
+
+    /// Part of the table, the stack traces are distributed over the parts by hash value
+    struct CallSiteShard
+    {
+        std::unordered_map<CallSiteKey, unsigned int, CallSiteKeyHash> m_callSiteIDs; ///< call site ID of each stack trace
+        std::mutex                                                     m_mtx;         ///< mutex protecting m_callSiteIDs
+    };
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    CallSiteTable(const CallSiteTable& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    CallSiteTable& operator=(const CallSiteTable& obj) = delete;
+
+    CallSiteShard          m_shards[CALL_SITE_TABLE_SHARDS]; ///< parts of the table
+    std::vector<CallSite*> m_callSites;                      ///< call sites indexed by ID
+    std::mutex             m_mtxCallSites;                   ///< mutex protecting m_callSites
+};
+
+// @}
+
+#endif //_CALL_SITE_TABLE_H_
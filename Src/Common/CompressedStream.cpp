@@ -0,0 +1,639 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief These classes write and read files made of independently compressed
+///        blocks (trace fragments, .atp and kernel .csv files).
+//==============================================================================
+
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+#include "CompressedStream.h"
+#include "Logger.h"
+
+using namespace std;
+using namespace GPULogger;
+
+/// Minimum length of a match, also the number of bytes hashed to find one
+#define LZ_MIN_MATCH 4
+
+/// Number of bits of the hash table index
+#define LZ_HASH_BITS 12
+
+/// Largest distance between a match and its reference
+#define LZ_MAX_OFFSET 0xFFFF
+
+/// The last bytes of a block are always literals so that the decoder never reads past the end of a match
+#define LZ_LAST_LITERALS 5
+
+/// Write a little endian 32 bit value
+/// \param pDst the destination
+/// \param uiValue the value
+static void WriteUInt32(char* pDst, unsigned int uiValue)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        pDst[i] = static_cast<char>((uiValue >> (i * 8)) & 0xFF);
+    }
+}
+
+/// Read a little endian 32 bit value
+/// \param pSrc the source
+/// \return the value
+static unsigned int ReadUInt32(const char* pSrc)
+{
+    unsigned int uiValue = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        uiValue |= static_cast<unsigned int>(static_cast<unsigned char>(pSrc[i])) << (i * 8);
+    }
+
+    return uiValue;
+}
+
+/// Append a length that did not fit in its 4 bit token field
+/// \param out the compressed data
+/// \param length the remaining length (length of the sequence minus 15)
+static void WriteLengthExtension(vector<char>& out, size_t length)
+{
+    while (length >= 0xFF)
+    {
+        out.push_back(static_cast<char>(0xFF));
+        length -= 0xFF;
+    }
+
+    out.push_back(static_cast<char>(length));
+}
+
+/// Append a sequence: a token, the literals and, unless it is the last sequence, a match
+/// \param out the compressed data
+/// \param pLiterals the literals
+/// \param numLiterals the number of literals
+/// \param offset the distance to the match reference, 0 for the last sequence
+/// \param matchLength the match length
+static void WriteSequence(vector<char>& out, const char* pLiterals, size_t numLiterals, size_t offset, size_t matchLength)
+{
+    size_t matchCode = 0 != offset ? matchLength - LZ_MIN_MATCH : 0;
+    out.push_back(static_cast<char>((min<size_t>(numLiterals, 15) << 4) | min<size_t>(matchCode, 15)));
+
+    if (numLiterals >= 15)
+    {
+        WriteLengthExtension(out, numLiterals - 15);
+    }
+
+    out.insert(out.end(), pLiterals, pLiterals + numLiterals);
+
+    if (0 != offset)
+    {
+        out.push_back(static_cast<char>(offset & 0xFF));
+        out.push_back(static_cast<char>(offset >> 8));
+
+        if (matchCode >= 15)
+        {
+            WriteLengthExtension(out, matchCode - 15);
+        }
+    }
+}
+
+/// Compress a block with a byte oriented LZ77 codec (LZ4 style sequences)
+/// \param pSrc the data
+/// \param size the size of the data
+/// \param[out] out the compressed data
+static void LZCompress(const char* pSrc, size_t size, vector<char>& out)
+{
+    const unsigned int EMPTY_SLOT = 0xFFFFFFFF;
+    unsigned int hashTable[1 << LZ_HASH_BITS];
+    fill(hashTable, hashTable + (1 << LZ_HASH_BITS), EMPTY_SLOT);
+
+    out.clear();
+    out.reserve(size + size / 255 + 16);
+
+    size_t anchor = 0;
+    size_t pos = 0;
+
+    while (pos + LZ_MIN_MATCH + LZ_LAST_LITERALS <= size)
+    {
+        unsigned int uiSequence;
+        memcpy(&uiSequence, pSrc + pos, sizeof(uiSequence));
+        unsigned int uiHash = (uiSequence * 2654435761U) >> (32 - LZ_HASH_BITS);
+        unsigned int uiRef = hashTable[uiHash];
+        hashTable[uiHash] = static_cast<unsigned int>(pos);
+
+        if (EMPTY_SLOT == uiRef || pos - uiRef > LZ_MAX_OFFSET || 0 != memcmp(pSrc + uiRef, pSrc + pos, LZ_MIN_MATCH))
+        {
+            pos++;
+            continue;
+        }
+
+        size_t matchLength = LZ_MIN_MATCH;
+
+        while (pos + matchLength < size - LZ_LAST_LITERALS && pSrc[uiRef + matchLength] == pSrc[pos + matchLength])
+        {
+            matchLength++;
+        }
+
+        WriteSequence(out, pSrc + anchor, pos - anchor, pos - uiRef, matchLength);
+        pos += matchLength;
+        anchor = pos;
+    }
+
+    WriteSequence(out, pSrc + anchor, size - anchor, 0, 0);
+}
+
+/// Read a length that did not fit in its 4 bit token field
+/// \param pSrc the compressed data
+/// \param srcSize the size of the compressed data
+/// \param[in,out] pos the read position
+/// \param[in,out] length the length to extend
+/// \return false if the data is truncated
+static bool ReadLengthExtension(const char* pSrc, size_t srcSize, size_t& pos, size_t& length)
+{
+    unsigned char byte;
+
+    do
+    {
+        if (pos >= srcSize)
+        {
+            return false;
+        }
+
+        byte = static_cast<unsigned char>(pSrc[pos++]);
+        length += byte;
+    }
+    while (0xFF == byte);
+
+    return true;
+}
+
+/// Decompress a block written by LZCompress
+/// \param pSrc the compressed data
+/// \param srcSize the size of the compressed data
+/// \param pDst the destination
+/// \param dstSize the size of the uncompressed data
+/// \return false if the data is invalid
+static bool LZDecompress(const char* pSrc, size_t srcSize, char* pDst, size_t dstSize)
+{
+    size_t srcPos = 0;
+    size_t dstPos = 0;
+
+    while (srcPos < srcSize)
+    {
+        unsigned char token = static_cast<unsigned char>(pSrc[srcPos++]);
+        size_t numLiterals = token >> 4;
+
+        if (15 == numLiterals && !ReadLengthExtension(pSrc, srcSize, srcPos, numLiterals))
+        {
+            return false;
+        }
+
+        if (numLiterals > srcSize - srcPos || numLiterals > dstSize - dstPos)
+        {
+            return false;
+        }
+
+        memcpy(pDst + dstPos, pSrc + srcPos, numLiterals);
+        srcPos += numLiterals;
+        dstPos += numLiterals;
+
+        if (srcPos == srcSize)
+        {
+            // the last sequence has no match
+            break;
+        }
+
+        if (srcSize - srcPos < 2)
+        {
+            return false;
+        }
+
+        size_t offset = static_cast<unsigned char>(pSrc[srcPos]) | (static_cast<size_t>(static_cast<unsigned char>(pSrc[srcPos + 1])) << 8);
+        srcPos += 2;
+        size_t matchLength = token & 0xF;
+
+        if (15 == matchLength && !ReadLengthExtension(pSrc, srcSize, srcPos, matchLength))
+        {
+            return false;
+        }
+
+        matchLength += LZ_MIN_MATCH;
+
+        if (0 == offset || offset > dstPos || matchLength > dstSize - dstPos)
+        {
+            return false;
+        }
+
+        // the reference can overlap the match, copy one byte at a time
+        const char* pRef = pDst + dstPos - offset;
+
+        for (size_t i = 0; i < matchLength; i++)
+        {
+            pDst[dstPos + i] = pRef[i];
+        }
+
+        dstPos += matchLength;
+    }
+
+    return dstPos == dstSize;
+}
+
+CompressedOutputBuffer::CompressedOutputBuffer(size_t blockSize) :
+    m_pSink(nullptr),
+    m_blockSize(blockSize > 0 ? min<size_t>(blockSize, COMPRESSED_BLOCK_MAX_SIZE) : COMPRESSED_BLOCK_SIZE),
+    m_ullUncompressedBytes(0),
+    m_ullStoredBytes(0)
+{
+}
+
+CompressedOutputBuffer::~CompressedOutputBuffer()
+{
+    WriteBlock();
+}
+
+void CompressedOutputBuffer::Attach(std::ostream& out)
+{
+    WriteBlock();
+
+    // the block is allocated here so that an unused buffer costs nothing
+    if (m_block.empty())
+    {
+        m_block.resize(m_blockSize);
+        setp(&m_block[0], &m_block[0] + m_block.size());
+    }
+
+    m_pSink = out.rdbuf();
+    out.rdbuf(this);
+}
+
+CompressedOutputBuffer::int_type CompressedOutputBuffer::overflow(int_type ch)
+{
+    if (nullptr == m_pSink || !WriteBlock())
+    {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+int CompressedOutputBuffer::sync()
+{
+    if (!WriteBlock() || (nullptr != m_pSink && 0 != m_pSink->pubsync()))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+bool CompressedOutputBuffer::WriteBlock()
+{
+    size_t size = static_cast<size_t>(pptr() - pbase());
+
+    if (0 == size || nullptr == m_pSink)
+    {
+        return true;
+    }
+
+    LZCompress(pbase(), size, m_compressed);
+
+    unsigned int uiFlags = COMPRESSED_BLOCK_FLAG_LZ;
+    const char* pData = &m_compressed[0];
+    size_t storedSize = m_compressed.size();
+
+    if (storedSize >= size)
+    {
+        // incompressible data is stored as is
+        uiFlags = 0;
+        pData = pbase();
+        storedSize = size;
+    }
+
+    char header[COMPRESSED_BLOCK_HEADER_SIZE];
+    memcpy(header, COMPRESSED_BLOCK_SIGNATURE, COMPRESSED_BLOCK_SIGNATURE_SIZE);
+    WriteUInt32(header + 4, static_cast<unsigned int>(size));
+    WriteUInt32(header + 8, static_cast<unsigned int>(storedSize));
+    WriteUInt32(header + 12, uiFlags);
+
+    setp(&m_block[0], &m_block[0] + m_block.size());
+
+    if (m_pSink->sputn(header, COMPRESSED_BLOCK_HEADER_SIZE) != COMPRESSED_BLOCK_HEADER_SIZE ||
+        m_pSink->sputn(pData, static_cast<streamsize>(storedSize)) != static_cast<streamsize>(storedSize))
+    {
+        Log(logERROR, "CompressedOutputBuffer: failed to write a block of %llu bytes\n", static_cast<unsigned long long>(storedSize));
+        return false;
+    }
+
+    m_ullUncompressedBytes += size;
+    m_ullStoredBytes += COMPRESSED_BLOCK_HEADER_SIZE + storedSize;
+    return true;
+}
+
+bool CompressedOutputBuffer::CompressFile(const std::string& strFileName)
+{
+    string strTmpFileName = strFileName + ".tmp";
+
+    ifstream fin(strFileName.c_str(), ios_base::in | ios_base::binary);
+    ofstream fout(strTmpFileName.c_str(), ios_base::out | ios_base::trunc | ios_base::binary);
+
+    if (fin.fail() || fout.fail())
+    {
+        Log(logERROR, "Failed to compress %s\n", strFileName.c_str());
+        return false;
+    }
+
+    CompressedOutputBuffer buffer;
+    buffer.Attach(fout);
+
+    if (ifstream::traits_type::eof() != fin.peek())
+    {
+        fout << fin.rdbuf();
+    }
+
+    fout.flush();
+    bool bFailed = fout.fail();
+    fin.close();
+    fout.close();
+
+    if (bFailed || 0 != remove(strFileName.c_str()) || 0 != rename(strTmpFileName.c_str(), strFileName.c_str()))
+    {
+        Log(logERROR, "Failed to replace %s by its compressed version\n", strFileName.c_str());
+        remove(strTmpFileName.c_str());
+        return false;
+    }
+
+    Log(logMESSAGE, "Compressed %s: %llu bytes to %llu bytes\n", strFileName.c_str(), buffer.GetUncompressedBytes(), buffer.GetStoredBytes());
+    return true;
+}
+
+DecompressedInputBuffer::DecompressedInputBuffer() :
+    m_pSource(nullptr),
+    m_currentBlock(0)
+{
+}
+
+bool DecompressedInputBuffer::Attach(std::streambuf* pSource)
+{
+    Detach();
+
+    char signature[COMPRESSED_BLOCK_SIGNATURE_SIZE];
+
+    if (nullptr == pSource ||
+        pSource->sgetn(signature, COMPRESSED_BLOCK_SIGNATURE_SIZE) != COMPRESSED_BLOCK_SIGNATURE_SIZE ||
+        0 != memcmp(signature, COMPRESSED_BLOCK_SIGNATURE, COMPRESSED_BLOCK_SIGNATURE_SIZE))
+    {
+        if (nullptr != pSource)
+        {
+            pSource->pubseekpos(0, ios_base::in);
+        }
+
+        return false;
+    }
+
+    m_pSource = pSource;
+
+    BlockLocation first = { 0, 0 };
+    m_blocks.push_back(first);
+    return true;
+}
+
+void DecompressedInputBuffer::Detach()
+{
+    m_pSource = nullptr;
+    m_blocks.clear();
+    m_currentBlock = 0;
+    m_block.clear();
+    setg(nullptr, nullptr, nullptr);
+}
+
+bool DecompressedInputBuffer::ReadBlock(size_t blockIndex)
+{
+    if (nullptr == m_pSource || blockIndex >= m_blocks.size())
+    {
+        return false;
+    }
+
+    BlockLocation location = m_blocks[blockIndex];
+    char header[COMPRESSED_BLOCK_HEADER_SIZE];
+
+    if (m_pSource->pubseekpos(location.m_fileOffset, ios_base::in) != streampos(location.m_fileOffset) ||
+        m_pSource->sgetn(header, COMPRESSED_BLOCK_HEADER_SIZE) != COMPRESSED_BLOCK_HEADER_SIZE)
+    {
+        // end of the file
+        return false;
+    }
+
+    size_t size = ReadUInt32(header + 4);
+    size_t storedSize = ReadUInt32(header + 8);
+    unsigned int uiFlags = ReadUInt32(header + 12);
+
+    if (0 != memcmp(header, COMPRESSED_BLOCK_SIGNATURE, COMPRESSED_BLOCK_SIGNATURE_SIZE) ||
+        0 == size || size > COMPRESSED_BLOCK_MAX_SIZE || storedSize > COMPRESSED_BLOCK_MAX_SIZE)
+    {
+        Log(logWARNING, "DecompressedInputBuffer: invalid block header at offset %llu\n", static_cast<unsigned long long>(location.m_fileOffset));
+        return false;
+    }
+
+    // the current block stays valid if this one can't be read
+    m_nextBlock.resize(size);
+    bool bValid = false;
+
+    if (0 != (uiFlags & COMPRESSED_BLOCK_FLAG_LZ))
+    {
+        m_stored.resize(storedSize);
+        bValid = m_pSource->sgetn(&m_stored[0], static_cast<streamsize>(storedSize)) == static_cast<streamsize>(storedSize) &&
+                 LZDecompress(&m_stored[0], storedSize, &m_nextBlock[0], size);
+    }
+    else
+    {
+        bValid = storedSize == size &&
+                 m_pSource->sgetn(&m_nextBlock[0], static_cast<streamsize>(size)) == static_cast<streamsize>(size);
+    }
+
+    if (!bValid)
+    {
+        // the application can be terminated while a block is written
+        Log(logWARNING, "DecompressedInputBuffer: truncated or invalid block at offset %llu\n", static_cast<unsigned long long>(location.m_fileOffset));
+        return false;
+    }
+
+    if (blockIndex + 1 == m_blocks.size())
+    {
+        BlockLocation next = { location.m_fileOffset + static_cast<streamoff>(COMPRESSED_BLOCK_HEADER_SIZE + storedSize), location.m_ullOffset + size };
+        m_blocks.push_back(next);
+    }
+
+    m_block.swap(m_nextBlock);
+    m_currentBlock = blockIndex;
+    setg(&m_block[0], &m_block[0], &m_block[0] + size);
+    return true;
+}
+
+DecompressedInputBuffer::int_type DecompressedInputBuffer::underflow()
+{
+    if (gptr() < egptr())
+    {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    size_t nextBlock = nullptr == eback() ? 0 : m_currentBlock + 1;
+
+    if (!ReadBlock(nextBlock))
+    {
+        return traits_type::eof();
+    }
+
+    return traits_type::to_int_type(*gptr());
+}
+
+DecompressedInputBuffer::pos_type DecompressedInputBuffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (0 == (which & ios_base::in) || nullptr == m_pSource || ios_base::end == dir)
+    {
+        return pos_type(off_type(-1));
+    }
+
+    if (ios_base::cur == dir)
+    {
+        unsigned long long ullCurrent = nullptr == eback() ? 0 : m_blocks[m_currentBlock].m_ullOffset + static_cast<unsigned long long>(gptr() - eback());
+
+        if (0 == off)
+        {
+            // tellg
+            return pos_type(off_type(ullCurrent));
+        }
+
+        off += static_cast<off_type>(ullCurrent);
+    }
+
+    return seekpos(pos_type(off), which);
+}
+
+DecompressedInputBuffer::pos_type DecompressedInputBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    off_type offset = off_type(pos);
+
+    if (0 == (which & ios_base::in) || nullptr == m_pSource || offset < 0)
+    {
+        return pos_type(off_type(-1));
+    }
+
+    unsigned long long ullOffset = static_cast<unsigned long long>(offset);
+
+    // find the last known block starting at or before the position
+    size_t blockIndex = 0;
+
+    while (blockIndex + 1 < m_blocks.size() && m_blocks[blockIndex + 1].m_ullOffset <= ullOffset)
+    {
+        blockIndex++;
+    }
+
+    if (nullptr == eback() || blockIndex != m_currentBlock)
+    {
+        if (!ReadBlock(blockIndex))
+        {
+            // the location after the last block is known once that block has been read, it is the end of the data
+            if (0 == blockIndex || ullOffset != m_blocks[blockIndex].m_ullOffset ||
+                ((nullptr == eback() || blockIndex - 1 != m_currentBlock) && !ReadBlock(blockIndex - 1)))
+            {
+                return pos_type(off_type(-1));
+            }
+
+            setg(&m_block[0], &m_block[0] + m_block.size(), &m_block[0] + m_block.size());
+            return pos;
+        }
+    }
+
+    // the position is after the blocks found so far, read forward
+    while (ullOffset >= m_blocks[m_currentBlock].m_ullOffset + m_block.size())
+    {
+        if (!ReadBlock(m_currentBlock + 1))
+        {
+            if (ullOffset == m_blocks[m_currentBlock].m_ullOffset + m_block.size())
+            {
+                // end of the data
+                setg(&m_block[0], &m_block[0] + m_block.size(), &m_block[0] + m_block.size());
+                return pos;
+            }
+
+            return pos_type(off_type(-1));
+        }
+    }
+
+    setg(&m_block[0], &m_block[0] + (ullOffset - m_blocks[m_currentBlock].m_ullOffset), &m_block[0] + m_block.size());
+    return pos;
+}
+
+InputFileStream::InputFileStream() :
+    std::istream(nullptr)
+{
+}
+
+InputFileStream::InputFileStream(const char* szFileName, std::ios_base::openmode mode) :
+    std::istream(nullptr)
+{
+    open(szFileName, mode);
+}
+
+template <typename CharType>
+void InputFileStream::SetupBuffer(const CharType* szFileName, std::ios_base::openmode mode)
+{
+    m_decompressed.Detach();
+
+    if (nullptr == m_file.open(szFileName, ios_base::in | ios_base::binary))
+    {
+        rdbuf(&m_file);
+        setstate(ios_base::failbit);
+        return;
+    }
+
+    if (m_decompressed.Attach(&m_file))
+    {
+        rdbuf(&m_decompressed);
+        return;
+    }
+
+    if (0 == (mode & ios_base::binary))
+    {
+        // reopen the text file in text mode so that line endings are converted
+        m_file.close();
+
+        if (nullptr == m_file.open(szFileName, mode | ios_base::in))
+        {
+            rdbuf(&m_file);
+            setstate(ios_base::failbit);
+            return;
+        }
+    }
+
+    rdbuf(&m_file);
+}
+
+void InputFileStream::open(const char* szFileName, std::ios_base::openmode mode)
+{
+    SetupBuffer(szFileName, mode);
+}
+
+#ifdef _WIN32
+void InputFileStream::open(const wchar_t* szFileName, std::ios_base::openmode mode)
+{
+    SetupBuffer(szFileName, mode);
+}
+#endif
+
+void InputFileStream::close()
+{
+    m_decompressed.Detach();
+
+    if (nullptr == m_file.close())
+    {
+        setstate(ios_base::failbit);
+    }
+}
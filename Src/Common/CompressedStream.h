@@ -0,0 +1,235 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief These classes write and read files made of independently compressed
+///        blocks (trace fragments, .atp and kernel .csv files).
+//==============================================================================
+
+#ifndef _COMPRESSED_STREAM_H_
+#define _COMPRESSED_STREAM_H_
+
+/// \defgroup CompressedStream CompressedStream
+/// This module implements the block compressed file format
+///
+/// \ingroup Common
+// @{
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <fstream>
+
+/// Signature at the start of every block, a text file can't start with it
+#define COMPRESSED_BLOCK_SIGNATURE "\x89RCZ"
+
+/// Size of the block signature
+#define COMPRESSED_BLOCK_SIGNATURE_SIZE 4
+
+/// Size of the block header: signature, uncompressed size, stored size and flags (little endian 32 bit values)
+#define COMPRESSED_BLOCK_HEADER_SIZE 16
+
+/// Block header flag indicating that the block data is compressed, otherwise it is stored as is
+#define COMPRESSED_BLOCK_FLAG_LZ 0x1
+
+/// Default amount of uncompressed data in a block, matches the window of the codec
+#define COMPRESSED_BLOCK_SIZE (64 * 1024)
+
+/// Largest uncompressed block size accepted by the reader
+#define COMPRESSED_BLOCK_MAX_SIZE (16 * 1024 * 1024)
+
+//------------------------------------------------------------------------------------
+/// Stream buffer that compresses the data written to it into blocks and writes the
+/// blocks to the buffer it replaces in an output stream.
+/// A block ends when the buffer is full or the stream is flushed, so appending to an
+/// existing compressed file (or flushing at any time) produces a valid file, and a
+/// reader can seek to any block without decompressing the previous ones.
+//------------------------------------------------------------------------------------
+class CompressedOutputBuffer : public std::streambuf
+{
+public:
+    /// Constructor
+    /// \param blockSize amount of uncompressed data in a block
+    explicit CompressedOutputBuffer(size_t blockSize = COMPRESSED_BLOCK_SIZE);
+
+    /// Destructor, writes the pending block
+    ~CompressedOutputBuffer();
+
+    /// Compress the data written to a stream, the stream must be opened in binary mode
+    /// \param out the output stream, its current buffer receives the compressed blocks
+    void Attach(std::ostream& out);
+
+    /// Get the amount of data written to the buffer
+    /// \return the number of uncompressed bytes written to the blocks so far
+    unsigned long long GetUncompressedBytes() const { return m_ullUncompressedBytes; }
+
+    /// Get the amount of data written to the underlying buffer
+    /// \return the number of bytes (headers included) of the blocks written so far
+    unsigned long long GetStoredBytes() const { return m_ullStoredBytes; }
+
+    /// Replace a file by its compressed version, the file is read and compressed one block at a time
+    /// \param strFileName the file name
+    /// \return true if the file was compressed
+    static bool CompressFile(const std::string& strFileName);
+
+protected:
+    /// Called when the block is full
+    /// \param ch the character that did not fit in the block
+    /// \return ch, or eof if the block could not be written
+    int_type overflow(int_type ch) override;
+
+    /// Called when the stream is flushed, writes the pending block
+    /// \return 0 if succeeded, -1 otherwise
+    int sync() override;
+
+private:
+    /// Compress the pending data and write it as a new block
+    /// \return false if the underlying buffer failed
+    bool WriteBlock();
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    CompressedOutputBuffer(const CompressedOutputBuffer& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    CompressedOutputBuffer& operator=(const CompressedOutputBuffer& obj) = delete;
+
+    std::streambuf*    m_pSink;                ///< buffer receiving the compressed blocks
+    size_t             m_blockSize;            ///< amount of uncompressed data in a block
+    std::vector<char>  m_block;                ///< uncompressed data of the pending block, allocated by Attach
+    std::vector<char>  m_compressed;           ///< compressed data of the block being written
+    unsigned long long m_ullUncompressedBytes; ///< number of uncompressed bytes written to the blocks
+    unsigned long long m_ullStoredBytes;       ///< number of bytes of the blocks written
+};
+
+//------------------------------------------------------------------------------------
+/// Stream buffer that reads the uncompressed data of a file written by a
+/// CompressedOutputBuffer. Positions are offsets in the uncompressed data; the
+/// blocks found so far are indexed so that seeking back only reads one block.
+//------------------------------------------------------------------------------------
+class DecompressedInputBuffer : public std::streambuf
+{
+public:
+    /// Constructor
+    DecompressedInputBuffer();
+
+    /// Check whether a buffer starts with a compressed block and read from it if it does
+    /// \param pSource the buffer of the file, positioned at the start of the file
+    /// \return false if the file is not compressed, pSource is moved back to the start of the file
+    bool Attach(std::streambuf* pSource);
+
+    /// Stop reading from the attached buffer
+    void Detach();
+
+protected:
+    /// Called when the current block has been read
+    /// \return the first character of the next block, or eof
+    int_type underflow() override;
+
+    /// Move to a position relative to the start or the current position (the end is not supported)
+    /// \param off the offset
+    /// \param dir the origin
+    /// \param which the sequence, only input is supported
+    /// \return the new position or -1 if failed
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+    /// Move to a position
+    /// \param pos the position in the uncompressed data
+    /// \param which the sequence, only input is supported
+    /// \return the new position or -1 if failed
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+private:
+    /// Location of a block
+    struct BlockLocation
+    {
+        std::streamoff     m_fileOffset;   ///< offset of the block header in the file
+        unsigned long long m_ullOffset;    ///< offset of the first byte of the block in the uncompressed data
+    };
+
+    /// Read and decompress a block, m_blocks must contain its location
+    /// \param blockIndex the block index
+    /// \return false if the block is missing (end of the file) or invalid
+    bool ReadBlock(size_t blockIndex);
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    DecompressedInputBuffer(const DecompressedInputBuffer& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    DecompressedInputBuffer& operator=(const DecompressedInputBuffer& obj) = delete;
+
+    std::streambuf*            m_pSource;      ///< buffer of the compressed file
+    std::vector<BlockLocation> m_blocks;       ///< blocks found so far, the last one is the next block to read
+    size_t                     m_currentBlock; ///< index of the block in m_block
+    std::vector<char>          m_block;        ///< uncompressed data of the current block
+    std::vector<char>          m_nextBlock;    ///< uncompressed data of the block being read
+    std::vector<char>          m_stored;       ///< stored data of the block being read
+};
+
+//------------------------------------------------------------------------------------
+/// Input file stream reading either a text file or a compressed file. It mimics the
+/// std::ifstream interface used by the parsers so that it can replace it as is.
+//------------------------------------------------------------------------------------
+class InputFileStream : public std::istream
+{
+public:
+    /// Constructor
+    InputFileStream();
+
+    /// Constructor, opens a file
+    /// \param szFileName the file name
+    /// \param mode the open mode
+    explicit InputFileStream(const char* szFileName, std::ios_base::openmode mode = std::ios_base::in);
+
+    /// Open a file, compressed files are detected from their first block
+    /// \param szFileName the file name
+    /// \param mode the open mode
+    void open(const char* szFileName, std::ios_base::openmode mode = std::ios_base::in);
+
+#ifdef _WIN32
+    /// Open a file, compressed files are detected from their first block
+    /// \param szFileName the file name
+    /// \param mode the open mode
+    void open(const wchar_t* szFileName, std::ios_base::openmode mode = std::ios_base::in);
+#endif
+
+    /// Check whether the file is open
+    /// \return true if the file is open
+    bool is_open() const { return m_file.is_open(); }
+
+    /// Check whether the file is compressed
+    /// \return true if the data is decompressed while it is read
+    bool IsCompressed() const { return rdbuf() == &m_decompressed; }
+
+    /// Close the file
+    void close();
+
+private:
+    /// Select the buffer the stream reads from once the file is opened in binary mode
+    /// \param szFileName the file name
+    /// \param mode the open mode requested by the caller
+    template <typename CharType>
+    void SetupBuffer(const CharType* szFileName, std::ios_base::openmode mode);
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    InputFileStream(const InputFileStream& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    InputFileStream& operator=(const InputFileStream& obj) = delete;
+
+    std::filebuf            m_file;         ///< buffer of the file
+    DecompressedInputBuffer m_decompressed; ///< buffer used if the file is compressed
+};
+
+// @}
+
+#endif //_COMPRESSED_STREAM_H_
@@ -0,0 +1,471 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class is a read-mostly hash map whose lookups never take a
+///        lock. It is used for the caches filled once and for the registries
+///        of API object handles, whose entries are removed on release.
+//==============================================================================
+
+#ifndef _CONCURRENT_HASH_MAP_H_
+#define _CONCURRENT_HASH_MAP_H_
+
+/// \defgroup ConcurrentHashMap ConcurrentHashMap
+/// This module implements a read-mostly hash map with lock-free lookups
+///
+/// \ingroup Common
+// @{
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <functional>
+
+#include "DeferredReclaimer.h"
+
+/// Initial number of buckets of a ConcurrentHashMap
+#define CONCURRENT_HASH_MAP_INITIAL_BUCKETS 64
+
+/// Average number of entries per bucket above which a ConcurrentHashMap doubles its number of buckets
+#define CONCURRENT_HASH_MAP_MAX_LOAD 2
+
+//------------------------------------------------------------------------------------
+/// Hash map with lock-free lookups. Writers are serialized by a mutex. Entries are
+/// immutable: a new entry is published at the head of its bucket with a release store,
+/// replacing a value links a new entry in place of the old one. The bucket array is
+/// replaced by a twice larger copy when the map grows.
+/// Readers traverse the buckets in a DeferredReclaimer read section, the entries and
+/// bucket arrays that are unlinked are retired and deleted once no reader can reach
+/// them, so Find copies the value out of the entry.
+//------------------------------------------------------------------------------------
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ConcurrentHashMap
+{
+public:
+    /// Constructor
+    ConcurrentHashMap() : m_pTable(nullptr), m_size(0)
+    {
+        m_pTable.store(NewTable(CONCURRENT_HASH_MAP_INITIAL_BUCKETS), std::memory_order_relaxed);
+    }
+
+    /// Destructor, no other thread may use the map
+    ~ConcurrentHashMap()
+    {
+        DeleteTable(m_pTable.load(std::memory_order_relaxed));
+    }
+
+    /// Find the value of a key, never blocks
+    /// \param key the key
+    /// \param[out] value the value of the key
+    /// \return false if the key is not in the map
+    bool Find(const Key& key, Value& value) const
+    {
+        size_t hash = Hash()(key);
+        DeferredReclaimer::ReadSection section;
+
+        const Table* pTable = m_pTable.load(std::memory_order_acquire);
+        const Node* pNode = nullptr != pTable ? FindNode(key, hash, pTable) : nullptr;
+
+        if (nullptr == pNode)
+        {
+            return false;
+        }
+
+        value = pNode->m_value;
+        return true;
+    }
+
+    /// Add a key, or replace its value if it is already in the map
+    /// \param key the key
+    /// \param value the value
+    /// \return false if the entry could not be allocated
+    bool Set(const Key& key, const Value& value)
+    {
+        size_t hash = Hash()(key);
+
+        std::lock_guard<std::mutex> lock(m_mtx);
+
+        Table* pTable = GetTable();
+
+        if (nullptr == pTable)
+        {
+            return false;
+        }
+
+        std::atomic<Node*>* pLink = FindLink(key, hash, pTable);
+        Node* pOldNode = pLink->load(std::memory_order_relaxed);
+
+        if (nullptr == pOldNode)
+        {
+            return AddNode(key, value, hash, pTable);
+        }
+
+        Node* pNode = new(std::nothrow) Node(key, value, hash, pOldNode->m_pNext.load(std::memory_order_relaxed));
+
+        if (nullptr == pNode)
+        {
+            return false;
+        }
+
+        pLink->store(pNode, std::memory_order_release);
+        DeferredReclaimer::Instance()->Retire(pOldNode, DeleteNode);
+
+        return true;
+    }
+
+    /// Add a key, the value stored first is kept if the key is already in the map
+    /// \param key the key
+    /// \param value the value
+    /// \param[out] storedValue the value of the key in the map
+    /// \return false if the entry could not be allocated
+    bool Insert(const Key& key, const Value& value, Value& storedValue)
+    {
+        size_t hash = Hash()(key);
+
+        std::lock_guard<std::mutex> lock(m_mtx);
+
+        Table* pTable = GetTable();
+
+        if (nullptr == pTable)
+        {
+            return false;
+        }
+
+        const Node* pNode = FindNode(key, hash, pTable);
+
+        if (nullptr != pNode)
+        {
+            storedValue = pNode->m_value;
+            return true;
+        }
+
+        if (!AddNode(key, value, hash, pTable))
+        {
+            return false;
+        }
+
+        storedValue = value;
+        return true;
+    }
+
+    /// Remove a key
+    /// \param key the key
+    /// \return false if the key is not in the map
+    bool Remove(const Key& key)
+    {
+        size_t hash = Hash()(key);
+
+        std::lock_guard<std::mutex> lock(m_mtx);
+
+        Table* pTable = m_pTable.load(std::memory_order_relaxed);
+
+        if (nullptr == pTable)
+        {
+            return false;
+        }
+
+        std::atomic<Node*>* pLink = FindLink(key, hash, pTable);
+        Node* pNode = pLink->load(std::memory_order_relaxed);
+
+        if (nullptr == pNode)
+        {
+            return false;
+        }
+
+        // a reader on the removed entry still reaches the rest of the bucket
+        pLink->store(pNode->m_pNext.load(std::memory_order_relaxed), std::memory_order_release);
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        DeferredReclaimer::Instance()->Retire(pNode, DeleteNode);
+
+        return true;
+    }
+
+    /// Remove all keys
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+
+        Table* pOldTable = m_pTable.load(std::memory_order_relaxed);
+
+        if (nullptr == pOldTable)
+        {
+            return;
+        }
+
+        Table* pTable = NewTable(CONCURRENT_HASH_MAP_INITIAL_BUCKETS);
+
+        if (nullptr != pTable)
+        {
+            m_pTable.store(pTable, std::memory_order_release);
+            DeferredReclaimer::Instance()->Retire(pOldTable, DeleteTable);
+        }
+        else
+        {
+            // keep the bucket array, retire the bucket lists
+            for (size_t i = 0; i < pOldTable->m_numBuckets; i++)
+            {
+                Node* pHead = pOldTable->m_pBuckets[i].exchange(nullptr, std::memory_order_acq_rel);
+
+                if (nullptr != pHead)
+                {
+                    DeferredReclaimer::Instance()->Retire(pHead, DeleteNodeList);
+                }
+            }
+        }
+
+        m_size.store(0, std::memory_order_relaxed);
+    }
+
+    /// Get the number of entries
+    /// \return the number of entries
+    size_t GetSize() const
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    /// Get the number of buckets
+    /// \return the number of buckets
+    size_t GetNumBuckets() const
+    {
+        DeferredReclaimer::ReadSection section;
+        const Table* pTable = m_pTable.load(std::memory_order_acquire);
+        return nullptr != pTable ? pTable->m_numBuckets : 0;
+    }
+
+private:
+    /// Entry of a bucket list
+    struct Node
+    {
+        /// Constructor
+        /// \param key the key
+        /// \param value the value
+        /// \param hash the hash value of the key
+        /// \param pNext the next entry of the bucket
+        Node(const Key& key, const Value& value, size_t hash, Node* pNext) : m_key(key), m_value(value), m_hash(hash), m_pNext(pNext)
+        {
+        }
+
+        const Key          m_key;    ///< key
+        const Value        m_value;  ///< value
+        const size_t       m_hash;   ///< hash value of the key
+        std::atomic<Node*> m_pNext;  ///< next entry of the bucket, changed when the next entry is removed or replaced
+    };
+
+    /// Bucket array, replaced by a larger one when the map grows
+    struct Table
+    {
+        size_t              m_numBuckets; ///< number of buckets, a power of two
+        std::atomic<Node*>* m_pBuckets;   ///< head of the entry list of each bucket
+    };
+
+    /// Allocate an empty bucket array
+    /// \param numBuckets the number of buckets, a power of two
+    /// \return the bucket array, NULL if it could not be allocated
+    static Table* NewTable(size_t numBuckets)
+    {
+        Table* pTable = new(std::nothrow) Table;
+
+        if (nullptr == pTable)
+        {
+            return nullptr;
+        }
+
+        pTable->m_numBuckets = numBuckets;
+        pTable->m_pBuckets = new(std::nothrow) std::atomic<Node*>[numBuckets];
+
+        if (nullptr == pTable->m_pBuckets)
+        {
+            delete pTable;
+            return nullptr;
+        }
+
+        for (size_t i = 0; i < numBuckets; i++)
+        {
+            pTable->m_pBuckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        return pTable;
+    }
+
+    /// Get the current bucket array, allocated if the constructor could not allocate it, m_mtx must be locked
+    /// \return the bucket array, NULL if it could not be allocated
+    Table* GetTable()
+    {
+        Table* pTable = m_pTable.load(std::memory_order_relaxed);
+
+        if (nullptr == pTable)
+        {
+            pTable = NewTable(CONCURRENT_HASH_MAP_INITIAL_BUCKETS);
+            m_pTable.store(pTable, std::memory_order_release);
+        }
+
+        return pTable;
+    }
+
+    /// Get the bucket of a hash value
+    /// \param hash the hash value
+    /// \param pTable the bucket array
+    /// \return the bucket
+    static std::atomic<Node*>& GetBucket(size_t hash, const Table* pTable)
+    {
+        // handles are addresses of heap objects, their low bits are mostly the same
+        return pTable->m_pBuckets[(hash ^ (hash >> 4) ^ (hash >> 16)) & (pTable->m_numBuckets - 1)];
+    }
+
+    /// Find a key
+    /// \param key the key
+    /// \param hash the hash value of the key
+    /// \param pTable the bucket array
+    /// \return the entry, NULL if the key is not in the map
+    static const Node* FindNode(const Key& key, size_t hash, const Table* pTable)
+    {
+        for (const Node* pNode = GetBucket(hash, pTable).load(std::memory_order_acquire); nullptr != pNode; pNode = pNode->m_pNext.load(std::memory_order_acquire))
+        {
+            if (pNode->m_hash == hash && pNode->m_key == key)
+            {
+                return pNode;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /// Find the link to the entry of a key, m_mtx must be locked
+    /// \param key the key
+    /// \param hash the hash value of the key
+    /// \param pTable the bucket array
+    /// \return the bucket head or the m_pNext member pointing to the entry, pointing to NULL if the key is not in the map
+    static std::atomic<Node*>* FindLink(const Key& key, size_t hash, Table* pTable)
+    {
+        std::atomic<Node*>* pLink = &GetBucket(hash, pTable);
+
+        for (Node* pNode = pLink->load(std::memory_order_relaxed); nullptr != pNode; pNode = pLink->load(std::memory_order_relaxed))
+        {
+            if (pNode->m_hash == hash && pNode->m_key == key)
+            {
+                break;
+            }
+
+            pLink = &pNode->m_pNext;
+        }
+
+        return pLink;
+    }
+
+    /// Add an entry for a key that is not in the map and grow the map if needed, m_mtx must be locked
+    /// \param key the key
+    /// \param value the value
+    /// \param hash the hash value of the key
+    /// \param pTable the current bucket array
+    /// \return false if the entry could not be allocated
+    bool AddNode(const Key& key, const Value& value, size_t hash, Table* pTable)
+    {
+        std::atomic<Node*>& bucket = GetBucket(hash, pTable);
+        Node* pNode = new(std::nothrow) Node(key, value, hash, bucket.load(std::memory_order_relaxed));
+
+        if (nullptr == pNode)
+        {
+            return false;
+        }
+
+        bucket.store(pNode, std::memory_order_release);
+
+        if (m_size.fetch_add(1, std::memory_order_relaxed) + 1 > pTable->m_numBuckets * CONCURRENT_HASH_MAP_MAX_LOAD)
+        {
+            Grow(pTable);
+        }
+
+        return true;
+    }
+
+    /// Replace the bucket array by a copy with twice as many buckets, m_mtx must be locked.
+    /// The map keeps its bucket array if the copy can't be allocated
+    /// \param pOldTable the current bucket array
+    void Grow(Table* pOldTable)
+    {
+        Table* pTable = NewTable(pOldTable->m_numBuckets * 2);
+
+        if (nullptr == pTable)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < pOldTable->m_numBuckets; i++)
+        {
+            for (Node* pOldNode = pOldTable->m_pBuckets[i].load(std::memory_order_relaxed); nullptr != pOldNode; pOldNode = pOldNode->m_pNext.load(std::memory_order_relaxed))
+            {
+                std::atomic<Node*>& bucket = GetBucket(pOldNode->m_hash, pTable);
+                Node* pNode = new(std::nothrow) Node(pOldNode->m_key, pOldNode->m_value, pOldNode->m_hash, bucket.load(std::memory_order_relaxed));
+
+                if (nullptr == pNode)
+                {
+                    DeleteTable(pTable);
+                    return;
+                }
+
+                bucket.store(pNode, std::memory_order_relaxed);
+            }
+        }
+
+        m_pTable.store(pTable, std::memory_order_release);
+        DeferredReclaimer::Instance()->Retire(pOldTable, DeleteTable);
+    }
+
+    /// Delete an entry
+    /// \param pNode the entry
+    static void DeleteNode(void* pNode)
+    {
+        delete static_cast<Node*>(pNode);
+    }
+
+    /// Delete the entries of a bucket list
+    /// \param pHead the head of the bucket list
+    static void DeleteNodeList(void* pHead)
+    {
+        Node* pNode = static_cast<Node*>(pHead);
+
+        while (nullptr != pNode)
+        {
+            Node* pNext = pNode->m_pNext.load(std::memory_order_relaxed);
+            delete pNode;
+            pNode = pNext;
+        }
+    }
+
+    /// Delete a bucket array and its entries
+    /// \param pTable the bucket array
+    static void DeleteTable(void* pTable)
+    {
+        Table* pOldTable = static_cast<Table*>(pTable);
+
+        if (nullptr == pOldTable)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < pOldTable->m_numBuckets; i++)
+        {
+            DeleteNodeList(pOldTable->m_pBuckets[i].load(std::memory_order_relaxed));
+        }
+
+        delete[] pOldTable->m_pBuckets;
+        delete pOldTable;
+    }
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    ConcurrentHashMap(const ConcurrentHashMap& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    ConcurrentHashMap& operator=(const ConcurrentHashMap& obj) = delete;
+
+    std::atomic<Table*> m_pTable; ///< current bucket array
+    std::atomic<size_t> m_size;   ///< number of entries
+    std::mutex          m_mtx;    ///< mutex serializing the writers
+};
+
+// @}
+
+#endif //_CONCURRENT_HASH_MAP_H_
@@ -50,7 +50,8 @@ typedef struct
     bool                bPerfCounter;                       ///< flag indicating the CL performance counter agent to be used
     bool                bTimeOut;                           ///< flag indicating which mode to use
     bool                bQueryRetStat;                      ///< flag indicating whether to always query return status
-    bool                bCollapseClGetEventInfo;            ///< flag indicating whether consecutive identical calls to clGetEventInfo should be collapsed
+    bool                bCollapseClGetEventInfo;            ///< flag indicating whether consecutive identical calls to the polling APIs (clGetEventInfo, hsa_signal_load_*, hsa_signal_wait_*) should be collapsed
+    bool                bAPIStatisticsOnly;                 ///< flag indicating whether only per-API statistics are collected instead of a full API trace
     bool                bSubKernelProfile;                  ///< flag indicating which module to use, performance counter, API tracer or sub-kernel profiler.
     bool                bGMTrace;                           ///< flag indicating whether or not global memory trace is enabled
     bool                bTestMode;                          ///< flag indicating that we're running automated tests. [Hidden option, INTERNAL]
@@ -84,6 +85,18 @@ typedef struct
     bool                bAqlPacketTracing;                  ///< flag indicating whether or not to enable AQL packet tracing
     bool                bDisableKernelDemangling;           ///< flag indicating whether or not to demangle the kernel name
     bool                bNoHSATransferTime;                 ///< flag indicating whether or not HSA transfer time is ignored
+    bool                bTSCTimer;                          ///< flag indicating that timestamps are read from the invariant CPU time stamp counter [Hidden option, INTERNAL]
+    bool                bCompressOutput;                    ///< flag indicating that the tmp fragments, the .atp file and the kernel .csv files are written as compressed blocks [Hidden option, INTERNAL]
+    bool                bOfflineSymbols;                    ///< flag indicating that the stack traces are recorded as raw addresses and symbolized by rcprof [Hidden option, INTERNAL]
+    bool                bNoThreadTraceBuffer;               ///< flag indicating that trace entries are added to the shared trace map instead of per-thread buffers [Hidden option, INTERNAL]
+    unsigned int        uiFragmentBufferSize;               ///< buffer size in KB of the fragment files kept open in timeout mode [Hidden option, INTERNAL]
+    unsigned int        uiFlushWatermark;                   ///< number of pending entries of a thread that triggers an early flush in timeout mode [Hidden option, INTERNAL]
+    unsigned int        uiMaxPendingTraceEntries;           ///< maximum number of entries waiting to be flushed in timeout mode [Hidden option, INTERNAL]
+    unsigned int        uiSpillEntryThreshold;              ///< number of pending entries that triggers writing the completed ones to spill files in non-timeout mode [Hidden option, INTERNAL]
+    unsigned int        uiBackpressureTimeout;              ///< time in ms a thread waits for a flush once the pending entry limit is reached [Hidden option, INTERNAL]
+    unsigned int        uiFlightRecorderEntries;            ///< number of most recent entries per thread kept by the flight recorder, 0 for no entry limit
+    unsigned int        uiFlightRecorderSeconds;            ///< number of seconds of most recent entries kept by the flight recorder, 0 for no time limit
+    unsigned int        uiFlightRecorderLatencyTrigger;     ///< API duration in us that triggers a flight recorder dump, 0 to disable the trigger
 } Config;
 
 #endif // _CONFIG_H_
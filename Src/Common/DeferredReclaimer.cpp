@@ -0,0 +1,182 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class defers the deletion of objects removed from lock-free
+///        structures until no reader can still access them.
+//==============================================================================
+
+#include <climits>
+#include <new>
+
+#include "DeferredReclaimer.h"
+
+/// Global epoch, incremented each time an object is retired
+static std::atomic<unsigned long long> s_ullEpoch(1);
+
+/// Owner of the read section record of a thread, releases the record when the thread exits
+struct DeferredReclaimerRecordOwner
+{
+    /// Constructor
+    DeferredReclaimerRecordOwner() : m_pRecord(nullptr), m_bAcquireFailed(false)
+    {
+    }
+
+    /// Destructor, the record is reused by the next thread that needs one
+    ~DeferredReclaimerRecordOwner()
+    {
+        if (nullptr != m_pRecord)
+        {
+            m_pRecord->m_bInUse.store(false, std::memory_order_release);
+            m_pRecord = nullptr;
+        }
+    }
+
+    DeferredReclaimer::ThreadRecord* m_pRecord;        ///< record of the thread, nullptr until the first read section
+    bool                             m_bAcquireFailed; ///< flag indicating that the record could not be allocated
+};
+
+static thread_local DeferredReclaimerRecordOwner t_recordOwner;
+
+DeferredReclaimer::DeferredReclaimer() :
+    m_pRecords(nullptr),
+    m_bUnprotectedReaders(false)
+{
+}
+
+void DeferredReclaimer::EnterReadSection()
+{
+    ThreadRecord* pRecord = t_recordOwner.m_pRecord;
+
+    if (nullptr == pRecord)
+    {
+        if (t_recordOwner.m_bAcquireFailed)
+        {
+            return;
+        }
+
+        pRecord = DeferredReclaimer::Instance()->AcquireThreadRecord();
+
+        if (nullptr == pRecord)
+        {
+            t_recordOwner.m_bAcquireFailed = true;
+            return;
+        }
+
+        t_recordOwner.m_pRecord = pRecord;
+    }
+
+    if (0 == pRecord->m_uiDepth++)
+    {
+        pRecord->m_ullEpoch.store(s_ullEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        // the announcement is visible to the writers before the thread reads the shared structures
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void DeferredReclaimer::LeaveReadSection()
+{
+    ThreadRecord* pRecord = t_recordOwner.m_pRecord;
+
+    if (nullptr != pRecord && 0 == --pRecord->m_uiDepth)
+    {
+        pRecord->m_ullEpoch.store(0, std::memory_order_release);
+    }
+}
+
+void DeferredReclaimer::Retire(void* pObject, DeleteFunc pfnDelete)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    // the readers announcing a later epoch entered their read section after the object was unlinked
+    RetiredObject retiredObject = { pObject, pfnDelete, s_ullEpoch.fetch_add(1, std::memory_order_seq_cst) };
+    m_retiredObjects.push_back(retiredObject);
+
+    if (DEFERRED_RECLAIMER_BATCH_SIZE <= m_retiredObjects.size())
+    {
+        ReclaimLocked();
+    }
+}
+
+void DeferredReclaimer::Reclaim()
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ReclaimLocked();
+}
+
+size_t DeferredReclaimer::GetNumRetired()
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_retiredObjects.size();
+}
+
+DeferredReclaimer::ThreadRecord* DeferredReclaimer::AcquireThreadRecord()
+{
+    for (ThreadRecord* pRecord = m_pRecords.load(std::memory_order_acquire); nullptr != pRecord; pRecord = pRecord->m_pNext)
+    {
+        bool bInUse = false;
+
+        if (!pRecord->m_bInUse.load(std::memory_order_relaxed) &&
+            pRecord->m_bInUse.compare_exchange_strong(bInUse, true, std::memory_order_acquire))
+        {
+            return pRecord;
+        }
+    }
+
+    ThreadRecord* pRecord = new(std::nothrow) ThreadRecord();
+
+    if (nullptr == pRecord)
+    {
+        // the reads of this thread can't be protected, stop deleting the retired objects
+        m_bUnprotectedReaders.store(true, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // a record added while ReclaimLocked runs is seen by the next reclamation, the thread
+    // doesn't access any object before it is added
+    std::lock_guard<std::mutex> lock(m_mtx);
+    pRecord->m_pNext = m_pRecords.load(std::memory_order_relaxed);
+    m_pRecords.store(pRecord, std::memory_order_release);
+
+    return pRecord;
+}
+
+void DeferredReclaimer::ReclaimLocked()
+{
+    if (m_bUnprotectedReaders.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    // the objects are unlinked before the announcements of the readers are read
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    unsigned long long ullMinEpoch = ULLONG_MAX;
+
+    for (ThreadRecord* pRecord = m_pRecords.load(std::memory_order_acquire); nullptr != pRecord; pRecord = pRecord->m_pNext)
+    {
+        unsigned long long ullEpoch = pRecord->m_ullEpoch.load(std::memory_order_acquire);
+
+        if (0 != ullEpoch && ullEpoch < ullMinEpoch)
+        {
+            ullMinEpoch = ullEpoch;
+        }
+    }
+
+    std::vector<RetiredObject>::iterator itKept = m_retiredObjects.begin();
+
+    for (std::vector<RetiredObject>::iterator it = m_retiredObjects.begin(); it != m_retiredObjects.end(); ++it)
+    {
+        if (it->m_ullEpoch < ullMinEpoch)
+        {
+            it->m_pfnDelete(it->m_pObject);
+        }
+        else
+        {
+            *itKept++ = *it;
+        }
+    }
+
+    m_retiredObjects.erase(itKept, m_retiredObjects.end());
+}
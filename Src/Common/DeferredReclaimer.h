@@ -0,0 +1,140 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class defers the deletion of objects removed from lock-free
+///        structures until no reader can still access them.
+//==============================================================================
+
+#ifndef _DEFERRED_RECLAIMER_H_
+#define _DEFERRED_RECLAIMER_H_
+
+/// \defgroup DeferredReclaimer DeferredReclaimer
+/// This module implements the epoch-based reclamation used by the lock-free maps
+///
+/// \ingroup Common
+// @{
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <TSingleton.h>
+
+/// Number of retired objects that triggers a reclamation
+#define DEFERRED_RECLAIMER_BATCH_SIZE 32
+
+//------------------------------------------------------------------------------------
+/// Epoch-based reclamation. A reader announces the global epoch when it enters a read
+/// section and clears it when it leaves. A writer unlinks an object, then retires it:
+/// the object is tagged with the current epoch and the epoch is incremented. The object
+/// is deleted once every thread in a read section has announced a later epoch, such
+/// a thread entered its section after the object was unlinked.
+//------------------------------------------------------------------------------------
+class DeferredReclaimer : public TSingleton<DeferredReclaimer>
+{
+    friend class TSingleton<DeferredReclaimer>;
+    friend struct DeferredReclaimerRecordOwner;
+
+public:
+    /// Function deleting a retired object
+    typedef void (*DeleteFunc)(void* pObject);
+
+    /// Read section of the calling thread, the objects the thread reaches in the lock-free
+    /// structures are not deleted until the section ends. Read sections may be nested
+    class ReadSection
+    {
+    public:
+        /// Constructor, enters the read section
+        ReadSection()
+        {
+            DeferredReclaimer::EnterReadSection();
+        }
+
+        /// Destructor, leaves the read section
+        ~ReadSection()
+        {
+            DeferredReclaimer::LeaveReadSection();
+        }
+
+    private:
+        /// Disable copy constructor
+        /// \param obj the input object
+        ReadSection(const ReadSection& obj) = delete;
+
+        /// Disable assignment operator
+        /// \param obj the input object
+        /// \return a reference of the object
+        ReadSection& operator=(const ReadSection& obj) = delete;
+    };
+
+    /// Retire an object that has been unlinked from a lock-free structure, it is deleted
+    /// once no read section can still access it
+    /// \param pObject the object
+    /// \param pfnDelete the function deleting the object, it must not retire other objects
+    void Retire(void* pObject, DeleteFunc pfnDelete);
+
+    /// Delete the retired objects no read section can access anymore
+    void Reclaim();
+
+    /// Get the number of retired objects that are not deleted yet
+    /// \return the number of retired objects
+    size_t GetNumRetired();
+
+private:
+    /// Read section state of a thread, records are reused by new threads and never deleted
+    struct ThreadRecord
+    {
+        /// Constructor
+        ThreadRecord() : m_ullEpoch(0), m_uiDepth(0), m_bInUse(true), m_pNext(nullptr)
+        {
+        }
+
+        std::atomic<unsigned long long> m_ullEpoch;  ///< epoch announced by the thread, 0 outside of read sections
+        unsigned int                    m_uiDepth;   ///< number of nested read sections of the thread
+        std::atomic<bool>               m_bInUse;    ///< flag indicating that a thread owns the record
+        ThreadRecord*                   m_pNext;     ///< next record
+    };
+
+    /// Object waiting for the end of the read sections that may access it
+    struct RetiredObject
+    {
+        void*              m_pObject;   ///< the object
+        DeleteFunc         m_pfnDelete; ///< function deleting the object
+        unsigned long long m_ullEpoch;  ///< epoch when the object was retired
+    };
+
+    /// Constructor
+    DeferredReclaimer();
+
+    /// Enter a read section of the calling thread
+    static void EnterReadSection();
+
+    /// Leave a read section of the calling thread
+    static void LeaveReadSection();
+
+    /// Get the record of the calling thread, allocated or reused by the first read section of the thread
+    /// \return the record, NULL if it could not be allocated
+    ThreadRecord* AcquireThreadRecord();
+
+    /// Delete the retired objects no read section can access anymore, m_mtx must be locked
+    void ReclaimLocked();
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    DeferredReclaimer(const DeferredReclaimer& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    DeferredReclaimer& operator=(const DeferredReclaimer& obj) = delete;
+
+    std::atomic<ThreadRecord*> m_pRecords;              ///< records of the threads that entered a read section, new records are added at the head
+    std::vector<RetiredObject> m_retiredObjects;        ///< objects waiting for the end of the read sections that may access them
+    std::atomic<bool>          m_bUnprotectedReaders;   ///< set if a thread could not allocate its record, retired objects are then never deleted
+    std::mutex                 m_mtx;                   ///< mutex protecting m_retiredObjects and serializing the addition of records
+};
+
+// @}
+
+#endif //_DEFERRED_RECLAIMER_H_
@@ -199,6 +199,13 @@
 
 #define DEFAULT_TIMEOUT_INTERVAL 100
 
+#define DEFAULT_FRAGMENT_BUFFER_SIZE 64
+
+#define DEFAULT_FLUSH_WATERMARK 4096
+#define DEFAULT_MAX_PENDING_TRACE_ENTRIES 1000000
+#define DEFAULT_BACKPRESSURE_TIMEOUT 10
+#define DEFAULT_SPILL_ENTRY_THRESHOLD 1000000
+
 #define DEFAULT_MAX_NUM_OF_API_CALLS 1000000
 #define DEFAULT_MAX_KERNELS 100000
 
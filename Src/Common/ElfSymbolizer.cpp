@@ -0,0 +1,1562 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class resolves code addresses of the current process to symbol
+///        names and source lines by reading the ELF symbol tables and the
+///        DWARF line tables of the loaded modules (Linux only). The module
+///        map records the loaded modules so that raw addresses can be
+///        resolved after the process has exited.
+//==============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <elf.h>
+#include <link.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ElfSymbolizer.h"
+#include "CompressedStream.h"
+#include "StringUtils.h"
+#include "Logger.h"
+#include "Defs.h"
+
+using namespace std;
+using namespace GPULogger;
+
+/// DWARF line number standard opcodes
+enum DwarfLineOpcode
+{
+    DW_LNS_copy = 1,
+    DW_LNS_advance_pc = 2,
+    DW_LNS_advance_line = 3,
+    DW_LNS_set_file = 4,
+    DW_LNS_const_add_pc = 8,
+    DW_LNS_fixed_advance_pc = 9
+};
+
+/// DWARF line number extended opcodes
+enum DwarfLineExtendedOpcode
+{
+    DW_LNE_end_sequence = 1,
+    DW_LNE_set_address = 2,
+    DW_LNE_define_file = 3
+};
+
+/// DWARF 5 line table entry content types
+enum DwarfLineContentType
+{
+    DW_LNCT_path = 1,
+    DW_LNCT_directory_index = 2
+};
+
+/// DWARF attribute forms used by the DWARF 5 line table header
+enum DwarfForm
+{
+    DW_FORM_block2 = 0x03,
+    DW_FORM_block4 = 0x04,
+    DW_FORM_data2 = 0x05,
+    DW_FORM_data4 = 0x06,
+    DW_FORM_data8 = 0x07,
+    DW_FORM_string = 0x08,
+    DW_FORM_block = 0x09,
+    DW_FORM_block1 = 0x0a,
+    DW_FORM_data1 = 0x0b,
+    DW_FORM_sdata = 0x0d,
+    DW_FORM_strp = 0x0e,
+    DW_FORM_udata = 0x0f,
+    DW_FORM_data16 = 0x1e,
+    DW_FORM_line_strp = 0x1f
+};
+
+/// Bounds checked reader of DWARF data
+class DwarfReader
+{
+public:
+    /// Constructor
+    /// \param pData the data
+    /// \param size the data size
+    DwarfReader(const unsigned char* pData, size_t size) : m_pData(pData), m_size(size), m_pos(0), m_bError(false)
+    {
+    }
+
+    /// Check whether a read went past the end of the data
+    /// \return true if the data is truncated
+    bool HasError() const { return m_bError; }
+
+    /// Check whether all the data has been read
+    /// \return true if there is nothing left to read
+    bool AtEnd() const { return m_bError || m_pos >= m_size; }
+
+    /// Get the read position
+    /// \return the offset of the next byte to read
+    size_t GetPos() const { return m_pos; }
+
+    /// Skip bytes
+    /// \param count the number of bytes
+    void Skip(unsigned long long count)
+    {
+        if (count > m_size - m_pos)
+        {
+            m_bError = true;
+            m_pos = m_size;
+        }
+        else
+        {
+            m_pos += static_cast<size_t>(count);
+        }
+    }
+
+    /// Read a little endian unsigned value
+    /// \param numBytes the size of the value (1 to 8)
+    /// \return the value, 0 if the data is truncated
+    unsigned long long ReadUnsigned(size_t numBytes)
+    {
+        if (numBytes > m_size - m_pos)
+        {
+            m_bError = true;
+            m_pos = m_size;
+            return 0;
+        }
+
+        unsigned long long ullValue = 0;
+
+        for (size_t i = 0; i < numBytes; i++)
+        {
+            ullValue |= static_cast<unsigned long long>(m_pData[m_pos + i]) << (8 * i);
+        }
+
+        m_pos += numBytes;
+        return ullValue;
+    }
+
+    /// Read an unsigned LEB128 value
+    /// \return the value
+    unsigned long long ReadULEB128()
+    {
+        unsigned long long ullValue = 0;
+        unsigned int shift = 0;
+        unsigned char byte;
+
+        do
+        {
+            byte = static_cast<unsigned char>(ReadUnsigned(1));
+
+            if (shift < 64)
+            {
+                ullValue |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+            }
+
+            shift += 7;
+        }
+        while ((byte & 0x80) != 0 && !m_bError);
+
+        return ullValue;
+    }
+
+    /// Read a signed LEB128 value
+    /// \return the value
+    long long ReadSLEB128()
+    {
+        unsigned long long ullValue = 0;
+        unsigned int shift = 0;
+        unsigned char byte;
+
+        do
+        {
+            byte = static_cast<unsigned char>(ReadUnsigned(1));
+
+            if (shift < 64)
+            {
+                ullValue |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+            }
+
+            shift += 7;
+        }
+        while ((byte & 0x80) != 0 && !m_bError);
+
+        if (shift < 64 && (byte & 0x40) != 0)
+        {
+            ullValue |= ~0ULL << shift;
+        }
+
+        return static_cast<long long>(ullValue);
+    }
+
+    /// Read a nul terminated string
+    /// \return the string, empty if the data is truncated
+    const char* ReadString()
+    {
+        const char* pStr = reinterpret_cast<const char*>(m_pData + m_pos);
+        const void* pEnd = memchr(pStr, 0, m_size - m_pos);
+
+        if (pEnd == NULL)
+        {
+            m_bError = true;
+            m_pos = m_size;
+            return "";
+        }
+
+        m_pos = static_cast<const unsigned char*>(pEnd) - m_pData + 1;
+        return pStr;
+    }
+
+private:
+    const unsigned char* m_pData;  ///< the data
+    size_t               m_size;   ///< the data size
+    size_t               m_pos;    ///< offset of the next byte to read
+    bool                 m_bError; ///< flag indicating that a read went past the end of the data
+};
+
+/// Get a string from a string section
+/// \param pSection the section data, can be NULL
+/// \param size the section size
+/// \param ullOffset the offset of the string
+/// \return the string, empty if the offset is not valid
+static const char* GetSectionString(const unsigned char* pSection, size_t size, unsigned long long ullOffset)
+{
+    if (pSection == NULL || ullOffset >= size || memchr(pSection + ullOffset, 0, size - static_cast<size_t>(ullOffset)) == NULL)
+    {
+        return "";
+    }
+
+    return reinterpret_cast<const char*>(pSection + ullOffset);
+}
+
+/// Find the GNU build ID in notes
+/// \param pNotes the notes (a note section or segment)
+/// \param size the size of the notes
+/// \return the build ID as a hex string, empty if there is none
+static string GetBuildIDFromNotes(const unsigned char* pNotes, size_t size)
+{
+    static const char s_hexDigits[] = "0123456789abcdef";
+    size_t pos = 0;
+
+    // the note header is the same in ELF32 and ELF64 files
+    while (size - pos >= sizeof(Elf64_Nhdr))
+    {
+        Elf64_Nhdr note;
+        memcpy(&note, pNotes + pos, sizeof(Elf64_Nhdr));
+        pos += sizeof(Elf64_Nhdr);
+
+        size_t nameSize = (static_cast<size_t>(note.n_namesz) + 3) & ~static_cast<size_t>(3);
+        size_t descSize = (static_cast<size_t>(note.n_descsz) + 3) & ~static_cast<size_t>(3);
+
+        if (nameSize > size - pos || descSize > size - pos - nameSize)
+        {
+            break;
+        }
+
+        if (note.n_type == NT_GNU_BUILD_ID && note.n_namesz == sizeof(ELF_NOTE_GNU) && memcmp(pNotes + pos, ELF_NOTE_GNU, sizeof(ELF_NOTE_GNU)) == 0)
+        {
+            const unsigned char* pDesc = pNotes + pos + nameSize;
+            string strBuildID;
+
+            for (size_t i = 0; i < note.n_descsz; i++)
+            {
+                strBuildID.push_back(s_hexDigits[pDesc[i] >> 4]);
+                strBuildID.push_back(s_hexDigits[pDesc[i] & 0xf]);
+            }
+
+            return strBuildID;
+        }
+
+        pos += nameSize + descSize;
+    }
+
+    return string();
+}
+
+/// Join a directory and a file name
+/// \param strDir the directory, can be empty
+/// \param strFile the file name
+/// \return the path of the file
+static string JoinPath(const string& strDir, const string& strFile)
+{
+    if (strDir.empty() || (!strFile.empty() && strFile[0] == '/'))
+    {
+        return strFile;
+    }
+
+    return strDir[strDir.size() - 1] == '/' ? strDir + strFile : strDir + "/" + strFile;
+}
+
+/// Directory of the separate debug files
+#define SEPARATE_DEBUG_FILE_DIR "/usr/lib/debug"
+
+/// Maximum number of addresses passed to one addr2line process
+#define ADDR2LINE_MAX_ADDRESSES 256
+
+ElfModule::ElfModule() : m_bCompressedLineTable(false)
+{
+}
+
+bool ElfModule::Load(const string& strFileName)
+{
+    m_strFileName = strFileName;
+
+    if (!LoadFile(strFileName))
+    {
+        return false;
+    }
+
+    if (m_lines.empty())
+    {
+        LoadSeparateDebugFile(strFileName);
+    }
+
+    return true;
+}
+
+void ElfModule::LoadSeparateDebugFile(const string& strFileName)
+{
+    // same search order as gdb: build ID, then debug link next to the file, in .debug and in the debug directory
+    vector<string> candidates;
+
+    if (m_strBuildID.size() > 2)
+    {
+        candidates.push_back(string(SEPARATE_DEBUG_FILE_DIR "/.build-id/") + m_strBuildID.substr(0, 2) + "/" + m_strBuildID.substr(2) + ".debug");
+    }
+
+    if (!m_strDebugLink.empty())
+    {
+        size_t slashPos = strFileName.find_last_of('/');
+        string strDir = slashPos == string::npos ? string() : strFileName.substr(0, slashPos);
+
+        candidates.push_back(JoinPath(strDir, m_strDebugLink));
+        candidates.push_back(JoinPath(JoinPath(strDir, ".debug"), m_strDebugLink));
+        candidates.push_back(JoinPath(SEPARATE_DEBUG_FILE_DIR + strDir, m_strDebugLink));
+    }
+
+    for (vector<string>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+    {
+        ElfModule debugFile;
+
+        if (*it == strFileName || access(it->c_str(), R_OK) != 0 || !debugFile.LoadFile(*it))
+        {
+            continue;
+        }
+
+        // a stale debug file describes another build of the file
+        if (!m_strBuildID.empty() && !debugFile.m_strBuildID.empty() && debugFile.m_strBuildID != m_strBuildID)
+        {
+            Log(logMESSAGE, "Ignoring %s, its build ID doesn't match %s\n", it->c_str(), strFileName.c_str());
+            continue;
+        }
+
+        // the debug file has the full .symtab, the file itself may only have .dynsym
+        for (vector<Symbol>::iterator itSym = debugFile.m_symbols.begin(); itSym != debugFile.m_symbols.end(); ++itSym)
+        {
+            itSym->m_nameOffset += m_strNames.size();
+            m_symbols.push_back(*itSym);
+        }
+
+        m_strNames.append(debugFile.m_strNames);
+        SortSymbols();
+
+        m_lines.swap(debugFile.m_lines);
+        m_files.swap(debugFile.m_files);
+        m_bCompressedLineTable = m_bCompressedLineTable || debugFile.m_bCompressedLineTable;
+
+        return;
+    }
+}
+
+bool ElfModule::LoadFile(const string& strFileName)
+{
+    int fd = open(strFileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+    void* pMap = MAP_FAILED;
+
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size >= EI_NIDENT)
+    {
+        pMap = mmap(NULL, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    close(fd);
+
+    if (pMap == MAP_FAILED)
+    {
+        return false;
+    }
+
+    const unsigned char* pData = static_cast<const unsigned char*>(pMap);
+    size_t size = static_cast<size_t>(fileStat.st_size);
+    bool bRet = false;
+
+    if (memcmp(pData, ELFMAG, SELFMAG) == 0 && pData[EI_DATA] == ELFDATA2LSB)
+    {
+        if (pData[EI_CLASS] == ELFCLASS64)
+        {
+            bRet = ParseElf<Elf64_Ehdr, Elf64_Shdr, Elf64_Phdr, Elf64_Sym>(pData, size);
+        }
+        else if (pData[EI_CLASS] == ELFCLASS32)
+        {
+            bRet = ParseElf<Elf32_Ehdr, Elf32_Shdr, Elf32_Phdr, Elf32_Sym>(pData, size);
+        }
+    }
+
+    munmap(pMap, size);
+
+    return bRet;
+}
+
+template <typename Ehdr, typename Shdr, typename Phdr, typename Sym>
+bool ElfModule::ParseElf(const unsigned char* pData, size_t size)
+{
+    if (size < sizeof(Ehdr))
+    {
+        return false;
+    }
+
+    Ehdr header;
+    memcpy(&header, pData, sizeof(Ehdr));
+
+    if (header.e_phoff > size || header.e_phnum > (size - header.e_phoff) / sizeof(Phdr) ||
+        header.e_shoff > size || header.e_shnum > (size - header.e_shoff) / sizeof(Shdr))
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < header.e_phnum; i++)
+    {
+        Phdr programHeader;
+        memcpy(&programHeader, pData + header.e_phoff + i * sizeof(Phdr), sizeof(Phdr));
+
+        if (programHeader.p_type == PT_LOAD)
+        {
+            Segment segment;
+            segment.m_ullOffset = programHeader.p_offset;
+            segment.m_ullFileSize = programHeader.p_filesz;
+            segment.m_ullAddress = programHeader.p_vaddr;
+            m_segments.push_back(segment);
+        }
+    }
+
+    vector<Shdr> sections(header.e_shnum);
+
+    if (header.e_shnum > 0)
+    {
+        memcpy(&sections[0], pData + header.e_shoff, header.e_shnum * sizeof(Shdr));
+    }
+
+    // the sections are used in place, ignore the ones that aren't in the file (compressed sections are left to addr2line)
+    auto getSectionData = [&](const Shdr& section, size_t& sectionSize) -> const unsigned char*
+    {
+        if (section.sh_type == SHT_NOBITS || (section.sh_flags & SHF_COMPRESSED) != 0 ||
+            section.sh_offset > size || section.sh_size > size - section.sh_offset)
+        {
+            sectionSize = 0;
+            return NULL;
+        }
+
+        sectionSize = static_cast<size_t>(section.sh_size);
+        return pData + section.sh_offset;
+    };
+
+    const char* pSectionNames = NULL;
+    size_t sectionNamesSize = 0;
+
+    if (header.e_shstrndx < sections.size())
+    {
+        pSectionNames = reinterpret_cast<const char*>(getSectionData(sections[header.e_shstrndx], sectionNamesSize));
+    }
+
+    const unsigned char* pDebugLine = NULL;
+    const unsigned char* pDebugLineStr = NULL;
+    const unsigned char* pDebugStr = NULL;
+    size_t debugLineSize = 0;
+    size_t debugLineStrSize = 0;
+    size_t debugStrSize = 0;
+
+    for (size_t i = 0; i < sections.size(); i++)
+    {
+        const Shdr& section = sections[i];
+        size_t sectionSize = 0;
+        const unsigned char* pSection = getSectionData(section, sectionSize);
+
+        if (pSection == NULL)
+        {
+            if (pSectionNames != NULL && section.sh_type != SHT_NOBITS)
+            {
+                string strName = GetSectionString(reinterpret_cast<const unsigned char*>(pSectionNames), sectionNamesSize, section.sh_name);
+                m_bCompressedLineTable = m_bCompressedLineTable || strName == ".debug_line";
+            }
+
+            continue;
+        }
+
+        if (section.sh_type == SHT_NOTE)
+        {
+            if (m_strBuildID.empty())
+            {
+                m_strBuildID = GetBuildIDFromNotes(pSection, sectionSize);
+            }
+        }
+        else if ((section.sh_type == SHT_SYMTAB || section.sh_type == SHT_DYNSYM) && section.sh_link < sections.size())
+        {
+            size_t stringsSize = 0;
+            const char* pStrings = reinterpret_cast<const char*>(getSectionData(sections[section.sh_link], stringsSize));
+
+            if (pStrings != NULL)
+            {
+                AddSymbols(reinterpret_cast<const Sym*>(pSection), sectionSize / sizeof(Sym), pStrings, stringsSize);
+            }
+        }
+        else if (pSectionNames != NULL)
+        {
+            string strName = GetSectionString(reinterpret_cast<const unsigned char*>(pSectionNames), sectionNamesSize, section.sh_name);
+
+            if (strName == ".debug_line")
+            {
+                pDebugLine = pSection;
+                debugLineSize = sectionSize;
+            }
+            else if (strName == ".debug_line_str")
+            {
+                pDebugLineStr = pSection;
+                debugLineStrSize = sectionSize;
+            }
+            else if (strName == ".debug_str")
+            {
+                pDebugStr = pSection;
+                debugStrSize = sectionSize;
+            }
+            else if (strName == ".zdebug_line")
+            {
+                m_bCompressedLineTable = true;
+            }
+            else if (strName == ".gnu_debuglink")
+            {
+                // file name, padding and CRC
+                m_strDebugLink = GetSectionString(pSection, sectionSize, 0);
+            }
+        }
+    }
+
+    SortSymbols();
+
+    if (pDebugLine != NULL)
+    {
+        ParseDebugLine(pDebugLine, debugLineSize, pDebugLineStr, debugLineStrSize, pDebugStr, debugStrSize);
+    }
+
+    return true;
+}
+
+void ElfModule::SortSymbols()
+{
+    // .symtab and .dynsym usually both contain the exported functions, keep one symbol per address
+    sort(m_symbols.begin(), m_symbols.end(), [](const Symbol & lhs, const Symbol & rhs)
+    {
+        return lhs.m_ullAddress < rhs.m_ullAddress || (lhs.m_ullAddress == rhs.m_ullAddress && lhs.m_ullSize > rhs.m_ullSize);
+    });
+    m_symbols.erase(unique(m_symbols.begin(), m_symbols.end(), [](const Symbol & lhs, const Symbol & rhs)
+    {
+        return lhs.m_ullAddress == rhs.m_ullAddress;
+    }), m_symbols.end());
+}
+
+template <typename Sym>
+void ElfModule::AddSymbols(const Sym* pSymbols, size_t numSymbols, const char* pStrings, size_t stringsSize)
+{
+    for (size_t i = 0; i < numSymbols; i++)
+    {
+        Sym symbol;
+        memcpy(&symbol, pSymbols + i, sizeof(Sym));
+
+        unsigned char type = symbol.st_info & 0xf;
+
+        if ((type != STT_FUNC && type != STT_GNU_IFUNC) || symbol.st_shndx == SHN_UNDEF || symbol.st_value == 0)
+        {
+            continue;
+        }
+
+        const char* pName = GetSectionString(reinterpret_cast<const unsigned char*>(pStrings), stringsSize, symbol.st_name);
+
+        if (*pName == '\0')
+        {
+            continue;
+        }
+
+        Symbol newSymbol;
+        newSymbol.m_ullAddress = symbol.st_value;
+        newSymbol.m_ullSize = symbol.st_size;
+        newSymbol.m_nameOffset = m_strNames.size();
+        m_strNames.append(pName, strlen(pName) + 1);
+        m_symbols.push_back(newSymbol);
+    }
+}
+
+void ElfModule::ParseDebugLine(const unsigned char* pData, size_t size, const unsigned char* pLineStr, size_t lineStrSize, const unsigned char* pStr, size_t strSize)
+{
+    DwarfReader section(pData, size);
+
+    while (!section.AtEnd())
+    {
+        size_t offsetSize = 4;
+        unsigned long long ullUnitLength = section.ReadUnsigned(4);
+
+        if (ullUnitLength == 0xffffffff)
+        {
+            offsetSize = 8;
+            ullUnitLength = section.ReadUnsigned(8);
+        }
+
+        if (section.HasError() || ullUnitLength > size - section.GetPos())
+        {
+            break;
+        }
+
+        size_t unitStart = section.GetPos();
+        DwarfReader unit(pData + unitStart, static_cast<size_t>(ullUnitLength));
+        section.Skip(ullUnitLength);
+
+        unsigned int version = static_cast<unsigned int>(unit.ReadUnsigned(2));
+
+        if (version < 2 || version > 5)
+        {
+            continue;
+        }
+
+        if (version >= 5)
+        {
+            // address size and segment selector size
+            unit.Skip(2);
+        }
+
+        unsigned long long ullHeaderLength = unit.ReadUnsigned(offsetSize);
+        size_t programStart = unit.GetPos() + static_cast<size_t>(min<unsigned long long>(ullHeaderLength, ullUnitLength));
+        unsigned int minInstLength = static_cast<unsigned int>(unit.ReadUnsigned(1));
+
+        if (version >= 4)
+        {
+            // maximum operations per instruction, only used by VLIW architectures
+            unit.Skip(1);
+        }
+
+        unit.Skip(1); // default_is_stmt
+        int lineBase = static_cast<signed char>(unit.ReadUnsigned(1));
+        unsigned int lineRange = static_cast<unsigned int>(unit.ReadUnsigned(1));
+        unsigned int opcodeBase = static_cast<unsigned int>(unit.ReadUnsigned(1));
+
+        if (lineRange == 0 || opcodeBase == 0)
+        {
+            continue;
+        }
+
+        vector<unsigned char> opcodeLengths(opcodeBase, 0);
+
+        for (unsigned int i = 1; i < opcodeBase; i++)
+        {
+            opcodeLengths[i] = static_cast<unsigned char>(unit.ReadUnsigned(1));
+        }
+
+        vector<string> dirs;
+        vector<uint32_t> unitFiles;
+        bool bValidHeader = true;
+
+        if (version >= 5)
+        {
+            // the directory and file entries are described by (content type, form) pairs
+            for (int table = 0; table < 2 && bValidHeader; table++)
+            {
+                unsigned int formatCount = static_cast<unsigned int>(unit.ReadUnsigned(1));
+                vector<pair<unsigned long long, unsigned long long> > formats;
+
+                for (unsigned int i = 0; i < formatCount; i++)
+                {
+                    unsigned long long ullContentType = unit.ReadULEB128();
+                    formats.push_back(make_pair(ullContentType, unit.ReadULEB128()));
+                }
+
+                unsigned long long ullCount = unit.ReadULEB128();
+
+                for (unsigned long long entry = 0; entry < ullCount && bValidHeader && !unit.HasError(); entry++)
+                {
+                    string strPath;
+                    unsigned long long ullDirIndex = 0;
+
+                    for (size_t i = 0; i < formats.size() && bValidHeader; i++)
+                    {
+                        const char* pStrValue = NULL;
+                        unsigned long long ullValue = 0;
+
+                        switch (formats[i].second)
+                        {
+                            case DW_FORM_string:
+                                pStrValue = unit.ReadString();
+                                break;
+
+                            case DW_FORM_line_strp:
+                                pStrValue = GetSectionString(pLineStr, lineStrSize, unit.ReadUnsigned(offsetSize));
+                                break;
+
+                            case DW_FORM_strp:
+                                pStrValue = GetSectionString(pStr, strSize, unit.ReadUnsigned(offsetSize));
+                                break;
+
+                            case DW_FORM_udata:
+                                ullValue = unit.ReadULEB128();
+                                break;
+
+                            case DW_FORM_sdata:
+                                ullValue = static_cast<unsigned long long>(unit.ReadSLEB128());
+                                break;
+
+                            case DW_FORM_data1:
+                                ullValue = unit.ReadUnsigned(1);
+                                break;
+
+                            case DW_FORM_data2:
+                                ullValue = unit.ReadUnsigned(2);
+                                break;
+
+                            case DW_FORM_data4:
+                                ullValue = unit.ReadUnsigned(4);
+                                break;
+
+                            case DW_FORM_data8:
+                                ullValue = unit.ReadUnsigned(8);
+                                break;
+
+                            case DW_FORM_data16:
+                                unit.Skip(16);
+                                break;
+
+                            case DW_FORM_block:
+                                unit.Skip(unit.ReadULEB128());
+                                break;
+
+                            case DW_FORM_block1:
+                                unit.Skip(unit.ReadUnsigned(1));
+                                break;
+
+                            case DW_FORM_block2:
+                                unit.Skip(unit.ReadUnsigned(2));
+                                break;
+
+                            case DW_FORM_block4:
+                                unit.Skip(unit.ReadUnsigned(4));
+                                break;
+
+                            default:
+                                // forms referencing other sections (strx) aren't supported, the size of the entry is unknown
+                                bValidHeader = false;
+                                break;
+                        }
+
+                        if (formats[i].first == DW_LNCT_path && pStrValue != NULL)
+                        {
+                            strPath = pStrValue;
+                        }
+                        else if (formats[i].first == DW_LNCT_directory_index)
+                        {
+                            ullDirIndex = ullValue;
+                        }
+                    }
+
+                    if (table == 0)
+                    {
+                        // directories are relative to the compilation directory (entry 0)
+                        dirs.push_back(dirs.empty() ? strPath : JoinPath(dirs[0], strPath));
+                    }
+                    else
+                    {
+                        unitFiles.push_back(static_cast<uint32_t>(m_files.size()));
+                        m_files.push_back(JoinPath(ullDirIndex < dirs.size() ? dirs[static_cast<size_t>(ullDirIndex)] : string(), strPath));
+                    }
+                }
+            }
+        }
+        else
+        {
+            // the compilation directory is not in the line table, directory 0 is left empty
+            dirs.push_back(string());
+
+            for (const char* pDir = unit.ReadString(); *pDir != '\0'; pDir = unit.ReadString())
+            {
+                dirs.push_back(pDir);
+            }
+
+            // file indices start at 1
+            unitFiles.push_back(static_cast<uint32_t>(m_files.size()));
+            m_files.push_back(string());
+
+            for (const char* pFile = unit.ReadString(); *pFile != '\0'; pFile = unit.ReadString())
+            {
+                unsigned long long ullDirIndex = unit.ReadULEB128();
+                unit.ReadULEB128(); // modification time
+                unit.ReadULEB128(); // file size
+                unitFiles.push_back(static_cast<uint32_t>(m_files.size()));
+                m_files.push_back(JoinPath(ullDirIndex < dirs.size() ? dirs[static_cast<size_t>(ullDirIndex)] : string(), pFile));
+            }
+        }
+
+        if (!bValidHeader || unit.HasError() || programStart > ullUnitLength)
+        {
+            continue;
+        }
+
+        // run the line number program, a row is added for each address/line change
+        DwarfReader program(pData + unitStart + programStart, static_cast<size_t>(ullUnitLength) - programStart);
+        unsigned long long ullAddress = 0;
+        unsigned long long ullFile = 1;
+        long long line = 1;
+        size_t sequenceStart = m_lines.size();
+
+        auto addRow = [&](bool bEndSequence)
+        {
+            LineRow row;
+            row.m_ullAddress = ullAddress;
+            row.m_fileIndex = ullFile < unitFiles.size() ? unitFiles[static_cast<size_t>(ullFile)] : UINT32_MAX;
+            row.m_line = static_cast<uint32_t>(line);
+            row.m_bEndSequence = bEndSequence;
+            m_lines.push_back(row);
+        };
+
+        while (!program.AtEnd())
+        {
+            unsigned int opcode = static_cast<unsigned int>(program.ReadUnsigned(1));
+
+            if (opcode >= opcodeBase)
+            {
+                // special opcode: advance the address and the line and add a row
+                unsigned int adjustedOpcode = opcode - opcodeBase;
+                ullAddress += (adjustedOpcode / lineRange) * minInstLength;
+                line += lineBase + static_cast<int>(adjustedOpcode % lineRange);
+                addRow(false);
+            }
+            else if (opcode == 0)
+            {
+                unsigned long long ullLength = program.ReadULEB128();
+                size_t opcodeEnd = program.GetPos() + static_cast<size_t>(min<unsigned long long>(ullLength, size));
+
+                if (ullLength == 0)
+                {
+                    continue;
+                }
+
+                unsigned int extendedOpcode = static_cast<unsigned int>(program.ReadUnsigned(1));
+
+                if (extendedOpcode == DW_LNE_end_sequence)
+                {
+                    addRow(true);
+
+                    // sequences of functions removed by the linker start at 0, drop them
+                    if (m_lines[sequenceStart].m_ullAddress == 0)
+                    {
+                        m_lines.resize(sequenceStart);
+                    }
+
+                    sequenceStart = m_lines.size();
+                    ullAddress = 0;
+                    ullFile = 1;
+                    line = 1;
+                }
+                else if (extendedOpcode == DW_LNE_set_address)
+                {
+                    ullAddress = program.ReadUnsigned(static_cast<size_t>(min<unsigned long long>(ullLength - 1, 8)));
+                }
+                else if (extendedOpcode == DW_LNE_define_file)
+                {
+                    const char* pFile = program.ReadString();
+                    unsigned long long ullDirIndex = program.ReadULEB128();
+                    unitFiles.push_back(static_cast<uint32_t>(m_files.size()));
+                    m_files.push_back(JoinPath(ullDirIndex < dirs.size() ? dirs[static_cast<size_t>(ullDirIndex)] : string(), pFile));
+                }
+
+                if (opcodeEnd > program.GetPos())
+                {
+                    program.Skip(opcodeEnd - program.GetPos());
+                }
+            }
+            else if (opcode == DW_LNS_copy)
+            {
+                addRow(false);
+            }
+            else if (opcode == DW_LNS_advance_pc)
+            {
+                ullAddress += program.ReadULEB128() * minInstLength;
+            }
+            else if (opcode == DW_LNS_advance_line)
+            {
+                line += program.ReadSLEB128();
+            }
+            else if (opcode == DW_LNS_set_file)
+            {
+                ullFile = program.ReadULEB128();
+            }
+            else if (opcode == DW_LNS_const_add_pc)
+            {
+                ullAddress += ((255 - opcodeBase) / lineRange) * minInstLength;
+            }
+            else if (opcode == DW_LNS_fixed_advance_pc)
+            {
+                ullAddress += program.ReadUnsigned(2);
+            }
+            else
+            {
+                // other standard opcodes don't change the address nor the line, skip their operands
+                for (unsigned int i = 0; i < opcodeLengths[opcode]; i++)
+                {
+                    program.ReadULEB128();
+                }
+            }
+        }
+
+        // drop an unterminated sequence
+        m_lines.resize(sequenceStart);
+    }
+
+    // when a sequence ends where another one starts, the end row must come first
+    stable_sort(m_lines.begin(), m_lines.end(), [](const LineRow & lhs, const LineRow & rhs)
+    {
+        return lhs.m_ullAddress < rhs.m_ullAddress || (lhs.m_ullAddress == rhs.m_ullAddress && lhs.m_bEndSequence && !rhs.m_bEndSequence);
+    });
+}
+
+bool ElfModule::FileOffsetToAddress(unsigned long long ullFileOffset, unsigned long long& ullAddress) const
+{
+    for (vector<Segment>::const_iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+    {
+        if (ullFileOffset >= it->m_ullOffset && ullFileOffset - it->m_ullOffset < it->m_ullFileSize)
+        {
+            ullAddress = it->m_ullAddress + (ullFileOffset - it->m_ullOffset);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ElfModule::Lookup(unsigned long long ullAddress, ElfSymbolInfo& info) const
+{
+    vector<Symbol>::const_iterator itSym = upper_bound(m_symbols.begin(), m_symbols.end(), ullAddress, [](unsigned long long ullAddr, const Symbol & symbol)
+    {
+        return ullAddr < symbol.m_ullAddress;
+    });
+
+    if (itSym != m_symbols.begin())
+    {
+        --itSym;
+
+        // symbols without a size (hand written assembly) cover everything up to the next symbol
+        if (itSym->m_ullSize == 0 || ullAddress - itSym->m_ullAddress < itSym->m_ullSize)
+        {
+            info.m_strSymName = m_strNames.c_str() + itSym->m_nameOffset;
+        }
+    }
+
+    vector<LineRow>::const_iterator itLine = upper_bound(m_lines.begin(), m_lines.end(), ullAddress, [](unsigned long long ullAddr, const LineRow & row)
+    {
+        return ullAddr < row.m_ullAddress;
+    });
+
+    if (itLine != m_lines.begin())
+    {
+        --itLine;
+
+        if (!itLine->m_bEndSequence && itLine->m_fileIndex < m_files.size() && !m_files[itLine->m_fileIndex].empty())
+        {
+            info.m_strFile = m_files[itLine->m_fileIndex];
+            info.m_lineNum = itLine->m_line;
+        }
+    }
+}
+
+void ElfModule::LookupSourceLines(const std::string& strFileName, std::vector<std::pair<unsigned long long, ElfSymbolInfo*> >& addresses)
+{
+    // the file name is quoted for the shell
+    string strCommand = "addr2line -e '" + StringUtils::Replace(strFileName, "'", "'\\''") + "'";
+
+    for (size_t first = 0; first < addresses.size(); first += ADDR2LINE_MAX_ADDRESSES)
+    {
+        size_t last = min<size_t>(first + ADDR2LINE_MAX_ADDRESSES, addresses.size());
+        stringstream ss;
+        ss << strCommand << hex;
+
+        for (size_t i = first; i < last; i++)
+        {
+            ss << " 0x" << addresses[i].first;
+        }
+
+        FILE* pOutput = popen(ss.str().c_str(), "r");
+
+        if (pOutput == NULL)
+        {
+            Log(logWARNING, "Failed to run addr2line for %s\n", strFileName.c_str());
+            return;
+        }
+
+        // one "file:line" line per address, "??:0" if the address has no line
+        char szLine[SP_MAX_PATH];
+
+        for (size_t i = first; i < last && fgets(szLine, sizeof(szLine), pOutput) != NULL; i++)
+        {
+            string strOut = szLine;
+            size_t pos = strOut.find(" (discriminator");
+
+            if (pos == string::npos)
+            {
+                pos = strOut.find_last_not_of("\r\n") + 1;
+            }
+
+            strOut.resize(pos);
+            pos = strOut.find_last_of(':');
+
+            if (pos == string::npos || strOut.compare(0, 2, "??") == 0)
+            {
+                continue;
+            }
+
+            size_t lineNum = strtoul(strOut.c_str() + pos + 1, NULL, 10);
+
+            if (lineNum != 0)
+            {
+                addresses[i].second->m_strFile = strOut.substr(0, pos);
+                addresses[i].second->m_lineNum = lineNum;
+            }
+        }
+
+        pclose(pOutput);
+    }
+}
+
+ElfSymbolizer::ElfSymbolizer()
+{
+}
+
+ElfSymbolizer::~ElfSymbolizer()
+{
+    for (map<string, ElfModule*>::iterator it = m_modules.begin(); it != m_modules.end(); ++it)
+    {
+        SAFE_DELETE(it->second);
+    }
+
+    m_modules.clear();
+}
+
+void ElfSymbolizer::ReadProcessMaps()
+{
+    FILE* pMaps = fopen("/proc/self/maps", "r");
+
+    if (pMaps == NULL)
+    {
+        Log(logWARNING, "Failed to open /proc/self/maps\n");
+        return;
+    }
+
+    m_mappings.clear();
+
+    char szLine[SP_MAX_PATH + 128];
+
+    while (fgets(szLine, sizeof(szLine), pMaps) != NULL)
+    {
+        unsigned long long ullStart = 0;
+        unsigned long long ullEnd = 0;
+        unsigned long long ullOffset = 0;
+        char szPerms[8] = { 0 };
+        int pathPos = 0;
+
+        // start-end perms offset dev inode path
+        if (sscanf(szLine, "%llx-%llx %7s %llx %*s %*s %n", &ullStart, &ullEnd, szPerms, &ullOffset, &pathPos) < 4 ||
+            strchr(szPerms, 'x') == NULL || szLine[pathPos] != '/')
+        {
+            continue;
+        }
+
+        string strPath = szLine + pathPos;
+
+        while (!strPath.empty() && (strPath[strPath.size() - 1] == '\n' || strPath[strPath.size() - 1] == ' '))
+        {
+            strPath.erase(strPath.size() - 1);
+        }
+
+        map<string, ElfModule*>::iterator itModule = m_modules.find(strPath);
+
+        if (itModule == m_modules.end())
+        {
+            ElfModule* pModule = new(nothrow) ElfModule();
+
+            if (pModule != NULL && !pModule->Load(strPath))
+            {
+                Log(logMESSAGE, "Unable to read symbols of %s\n", strPath.c_str());
+                SAFE_DELETE(pModule);
+            }
+
+            itModule = m_modules.insert(make_pair(strPath, pModule)).first;
+        }
+
+        Mapping mapping;
+        mapping.m_end = static_cast<uintptr_t>(ullEnd);
+        mapping.m_ullOffset = ullOffset;
+        mapping.m_pModule = itModule->second;
+        m_mappings[static_cast<uintptr_t>(ullStart)] = mapping;
+    }
+
+    fclose(pMaps);
+}
+
+const ElfSymbolizer::Mapping* ElfSymbolizer::FindMapping(uintptr_t address, uintptr_t& start) const
+{
+    map<uintptr_t, Mapping>::const_iterator it = m_mappings.upper_bound(address);
+
+    if (it == m_mappings.begin())
+    {
+        return NULL;
+    }
+
+    --it;
+
+    if (address >= it->second.m_end)
+    {
+        return NULL;
+    }
+
+    start = it->first;
+    return &it->second;
+}
+
+bool ElfSymbolizer::Symbolize(const void* pAddress, ElfSymbolInfo& info)
+{
+    uintptr_t address = reinterpret_cast<uintptr_t>(pAddress);
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    unordered_map<uintptr_t, ElfSymbolInfo>::const_iterator itCache = m_cache.find(address);
+
+    if (itCache != m_cache.end())
+    {
+        info = itCache->second;
+        return !info.m_strSymName.empty() || !info.m_strFile.empty();
+    }
+
+    uintptr_t start = 0;
+    const Mapping* pMapping = FindMapping(address, start);
+
+    if (pMapping == NULL)
+    {
+        // the module may have been loaded since the maps were read
+        ReadProcessMaps();
+        pMapping = FindMapping(address, start);
+    }
+
+    ElfSymbolInfo newInfo;
+    unsigned long long ullModuleAddress = 0;
+
+    if (pMapping != NULL && pMapping->m_pModule != NULL &&
+        pMapping->m_pModule->FileOffsetToAddress(address - start + pMapping->m_ullOffset, ullModuleAddress))
+    {
+        pMapping->m_pModule->Lookup(ullModuleAddress, newInfo);
+
+        if (newInfo.m_strFile.empty() && pMapping->m_pModule->HasCompressedLineTable())
+        {
+            vector<pair<unsigned long long, ElfSymbolInfo*> > lineAddress(1, make_pair(ullModuleAddress, &newInfo));
+            ElfModule::LookupSourceLines(pMapping->m_pModule->GetFileName(), lineAddress);
+        }
+    }
+
+    // failures are cached too so that the maps are read again only for new addresses
+    m_cache[address] = newInfo;
+    info = newInfo;
+
+    return !info.m_strSymName.empty() || !info.m_strFile.empty();
+}
+
+ProcessModuleMap::ProcessModuleMap() : m_numModulesWritten(0), m_bUpdated(false)
+{
+}
+
+void ProcessModuleMap::Update()
+{
+    m_codeRanges.clear();
+
+    dl_iterate_phdr([](struct dl_phdr_info * pInfo, size_t size, void* pData) -> int
+    {
+        SP_UNREFERENCED_PARAMETER(size);
+        ProcessModuleMap* pThis = static_cast<ProcessModuleMap*>(pData);
+        string strPath = pInfo->dlpi_name != NULL ? pInfo->dlpi_name : "";
+
+        if (strPath.empty())
+        {
+            // the main executable
+            char szPath[SP_MAX_PATH];
+            ssize_t len = readlink("/proc/self/exe", szPath, sizeof(szPath) - 1);
+
+            if (len > 0)
+            {
+                strPath.assign(szPath, static_cast<size_t>(len));
+            }
+        }
+
+        // skip the modules that aren't files (vdso)
+        if (strPath.empty() || strPath[0] != '/')
+        {
+            return 0;
+        }
+
+        string strBuildID;
+
+        for (ElfW(Half) i = 0; i < pInfo->dlpi_phnum && strBuildID.empty(); i++)
+        {
+            const ElfW(Phdr)& programHeader = pInfo->dlpi_phdr[i];
+
+            if (programHeader.p_type == PT_NOTE)
+            {
+                strBuildID = GetBuildIDFromNotes(reinterpret_cast<const unsigned char*>(pInfo->dlpi_addr + programHeader.p_vaddr), programHeader.p_memsz);
+            }
+        }
+
+        // a file replaced while the process runs is a different module
+        string strKey = strPath + "\n" + strBuildID;
+        map<string, unsigned int>::const_iterator itIndex = pThis->m_moduleIndices.find(strKey);
+        unsigned int uiModuleIndex;
+
+        if (itIndex != pThis->m_moduleIndices.end())
+        {
+            uiModuleIndex = itIndex->second;
+        }
+        else
+        {
+            uiModuleIndex = static_cast<unsigned int>(pThis->m_modules.size());
+
+            ModuleMapEntry module;
+            module.m_strPath = strPath;
+            module.m_strBuildID = strBuildID;
+            pThis->m_modules.push_back(module);
+            pThis->m_moduleIndices.insert(make_pair(strKey, uiModuleIndex));
+        }
+
+        for (ElfW(Half) i = 0; i < pInfo->dlpi_phnum; i++)
+        {
+            const ElfW(Phdr)& programHeader = pInfo->dlpi_phdr[i];
+
+            if (programHeader.p_type == PT_LOAD && (programHeader.p_flags & PF_X) != 0)
+            {
+                uintptr_t start = static_cast<uintptr_t>(pInfo->dlpi_addr + programHeader.p_vaddr);
+
+                CodeRange range;
+                range.m_end = start + static_cast<uintptr_t>(programHeader.p_memsz);
+                range.m_loadBias = static_cast<uintptr_t>(pInfo->dlpi_addr);
+                range.m_uiModuleIndex = uiModuleIndex;
+                pThis->m_codeRanges[start] = range;
+            }
+        }
+
+        return 0;
+    }, this);
+
+    m_bUpdated = true;
+}
+
+bool ProcessModuleMap::FindModule(const void* pAddress, unsigned int& uiModuleIndex, unsigned long long& ullModuleAddress, std::string* pStrPath)
+{
+    uintptr_t address = reinterpret_cast<uintptr_t>(pAddress);
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    auto findRange = [&]() -> const CodeRange*
+    {
+        map<uintptr_t, CodeRange>::const_iterator it = m_codeRanges.upper_bound(address);
+
+        if (it == m_codeRanges.begin())
+        {
+            return NULL;
+        }
+
+        --it;
+        return address < it->second.m_end ? &it->second : NULL;
+    };
+
+    const CodeRange* pRange = m_bUpdated ? findRange() : NULL;
+
+    if (pRange == NULL)
+    {
+        // first lookup, or the module has been loaded since the modules were listed
+        Update();
+        pRange = findRange();
+    }
+
+    if (pRange == NULL)
+    {
+        return false;
+    }
+
+    uiModuleIndex = pRange->m_uiModuleIndex;
+    ullModuleAddress = address - pRange->m_loadBias;
+
+    if (pStrPath != NULL)
+    {
+        *pStrPath = m_modules[uiModuleIndex].m_strPath;
+    }
+
+    return true;
+}
+
+bool ProcessModuleMap::WriteToFile(const std::string& strFileName)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    if (m_numModulesWritten == m_modules.size())
+    {
+        return true;
+    }
+
+    ofstream fout(strFileName.c_str(), ios::out | ios::trunc);
+
+    if (fout.fail())
+    {
+        Log(logWARNING, "Failed to open file: %s.\n", strFileName.c_str());
+        return false;
+    }
+
+    // index, build ID ("-" if none) and file name, one module per line
+    for (size_t i = 0; i < m_modules.size(); i++)
+    {
+        fout << i << '\t' << (m_modules[i].m_strBuildID.empty() ? "-" : m_modules[i].m_strBuildID) << '\t' << m_modules[i].m_strPath << '\n';
+    }
+
+    fout.close();
+
+    if (fout.fail())
+    {
+        Log(logWARNING, "Failed to write file: %s.\n", strFileName.c_str());
+        return false;
+    }
+
+    m_numModulesWritten = m_modules.size();
+
+    return true;
+}
+
+bool ProcessModuleMap::ReadFromFile(const std::string& strFileName, std::vector<ModuleMapEntry>& modules)
+{
+    ifstream fin(strFileName.c_str());
+
+    if (fin.fail())
+    {
+        return false;
+    }
+
+    modules.clear();
+    string strLine;
+
+    while (getline(fin, strLine))
+    {
+        size_t pos0 = strLine.find('\t');
+        size_t pos1 = pos0 == string::npos ? string::npos : strLine.find('\t', pos0 + 1);
+
+        if (pos1 == string::npos || strtoul(strLine.c_str(), NULL, 10) != modules.size())
+        {
+            Log(logWARNING, "Invalid module map %s\n", strFileName.c_str());
+            return false;
+        }
+
+        ModuleMapEntry module;
+        module.m_strBuildID = strLine.substr(pos0 + 1, pos1 - pos0 - 1);
+        module.m_strPath = strLine.substr(pos1 + 1);
+
+        if (module.m_strBuildID == "-")
+        {
+            module.m_strBuildID.clear();
+        }
+
+        modules.push_back(module);
+    }
+
+    return true;
+}
+
+/// Parse the raw address of a stack trace line
+/// \param strLine the line
+/// \param[out] tokenPos the position of the raw address token
+/// \param[out] tokenEnd the end of the raw address token
+/// \param[out] uiModuleIndex the module index
+/// \param[out] ullModuleAddress the address in the module
+/// \return false if the line doesn't contain a raw address
+static bool ParseRawAddress(const string& strLine, size_t& tokenPos, size_t& tokenEnd, unsigned int& uiModuleIndex, unsigned long long& ullModuleAddress)
+{
+    const char szPrefix[] = { '\t', RAW_ADDRESS_PREFIX, '\0' };
+    tokenPos = strLine.find(szPrefix);
+
+    if (tokenPos == string::npos)
+    {
+        return false;
+    }
+
+    tokenPos++;
+
+    const char* pStart = strLine.c_str() + tokenPos + 1;
+    char* pEnd = NULL;
+    uiModuleIndex = static_cast<unsigned int>(strtoul(pStart, &pEnd, 10));
+
+    if (pEnd == pStart || *pEnd != '+')
+    {
+        return false;
+    }
+
+    pStart = pEnd + 1;
+    ullModuleAddress = strtoull(pStart, &pEnd, 16);
+
+    if (pEnd == pStart || (*pEnd != '\0' && *pEnd != '\t'))
+    {
+        return false;
+    }
+
+    tokenEnd = static_cast<size_t>(pEnd - strLine.c_str());
+
+    return true;
+}
+
+bool OfflineSymbolizer::SymbolizeFiles(const std::string& strModuleMapFile, const std::vector<std::string>& stackFiles)
+{
+    vector<ModuleMapEntry> modules;
+
+    if (!ProcessModuleMap::ReadFromFile(strModuleMapFile, modules))
+    {
+        return false;
+    }
+
+    // the unique addresses of each module
+    vector<map<unsigned long long, ElfSymbolInfo> > addresses(modules.size());
+    string strLine;
+
+    for (vector<string>::const_iterator it = stackFiles.begin(); it != stackFiles.end(); ++it)
+    {
+        InputFileStream fin(it->c_str());
+
+        while (getline(fin, strLine))
+        {
+            size_t tokenPos;
+            size_t tokenEnd;
+            unsigned int uiModuleIndex;
+            unsigned long long ullModuleAddress;
+
+            if (ParseRawAddress(strLine, tokenPos, tokenEnd, uiModuleIndex, ullModuleAddress) && uiModuleIndex < modules.size())
+            {
+                addresses[uiModuleIndex][ullModuleAddress];
+            }
+        }
+    }
+
+    // each module is read by one thread, the threads take the next module to resolve until there is none left
+    std::atomic<size_t> nextModule(0);
+    auto resolveModules = [&]()
+    {
+        for (size_t i = nextModule++; i < modules.size(); i = nextModule++)
+        {
+            if (addresses[i].empty())
+            {
+                continue;
+            }
+
+            ElfModule module;
+
+            if (!module.Load(modules[i].m_strPath))
+            {
+                Log(logMESSAGE, "Unable to read symbols of %s\n", modules[i].m_strPath.c_str());
+                continue;
+            }
+
+            if (!modules[i].m_strBuildID.empty() && module.GetBuildID() != modules[i].m_strBuildID)
+            {
+                Log(logWARNING, "%s has been modified since it was profiled, its stack entries are not symbolized\n", modules[i].m_strPath.c_str());
+                continue;
+            }
+
+            vector<pair<unsigned long long, ElfSymbolInfo*> > lineAddresses;
+
+            for (map<unsigned long long, ElfSymbolInfo>::iterator itAddress = addresses[i].begin(); itAddress != addresses[i].end(); ++itAddress)
+            {
+                // the raw addresses are return addresses, look up the call instruction
+                module.Lookup(itAddress->first - 1, itAddress->second);
+
+                if (itAddress->second.m_strFile.empty() && module.HasCompressedLineTable())
+                {
+                    lineAddresses.push_back(make_pair(itAddress->first - 1, &itAddress->second));
+                }
+            }
+
+            if (!lineAddresses.empty())
+            {
+                ElfModule::LookupSourceLines(modules[i].m_strPath, lineAddresses);
+            }
+        }
+    };
+
+    size_t numThreads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), modules.size());
+    vector<std::thread> threads;
+
+    for (size_t i = 1; i < numThreads; i++)
+    {
+        threads.push_back(std::thread(resolveModules));
+    }
+
+    resolveModules();
+
+    for (vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+    {
+        it->join();
+    }
+
+    // replace the raw addresses by the entries the agents write when they resolve the symbols in-process
+    for (vector<string>::const_iterator it = stackFiles.begin(); it != stackFiles.end(); ++it)
+    {
+        string strTmpFile = *it + ".sym";
+        InputFileStream fin(it->c_str());
+        ofstream fout(strTmpFile.c_str(), ios::out | ios::trunc);
+
+        if (!fin.is_open() || fout.fail())
+        {
+            Log(logWARNING, "Failed to symbolize %s\n", it->c_str());
+            continue;
+        }
+
+        while (getline(fin, strLine))
+        {
+            size_t tokenPos;
+            size_t tokenEnd;
+            unsigned int uiModuleIndex;
+            unsigned long long ullModuleAddress;
+
+            if (ParseRawAddress(strLine, tokenPos, tokenEnd, uiModuleIndex, ullModuleAddress) && uiModuleIndex < modules.size())
+            {
+                const ElfSymbolInfo& info = addresses[uiModuleIndex][ullModuleAddress];
+
+                fout.write(strLine.c_str(), tokenPos);
+                fout << "NA\t" << info.m_lineNum << "\t" << StringUtils::Replace(info.m_strFile, " ", string(SPACE));
+                fout << strLine.c_str() + tokenEnd << '\n';
+            }
+            else
+            {
+                fout << strLine << '\n';
+            }
+        }
+
+        fin.close();
+        fout.close();
+
+        if (fout.fail() || rename(strTmpFile.c_str(), it->c_str()) != 0)
+        {
+            Log(logWARNING, "Failed to symbolize %s\n", it->c_str());
+            remove(strTmpFile.c_str());
+        }
+    }
+
+    return true;
+}
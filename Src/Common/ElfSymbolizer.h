@@ -0,0 +1,306 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class resolves code addresses of the current process to symbol
+///        names and source lines by reading the ELF symbol tables and the
+///        DWARF line tables of the loaded modules (Linux only). The module
+///        map records the loaded modules so that raw addresses can be
+///        resolved after the process has exited.
+//==============================================================================
+
+#ifndef _ELF_SYMBOLIZER_H_
+#define _ELF_SYMBOLIZER_H_
+
+/// \defgroup ElfSymbolizer ElfSymbolizer
+/// This module implements the symbolizers used by the stack tracer on Linux
+///
+/// \ingroup Common
+// @{
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+/// Symbol information of an address
+struct ElfSymbolInfo
+{
+    /// Constructor
+    ElfSymbolInfo() : m_lineNum(0)
+    {
+    }
+
+    std::string m_strSymName;     ///< symbol name, empty if the address isn't in a symbol
+    std::string m_strFile;        ///< source file, empty if there is no line information
+    size_t      m_lineNum;        ///< line number
+};
+
+/// Prefix of a raw address in the stack trace output, "@<module index>+0x<address in the module>"
+#define RAW_ADDRESS_PREFIX '@'
+
+/// Module of the module map
+struct ModuleMapEntry
+{
+    std::string m_strPath;        ///< file name
+    std::string m_strBuildID;     ///< GNU build ID (hex string), empty if the module doesn't have one
+};
+
+//------------------------------------------------------------------------------------
+/// Symbols and line table of an ELF file. The file is read once by Load, the symbol
+/// table and the line table are then kept as arrays sorted by address.
+//------------------------------------------------------------------------------------
+class ElfModule
+{
+public:
+    /// Constructor
+    ElfModule();
+
+    /// Read the symbol tables (.symtab and .dynsym) and the line table (.debug_line) of a file.
+    /// If the file has no line table, the separate debug file found by its build ID
+    /// (/usr/lib/debug/.build-id) or its .gnu_debuglink section is read as well
+    /// \param strFileName the file name
+    /// \return false if the file is not a valid ELF file
+    bool Load(const std::string& strFileName);
+
+    /// Convert a file offset to an address, addresses in the symbol and line tables are in this space
+    /// \param ullFileOffset offset in the file of a mapped byte
+    /// \param[out] ullAddress the address of the byte in the file's address space
+    /// \return false if the offset is not in a loadable segment
+    bool FileOffsetToAddress(unsigned long long ullFileOffset, unsigned long long& ullAddress) const;
+
+    /// Find the symbol and the source line of an address
+    /// \param ullAddress the address in the file's address space
+    /// \param[out] info the symbol information, fields not found are left as is
+    void Lookup(unsigned long long ullAddress, ElfSymbolInfo& info) const;
+
+    /// Get the GNU build ID of the file
+    /// \return the build ID (hex string), empty if the file doesn't have one
+    const std::string& GetBuildID() const
+    {
+        return m_strBuildID;
+    }
+
+    /// Get the name of the file read by Load
+    /// \return the file name
+    const std::string& GetFileName() const
+    {
+        return m_strFileName;
+    }
+
+    /// Check whether the line table could not be read because its sections are compressed
+    /// (SHF_COMPRESSED or .zdebug_*), the source lines are then left to addr2line
+    /// \return true if the line table is compressed
+    bool HasCompressedLineTable() const
+    {
+        return m_bCompressedLineTable && m_lines.empty();
+    }
+
+    /// Find the source lines of addresses with addr2line, used for the files whose line table is compressed
+    /// \param strFileName the file name
+    /// \param[in,out] addresses the addresses in the file's address space and their symbol information, the source file and line are set if found
+    static void LookupSourceLines(const std::string& strFileName, std::vector<std::pair<unsigned long long, ElfSymbolInfo*> >& addresses);
+
+private:
+    /// Loadable segment
+    struct Segment
+    {
+        unsigned long long m_ullOffset;    ///< offset in the file
+        unsigned long long m_ullFileSize;  ///< size in the file
+        unsigned long long m_ullAddress;   ///< address
+    };
+
+    /// Function symbol
+    struct Symbol
+    {
+        unsigned long long m_ullAddress;   ///< start address
+        unsigned long long m_ullSize;      ///< size, 0 if unknown
+        size_t             m_nameOffset;   ///< offset of the name in m_strNames
+    };
+
+    /// Row of the line table
+    struct LineRow
+    {
+        unsigned long long m_ullAddress;   ///< address of the first instruction of the row
+        uint32_t           m_fileIndex;    ///< index of the source file in m_files
+        uint32_t           m_line;         ///< line number
+        bool               m_bEndSequence; ///< flag indicating that the row is the end of a sequence (the address is past the code)
+    };
+
+    /// Map and parse an ELF file
+    /// \param strFileName the file name
+    /// \return false if the file is not a valid ELF file
+    bool LoadFile(const std::string& strFileName);
+
+    /// Read the symbols and the line table of the separate debug file of the file read by LoadFile
+    /// \param strFileName the file name
+    void LoadSeparateDebugFile(const std::string& strFileName);
+
+    /// Sort the function symbols by address, keeping one symbol per address
+    void SortSymbols();
+
+    /// Parse the sections and segments of an ELF file
+    /// \param pData the file data
+    /// \param size the file size
+    /// \return false if the file is not valid
+    template <typename Ehdr, typename Shdr, typename Phdr, typename Sym>
+    bool ParseElf(const unsigned char* pData, size_t size);
+
+    /// Add the function symbols of a symbol table
+    /// \param pSymbols the symbols
+    /// \param numSymbols the number of symbols
+    /// \param pStrings the string table of the symbols
+    /// \param stringsSize the size of the string table
+    template <typename Sym>
+    void AddSymbols(const Sym* pSymbols, size_t numSymbols, const char* pStrings, size_t stringsSize);
+
+    /// Parse the line number programs of the .debug_line section
+    /// \param pData the section data
+    /// \param size the section size
+    /// \param pLineStr the .debug_line_str section, or NULL
+    /// \param lineStrSize the .debug_line_str section size
+    /// \param pStr the .debug_str section, or NULL
+    /// \param strSize the .debug_str section size
+    void ParseDebugLine(const unsigned char* pData, size_t size, const unsigned char* pLineStr, size_t lineStrSize, const unsigned char* pStr, size_t strSize);
+
+    std::vector<Segment> m_segments;       ///< loadable segments
+    std::vector<Symbol>  m_symbols;        ///< function symbols sorted by address
+    std::string          m_strNames;       ///< names of the symbols, nul separated
+    std::vector<LineRow> m_lines;          ///< line table sorted by address
+    std::vector<std::string> m_files;      ///< source files referenced by the line table
+    std::string          m_strBuildID;     ///< GNU build ID
+    std::string          m_strDebugLink;   ///< file name of the separate debug file (.gnu_debuglink), empty if there is none
+    std::string          m_strFileName;    ///< file name
+    bool                 m_bCompressedLineTable; ///< flag indicating that a line table section is compressed
+};
+
+//------------------------------------------------------------------------------------
+/// Symbolizer of the addresses of the current process. The modules are found in
+/// /proc/self/maps and each one is read once; the resolved addresses are cached so
+/// a frame seen again is resolved by a single lookup.
+//------------------------------------------------------------------------------------
+class ElfSymbolizer
+{
+public:
+    /// Constructor
+    ElfSymbolizer();
+
+    /// Destructor
+    ~ElfSymbolizer();
+
+    /// Resolve an address
+    /// \param pAddress the address
+    /// \param[out] info the symbol information
+    /// \return false if the address is not in a module or the module has no symbols nor line information
+    bool Symbolize(const void* pAddress, ElfSymbolInfo& info);
+
+private:
+    /// Executable mapping of a module
+    struct Mapping
+    {
+        uintptr_t          m_end;          ///< end address (exclusive)
+        unsigned long long m_ullOffset;    ///< offset in the file of the start address
+        ElfModule*         m_pModule;      ///< module, NULL if the file could not be read
+    };
+
+    /// Read the executable mappings of /proc/self/maps, the modules not seen before are loaded
+    void ReadProcessMaps();
+
+    /// Find the mapping of an address
+    /// \param address the address
+    /// \param[out] start the start address of the mapping
+    /// \return the mapping or NULL if the address is not mapped from a file
+    const Mapping* FindMapping(uintptr_t address, uintptr_t& start) const;
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    ElfSymbolizer(const ElfSymbolizer& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    ElfSymbolizer& operator=(const ElfSymbolizer& obj) = delete;
+
+    std::map<uintptr_t, Mapping>                 m_mappings; ///< executable mappings indexed by start address
+    std::map<std::string, ElfModule*>            m_modules;  ///< modules indexed by file name
+    std::unordered_map<uintptr_t, ElfSymbolInfo> m_cache;    ///< resolved addresses
+    std::mutex                                   m_mtx;      ///< mutex protecting the maps and the cache
+};
+
+//------------------------------------------------------------------------------------
+/// Map of the modules loaded in the current process. The stack tracer uses it in the
+/// offline symbolization mode: a frame is recorded as a module index and an address in
+/// the module's address space, the module list (file names and build IDs) is written
+/// once per process and rcprof resolves the addresses when it merges the stack traces.
+/// Modules are only appended so that the indices stay valid.
+//------------------------------------------------------------------------------------
+class ProcessModuleMap
+{
+public:
+    /// Constructor
+    ProcessModuleMap();
+
+    /// Find the module of an address, the loaded modules are listed again if the address isn't in a known module
+    /// \param pAddress the address
+    /// \param[out] uiModuleIndex the module index
+    /// \param[out] ullModuleAddress the address in the module's address space
+    /// \param[out] pStrPath if not NULL, receives the file name of the module
+    /// \return false if the address is not in the code of a module
+    bool FindModule(const void* pAddress, unsigned int& uiModuleIndex, unsigned long long& ullModuleAddress, std::string* pStrPath = NULL);
+
+    /// Write the module list, the file is only written if modules were added since the last call
+    /// \param strFileName the file name
+    /// \return false if the file could not be written
+    bool WriteToFile(const std::string& strFileName);
+
+    /// Read a module list written by WriteToFile
+    /// \param strFileName the file name
+    /// \param[out] modules the modules indexed by module index
+    /// \return false if the file could not be read
+    static bool ReadFromFile(const std::string& strFileName, std::vector<ModuleMapEntry>& modules);
+
+private:
+    /// Code segment of a loaded module
+    struct CodeRange
+    {
+        uintptr_t    m_end;           ///< end address (exclusive)
+        uintptr_t    m_loadBias;      ///< difference between the addresses in memory and in the module
+        unsigned int m_uiModuleIndex; ///< module index
+    };
+
+    /// List the loaded modules (dl_iterate_phdr)
+    void Update();
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    ProcessModuleMap(const ProcessModuleMap& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    ProcessModuleMap& operator=(const ProcessModuleMap& obj) = delete;
+
+    std::vector<ModuleMapEntry>              m_modules;            ///< modules indexed by module index
+    std::map<std::string, unsigned int>      m_moduleIndices;      ///< module index of each file name and build ID
+    std::map<uintptr_t, CodeRange>           m_codeRanges;         ///< code segments indexed by start address
+    size_t                                   m_numModulesWritten;  ///< number of modules in the file written last
+    bool                                     m_bUpdated;           ///< flag indicating that the modules have been listed at least once
+    std::mutex                               m_mtx;                ///< mutex protecting the map
+};
+
+/// Resolution of the raw addresses written by the agents in the offline symbolization mode
+namespace OfflineSymbolizer
+{
+/// Replace the raw addresses of stack trace files by source lines. The unique addresses
+/// are collected first, each module is then read once by one of a few worker threads
+/// \param strModuleMapFile the module map written by the agent
+/// \param stackFiles the stack trace files (or fragments) referring to the module map
+/// \return false if the module map could not be read
+bool SymbolizeFiles(const std::string& strModuleMapFile, const std::vector<std::string>& stackFiles);
+}
+
+// @}
+
+#endif //_ELF_SYMBOLIZER_H_
@@ -28,6 +28,9 @@
 #include <iostream>
 #include <sstream>
 #include <locale>
+#include <thread>
+#include <atomic>
+#include <vector>
 
 #include <AMDTBaseTools/Include/gtString.h>
 #include <AMDTBaseTools/Include/gtStringTokenizer.h>
@@ -43,6 +46,7 @@
 #include "OSUtils.h"
 #include "Defs.h"
 #include "ProfilerOutputFileDefs.h"
+#include "CompressedStream.h"
 
 
 using std::stringstream;
@@ -54,6 +58,12 @@ using std::endl;
 
 using namespace GPULogger;
 
+/// Size of the chunks read from the tmp files when they are merged
+#define TMP_FILE_MERGE_CHUNK_SIZE (1024 * 1024)
+
+/// Total size of the tmp file contents kept in memory between the counting and the copying passes of a merge
+#define TMP_FILE_MERGE_CACHE_SIZE (64 * 1024 * 1024)
+
 
 #ifdef _DEBUG
 //
@@ -229,6 +239,19 @@ void FileUtils::PassParametersByFile(Parameters params)
     fout << "AqlPacketTracing=" << (params.m_bAqlPacketTracing ? "True" : "False") << endl;
     fout << "HSADisableKernelDemangle=" << (params.m_bDisableKernelDemangling ? "True" : "False") << endl;
     fout << "NoHSATransferTime=" << (params.m_bNoHSATransferTime ? "True" : "False") << endl;
+    fout << "ThreadTraceBuffer=" << (params.m_bThreadTraceBuffer ? "True" : "False") << endl;
+    fout << "FragmentBufferSize=" << params.m_uiFragmentBufferSize << endl;
+    fout << "FlushWatermark=" << params.m_uiFlushWatermark << endl;
+    fout << "MaxPendingTraceEntries=" << params.m_uiMaxPendingTraceEntries << endl;
+    fout << "SpillEntryThreshold=" << params.m_uiSpillEntryThreshold << endl;
+    fout << "BackpressureTimeout=" << params.m_uiBackpressureTimeout << endl;
+    fout << "APIStatisticsOnly=" << (params.m_bAPIStatisticsOnly ? "True" : "False") << endl;
+    fout << "FlightRecorderEntries=" << params.m_uiFlightRecorderEntries << endl;
+    fout << "FlightRecorderSeconds=" << params.m_uiFlightRecorderSeconds << endl;
+    fout << "FlightRecorderLatencyTrigger=" << params.m_uiFlightRecorderLatencyTrigger << endl;
+    fout << "TSCTimer=" << (params.m_bTSCTimer ? "True" : "False") << endl;
+    fout << "CompressOutput=" << (params.m_bCompressOutput ? "True" : "False") << endl;
+    fout << "OfflineSymbols=" << (params.m_bOfflineSymbols ? "True" : "False") << endl;
 
     for (EnvVarMap::const_iterator it = params.m_mapEnvVars.begin(); it != params.m_mapEnvVars.end(); ++it)
     {
@@ -625,6 +648,106 @@ bool FileUtils::GetParametersFromFile(Parameters& params)
                 {
                     params.m_bNoHSATransferTime = (valStr.find("True") != std::string::npos);
                 }
+                else if (opStr == "CompressOutput")
+                {
+                    params.m_bCompressOutput = (valStr.find("True") != std::string::npos);
+                }
+                else if (opStr == "OfflineSymbols")
+                {
+                    params.m_bOfflineSymbols = (valStr.find("True") != std::string::npos);
+                }
+                else if (opStr == "TSCTimer")
+                {
+                    params.m_bTSCTimer = (valStr.find("True") != std::string::npos);
+                }
+                else if (opStr == "ThreadTraceBuffer")
+                {
+                    params.m_bThreadTraceBuffer = (valStr.find("True") != std::string::npos);
+                }
+                else if (opStr == "FragmentBufferSize")
+                {
+                    bool ret = StringUtils::Parse(valStr, params.m_uiFragmentBufferSize);
+
+                    if (!ret)
+                    {
+                        Log(logWARNING, "Failed to parse parameter file.\n");
+                        params.m_uiFragmentBufferSize = DEFAULT_FRAGMENT_BUFFER_SIZE;
+                    }
+                }
+                else if (opStr == "FlushWatermark")
+                {
+                    bool ret = StringUtils::Parse(valStr, params.m_uiFlushWatermark);
+
+                    if (!ret)
+                    {
+                        Log(logWARNING, "Failed to parse parameter file.\n");
+                        params.m_uiFlushWatermark = DEFAULT_FLUSH_WATERMARK;
+                    }
+                }
+                else if (opStr == "MaxPendingTraceEntries")
+                {
+                    bool ret = StringUtils::Parse(valStr, params.m_uiMaxPendingTraceEntries);
+
+                    if (!ret)
+                    {
+                        Log(logWARNING, "Failed to parse parameter file.\n");
+                        params.m_uiMaxPendingTraceEntries = DEFAULT_MAX_PENDING_TRACE_ENTRIES;
+                    }
+                }
+                else if (opStr == "SpillEntryThreshold")
+                {
+                    bool ret = StringUtils::Parse(valStr, params.m_uiSpillEntryThreshold);
+
+                    if (!ret)
+                    {
+                        Log(logWARNING, "Failed to parse parameter file.\n");
+                        params.m_uiSpillEntryThreshold = DEFAULT_SPILL_ENTRY_THRESHOLD;
+                    }
+                }
+                else if (opStr == "BackpressureTimeout")
+                {
+                    bool ret = StringUtils::Parse(valStr, params.m_uiBackpressureTimeout);
+
+                    if (!ret)
+                    {
+                        Log(logWARNING, "Failed to parse parameter file.\n");
+                        params.m_uiBackpressureTimeout = DEFAULT_BACKPRESSURE_TIMEOUT;
+                    }
+                }
+                else if (opStr == "APIStatisticsOnly")
+                {
+                    params.m_bAPIStatisticsOnly = (valStr.find("True") != std::string::npos);
+                }
+                else if (opStr == "FlightRecorderEntries")
+                {
+                    bool ret = StringUtils::Parse(valStr, params.m_uiFlightRecorderEntries);
+
+                    if (!ret)
+                    {
+                        Log(logWARNING, "Failed to parse parameter file.\n");
+                        params.m_uiFlightRecorderEntries = 0;
+                    }
+                }
+                else if (opStr == "FlightRecorderSeconds")
+                {
+                    bool ret = StringUtils::Parse(valStr, params.m_uiFlightRecorderSeconds);
+
+                    if (!ret)
+                    {
+                        Log(logWARNING, "Failed to parse parameter file.\n");
+                        params.m_uiFlightRecorderSeconds = 0;
+                    }
+                }
+                else if (opStr == "FlightRecorderLatencyTrigger")
+                {
+                    bool ret = StringUtils::Parse(valStr, params.m_uiFlightRecorderLatencyTrigger);
+
+                    if (!ret)
+                    {
+                        Log(logWARNING, "Failed to parse parameter file.\n");
+                        params.m_uiFlightRecorderLatencyTrigger = 0;
+                    }
+                }
             }
         }
         catch (...)
@@ -813,7 +936,8 @@ bool FileUtils::WriteFile(const std::wstring& strFilename, const std::vector<std
 template<typename InsertionFunc>
 bool DoReadFile(const std::wstring& strFilename, InsertionFunc insertionFunc, bool bSkipEmptyLines, bool bOutputError)
 {
-    std::ifstream iFile;
+    // tmp fragments can be compressed
+    InputFileStream iFile;
 
 #ifdef _WIN32
     iFile.open(strFilename.c_str());
@@ -1201,6 +1325,228 @@ bool FileUtils::GetTmpFilesToMerge(const gtString& strTmpFilesDirPath,
     return ret;
 }
 
+/// A tmp file to merge
+struct TmpFileToMerge
+{
+    std::wstring m_strFullFilePath; ///< file path
+    std::wstring m_strTid;          ///< thread id extracted from the file name
+    int          m_numLines;        ///< number of non-blank lines
+    size_t       m_size;            ///< size of the non-blank lines
+    bool         m_bFiltered;       ///< flag indicating that the file has blank lines or no final newline, its non-blank lines differ from its contents
+    bool         m_bReadable;       ///< flag indicating whether the file could be read
+    std::string  m_strData;         ///< the non-blank lines, kept if the file is small enough (see TMP_FILE_MERGE_CACHE_SIZE)
+    bool         m_bCached;         ///< flag indicating that m_strData holds all the non-blank lines
+};
+
+/// Write data read from a tmp file to the merged output
+/// \param sout the output stream
+/// \param pData the data
+/// \param size the size of the data
+static void WriteMergedData(SP_outStream& sout, const char* pData, size_t size)
+{
+#ifdef _WIN32
+
+    // the output is a wide stream, widen the characters as operator<<(const char*) does
+    for (size_t i = 0; i < size; i++)
+    {
+        sout.put(sout.widen(pData[i]));
+    }
+
+#else
+    sout.write(pData, static_cast<std::streamsize>(size));
+#endif
+}
+
+/// Read the lines of a tmp file that contain a non-whitespace character, in chunks of TMP_FILE_MERGE_CHUNK_SIZE.
+/// This matches ReadFile (with empty lines skipped): each line is passed on with a trailing '\n'
+/// \param strFileName the tmp file, it can be compressed
+/// \param buffer the chunk buffer
+/// \param writeFunc function called with consecutive pieces of the non-blank lines, runs of whole lines are passed in a single call
+/// \param[out] numLines the number of non-blank lines
+/// \param[out] bFiltered set if blank lines were dropped or a final newline was added
+/// \return false if the file could not be read
+template<typename WriteFunc>
+static bool ReadTmpFileLines(const std::wstring& strFileName, std::vector<char>& buffer, WriteFunc writeFunc, int& numLines, bool& bFiltered)
+{
+    InputFileStream iFile;
+
+#ifdef _WIN32
+    iFile.open(strFileName.c_str());
+#else
+    std::string convertedName;
+    StringUtils::WideStringToUtf8String(strFileName, convertedName);
+    iFile.open(convertedName.c_str());
+#endif
+
+    if (iFile.fail())
+    {
+        return false;
+    }
+
+    numLines = 0;
+    bFiltered = false;
+    bool bLineHasText = false;
+    std::string strLeadingSpaces;
+
+    while (iFile.read(&buffer[0], buffer.size()) || iFile.gcount() > 0)
+    {
+        const char* pChunk = &buffer[0];
+        size_t chunkSize = static_cast<size_t>(iFile.gcount());
+
+        // a line started in the previous chunk continues at the start of this one
+        size_t runStart = bLineHasText ? 0 : string::npos;
+
+        for (size_t i = 0; i < chunkSize; i++)
+        {
+            char ch = pChunk[i];
+
+            if ('\n' == ch)
+            {
+                if (bLineHasText)
+                {
+                    writeFunc(pChunk + runStart, i + 1 - runStart);
+                    runStart = string::npos;
+                    numLines++;
+                }
+                else
+                {
+                    bFiltered = true;
+                }
+
+                strLeadingSpaces.clear();
+                bLineHasText = false;
+            }
+            else if (!bLineHasText)
+            {
+                if (isspace(static_cast<unsigned char>(ch)))
+                {
+                    // blank lines are dropped, so the leading spaces are only written once a character follows
+                    strLeadingSpaces += ch;
+                }
+                else
+                {
+                    if (!strLeadingSpaces.empty())
+                    {
+                        writeFunc(strLeadingSpaces.c_str(), strLeadingSpaces.size());
+                        strLeadingSpaces.clear();
+                    }
+
+                    bLineHasText = true;
+                    runStart = i;
+                }
+            }
+        }
+
+        if (string::npos != runStart)
+        {
+            writeFunc(pChunk + runStart, chunkSize - runStart);
+        }
+    }
+
+    if (bLineHasText)
+    {
+        writeFunc("\n", 1);
+        numLines++;
+        bFiltered = true;
+    }
+    else if (!strLeadingSpaces.empty())
+    {
+        bFiltered = true;
+    }
+
+    return !iFile.bad();
+}
+
+/// Copy the contents of a tmp file without looking for blank lines, for the files ReadTmpFileLines doesn't filter
+/// \param strFileName the tmp file, it can be compressed
+/// \param buffer the chunk buffer
+/// \param writeFunc function called with each chunk
+/// \param[out] size the number of bytes copied
+/// \return false if the file could not be read
+template<typename WriteFunc>
+static bool CopyTmpFile(const std::wstring& strFileName, std::vector<char>& buffer, WriteFunc writeFunc, size_t& size)
+{
+    InputFileStream iFile;
+
+#ifdef _WIN32
+    iFile.open(strFileName.c_str());
+#else
+    std::string convertedName;
+    StringUtils::WideStringToUtf8String(strFileName, convertedName);
+    iFile.open(convertedName.c_str());
+#endif
+
+    if (iFile.fail())
+    {
+        return false;
+    }
+
+    size = 0;
+
+    while (iFile.read(&buffer[0], buffer.size()) || iFile.gcount() > 0)
+    {
+        size_t chunkSize = static_cast<size_t>(iFile.gcount());
+        writeFunc(&buffer[0], chunkSize);
+        size += chunkSize;
+    }
+
+    return !iFile.bad();
+}
+
+/// Count the non-blank lines and their size of the tmp files, the files are distributed over one thread per core.
+/// The non-blank lines of the files that fit in their share of TMP_FILE_MERGE_CACHE_SIZE are kept
+/// \param files the tmp files
+static void CountTmpFileLines(std::vector<TmpFileToMerge>& files)
+{
+    std::atomic<size_t> nextFile(0);
+    size_t maxCachedSize = TMP_FILE_MERGE_CACHE_SIZE / std::max<size_t>(files.size(), 1);
+
+    auto countFunc = [&]()
+    {
+        std::vector<char> buffer(TMP_FILE_MERGE_CHUNK_SIZE);
+
+        for (size_t i = nextFile++; i < files.size(); i = nextFile++)
+        {
+            TmpFileToMerge& file = files[i];
+            file.m_size = 0;
+            file.m_bCached = true;
+
+            auto cacheFunc = [&file, maxCachedSize](const char* pData, size_t size)
+            {
+                file.m_size += size;
+
+                if (file.m_bCached && file.m_size > maxCachedSize)
+                {
+                    // too big, the copying pass reads the file again
+                    std::string().swap(file.m_strData);
+                    file.m_bCached = false;
+                }
+                else if (file.m_bCached)
+                {
+                    file.m_strData.append(pData, size);
+                }
+            };
+
+            file.m_bReadable = ReadTmpFileLines(file.m_strFullFilePath, buffer, cacheFunc, file.m_numLines, file.m_bFiltered);
+        }
+    };
+
+    size_t numThreads = std::min<size_t>(std::max(1U, std::thread::hardware_concurrency()), files.size());
+    std::vector<std::thread> threads;
+
+    for (size_t i = 1; i < numThreads; i++)
+    {
+        threads.push_back(std::thread(countFunc));
+    }
+
+    countFunc();
+
+    for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+    {
+        it->join();
+    }
+}
+
 bool FileUtils::MergeTmpTraceFiles(SP_outStream& sout,
                                    const gtString& strTmpFilesDirPath,
                                    const gtString& strFilePrefix,
@@ -1214,26 +1560,25 @@ bool FileUtils::MergeTmpTraceFiles(SP_outStream& sout,
 
     if (ret)
     {
-        bool bWriteHeader = false;
-
-        std::wstring strFullFilePath;
-        std::string strFileContent;
+        std::vector<TmpFileToMerge> filesToMerge;
         osFilePath strFileAsFilePath;
         gtString strFileName;
         std::wstring strFile;
-        std::wstring strTid;
         std::wstring strExt;
-        strFileContent.empty();
-
-        int cumulativeAPICount = 0;
-        std::string cumulativeStrFileContent;
 
         for (gtList<osFilePath>::iterator it = files.begin(); it != files.end(); ++it)
         {
             strFileAsFilePath = (*it);
             strFileAsFilePath.getFileNameAndExtension(strFileName);
             strFile = strFileName.asCharArray();
-            strFullFilePath = strFileAsFilePath.asString().asCharArray();
+
+            TmpFileToMerge fileToMerge;
+            fileToMerge.m_strFullFilePath = strFileAsFilePath.asString().asCharArray();
+            fileToMerge.m_numLines = 0;
+            fileToMerge.m_size = 0;
+            fileToMerge.m_bFiltered = false;
+            fileToMerge.m_bReadable = false;
+            fileToMerge.m_bCached = false;
 
             // extract thread id from file name
             size_t found;
@@ -1247,7 +1592,7 @@ bool FileUtils::MergeTmpTraceFiles(SP_outStream& sout,
 
                 if (found != string::npos)
                 {
-                    strTid = strPidTid.substr(found + 1);
+                    fileToMerge.m_strTid = strPidTid.substr(found + 1);
                 }
                 else
                 {
@@ -1265,57 +1610,94 @@ bool FileUtils::MergeTmpTraceFiles(SP_outStream& sout,
 
             if (strExt == szFileExt.asCharArray())
             {
-                if (!bWriteHeader)
-                {
-                    if (szHeader != NULL)
-                    {
-                        sout << szHeader << endl;
-                    }
+                filesToMerge.push_back(fileToMerge);
+            }
+        }
 
-                    bWriteHeader = true;
-                }
+        if (filesToMerge.empty())
+        {
+            return true;
+        }
 
-                ret = ReadFile(strFullFilePath, strFileContent);
+        // the number of entries of a file is written before its contents, count the lines of all files first.
+        // The small files are kept in memory, the others are then copied one chunk at a time
+        CountTmpFileLines(filesToMerge);
 
-                if (!ret)
-                {
-                    Log(logWARNING, "Error reading file: %s\n", strFullFilePath.c_str());
-                    continue;
-                }
-                else
-                {
-                    // remove tmp file
-                    gtString fileToRemoveName(strFullFilePath.c_str());
-                    osFilePath filePathToRemove(fileToRemoveName);
-                    osFile fileToRemove(filePathToRemove);
-                    fileToRemove.deleteFile();
-                }
+        int cumulativeAPICount = 0;
 
-                int apiCount = StringUtils::GetNumLines(strFileContent);
+        for (std::vector<TmpFileToMerge>::const_iterator it = filesToMerge.begin(); it != filesToMerge.end(); ++it)
+        {
+            if (!it->m_bReadable)
+            {
+                // the entry counts would not match the merged entries
+                Log(logERROR, "Error reading file: %s\n", it->m_strFullFilePath.c_str());
+                return false;
+            }
 
-                if (MergeSummaryType_CumulativeNumEntries == mergeSummaryType)
-                {
-                    cumulativeAPICount += apiCount;
-                    cumulativeStrFileContent += strFileContent;
-                }
-                else if (MergeSummaryType_TidAndNumEntries == mergeSummaryType)
-                {
-                    std::string strConvertedTID;
-                    StringUtils::WideStringToUtf8String(strTid, strConvertedTID);
-                    sout << strConvertedTID.c_str() << endl << apiCount << endl;
-                }
+            cumulativeAPICount += it->m_numLines;
+        }
 
-                if (MergeSummaryType_CumulativeNumEntries != mergeSummaryType)
-                {
-                    sout << strFileContent.c_str();
-                }
-            }
+        if (szHeader != NULL)
+        {
+            sout << szHeader << endl;
         }
 
         if (MergeSummaryType_CumulativeNumEntries == mergeSummaryType && 0 < cumulativeAPICount)
         {
             sout << cumulativeAPICount << endl;
-            sout << cumulativeStrFileContent.c_str();
+        }
+
+        std::vector<char> buffer(TMP_FILE_MERGE_CHUNK_SIZE);
+        auto writeFunc = [&sout](const char* pData, size_t size) { WriteMergedData(sout, pData, size); };
+
+        for (std::vector<TmpFileToMerge>::iterator it = filesToMerge.begin(); it != filesToMerge.end(); ++it)
+        {
+            if (MergeSummaryType_TidAndNumEntries == mergeSummaryType)
+            {
+                std::string strConvertedTID;
+                StringUtils::WideStringToUtf8String(it->m_strTid, strConvertedTID);
+                sout << strConvertedTID.c_str() << endl << it->m_numLines << endl;
+            }
+
+            bool bCopied = true;
+
+            if (it->m_bCached)
+            {
+                WriteMergedData(sout, it->m_strData.c_str(), it->m_strData.size());
+                std::string().swap(it->m_strData);
+            }
+            else if (!it->m_bFiltered)
+            {
+                // the file only has non-blank lines, copy it as is
+                size_t size = 0;
+                bCopied = CopyTmpFile(it->m_strFullFilePath, buffer, writeFunc, size) && size == it->m_size;
+            }
+            else
+            {
+                int numLines = 0;
+                bool bFiltered = false;
+                size_t size = 0;
+                auto writeAndCountFunc = [&sout, &size](const char* pData, size_t dataSize)
+                {
+                    WriteMergedData(sout, pData, dataSize);
+                    size += dataSize;
+                };
+
+                bCopied = ReadTmpFileLines(it->m_strFullFilePath, buffer, writeAndCountFunc, numLines, bFiltered) && numLines == it->m_numLines && size == it->m_size;
+            }
+
+            if (!bCopied)
+            {
+                // the file changed since its lines were counted, the entry counts written don't match its contents
+                Log(logERROR, "Error reading file: %s\n", it->m_strFullFilePath.c_str());
+                return false;
+            }
+
+            // remove tmp file
+            gtString fileToRemoveName(it->m_strFullFilePath.c_str());
+            osFilePath filePathToRemove(fileToRemoveName);
+            osFile fileToRemove(filePathToRemove);
+            fileToRemove.deleteFile();
         }
 
         return true;
@@ -0,0 +1,193 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class keeps the tmp fragment files written by the timer thread
+///        open between flushes.
+//==============================================================================
+
+#include <new>
+
+#include "FragmentWriterCache.h"
+#include "Defs.h"
+#include "Logger.h"
+
+using namespace std;
+using namespace GPULogger;
+
+FragmentWriterCache::FragmentWriterCache() :
+    m_bufferSize(0),
+    m_bCompress(false),
+    m_ullNumRequests(0),
+    m_ullNumOpens(0),
+    m_ullBytesWritten(0),
+    m_ullUncompressedBytes(0)
+{
+}
+
+FragmentWriterCache::~FragmentWriterCache()
+{
+    CloseFiles();
+}
+
+std::ostream* FragmentWriterCache::GetWriter(const std::string& strFileName)
+{
+    m_ullNumRequests++;
+
+    FragmentWriterMap::iterator it = m_writers.find(strFileName);
+
+    if (it != m_writers.end())
+    {
+        it->second->m_ullLastUsed = m_ullNumRequests;
+        return &it->second->m_fout;
+    }
+
+    if (m_writers.size() >= FRAGMENT_WRITER_MAX_OPEN_FILES)
+    {
+        CloseLeastRecentlyUsed();
+    }
+
+    FragmentWriter* pWriter = new(nothrow) FragmentWriter();
+
+    if (nullptr == pWriter)
+    {
+        return nullptr;
+    }
+
+    if (m_bufferSize > 0)
+    {
+        // the buffer has to be set before the file is opened
+        pWriter->m_buffer.resize(m_bufferSize);
+        pWriter->m_fout.rdbuf()->pubsetbuf(&pWriter->m_buffer[0], static_cast<streamsize>(m_bufferSize));
+    }
+
+    pWriter->m_pCompressedBuffer = nullptr;
+
+    ios_base::openmode mode = fstream::out | fstream::app;
+
+    // the compressed blocks are binary data even if the fragment is text
+    if (m_bCompress)
+    {
+        mode |= fstream::binary;
+    }
+
+    pWriter->m_fout.open(strFileName.c_str(), mode);
+
+    if (pWriter->m_fout.fail())
+    {
+        Log(logWARNING, "Failed to open fragment file: %s\n", strFileName.c_str());
+        SAFE_DELETE(pWriter);
+        return nullptr;
+    }
+
+    // the file is opened for append, move to the end so that the data written by this process can be counted
+    pWriter->m_fout.seekp(0, ios_base::end);
+    streamoff size = pWriter->m_fout.tellp();
+    pWriter->m_ullSize = size > 0 ? static_cast<unsigned long long>(size) : 0;
+
+    if (m_bCompress)
+    {
+        pWriter->m_pCompressedBuffer = new(nothrow) CompressedOutputBuffer();
+
+        if (nullptr != pWriter->m_pCompressedBuffer)
+        {
+            pWriter->m_pCompressedBuffer->Attach(pWriter->m_fout);
+        }
+        else
+        {
+            Log(logWARNING, "Failed to allocate the compression buffer of fragment file: %s\n", strFileName.c_str());
+        }
+    }
+
+    m_ullNumOpens++;
+    pWriter->m_ullLastUsed = m_ullNumRequests;
+    m_writers[strFileName] = pWriter;
+    return &pWriter->m_fout;
+}
+
+void FragmentWriterCache::EndFlush(bool bKeepOpen)
+{
+    if (!bKeepOpen || 0 == m_bufferSize)
+    {
+        CloseFiles();
+        return;
+    }
+
+    // Keep the files open but don't leave data in the buffers, the application can exit at any time
+    for (FragmentWriterMap::iterator it = m_writers.begin(); it != m_writers.end(); ++it)
+    {
+        FlushWriter(it->second);
+    }
+}
+
+void FragmentWriterCache::CloseAll()
+{
+    CloseFiles();
+
+    if (m_ullNumRequests > 0)
+    {
+        Log(logMESSAGE, "FragmentWriterCache: %llu files opened for %llu fragment writes, %llu bytes written\n", m_ullNumOpens, m_ullNumRequests, m_ullBytesWritten);
+    }
+
+    if (m_ullUncompressedBytes > 0)
+    {
+        Log(logMESSAGE, "FragmentWriterCache: %llu bytes compressed to %llu bytes\n", m_ullUncompressedBytes, m_ullBytesWritten);
+    }
+}
+
+void FragmentWriterCache::CloseFiles()
+{
+    for (FragmentWriterMap::iterator it = m_writers.begin(); it != m_writers.end(); ++it)
+    {
+        CloseWriter(it->second);
+    }
+
+    m_writers.clear();
+}
+
+void FragmentWriterCache::FlushWriter(FragmentWriter* pWriter)
+{
+    pWriter->m_fout.flush();
+
+    // the stream position follows the end of the file once the data is written, query the file buffer directly as the stream can write to the compression buffer
+    streamoff size = pWriter->m_fout.rdbuf()->pubseekoff(0, ios_base::end, ios_base::out);
+
+    if (size > 0 && static_cast<unsigned long long>(size) > pWriter->m_ullSize)
+    {
+        m_ullBytesWritten += static_cast<unsigned long long>(size) - pWriter->m_ullSize;
+        pWriter->m_ullSize = static_cast<unsigned long long>(size);
+    }
+}
+
+void FragmentWriterCache::CloseLeastRecentlyUsed()
+{
+    FragmentWriterMap::iterator lruIt = m_writers.begin();
+
+    for (FragmentWriterMap::iterator it = m_writers.begin(); it != m_writers.end(); ++it)
+    {
+        if (it->second->m_ullLastUsed < lruIt->second->m_ullLastUsed)
+        {
+            lruIt = it;
+        }
+    }
+
+    if (lruIt != m_writers.end())
+    {
+        CloseWriter(lruIt->second);
+        m_writers.erase(lruIt);
+    }
+}
+
+void FragmentWriterCache::CloseWriter(FragmentWriter* pWriter)
+{
+    FlushWriter(pWriter);
+    pWriter->m_fout.close();
+
+    if (nullptr != pWriter->m_pCompressedBuffer)
+    {
+        m_ullUncompressedBytes += pWriter->m_pCompressedBuffer->GetUncompressedBytes();
+        SAFE_DELETE(pWriter->m_pCompressedBuffer);
+    }
+
+    SAFE_DELETE(pWriter);
+}
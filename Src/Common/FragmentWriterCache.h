@@ -0,0 +1,118 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class keeps the tmp fragment files written by the timer thread
+///        open between flushes.
+//==============================================================================
+
+#ifndef _FRAGMENT_WRITER_CACHE_H_
+#define _FRAGMENT_WRITER_CACHE_H_
+
+/// \defgroup FragmentWriterCache FragmentWriterCache
+/// This module caches the output streams of tmp fragment files
+///
+/// \ingroup Common
+// @{
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+
+#include "CompressedStream.h"
+
+/// Maximum number of fragment files kept open, the least recently used one is closed when the limit is reached
+#define FRAGMENT_WRITER_MAX_OPEN_FILES 256
+
+//------------------------------------------------------------------------------------
+/// Maps a fragment file name to an output stream opened in append mode.
+/// Each stream uses its own buffer of the configured size, so a flush normally issues a
+/// single write per file instead of an open/write/close sequence.
+/// Not thread safe, callers serialize access (TraceInfoManager::m_mtxFlush).
+//------------------------------------------------------------------------------------
+class FragmentWriterCache
+{
+public:
+    /// Constructor
+    FragmentWriterCache();
+
+    /// Destructor, closes all files
+    ~FragmentWriterCache();
+
+    /// Set the size of the buffer used by the files opened after this call
+    /// \param bufferSize buffer size in bytes, 0 to use the default stream buffer and close the files after every flush
+    void SetBufferSize(size_t bufferSize) { m_bufferSize = bufferSize; }
+
+    /// Enable block compression of the files opened after this call
+    /// \param bCompress true to write the files as compressed blocks (CompressedOutputBuffer)
+    void SetCompression(bool bCompress) { m_bCompress = bCompress; }
+
+    /// Get the output stream of a fragment file, opening the file for append if needed
+    /// \param strFileName the fragment file name
+    /// \return the output stream or nullptr if the file could not be opened
+    std::ostream* GetWriter(const std::string& strFileName);
+
+    /// Called at the end of a flush, writes the buffered data to the files
+    /// \param bKeepOpen false to close the files (the timer is stopped or the buffer size is 0)
+    void EndFlush(bool bKeepOpen);
+
+    /// Close all files and log the number of files opened
+    void CloseAll();
+
+    /// Get the number of bytes written to the files
+    /// \return the number of bytes written to the files that were flushed or closed so far
+    unsigned long long GetBytesWritten() const { return m_ullBytesWritten; }
+
+    /// Get the amount of data written to the files before compression
+    /// \return the number of uncompressed bytes written to the compressed files that were closed so far
+    unsigned long long GetUncompressedBytesWritten() const { return m_ullUncompressedBytes; }
+
+private:
+    /// An open fragment file
+    struct FragmentWriter
+    {
+        std::ofstream           m_fout;               ///< output stream
+        std::vector<char>       m_buffer;             ///< stream buffer, empty to use the default one
+        CompressedOutputBuffer* m_pCompressedBuffer;  ///< buffer compressing the data written to m_fout, nullptr if the file is not compressed
+        unsigned long long      m_ullLastUsed;        ///< value of m_ullNumRequests when the file was last used
+        unsigned long long      m_ullSize;            ///< file size when the data written so far was last counted
+    };
+
+    typedef std::unordered_map<std::string, FragmentWriter*> FragmentWriterMap;
+
+    /// Close all files
+    void CloseFiles();
+
+    /// Write the buffered data of a file and add the file growth to m_ullBytesWritten
+    /// \param pWriter the file
+    void FlushWriter(FragmentWriter* pWriter);
+
+    /// Flush and close a file and release the writer
+    /// \param pWriter the file
+    void CloseWriter(FragmentWriter* pWriter);
+
+    /// Close the least recently used file
+    void CloseLeastRecentlyUsed();
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    FragmentWriterCache(const FragmentWriterCache& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    FragmentWriterCache& operator=(const FragmentWriterCache& obj) = delete;
+
+    FragmentWriterMap  m_writers;              ///< open files
+    size_t             m_bufferSize;           ///< buffer size of newly opened files
+    bool               m_bCompress;            ///< flag indicating whether newly opened files are compressed
+    unsigned long long m_ullNumRequests;       ///< number of GetWriter calls
+    unsigned long long m_ullNumOpens;          ///< number of files opened
+    unsigned long long m_ullBytesWritten;      ///< number of bytes written to the files
+    unsigned long long m_ullUncompressedBytes; ///< number of bytes written to the compressed files before compression
+};
+
+// @}
+
+#endif //_FRAGMENT_WRITER_CACHE_H_
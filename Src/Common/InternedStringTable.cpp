@@ -0,0 +1,111 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class interns strings referenced by many trace entries (e.g.
+///        kernel names), an entry only stores the ID of its string.
+//==============================================================================
+
+#include <new>
+
+#include "InternedStringTable.h"
+#include "Logger.h"
+
+using namespace std;
+using namespace GPULogger;
+
+/// Empty string returned for the invalid IDs
+static const std::string s_emptyString;
+
+InternedStringTable::InternedStringTable() : m_uiNumStrings(1)
+{
+    for (unsigned int i = 0; i < INTERNED_STRING_MAX_CHUNKS; i++)
+    {
+        m_chunks[i].store(nullptr, memory_order_relaxed);
+    }
+}
+
+InternedStringTable::~InternedStringTable()
+{
+    for (unsigned int i = 0; i < INTERNED_STRING_MAX_CHUNKS; i++)
+    {
+        delete[] m_chunks[i].load(memory_order_relaxed);
+    }
+}
+
+unsigned int InternedStringTable::Intern(const std::string& str)
+{
+    if (str.empty())
+    {
+        return INTERNED_STRING_EMPTY_ID;
+    }
+
+    unsigned int uiID = INTERNED_STRING_EMPTY_ID;
+
+    if (m_ids.Find(str, uiID))
+    {
+        return uiID;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    // another thread may have added the string in the meantime
+    if (m_ids.Find(str, uiID))
+    {
+        return uiID;
+    }
+
+    uiID = m_uiNumStrings;
+    unsigned int uiChunk = uiID / INTERNED_STRING_CHUNK_SIZE;
+
+    if (uiChunk >= INTERNED_STRING_MAX_CHUNKS)
+    {
+        Log(logERROR, "The interned string table is full\n");
+        return INTERNED_STRING_EMPTY_ID;
+    }
+
+    std::string* pChunk = m_chunks[uiChunk].load(memory_order_relaxed);
+
+    if (nullptr == pChunk)
+    {
+        pChunk = new(nothrow) std::string[INTERNED_STRING_CHUNK_SIZE];
+
+        if (nullptr == pChunk)
+        {
+            Log(logERROR, "Failed to allocate an interned string chunk\n");
+            return INTERNED_STRING_EMPTY_ID;
+        }
+
+        m_chunks[uiChunk].store(pChunk, memory_order_release);
+    }
+
+    pChunk[uiID % INTERNED_STRING_CHUNK_SIZE] = str;
+
+    // the ID is published after the string is stored, a thread that gets the ID can read the string
+    if (!m_ids.Set(str, uiID))
+    {
+        return INTERNED_STRING_EMPTY_ID;
+    }
+
+    m_uiNumStrings++;
+    return uiID;
+}
+
+const std::string& InternedStringTable::GetString(unsigned int uiID) const
+{
+    unsigned int uiChunk = uiID / INTERNED_STRING_CHUNK_SIZE;
+
+    if (INTERNED_STRING_EMPTY_ID == uiID || uiChunk >= INTERNED_STRING_MAX_CHUNKS)
+    {
+        return s_emptyString;
+    }
+
+    const std::string* pChunk = m_chunks[uiChunk].load(memory_order_acquire);
+
+    if (nullptr == pChunk)
+    {
+        return s_emptyString;
+    }
+
+    return pChunk[uiID % INTERNED_STRING_CHUNK_SIZE];
+}
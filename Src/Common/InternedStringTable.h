@@ -0,0 +1,76 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class interns strings referenced by many trace entries (e.g.
+///        kernel names), an entry only stores the ID of its string.
+//==============================================================================
+
+#ifndef _INTERNED_STRING_TABLE_H_
+#define _INTERNED_STRING_TABLE_H_
+
+/// \defgroup InternedStringTable InternedStringTable
+/// This module interns the strings shared by the trace entries
+///
+/// \ingroup Common
+// @{
+
+#include <string>
+#include <atomic>
+#include <mutex>
+
+#include "ConcurrentHashMap.h"
+
+/// ID of the empty string, returned when a string could not be interned
+#define INTERNED_STRING_EMPTY_ID 0
+
+/// Number of strings of a chunk of the table
+#define INTERNED_STRING_CHUNK_SIZE 1024
+
+/// Maximum number of chunks of the table
+#define INTERNED_STRING_MAX_CHUNKS 1024
+
+//------------------------------------------------------------------------------------
+/// Table of unique strings. Each string is stored once and gets a 32 bit ID; both
+/// the ID of a known string and the string of an ID are found without taking a lock.
+/// Strings are stored in chunks that are never moved nor freed until the table is
+/// destroyed. ID 0 is the empty string.
+//------------------------------------------------------------------------------------
+class InternedStringTable
+{
+public:
+    /// Constructor
+    InternedStringTable();
+
+    /// Destructor, no other thread may use the table
+    ~InternedStringTable();
+
+    /// Get the ID of a string, the string is added if it is not in the table yet
+    /// \param str the string
+    /// \return the ID of the string, INTERNED_STRING_EMPTY_ID if the table is full
+    unsigned int Intern(const std::string& str);
+
+    /// Get the string of an ID, never blocks
+    /// \param uiID an ID returned by Intern
+    /// \return the string, the empty string if the ID is not valid
+    const std::string& GetString(unsigned int uiID) const;
+
+private:
+    /// Disable copy constructor
+    /// \param obj the input object
+    InternedStringTable(const InternedStringTable& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    InternedStringTable& operator=(const InternedStringTable& obj) = delete;
+
+    ConcurrentHashMap<std::string, unsigned int> m_ids;                                 ///< ID of each string
+    std::atomic<std::string*>                    m_chunks[INTERNED_STRING_MAX_CHUNKS]; ///< strings indexed by ID, INTERNED_STRING_CHUNK_SIZE per chunk
+    unsigned int                                 m_uiNumStrings;                       ///< number of strings, including the empty string
+    std::mutex                                   m_mtx;                                ///< mutex serializing the insertions
+};
+
+// @}
+
+#endif //_INTERNED_STRING_TABLE_H_
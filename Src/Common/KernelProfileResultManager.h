@@ -113,6 +113,14 @@ public:
         m_pWriter->SetListSeparator(ch);
     }
 
+    /// Set compression
+    /// \param bCompress true to write the output file as compressed blocks
+    void SetCompression(bool bCompress)
+    {
+        SpAssertRet(m_pWriter != NULL);
+        m_pWriter->SetCompression(bCompress);
+    }
+
 protected:
     /// Write csv file header
     void WriteHeader();
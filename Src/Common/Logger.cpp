@@ -7,12 +7,18 @@
 
 #include <cstdio> // for snprintf
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <vector>
 #ifdef _WIN32
     #include <windows.h>
 #else
     #include <string.h> // strcpy
     #include <stdarg.h>
 #endif
+#include <AMDTOSWrappers/Include/osProcess.h>
+
 #include "Logger.h"
 #include "OSUtils.h"
 #include "StringUtils.h"
@@ -20,6 +26,8 @@
 
 #define SP_LOG_MAX_LENGTH 1024
 #define SP_LOG_INDENT_SIZE 4
+#define SP_LOG_RING_SLOTS 64           // number of messages of a thread that can wait for the log writer thread
+#define SP_LOG_WRITER_INTERVAL_MS 50   // maximum time a message waits for the log writer thread
 
 static bool OptionNoLogfile = false;
 static char LogfilePath[SP_MAX_PATH];
@@ -30,12 +38,17 @@ static bool s_ConsoleAttached = false;
 #endif
 // *INDENT-ON*
 
-static std::mutex s_mutex;
+static std::mutex s_mutex;          // protects s_syncString, LogfilePath and the log file when messages are written synchronously, locked after LogWriter::m_mtx
 
 
 namespace GPULogger
 {
 
+#ifndef DISABLE_LOG
+static void _logFlush();
+static void _logSetFilename(const char* strFileName);
+#endif
+
 
 // Returns reference to file that is currently being used.
 //
@@ -62,15 +75,16 @@ void LogFileInitialize(const char* strFileName)
     FILE* f = NULL;
     const char* logFilename;
 
+    // messages logged so far go to the previous log file
     if (strFileName == NULL)
     {
-        SP_strcpy(LogfilePath, SP_MAX_PATH, "c:\\splog.txt");
+        _logSetFilename("c:\\splog.txt");
         logFilename = GetLogFilename();
     }
     else
     {
         logFilename = strFileName;
-        SP_strcpy(LogfilePath, SP_MAX_PATH, strFileName);
+        _logSetFilename(strFileName);
     }
 
     // It is valid for there to be no Log File. However since this
@@ -121,7 +135,7 @@ void LogFileInitialize(const char* strFileName)
 // for all builds - add log module name
 static const char* s_LogModule;
 
-static int logIndent = 0;
+static std::atomic<int> logIndent(0);
 
 // *INDENT-OFF*
 #ifdef _DEBUG
@@ -131,6 +145,8 @@ static int OptionLogLevel = logERROR;
 #endif
 // *INDENT-ON*
 
+static char s_syncString[SP_LOG_MAX_LENGTH]; // message buffer used when the message can't be queued for the log writer thread
+
 //
 // Write log messages into the logfile.
 //
@@ -154,6 +170,382 @@ static void _logWrite(const char* pMessage)
         }
     }
 }
+//------------------------------------------------------------------------------------
+/// Log messages of a thread waiting for the log writer thread. The thread formats
+/// each message directly in a free slot and publishes it (single producer), the log
+/// writer thread writes the published slots to the log file (single consumer).
+//------------------------------------------------------------------------------------
+class LogRing
+{
+public:
+    /// Constructor
+    LogRing() : m_head(0), m_tail(0), m_bThreadExited(false)
+    {
+    }
+
+    /// Get the buffer of the next message, called by the owning thread only
+    /// \return the message buffer (SP_LOG_MAX_LENGTH chars), NULL if all the slots are waiting for the log writer thread
+    char* BeginWrite()
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head - m_tail.load(std::memory_order_acquire) >= SP_LOG_RING_SLOTS)
+        {
+            return NULL;
+        }
+
+        return m_slots[head % SP_LOG_RING_SLOTS].m_string;
+    }
+
+    /// Publish the message of the buffer returned by BeginWrite, called by the owning thread only
+    /// \param pMessage the part of the message buffer written to the log file
+    /// \return the number of messages waiting for the log writer thread
+    size_t EndWrite(const char* pMessage)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        LogSlot& slot = m_slots[head % SP_LOG_RING_SLOTS];
+        slot.m_offset = static_cast<size_t>(pMessage - slot.m_string);
+        m_head.store(head + 1, std::memory_order_release);
+
+        return head + 1 - m_tail.load(std::memory_order_relaxed);
+    }
+
+    /// Write the published messages, called by the log writer thread only
+    /// \param pFile the log file, the messages are discarded if NULL
+    void Drain(FILE* pFile)
+    {
+        size_t head = m_head.load(std::memory_order_acquire);
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        for (; tail != head; tail++)
+        {
+            const LogSlot& slot = m_slots[tail % SP_LOG_RING_SLOTS];
+
+            if (pFile != NULL)
+            {
+                fputs(slot.m_string + slot.m_offset, pFile);
+            }
+        }
+
+        m_tail.store(tail, std::memory_order_release);
+    }
+
+    /// Check whether messages are waiting for the log writer thread
+    /// \return true if there are published messages
+    bool HasMessages() const
+    {
+        return m_head.load(std::memory_order_acquire) != m_tail.load(std::memory_order_relaxed);
+    }
+
+    /// Flag the ring as unused, its thread has exited
+    void SetThreadExited()
+    {
+        m_bThreadExited.store(true, std::memory_order_release);
+    }
+
+    /// Check whether the thread of the ring has exited
+    /// \return true if the ring can be deleted once drained
+    bool IsThreadExited() const
+    {
+        return m_bThreadExited.load(std::memory_order_acquire);
+    }
+
+private:
+    /// Message buffer
+    struct LogSlot
+    {
+        char   m_string[SP_LOG_MAX_LENGTH]; ///< formatted message
+        size_t m_offset;                    ///< offset of the part written to the log file
+    };
+
+    LogSlot             m_slots[SP_LOG_RING_SLOTS]; ///< message buffers
+    std::atomic<size_t> m_head;                     ///< number of messages published by the thread
+    std::atomic<size_t> m_tail;                     ///< number of messages written by the log writer thread
+    std::atomic<bool>   m_bThreadExited;            ///< flag indicating that the thread has exited
+};
+
+/// Flag indicating that s_logWriter can be used: it is set once the writer is constructed and
+/// cleared when it is destroyed, messages logged outside of that window are written synchronously
+static std::atomic<bool> s_bAsyncLog(false);
+
+/// Number of messages dropped because the ring of their thread was full
+static std::atomic<unsigned long long> s_numDroppedMessages(0);
+
+//------------------------------------------------------------------------------------
+/// Background thread writing the messages of the log rings to the log file. The file
+/// is opened once per batch of messages rather than once per message, and logging
+/// threads never wait for the file: a message is dropped if its thread's ring is full.
+//------------------------------------------------------------------------------------
+class LogWriter
+{
+public:
+    /// Constructor
+    LogWriter() : m_pid(0), m_bStop(false)
+    {
+        s_bAsyncLog.store(true);
+    }
+
+    /// Destructor, writes the pending messages
+    ~LogWriter()
+    {
+        s_bAsyncLog.store(false);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_bStop = true;
+        }
+
+        m_cv.notify_one();
+
+        if (m_thread.joinable())
+        {
+            if (m_pid == osGetCurrentProcessId())
+            {
+                m_thread.join();
+            }
+            else
+            {
+                // the thread was started by the parent process
+                m_thread.detach();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mtx);
+        WriteMessages();
+
+        // the rings of the running threads are still referred to by their owners
+        for (std::vector<LogRing*>::iterator it = m_rings.begin(); it != m_rings.end(); ++it)
+        {
+            if ((*it)->IsThreadExited())
+            {
+                delete *it;
+            }
+        }
+
+        m_rings.clear();
+    }
+
+    /// Create the log ring of the calling thread, the log writer thread is started by the first call
+    /// \return the ring or NULL if the messages must be written synchronously
+    LogRing* CreateRing()
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+
+        if (m_bStop)
+        {
+            return NULL;
+        }
+
+        if (!m_thread.joinable())
+        {
+            m_pid = osGetCurrentProcessId();
+            m_thread = std::thread(&LogWriter::Run, this);
+        }
+
+        LogRing* pRing = new(std::nothrow) LogRing();
+
+        if (pRing != NULL)
+        {
+            m_rings.push_back(pRing);
+        }
+
+        return pRing;
+    }
+
+    /// Check whether the log writer thread runs in the calling process, it doesn't in a forked child
+    /// \return true if the rings are drained
+    bool IsRunningInCurrentProcess() const
+    {
+        return m_pid == osGetCurrentProcessId();
+    }
+
+    /// Wake the log writer thread up before the end of its interval
+    void Wake()
+    {
+        m_cv.notify_one();
+    }
+
+    /// Write the pending messages now
+    void Flush()
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        WriteMessages();
+    }
+
+    /// Write the pending messages to the current log file and switch to another log file,
+    /// the log writer thread reads the path of the log file with m_mtx locked
+    /// \param strFileName the path of the new log file
+    void SetLogFilename(const char* strFileName)
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        WriteMessages();
+
+        std::lock_guard<std::mutex> s(s_mutex);
+        SP_strcpy(LogfilePath, SP_MAX_PATH, strFileName);
+    }
+
+private:
+    /// Thread function, writes the messages every SP_LOG_WRITER_INTERVAL_MS or when woken up
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(m_mtx);
+
+        while (!m_bStop)
+        {
+            m_cv.wait_for(lock, std::chrono::milliseconds(SP_LOG_WRITER_INTERVAL_MS));
+            WriteMessages();
+        }
+    }
+
+    /// Write the messages of all rings and delete the rings of the exited threads, m_mtx must be locked
+    void WriteMessages()
+    {
+        unsigned long long numDropped = s_numDroppedMessages.exchange(0);
+        bool bHasMessages = numDropped > 0;
+
+        for (std::vector<LogRing*>::const_iterator it = m_rings.begin(); it != m_rings.end() && !bHasMessages; ++it)
+        {
+            bHasMessages = (*it)->HasMessages();
+        }
+
+        if (!bHasMessages)
+        {
+            return;
+        }
+
+        FILE* f = NULL;
+        const char* logFilename = GetLogFilename();
+
+        if (logFilename != NULL)
+        {
+#ifdef _WIN32
+            fopen_s(&f, logFilename, "a+");    // append
+#else
+            f = fopen(logFilename, "a+");
+#endif
+        }
+
+        for (std::vector<LogRing*>::iterator it = m_rings.begin(); it != m_rings.end();)
+        {
+            // a thread doesn't log anything once it has flagged its ring
+            bool bThreadExited = (*it)->IsThreadExited();
+            (*it)->Drain(f);
+
+            if (bThreadExited)
+            {
+                delete *it;
+                it = m_rings.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (f != NULL)
+        {
+            if (numDropped > 0)
+            {
+                fprintf(f, "Warning: %llu log messages were dropped, the log writer thread could not keep up\n", numDropped);
+            }
+
+            fclose(f);
+        }
+    }
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    LogWriter(const LogWriter& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    LogWriter& operator=(const LogWriter& obj) = delete;
+
+    std::vector<LogRing*>   m_rings;  ///< log rings of the threads that logged a message
+    std::thread             m_thread; ///< log writer thread
+    osProcessId             m_pid;    ///< process that started the log writer thread
+    bool                    m_bStop;  ///< flag indicating that the log writer thread must exit
+    std::mutex              m_mtx;    ///< mutex protecting the rings, the flags and the log file
+    std::condition_variable m_cv;     ///< condition variable waking the log writer thread up
+};
+
+static LogWriter s_logWriter;
+
+/// Owner of the log ring of a thread, flags the ring when the thread exits
+struct LogRingOwner
+{
+    /// Constructor
+    LogRingOwner() : m_pRing(NULL), m_bCreated(false)
+    {
+    }
+
+    /// Destructor
+    ~LogRingOwner()
+    {
+        if (m_pRing != NULL)
+        {
+            m_pRing->SetThreadExited();
+            m_pRing = NULL;
+        }
+    }
+
+    LogRing* m_pRing;    ///< log ring of the thread, NULL if none
+    bool     m_bCreated; ///< flag indicating that the creation of the ring has been attempted
+};
+
+static thread_local LogRingOwner t_logRingOwner;
+
+/// Get the log ring of the calling thread
+/// \return the ring or NULL if the message must be written synchronously
+static LogRing* GetThreadLogRing()
+{
+    if (!s_bAsyncLog.load(std::memory_order_acquire))
+    {
+        return NULL;
+    }
+
+    if (!t_logRingOwner.m_bCreated)
+    {
+        t_logRingOwner.m_bCreated = true;
+        t_logRingOwner.m_pRing = s_logWriter.CreateRing();
+    }
+
+    if (t_logRingOwner.m_pRing == NULL || !s_logWriter.IsRunningInCurrentProcess())
+    {
+        return NULL;
+    }
+
+    return t_logRingOwner.m_pRing;
+}
+
+//
+// Write the messages waiting for the log writer thread.
+//
+static void _logFlush()
+{
+    if (s_bAsyncLog.load(std::memory_order_acquire) && s_logWriter.IsRunningInCurrentProcess())
+    {
+        s_logWriter.Flush();
+    }
+}
+
+//
+// Switch to another log file once the pending messages are written to the current one.
+//
+static void _logSetFilename(const char* strFileName)
+{
+    if (s_bAsyncLog.load(std::memory_order_acquire) && s_logWriter.IsRunningInCurrentProcess())
+    {
+        s_logWriter.SetLogFilename(strFileName);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> s(s_mutex);
+        SP_strcpy(LogfilePath, SP_MAX_PATH, strFileName);
+    }
+}
+
 #ifdef WIN32
 //
 // Write log messages into the logfile.
@@ -187,29 +579,53 @@ void Log(enum LogType type, const char* fmt, ...)
     return;
 #else
 
-    std::lock_guard<std::mutex> s(s_mutex);
-
-    bool s_LogConsole = false;
-
-    const char* s_LogFunction = __FUNCTION__;
-
-    va_list arg_ptr;
-
-    va_start(arg_ptr, fmt);
-
     // check to see if logging of the level is enabled, or if s_LogConsole is specified
-    // if not, don't process it.
+    // if not, don't process it. This is done before anything else so that disabled
+    // messages cost a single comparison.
     if (type > OptionLogLevel)
     {
-        va_end(arg_ptr);
         return;
     }
 
     // Define buffer to store maximum current log message.
     // Different destinations will receive a subset of this string.
     // On Win32 the entire string is passed to OutputDebugString()
+    // The message is formatted in a slot of the thread's log ring and written to the logfile
+    // by the log writer thread. Without a ring (before static initialization, after static
+    // destruction or in a forked child), it is formatted in s_syncString and written right away.
+
+    LogRing* pRing = GetThreadLogRing();
+    std::unique_lock<std::mutex> s(s_mutex, std::defer_lock);
+    char* fullString;
+
+    if (pRing != NULL)
+    {
+        fullString = pRing->BeginWrite();
+
+        if (fullString == NULL)
+        {
+            // the log writer thread is behind, don't wait for it
+            s_numDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    else
+    {
+        s.lock();
+        fullString = s_syncString;
+    }
+
+    fullString[0] = '\0';
+
+    bool s_LogConsole = false;
 
-    char fullString[SP_LOG_MAX_LENGTH] = "\0";
+    const char* s_LogFunction = __FUNCTION__;
+
+    va_list arg_ptr;
+
+    va_start(arg_ptr, fmt);
+
+    char* pFileString = NULL; // String written to the logfile, if any
     int nLen = 0;
     int nSize;
     bool truncated = false;
@@ -425,7 +841,7 @@ void Log(enum LogType type, const char* fmt, ...)
             printf("%s", pRaw);
         }
 
-        _logWrite(pRaw);
+        pFileString = pRaw;
     }
     else
     {
@@ -434,7 +850,7 @@ void Log(enum LogType type, const char* fmt, ...)
             // Console messages are always printed in console and in log file
             // regardless of logLEVEL
             printf("%s", pConsole);
-            _logWrite(pLogString);
+            pFileString = pLogString;
 #ifdef WIN32
             SP_TODO("revisit use of OutputDebugStringA for Unicode support")
             OutputDebugStringA(fullString);
@@ -451,7 +867,7 @@ void Log(enum LogType type, const char* fmt, ...)
                     printf("%s", pConsole);
                 }
 
-                _logWrite(pLogString);
+                pFileString = pLogString;
 #ifdef WIN32
                 SP_TODO("revisit use of OutputDebugStringA for Unicode support")
                 OutputDebugStringA(fullString);
@@ -462,6 +878,19 @@ void Log(enum LogType type, const char* fmt, ...)
 
     va_end(arg_ptr);
 
+    if (pFileString != NULL)
+    {
+        if (pRing == NULL)
+        {
+            _logWrite(pFileString);
+        }
+        else if (pRing->EndWrite(pFileString) >= SP_LOG_RING_SLOTS / 2)
+        {
+            // wake the log writer thread up before the ring fills up
+            s_logWriter.Wake();
+        }
+    }
+
 #endif
 }
 
@@ -475,6 +904,16 @@ void LogW(enum LogType type, const wchar_t* fmt, ...)
     return;
 #else
 
+    // check to see if logging of the level is enabled, or if s_LogConsole is specified
+    // if not, don't process it.
+    if (type > OptionLogLevel)
+    {
+        return;
+    }
+
+    // wide messages are written synchronously, after the messages already queued
+    _logFlush();
+
     std::lock_guard<std::mutex> s(s_mutex);
 
     bool s_LogConsole = false;
@@ -483,14 +922,6 @@ void LogW(enum LogType type, const wchar_t* fmt, ...)
 
     va_start(arg_ptr, fmt);
 
-    // check to see if logging of the level is enabled, or if s_LogConsole is specified
-    // if not, don't process it.
-    if (type > OptionLogLevel)
-    {
-        va_end(arg_ptr);
-        return;
-    }
-
     // Define buffer to store maximum current log message.
     // Different destinations will receive a subset of this string.
     // On Win32 the entire string is passed to OutputDebugString()
@@ -31,7 +31,8 @@ OSUtils::OSUtils() :
     m_pUserTimerInit(NULL),
     m_pUserTimerDestroy(NULL),
     m_bUserTimer(false),
-    m_userTimerLibraryHandle(NULL)
+    m_userTimerLibraryHandle(NULL),
+    m_bTSCTimer(false)
 {
     LARGE_INTEGER freq;
     QueryPerformanceFrequency(&freq);
@@ -45,6 +46,10 @@ ULONGLONG OSUtils::GetTimeNanos(void)
     {
         return m_pGetUserTime();
     }
+    else if (m_bTSCTimer)
+    {
+        return m_tscClock.GetTimeNanos();
+    }
     else
     {
         LARGE_INTEGER current;
@@ -285,7 +290,8 @@ OSUtils::OSUtils() :
     m_pUserTimerInit(NULL),
     m_pUserTimerDestroy(NULL),
     m_bUserTimer(false),
-    m_userTimerLibraryHandle(NULL)
+    m_userTimerLibraryHandle(NULL),
+    m_bTSCTimer(false)
 {
 }
 
@@ -298,6 +304,10 @@ ULONGLONG OSUtils::GetTimeNanos()
     {
         return m_pGetUserTime();
     }
+    else if (m_bTSCTimer)
+    {
+        return m_tscClock.GetTimeNanos();
+    }
     else
     {
         clock_gettime(CLOCK_MONOTONIC, &tp);
@@ -672,6 +682,19 @@ void OSUtils::SetupUserTimer(const Parameters& params)
     }
 }
 
+void OSUtils::SetupTSCTimer(const Parameters& params)
+{
+    if (params.m_bTSCTimer && !m_bUserTimer)
+    {
+        m_bTSCTimer = m_tscClock.Init();
+
+        if (!m_bTSCTimer)
+        {
+            std::cout << "Unable to use the time stamp counter timer.  Reverting to default timer" << std::endl;
+        }
+    }
+}
+
 /// Shuts down the user timer
 /// \param params the parameters to check
 void OSUtils::ShutdownUserTimer()
@@ -14,6 +14,7 @@
 #include "LocalTSingleton.h"
 #include "OSDefs.h"
 #include "ProfilingParams.h"
+#include "TSCClock.h"
 
 typedef void (*TimerCallbackFunc)(TIMERID timerID);
 typedef void (*ThreadFunc)(void* param);
@@ -50,6 +51,28 @@ public:
     /// \return true if a user timer is being used, false otherwise
     bool IsUserTimerEnabled() const { return m_bUserTimer; }
 
+    /// Sets up the time stamp counter timer if it is requested and no user timer is used
+    /// \param params the parameters to check
+    void SetupTSCTimer(const Parameters& params);
+
+    /// Corrects the drift of the time stamp counter timer, called periodically by the timer thread
+    void CheckTSCTimerCalibration()
+    {
+        if (m_bTSCTimer)
+        {
+            m_tscClock.CheckCalibration();
+        }
+    }
+
+    /// Logs the calibration of the time stamp counter timer
+    void LogTSCTimerStatistics() const
+    {
+        if (m_bTSCTimer)
+        {
+            m_tscClock.LogStatistics();
+        }
+    }
+
     /// Get Current time in nanoseconds
     /// Default time function, but if user selected
     /// time function is loaded, that function is called
@@ -157,6 +180,8 @@ private:
     UserTimerDestroyProc m_pUserTimerDestroy;      ///< Pointer to user timer destruction function: DestroyTimer()
     bool                 m_bUserTimer;             ///< flag to signal the use of the standard timer (value is false) or a user timer (value is true)
     LIB_HANDLE           m_userTimerLibraryHandle; ///< handle to the user timer library
+    TSCClock             m_tscClock;               ///< time stamp counter clock
+    bool                 m_bTSCTimer;              ///< flag indicating whether timestamps are read from m_tscClock
 
 #if defined(_LINUX) || defined(LINUX)
     /// helper function used by Linux versions of osCopyFile and osMoveFile
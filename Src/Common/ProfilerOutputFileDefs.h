@@ -23,12 +23,17 @@
 #define TMP_ASYNC_COPY_TIME_STAMP_EXT ".copytstamp"
 #define TMP_TRACE_EXT ".apitrace"
 #define TMP_TRACE_STACK_EXT ".stfrag"
+#define TMP_SPILL_TRACE_EXT ".apitracespill"
+#define TMP_SPILL_TIME_STAMP_EXT ".tstampspill"
+#define TMP_SPILL_STACK_EXT ".stspill"
 #define TMP_OCCUPANCY_EXT ".occupancyfrag"
 #define TRACE_STACK_EXT ".st"
+#define MODULE_MAP_EXT ".modmap"
 #define PERFMARKER_EXT ".amdtperfmarker"
 #define OCCUPANCY_EXT "occupancy"
 #define TRACE_EXT "atp"
 #define PERF_COUNTER_EXT "csv"
+#define API_STATISTICS_EXT "apistats"
 #define DEFAULT_OUTPUT_FILE "session1"
 #define KERNEL_ASSEMBLY_FILE_PREFIX "sp_tmp."
 
@@ -47,6 +52,7 @@
 #define FILE_HEADER_LIST_SEPARATOR "ListSeparator"
 #define FILE_HEADER_TRACE_FILE_VERSION "TraceFileVersion"
 #define FILE_HEADER_EXCLUDED_APIS "ExcludedAPIs"
+#define FILE_HEADER_API_SAMPLING "APISampling"
 #define FILE_HEADER_PROFILE_FILE_VERSION "ProfileFileVersion"
 #define FILE_HEADER_FORCE_SINGLE_PASS "ForceSinglePass"
 #define FILE_HEADER_MAX_NUMBER_OF_KERNELS_TO_PROFILE "MaxNumberOfKernelsToProfile"
@@ -96,6 +102,11 @@
 #define ATP_PERFMARKER_SECTION_NAME "Perfmarker Output"
 #define ATP_PERFMARKER_SECTION_NAME_PREV "OpenCL Perfmarker Output"
 
+// API Statistics File Defs
+#define API_STATISTICS_HEADER_FILE_VERSION "APIStatisticsFileVersion"
+#define API_STATISTICS_HEADER_NUM_THREADS "NumThreads"
+#define API_STATISTICS_HEADER_HISTOGRAM_BINS "HistogramBins"
+
 // CSV File Defs
 #define CSV_DEFAULT_LIST_SEPARATOR_CHAR OCCUPANCY_DEFAULT_LIST_SEPARATOR_CHAR
 #define CSV_COMMON_COLUMN_METHOD "Method"
@@ -117,6 +128,12 @@
 #define ATP_PARAM_VALUE_DELIMITER EQUAL_SIGN_STR
 #define ATP_TRACE_ENTRY_ARG_SEPARATOR SEMI_COLON_STR
 #define ATP_TRACE_STRUCT_ARG_SEPARATOR ","
+
+// Comment appended to the argument list of an API entry that collapses a run of identical calls:
+// "/*<number of calls> consecutive calls, <total time> ns*/"
+#define ATP_REPEATED_CALLS_COMMENT_COUNT " consecutive calls"
+#define ATP_REPEATED_CALLS_COMMENT_TIME ", "
+#define ATP_REPEATED_CALLS_COMMENT_TIME_UNIT " ns"
 #define OCCUPANCY_HEADER_START HASH_SIGN_WITH_SPACE_STR
 
 #endif // _PROFILER_OUTPUT_FILE_DEFS_H_
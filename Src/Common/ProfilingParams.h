@@ -64,6 +64,19 @@ struct Parameters
         m_uiForcedGpuIndex = 0;
         m_bAqlPacketTracing = false;
         m_bDisableKernelDemangling = false;
+        m_bThreadTraceBuffer = true;
+        m_uiFragmentBufferSize = DEFAULT_FRAGMENT_BUFFER_SIZE;
+        m_uiFlushWatermark = DEFAULT_FLUSH_WATERMARK;
+        m_uiMaxPendingTraceEntries = DEFAULT_MAX_PENDING_TRACE_ENTRIES;
+        m_uiSpillEntryThreshold = DEFAULT_SPILL_ENTRY_THRESHOLD;
+        m_uiBackpressureTimeout = DEFAULT_BACKPRESSURE_TIMEOUT;
+        m_bAPIStatisticsOnly = false;
+        m_uiFlightRecorderEntries = 0;
+        m_uiFlightRecorderSeconds = 0;
+        m_uiFlightRecorderLatencyTrigger = 0;
+        m_bTSCTimer = false;
+        m_bCompressOutput = false;
+        m_bOfflineSymbols = false;
     }
 
     unsigned int m_uiVersionMajor;                ///< Version major
@@ -98,7 +111,7 @@ struct Parameters
     bool m_bTestMode;                             ///< internal test mode flag
     bool m_bUserTimer;                            ///< internal mode to use the user timer rather than the default Win32 timers
     bool m_bQueryRetStat;                         ///< Always query cl function status
-    bool m_bCollapseClGetEventInfo;               ///< Collapse consecutive, identical clGetEventInfo calls into a single call
+    bool m_bCollapseClGetEventInfo;               ///< Collapse consecutive, identical calls to the polling APIs (clGetEventInfo, hsa_signal_load_*, hsa_signal_wait_*) into a single call
     bool m_bStackTrace;                           ///< Stack trace
     bool m_bKernelOccupancy;                      ///< Flag to signal whether to record kernel occupancy
     bool m_bUserPMC;                              ///< flag indicating whether or not user PMC sampler callbacks are invoked during CPU timestamp read.
@@ -119,6 +132,19 @@ struct Parameters
     bool m_bAqlPacketTracing;                     ///< Flag indicating that an AQL Packet Trace should be performed.
     bool m_bDisableKernelDemangling;              ///< Flag indicating whether or not to demangle the kernel name
     bool m_bNoHSATransferTime;                    ///< Flag indicating whether or not HSA transfer time is ignored
+    bool m_bThreadTraceBuffer;                    ///< Flag indicating whether trace entries are stored in per-thread buffers rather than in the shared trace map
+    unsigned int m_uiFragmentBufferSize;          ///< Buffer size in KB of the fragment files kept open between flushes (timeout mode only), 0 to reopen the files on every flush
+    unsigned int m_uiFlushWatermark;              ///< Number of pending entries of a thread that wakes the timer thread before the interval expires (timeout mode only), 0 to flush on the interval only
+    unsigned int m_uiMaxPendingTraceEntries;      ///< Maximum number of entries waiting to be flushed (timeout mode only), 0 for no limit
+    unsigned int m_uiSpillEntryThreshold;         ///< Number of pending entries that triggers writing the completed ones to spill files (non-timeout mode only), 0 to keep all entries in memory. Entries that can't be written yet stay in memory, so this doesn't bound the memory used
+    unsigned int m_uiBackpressureTimeout;         ///< Time in ms a thread waits for the timer thread once m_uiMaxPendingTraceEntries is reached, before entries are dropped
+    bool m_bAPIStatisticsOnly;                    ///< Flag indicating whether only per-API statistics (.apistats file) are collected instead of a full API trace
+    unsigned int m_uiFlightRecorderEntries;       ///< Number of most recent entries of each thread kept by the flight recorder (timeout mode only), 0 for no entry limit
+    unsigned int m_uiFlightRecorderSeconds;       ///< Number of seconds of most recent entries kept by the flight recorder (timeout mode only), 0 for no time limit
+    unsigned int m_uiFlightRecorderLatencyTrigger;///< API duration in us that triggers a flight recorder dump, 0 to disable the trigger
+    bool m_bTSCTimer;                             ///< Flag indicating whether timestamps are read from the invariant CPU time stamp counter instead of the default timer
+    bool m_bCompressOutput;                       ///< Flag indicating whether the tmp fragment files and the kernel profile .csv files are written as compressed blocks
+    bool m_bOfflineSymbols;                       ///< Flag indicating whether stack traces are recorded as raw addresses that rcprof symbolizes (Linux only)
 };
 
 #endif // _PROFILING_PARAMS_H_
@@ -0,0 +1,181 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class collapses the runs of identical calls an application makes
+///        to the APIs it polls into a single trace entry per run.
+//==============================================================================
+
+#include <new>
+
+#include <AMDTOSWrappers/Include/osThread.h>
+
+#include "RepeatedCallCollapser.h"
+#include "APIInfoManagerBase.h"
+
+using namespace std;
+
+/// Number of runs cached per thread (one per collapser the thread makes pollable calls through)
+#define REPEATED_CALL_RUN_CACHE_SIZE 4
+
+/// Per-thread cache entry mapping a collapser to the calling thread's run
+struct RepeatedCallRunCacheEntry
+{
+    const RepeatedCallCollapser* m_pOwner;  ///< the collapser the run is registered with
+    void*                        m_pRun;    ///< the calling thread's run
+};
+
+/// Runs registered by the calling thread, looked up without taking any lock
+static thread_local RepeatedCallRunCacheEntry s_runCache[REPEATED_CALL_RUN_CACHE_SIZE] = {};
+
+RepeatedCallCollapser::RepeatedCallCollapser()
+{
+}
+
+RepeatedCallCollapser::~RepeatedCallCollapser()
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    for (map<osThreadId, Run*>::iterator it = m_runs.begin(); it != m_runs.end(); ++it)
+    {
+        SAFE_DELETE(it->second);
+    }
+
+    m_runs.clear();
+}
+
+bool RepeatedCallCollapser::AddCall(APIBase* pEntry)
+{
+    if (!pEntry->IsPollable())
+    {
+        // a thread that never made a pollable call has no run to close
+        Run* pRun = GetThreadRun(false);
+
+        if (nullptr != pRun && nullptr != pRun->m_pEntry.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(pRun->m_mtx);
+            pRun->m_pEntry = nullptr;
+        }
+
+        return false;
+    }
+
+    Run* pRun = GetThreadRun(true);
+
+    if (nullptr == pRun)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(pRun->m_mtx);
+    APIBase* pRunEntry = pRun->m_pEntry;
+
+    if (nullptr != pRunEntry && pEntry->IsRepeatOf(pRunEntry))
+    {
+        pRunEntry->AddRepeatedCall(pEntry);
+        return true;
+    }
+
+    pRun->m_pEntry = pEntry;
+    return false;
+}
+
+void RepeatedCallCollapser::CloseRun(osThreadId tid, const APIBase* pEntry)
+{
+    if (nullptr == pEntry || !pEntry->IsPollable())
+    {
+        return;
+    }
+
+    Run* pRun = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        map<osThreadId, Run*>::iterator it = m_runs.find(tid);
+
+        if (it == m_runs.end())
+        {
+            return;
+        }
+
+        pRun = it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(pRun->m_mtx);
+
+    if (pRun->m_pEntry == pEntry)
+    {
+        pRun->m_pEntry = nullptr;
+    }
+}
+
+void RepeatedCallCollapser::CloseRuns()
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+
+    for (map<osThreadId, Run*>::iterator it = m_runs.begin(); it != m_runs.end(); ++it)
+    {
+        std::lock_guard<std::mutex> lockRun(it->second->m_mtx);
+        it->second->m_pEntry = nullptr;
+    }
+}
+
+RepeatedCallCollapser::Run* RepeatedCallCollapser::GetThreadRun(bool bCreate)
+{
+    bool bCacheFull = true;
+
+    for (int i = 0; i < REPEATED_CALL_RUN_CACHE_SIZE; i++)
+    {
+        if (s_runCache[i].m_pOwner == this)
+        {
+            return static_cast<Run*>(s_runCache[i].m_pRun);
+        }
+        else if (nullptr == s_runCache[i].m_pOwner)
+        {
+            bCacheFull = false;
+            break;
+        }
+    }
+
+    // the run of the thread would be in the cache
+    if (!bCreate && !bCacheFull)
+    {
+        return nullptr;
+    }
+
+    osThreadId tid = osGetUniqueCurrentThreadId();
+    Run* pRun = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        map<osThreadId, Run*>::iterator it = m_runs.find(tid);
+
+        if (it != m_runs.end())
+        {
+            pRun = it->second;
+        }
+        else if (bCreate)
+        {
+            pRun = new(nothrow) Run();
+
+            if (nullptr == pRun)
+            {
+                return nullptr;
+            }
+
+            m_runs.insert(make_pair(tid, pRun));
+        }
+    }
+
+    for (int i = 0; i < REPEATED_CALL_RUN_CACHE_SIZE && nullptr != pRun; i++)
+    {
+        if (nullptr == s_runCache[i].m_pOwner)
+        {
+            s_runCache[i].m_pOwner = this;
+            s_runCache[i].m_pRun = pRun;
+            break;
+        }
+    }
+
+    return pRun;
+}
@@ -0,0 +1,89 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class collapses the runs of identical calls an application makes
+///        to the APIs it polls into a single trace entry per run.
+//==============================================================================
+
+#ifndef _REPEATED_CALL_COLLAPSER_H_
+#define _REPEATED_CALL_COLLAPSER_H_
+
+/// \defgroup RepeatedCallCollapser RepeatedCallCollapser
+/// This module implements the run-length collapsing of the polling API calls
+///
+/// \ingroup Common
+// @{
+
+#include <map>
+#include <mutex>
+#include <atomic>
+
+#include <AMDTOSWrappers/Include/osOSDefinitions.h>
+
+class APIBase;
+
+//------------------------------------------------------------------------------------
+/// Run-length collapser of the pollable API calls (see APIBase::IsPollable) of each
+/// thread. The last pollable entry added by a thread is the open run of the thread:
+/// the following calls repeating it only increase its repeat count, end timestamp and
+/// total time, and are not added to the trace. Any other call of the thread closes
+/// the run. The writers close the run of an entry before writing it, so an open run
+/// never holds up a flush; a thread that keeps polling starts a new run instead.
+//------------------------------------------------------------------------------------
+class RepeatedCallCollapser
+{
+public:
+    /// Constructor
+    RepeatedCallCollapser();
+
+    /// Destructor
+    ~RepeatedCallCollapser();
+
+    /// Called by the calling thread for each API entry before it is added to the trace
+    /// \param pEntry the entry
+    /// \return true if the call repeats the open run of the thread: the run has been extended and the entry must not be added
+    bool AddCall(APIBase* pEntry);
+
+    /// Close the run of an entry about to be written or released, the thread no longer modifies the entry afterwards
+    /// \param tid the thread that added the entry
+    /// \param pEntry the entry
+    void CloseRun(osThreadId tid, const APIBase* pEntry);
+
+    /// Close the runs of all threads, called before all remaining entries are written
+    void CloseRuns();
+
+private:
+    /// Open run of a thread
+    struct Run
+    {
+        /// Constructor
+        Run() : m_pEntry(nullptr)
+        {
+        }
+
+        std::atomic<APIBase*> m_pEntry;  ///< first entry of the run, nullptr if no run is open. Set by the owning thread, cleared by any thread
+        std::mutex            m_mtx;     ///< mutex serializing the updates of the entry with the writers
+    };
+
+    /// Get the run of the calling thread
+    /// \param bCreate flag indicating whether the run is created if the thread doesn't have one yet
+    /// \return the run, nullptr if the thread doesn't have one
+    Run* GetThreadRun(bool bCreate);
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    RepeatedCallCollapser(const RepeatedCallCollapser& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    RepeatedCallCollapser& operator=(const RepeatedCallCollapser& obj) = delete;
+
+    std::map<osThreadId, Run*> m_runs;  ///< run of each thread that made a pollable call
+    std::mutex                 m_mtx;   ///< mutex protecting m_runs
+};
+
+// @}
+
+#endif //_REPEATED_CALL_COLLAPSER_H_
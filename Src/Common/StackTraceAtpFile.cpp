@@ -10,6 +10,7 @@
 
 // common
 #include <AMDTOSWrappers/Include/osOSDefinitions.h>
+#include <AMDTOSWrappers/Include/osDirectory.h>
 
 #include "ProfilerOutputFileDefs.h"
 #include "FileUtils.h"
@@ -18,6 +19,11 @@
 #include "StringUtils.h"
 #include "StackTraceAtpFile.h"
 #include "ATPFileUtils.h"
+#include "CallSiteTable.h"
+
+#ifndef _WIN32
+    #include "ElfSymbolizer.h"
+#endif
 
 StackTraceAtpFilePart::StackTraceAtpFilePart(const std::string& strModName, const Config& config, bool shouldReleaseMemory) : IAtpFilePart(config, shouldReleaseMemory)
 {
@@ -64,6 +70,10 @@ bool StackTraceAtpFilePart::WriteContentSection(SP_fileStream& sout, const std::
         std::stringstream ssExtName;
         ssExtName << "." << m_strPartName << TMP_TRACE_STACK_EXT;
 
+#ifndef _WIN32
+        SymbolizeTmpStackFiles(strTmpFilePath, strPID);
+#endif
+
         if (!m_config.bTestMode)
         {
             ret = FileUtils::MergeTmpTraceFiles(sout, strTmpFilePath, strPID, ssExtName.str().c_str(), GetSectionHeader(m_sections[0]).c_str());
@@ -79,6 +89,9 @@ bool StackTraceAtpFilePart::WriteContentSection(SP_fileStream& sout, const std::
         ss << FileUtils::GetBaseFileName(m_config.strOutputFile) << "." << m_strPartName << TRACE_STACK_EXT;
         std::string stackFile = ss.str();
         std::string fileContent;
+#ifndef _WIN32
+        SymbolizeStackFile(stackFile);
+#endif
         ret = FileUtils::ReadFile(stackFile, fileContent, false);
         sout << fileContent.c_str();
         remove(stackFile.c_str());
@@ -102,6 +115,10 @@ void StackTraceAtpFilePart::SaveToFile(const std::string& strTmpFilePath, const
         ss.str("");
         ss << GetSectionHeader(m_sections[0]) << std::endl;
 
+#ifndef _WIN32
+        SymbolizeTmpStackFiles(strTmpFilePath, strPID);
+#endif
+
         if (m_config.bCompatibilityMode)
         {
             if (!m_config.bTestMode)
@@ -130,10 +147,73 @@ void StackTraceAtpFilePart::SaveToFile(const std::string& strTmpFilePath, const
         // Construct output name: $name.$mod.st
         ss << FileUtils::GetBaseFileName(m_config.strOutputFile) << "." << m_strPartName << TRACE_STACK_EXT;
         std::string fromFile = ss.str();
+#ifndef _WIN32
+        SymbolizeStackFile(fromFile);
+#endif
         OSUtils::Instance()->OSMoveFile(fromFile.c_str(), stackFile.c_str());
     }
 }
 
+#ifndef _WIN32
+void StackTraceAtpFilePart::SymbolizeTmpStackFiles(const std::string& strTmpFilePath, const std::string& strPID)
+{
+    gtString strDirPath;
+    strDirPath.fromUtf8String(strTmpFilePath);
+    osDirectory tmpFileDirectory(strDirPath);
+
+    std::stringstream ssFileMask;
+    ssFileMask << strPID << "*." << m_strPartName << TMP_TRACE_STACK_EXT;
+    gtString fileMask;
+    fileMask.fromUtf8String(ssFileMask.str());
+
+    gtList<osFilePath> files;
+
+    if (!tmpFileDirectory.getContainedFilePaths(fileMask, osDirectory::SORT_BY_NAME_ASCENDING, files))
+    {
+        return;
+    }
+
+    // the fragments are named pid_tid.<mod>.stfrag, the module map of a process is pid.<mod>.modmap
+    std::map<std::string, std::vector<std::string> > stackFilesByModuleMap;
+
+    for (gtList<osFilePath>::const_iterator it = files.begin(); it != files.end(); ++it)
+    {
+        std::string strStackFile = it->asString().asUTF8CharArray();
+        size_t fileNamePos = strStackFile.find_last_of('/') + 1;
+        size_t pidEnd = strStackFile.find('_', fileNamePos);
+
+        if (pidEnd == std::string::npos)
+        {
+            continue;
+        }
+
+        std::stringstream ssModuleMapFile;
+        ssModuleMapFile << strStackFile.substr(0, pidEnd) << "." << m_strPartName << MODULE_MAP_EXT;
+        stackFilesByModuleMap[ssModuleMapFile.str()].push_back(strStackFile);
+    }
+
+    for (std::map<std::string, std::vector<std::string> >::const_iterator it = stackFilesByModuleMap.begin(); it != stackFilesByModuleMap.end(); ++it)
+    {
+        // the module map only exists if the agent recorded raw addresses
+        if (OfflineSymbolizer::SymbolizeFiles(it->first, it->second))
+        {
+            remove(it->first.c_str());
+        }
+    }
+}
+
+void StackTraceAtpFilePart::SymbolizeStackFile(const std::string& strStackFile)
+{
+    std::string strModuleMapFile = FileUtils::GetBaseFileName(strStackFile) + MODULE_MAP_EXT;
+
+    // the module map only exists if the agent recorded raw addresses
+    if (OfflineSymbolizer::SymbolizeFiles(strModuleMapFile, std::vector<std::string>(1, strStackFile)))
+    {
+        remove(strModuleMapFile.c_str());
+    }
+}
+#endif
+
 bool StackTraceAtpFilePart::Parse(std::istream& in, std::string& outErrorMsg)
 {
     bool bError = false;
@@ -270,6 +350,32 @@ bool StackTraceAtpFilePart::ParseSymbolEntry(const std::string& buf, SymbolFileE
     ss >> secondToken;
     CHECK_SS_ERROR(ss)
 
+    unsigned int uiCallSiteID = INVALID_CALL_SITE_ID;
+
+    if (secondToken[0] == CALL_SITE_ID_PREFIX)
+    {
+        if (!StringUtils::Parse(secondToken.substr(1), uiCallSiteID))
+        {
+            return false;
+        }
+
+        ss >> secondToken;
+
+        if (ss.fail())
+        {
+            // the stack entry was written with a previous API from the same call site
+            std::map<unsigned int, StackEntry>::const_iterator it = m_callSiteMap.find(uiCallSiteID);
+
+            if (it == m_callSiteMap.end())
+            {
+                return false;
+            }
+
+            pSymbolFileEntry = new SymbolFileEntry(m_strPartName, strApiName, new StackEntry(it->second));
+            return true;
+        }
+    }
+
     if (secondToken.find('+') != std::string::npos)
     {
         std::vector<std::string> tokens;
@@ -316,6 +422,11 @@ bool StackTraceAtpFilePart::ParseSymbolEntry(const std::string& buf, SymbolFileE
     stackEntry->m_strSymAddr = strSymAddr;
     stackEntry->m_strSymName = strSymName;
 
+    if (uiCallSiteID != INVALID_CALL_SITE_ID)
+    {
+        m_callSiteMap[uiCallSiteID] = *stackEntry;
+    }
+
     pSymbolFileEntry = new SymbolFileEntry(m_strPartName, strApiName, stackEntry);
 
     return true;
@@ -92,7 +92,20 @@ private:
     /// \return True if succeed.
     bool ParseSymbolEntry(const std::string& buf, SymbolFileEntry*& pSymbolFileEntry);
 
+#ifndef _WIN32
+    /// Resolve the raw addresses of the stack trace fragments written in the offline symbolization mode,
+    /// the fragments of a process are symbolized if its module map file exists
+    /// \param strTmpFilePath Output fragment files path
+    /// \param strPID child process ID
+    void SymbolizeTmpStackFiles(const std::string& strTmpFilePath, const std::string& strPID);
+
+    /// Resolve the raw addresses of the stack trace file written in the offline symbolization mode (non-timeout mode)
+    /// \param strStackFile the stack trace file written by the agent
+    void SymbolizeStackFile(const std::string& strStackFile);
+#endif
+
     SymbolEntryMap m_SymbolEntryMap; ///< StackEntry Map key = threadID
+    std::map<unsigned int, StackEntry> m_callSiteMap; ///< stack entries of the call sites defined so far, key = call site ID
 };
 
 #endif // _STACK_TRACE_ATP_FILE_H
@@ -6,6 +6,7 @@
 //==============================================================================
 
 #include <iostream>
+#include <sstream>
 #include "StackTracer.h"
 #include "StringUtils.h"
 #include "Logger.h"
@@ -27,6 +28,58 @@ StackTracer::StackTracer(void)
     SpAssert(m_pMtx != NULL);
 #endif
     m_bInit = false;
+    m_bOfflineSymbols = false;
+}
+
+void StackTracer::SetOfflineSymbols(bool bOfflineSymbols)
+{
+#ifdef _WIN32
+
+    if (bOfflineSymbols)
+    {
+        Log(logWARNING, "StackTracer: offline symbolization is not supported on Windows\n");
+    }
+
+#else
+    m_bOfflineSymbols = bOfflineSymbols;
+#endif
+}
+
+bool StackTracer::GetRawAddress(Address dwAddress, std::string& strRawAddress)
+{
+#ifdef _WIN32
+    SP_UNREFERENCED_PARAMETER(dwAddress);
+    SP_UNREFERENCED_PARAMETER(strRawAddress);
+    return false;
+#else
+    unsigned int uiModuleIndex = 0;
+    unsigned long long ullModuleAddress = 0;
+
+    if (!m_bOfflineSymbols || !m_moduleMap.FindModule(dwAddress, uiModuleIndex, ullModuleAddress))
+    {
+        return false;
+    }
+
+    stringstream ss;
+    ss << RAW_ADDRESS_PREFIX << uiModuleIndex << "+0x" << hex << ullModuleAddress;
+    strRawAddress = ss.str();
+
+    return true;
+#endif
+}
+
+void StackTracer::WriteModuleMap(const std::string& strFileName)
+{
+#ifdef _WIN32
+    SP_UNREFERENCED_PARAMETER(strFileName);
+#else
+
+    if (m_bOfflineSymbols)
+    {
+        m_moduleMap.WriteToFile(strFileName);
+    }
+
+#endif
 }
 
 bool StackTracer::InitSymPath(wchar_t* pszSymPath)
@@ -543,16 +596,19 @@ bool StackTracer::GetStackTrace(std::vector<StackEntry>& stackTrace, bool bGetSy
     return !stackTrace.empty();
 }
 
-#else
+bool StackTracer::GetModuleNames(std::vector<StackEntry>& stackTrace)
+{
+    // GetSymbolName gets the module name from the address
+    SP_UNREFERENCED_PARAMETER(stackTrace);
+    return true;
+}
 
-#include <signal.h>
-#include <sys/wait.h>
+#else
 
 bool StackTracer::GetStackTrace(std::vector<StackEntry>& stackTrace, bool bGetSymbol, osThreadId tid)
 {
     int nEntries = 0;
     void* pBuffer[MAX_TRACE_SIZE];
-    char** ppStrs;
 
     nEntries = backtrace(pBuffer, MAX_TRACE_SIZE);
 
@@ -563,7 +619,59 @@ bool StackTracer::GetStackTrace(std::vector<StackEntry>& stackTrace, bool bGetSy
 
     stackTrace.reserve(nEntries);
 
-    ppStrs = backtrace_symbols(pBuffer, nEntries);
+    for (int i = 0; i < nEntries; ++i)
+    {
+        StackEntry en;
+        en.m_dwAddress = pBuffer[i];
+        stackTrace.push_back(en);
+    }
+
+    if (bGetSymbol)
+    {
+        return GetModuleNames(stackTrace);
+    }
+
+    return true;
+}
+
+bool StackTracer::GetModuleNames(std::vector<StackEntry>& stackTrace)
+{
+    if (stackTrace.empty())
+    {
+        return false;
+    }
+
+    if (m_bOfflineSymbols)
+    {
+        // the module map is enough, the symbols are resolved by rcprof
+        std::vector<StackEntry> resolvedStackTrace;
+        resolvedStackTrace.reserve(stackTrace.size());
+
+        for (std::vector<StackEntry>::iterator it = stackTrace.begin(); it != stackTrace.end(); ++it)
+        {
+            unsigned int uiModuleIndex = 0;
+            unsigned long long ullModuleAddress = 0;
+
+            if (m_moduleMap.FindModule(it->m_dwAddress, uiModuleIndex, ullModuleAddress, &it->m_strModName))
+            {
+                resolvedStackTrace.push_back(*it);
+            }
+        }
+
+        stackTrace.swap(resolvedStackTrace);
+
+        return true;
+    }
+
+    std::vector<void*> addresses;
+    addresses.reserve(stackTrace.size());
+
+    for (std::vector<StackEntry>::const_iterator it = stackTrace.begin(); it != stackTrace.end(); ++it)
+    {
+        addresses.push_back(it->m_dwAddress);
+    }
+
+    char** ppStrs = backtrace_symbols(&addresses[0], static_cast<int>(addresses.size()));
 
     if (ppStrs == NULL)
     {
@@ -571,12 +679,15 @@ bool StackTracer::GetStackTrace(std::vector<StackEntry>& stackTrace, bool bGetSy
     }
     else
     {
-        for (int i = 0; i < nEntries; ++i)
+        std::vector<StackEntry> resolvedStackTrace;
+        resolvedStackTrace.reserve(stackTrace.size());
+
+        for (size_t i = 0; i < addresses.size(); ++i)
         {
             if (ppStrs[i])
             {
                 StackEntry en;
-                en.m_dwAddress = pBuffer[i];
+                en.m_dwAddress = addresses[i];
                 bool bModSet = false;
                 string str = string(ppStrs[i]);
                 size_t pos0 = str.find_first_of("(");
@@ -634,172 +745,45 @@ bool StackTracer::GetStackTrace(std::vector<StackEntry>& stackTrace, bool bGetSy
                     continue;
                 }
 
-                stackTrace.push_back(en);
+                resolvedStackTrace.push_back(en);
             }
         }
 
-        return true;
-    }
-}
-
-bool StackTracer::CheckDbgInfo(const std::string& strMod)
-{
-    bool bRet = false;
-    // find debug info info from map
-    DbgInfoMap::iterator it = m_dbgInfoMods.find(strMod);
-
-    if (it == m_dbgInfoMods.end())
-    {
-        // check for dbg info availability
-        char filecmd[SP_MAX_PATH];
-        sprintf(filecmd, "file %s", strMod.c_str());
-
-        FILE* pFile = popen(filecmd, "r");
-
-        if (pFile != NULL)
-        {
-            char fileOut[SP_MAX_PATH];
-
-            if (fgets(fileOut, SP_MAX_PATH, pFile) != NULL)
-            {
-                string strOut = fileOut;
-
-                if (strOut.find("not stripped") == string::npos)
-                {
-                    // debug info missing
-                    m_dbgInfoMods.insert(DbgInfoMapPair(strMod, false));
-                }
-                else
-                {
-                    m_dbgInfoMods.insert(DbgInfoMapPair(strMod, true));
-                    bRet = true;
-                }
-            }
-
-            pclose(pFile);
-        }
-        else
-        {
-            // check failed, assume it has debug info
-            m_dbgInfoMods.insert(DbgInfoMapPair(strMod, true));
-            bRet = true;
-        }
-    }
-    else
-    {
-        bRet = it->second;
-    }
-
-    return bRet;
-}
-
-//
-pid_t popen2(const char* pCommand, int* pInfp, int* pOutfp)
-{
-    const int READ = 0;
-    const int WRITE = 1;
-    int p_stdin[2], p_stdout[2];
-    pid_t pid;
-
-    if (pipe(p_stdin) != 0 || pipe(p_stdout) != 0)
-    {
-        return -1;
-    }
-
-    pid = fork();
+        free(ppStrs);
+        stackTrace.swap(resolvedStackTrace);
 
-    if (pid < 0)
-    {
-        return pid;
-    }
-    else if (pid == 0)
-    {
-        close(p_stdin[WRITE]);
-        dup2(p_stdin[READ], READ);
-        close(p_stdout[READ]);
-        dup2(p_stdout[WRITE], WRITE);
-
-        execl("/bin/sh", "sh", "-c", pCommand, NULL);
-        perror("execl");
-        exit(1);
-    }
-
-    // Parent process
-    // Close unused pipe ends
-    close(p_stdin[READ]);
-    close(p_stdout[WRITE]);
-
-    if (pInfp == NULL)
-    {
-        close(p_stdin[WRITE]);
-    }
-    else
-    {
-        *pInfp = p_stdin[WRITE];
-    }
-
-    if (pOutfp == NULL)
-    {
-        close(p_stdout[READ]);
-    }
-    else
-    {
-        *pOutfp = p_stdout[READ];
+        return true;
     }
-
-    return pid;
 }
 
 bool StackTracer::GetSymbolName(Address dwAddress, StackEntry& en)
 {
-    if (dwAddress == NULL || en.m_strModName.empty())
+    if (dwAddress == NULL || en.m_strModName.empty() || m_bOfflineSymbols)
     {
         return false;
     }
 
-    bool bDbgInfo = CheckDbgInfo(en.m_strModName);
+    // backtrace returns return addresses, look up the call instruction
+    ElfSymbolInfo info;
 
-    if (!bDbgInfo)
+    if (!m_symbolizer.Symbolize(static_cast<const char*>(dwAddress) - 1, info))
     {
         return false;
     }
 
-    char syscom[SP_MAX_PATH];
-    sprintf(syscom, "addr2line -e %s %p", en.m_strModName.c_str(), en.m_dwAddress); //last parameter is the name of this app
-    int pstdout = 0;
-    pid_t pid = popen2(syscom, NULL, &pstdout);
-
-    if (pid > 0)
+    if (!info.m_strFile.empty())
     {
-        char addr2lineOut[SP_MAX_PATH];
-        memset(addr2lineOut, 0, SP_MAX_PATH);
-
-        if (read(pstdout, addr2lineOut, SP_MAX_PATH) != -1)
-        {
-            string strOut = addr2lineOut;
-
-            if (strOut.find("??") == string::npos)
-            {
-                size_t pos = strOut.find_last_of(":");
-                en.m_strFile = strOut.substr(0, pos);
-                string line = strOut.substr(pos + 1);
-                StringUtils::Parse(line, en.m_dwLineNum);
-            }
-
-            close(pstdout);
-        }
-        else
-        {
-            //failed to read output, kill process
-            kill(pid, SIGKILL);
-            return false;
-        }
+        en.m_strFile = info.m_strFile;
+        en.m_dwLineNum = info.m_lineNum;
+    }
 
-        waitpid(pid, NULL, 0);
-        return true;
+    // backtrace_symbols only knows the exported symbols
+    if (en.m_strSymName.empty())
+    {
+        en.m_strSymName = info.m_strSymName;
     }
 
-    return false;
+    return true;
 }
 
 #endif
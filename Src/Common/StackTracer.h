@@ -28,11 +28,9 @@
     #include <stdio.h>
     #include <stdlib.h>
     #include <unistd.h>
+    #include "ElfSymbolizer.h"
 #endif
 
-typedef std::map<std::string, bool> DbgInfoMap;
-typedef std::pair<std::string, bool> DbgInfoMapPair;
-
 #ifdef _WIN32
 typedef BOOL (WINAPI FAR* StackWalk64Proc)(DWORD MachineType, HANDLE hProcess, HANDLE hThread, LPSTACKFRAME64 StackFrame,
                                            PVOID ContextRecord, PREAD_PROCESS_MEMORY_ROUTINE64 ReadMemoryRoutine,
@@ -127,15 +125,37 @@ public:
     /// Stack walker
     /// \param[out] stackTrace Stack entries
     /// \param[in]  bGetSymbol flag indicating whether or not to get symbol info immediately,
-    ///             for normal mode, in order to minimize trace overhead, we retrieve symbol info during program shutdown. Ignored for Linux.
+    ///             for normal mode, in order to minimize trace overhead, we retrieve symbol info during program shutdown.
+    ///             On Linux, only the module names (see GetModuleNames) are retrieved.
     /// \param[in]  tid ThreadID for which stack trace is performed, Optional, default is current thread. Ingored for Linux
     bool GetStackTrace(std::vector<StackEntry>& stackTrace, bool bGetSymbol = true, osThreadId tid = 0);
 
+    /// Get the module names (and the exported symbol names on Linux) of a stack trace recorded without symbol info,
+    /// GetSymbolName needs them on Linux. Entries whose module can't be found are removed. Does nothing on Windows
+    /// \param[in,out] stackTrace Stack entries
+    /// \return true if succeeded
+    bool GetModuleNames(std::vector<StackEntry>& stackTrace);
+
     /// Get Symbol Name
     /// \param[in]    dwAddress Address
     /// \param[out]   Output stack entry
     bool GetSymbolName(Address dwAddress, StackEntry& en);
 
+    /// Enable the offline symbolization mode (Linux only). GetSymbolName doesn't resolve anything, the stack entries
+    /// are written as raw addresses (see GetRawAddress) that rcprof resolves once the application has exited
+    /// \param bOfflineSymbols flag indicating whether or not the symbols are resolved offline
+    void SetOfflineSymbols(bool bOfflineSymbols);
+
+    /// Get the raw address written in place of the symbol info in the offline symbolization mode
+    /// \param[in]  dwAddress Address
+    /// \param[out] strRawAddress the module index and the address in the module (see RAW_ADDRESS_PREFIX)
+    /// \return false if the symbols aren't resolved offline or the address isn't in a module
+    bool GetRawAddress(Address dwAddress, std::string& strRawAddress);
+
+    /// Write the module map the raw addresses refer to, does nothing if the symbols aren't resolved offline
+    /// \param strFileName the module map file name
+    void WriteModuleMap(const std::string& strFileName);
+
 #ifdef _WIN32
 private:
     /// Dynamically load dbghelp.dll
@@ -165,14 +185,11 @@ private:
     SymLoadModule64Proc m_pSymLoadModule64;                        ///< Function pointer to SymLoadModule64.
     SymUnloadModule64Proc m_pSymUnloadModule64;                    ///< Function pointer to SymUnloadModule64.
 #else // Linux specific mem vars
-    /// Check debug info availability
-    /// \param strMod Module name
-    /// \return true if debug info is available
-    bool CheckDbgInfo(const std::string& strMod);
-
-    DbgInfoMap m_dbgInfoMods;                                      ///< Debug info map
+    ElfSymbolizer m_symbolizer;                                    ///< Symbolizer reading the symbols and line tables of the loaded modules
+    ProcessModuleMap m_moduleMap;                                  ///< Modules of the raw addresses in the offline symbolization mode
 #endif
     bool m_bInit;                                                  ///< Init flag
+    bool m_bOfflineSymbols;                                        ///< Flag indicating whether or not the symbols are resolved offline by rcprof
 };
 
 #endif //_STACK_TRACER_H_
@@ -0,0 +1,227 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class converts the CPU time stamp counter to nanoseconds in the
+///        time base of the default profiler clock.
+//==============================================================================
+
+#include <thread>
+#include <chrono>
+
+#include "TSCClock.h"
+#include "Logger.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+#if defined(_LINUX) || defined(LINUX)
+    #include <time.h>
+
+    #ifdef TSC_CLOCK_SUPPORTED
+        #include <cpuid.h>
+    #endif
+#endif
+
+using namespace std;
+using namespace GPULogger;
+
+/// Number of attempts to read both clocks, the attempt with the fewest ticks between the two counter reads is used
+#define TSC_CLOCK_PAIR_ATTEMPTS 5
+
+TSCClock::TSCClock() :
+    m_iActiveCalibration(0),
+    m_ullFirstTSC(0),
+    m_ullFirstNanos(0),
+    m_ullLastCheck(0),
+    m_ullMaxDrift(0),
+    m_ullNumChecks(0)
+{
+    m_calibration[0].m_ullTSCBase = 0;
+    m_calibration[0].m_ullNanosBase = 0;
+    m_calibration[0].m_ullScale = 0;
+    m_calibration[1] = m_calibration[0];
+}
+
+bool TSCClock::Init()
+{
+    if (!IsInvariantTSC())
+    {
+        Log(logMESSAGE, "TSCClock: the CPU doesn't have an invariant time stamp counter, using the default clock\n");
+        return false;
+    }
+
+    ULONGLONG ullFirstTSC;
+    ULONGLONG ullFirstNanos;
+    ULONGLONG ullTSC;
+    ULONGLONG ullNanos;
+    ReadClockPair(ullFirstTSC, ullFirstNanos);
+    this_thread::sleep_for(chrono::milliseconds(TSC_CLOCK_CALIBRATION_TIME));
+    ReadClockPair(ullTSC, ullNanos);
+
+    if (!Calibrate(ullFirstTSC, ullFirstNanos, ullTSC, ullNanos))
+    {
+        Log(logWARNING, "TSCClock: calibration failed, using the default clock\n");
+        return false;
+    }
+
+    Log(logMESSAGE, "TSCClock: time stamp counter frequency %.3f MHz\n", static_cast<double>(ullTSC - m_ullFirstTSC) * 1000.0 / static_cast<double>(ullNanos - m_ullFirstNanos));
+    return true;
+}
+
+bool TSCClock::Calibrate(ULONGLONG ullFirstTSC, ULONGLONG ullFirstNanos, ULONGLONG ullTSC, ULONGLONG ullNanos)
+{
+    if (ullTSC <= ullFirstTSC || ullNanos <= ullFirstNanos)
+    {
+        return false;
+    }
+
+    m_ullFirstTSC = ullFirstTSC;
+    m_ullFirstNanos = ullFirstNanos;
+
+    TSCCalibration calibration;
+    calibration.m_ullTSCBase = ullTSC;
+    calibration.m_ullNanosBase = ullNanos;
+    calibration.m_ullScale = static_cast<ULONGLONG>(static_cast<double>(ullNanos - m_ullFirstNanos) / static_cast<double>(ullTSC - m_ullFirstTSC) * (1ULL << TSC_CLOCK_SCALE_SHIFT));
+    SetCalibration(calibration);
+    m_ullLastCheck = ullNanos;
+
+    return true;
+}
+
+void TSCClock::CheckCalibration()
+{
+    ULONGLONG ullNow = GetReferenceTimeNanos();
+
+    if (0 == m_ullLastCheck || ullNow - m_ullLastCheck < TSC_CLOCK_CHECK_INTERVAL * 1000000ULL)
+    {
+        return;
+    }
+
+    ULONGLONG ullTSC;
+    ULONGLONG ullNanos;
+    ReadClockPair(ullTSC, ullNanos);
+    Recalibrate(ullTSC, ullNanos);
+}
+
+void TSCClock::Recalibrate(ULONGLONG ullTSC, ULONGLONG ullNanos)
+{
+    if (ullTSC <= m_ullFirstTSC)
+    {
+        return;
+    }
+
+    const TSCCalibration& current = m_calibration[m_iActiveCalibration.load(memory_order_relaxed)];
+    ULONGLONG ullPredicted = Convert(current, ullTSC);
+    long long llDrift = static_cast<long long>(ullPredicted - ullNanos);
+    ULONGLONG ullDrift = llDrift < 0 ? static_cast<ULONGLONG>(-llDrift) : static_cast<ULONGLONG>(llDrift);
+
+    m_ullMaxDrift = ullDrift > m_ullMaxDrift ? ullDrift : m_ullMaxDrift;
+    m_ullNumChecks++;
+    m_ullLastCheck = ullNanos;
+
+    // long term rate measured since the initial calibration
+    double dScale = static_cast<double>(ullNanos - m_ullFirstNanos) / static_cast<double>(ullTSC - m_ullFirstTSC) * (1ULL << TSC_CLOCK_SCALE_SHIFT);
+    double dInterval = TSC_CLOCK_CHECK_INTERVAL * 1000000.0;
+
+    TSCCalibration calibration;
+    calibration.m_ullTSCBase = ullTSC;
+
+    if (static_cast<double>(ullDrift) < dInterval / 2)
+    {
+        // keep the timestamps continuous and absorb the drift over the next interval
+        calibration.m_ullNanosBase = ullPredicted;
+        calibration.m_ullScale = static_cast<ULONGLONG>(dScale * (dInterval - static_cast<double>(llDrift)) / dInterval);
+    }
+    else
+    {
+        Log(logWARNING, "TSCClock: time stamp counter drifted by %llu ns, resetting the calibration\n", ullDrift);
+        calibration.m_ullNanosBase = ullNanos;
+        calibration.m_ullScale = static_cast<ULONGLONG>(dScale);
+    }
+
+    SetCalibration(calibration);
+}
+
+void TSCClock::LogStatistics() const
+{
+    Log(logMESSAGE, "TSCClock: %llu calibration checks, largest drift %llu ns\n", m_ullNumChecks, m_ullMaxDrift);
+}
+
+void TSCClock::SetCalibration(const TSCCalibration& calibration)
+{
+    int iNext = 1 - m_iActiveCalibration.load(memory_order_relaxed);
+    m_calibration[iNext] = calibration;
+    m_iActiveCalibration.store(iNext, memory_order_release);
+}
+
+ULONGLONG TSCClock::GetReferenceTimeNanos()
+{
+#ifdef _WIN32
+    static const double s_dInvFrequency = []()
+    {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        return 1.0 / freq.QuadPart * 1e9;
+    }();
+
+    LARGE_INTEGER current;
+    QueryPerformanceCounter(&current);
+    return static_cast<ULONGLONG>(static_cast<double>(current.QuadPart) * s_dInvFrequency);
+#else
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return static_cast<ULONGLONG>(tp.tv_sec) * (1000ULL * 1000ULL * 1000ULL) + static_cast<ULONGLONG>(tp.tv_nsec);
+#endif
+}
+
+void TSCClock::ReadClockPair(ULONGLONG& ullTSC, ULONGLONG& ullNanos)
+{
+    ULONGLONG ullBestWindow = ~0ULL;
+
+    for (int i = 0; i < TSC_CLOCK_PAIR_ATTEMPTS; i++)
+    {
+        ULONGLONG ullBefore = ReadTSC();
+        ULONGLONG ullReference = GetReferenceTimeNanos();
+        ULONGLONG ullAfter = ReadTSC();
+
+        if (ullAfter - ullBefore < ullBestWindow)
+        {
+            ullBestWindow = ullAfter - ullBefore;
+            ullTSC = ullBefore + ullBestWindow / 2;
+            ullNanos = ullReference;
+        }
+    }
+}
+
+bool TSCClock::IsInvariantTSC()
+{
+#if !defined(TSC_CLOCK_SUPPORTED)
+    return false;
+#elif defined(_WIN32)
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+
+    if (static_cast<unsigned int>(regs[0]) < 0x80000007)
+    {
+        return false;
+    }
+
+    __cpuid(regs, 0x80000007);
+    return 0 != (regs[3] & (1 << 8));
+#else
+    unsigned int eax;
+    unsigned int ebx;
+    unsigned int ecx;
+    unsigned int edx;
+
+    if (0 == __get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+    {
+        return false;
+    }
+
+    // CPUID.80000007H:EDX[8] is the invariant TSC flag
+    return 0 != __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && 0 != (edx & (1 << 8));
+#endif
+}
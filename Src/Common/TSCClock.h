@@ -0,0 +1,189 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class converts the CPU time stamp counter to nanoseconds in the
+///        time base of the default profiler clock.
+//==============================================================================
+
+#ifndef _TSC_CLOCK_H_
+#define _TSC_CLOCK_H_
+
+/// \defgroup TSCClock TSCClock
+/// This module implements the time stamp counter clock
+///
+/// \ingroup Common
+// @{
+
+#include <atomic>
+
+#include "Defs.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define TSC_CLOCK_SUPPORTED
+
+    #ifdef _WIN32
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+#endif
+
+/// Interval in ms between two checks of the calibration
+#define TSC_CLOCK_CHECK_INTERVAL 1000
+
+/// Time in ms between the two samples of the initial calibration
+#define TSC_CLOCK_CALIBRATION_TIME 20
+
+/// Number of fractional bits of the fixed point tick to ns factor
+#define TSC_CLOCK_SCALE_SHIFT 32
+
+/// Conversion from time stamp counter ticks to ns
+struct TSCCalibration
+{
+    ULONGLONG m_ullTSCBase;    ///< time stamp counter value of the reference point
+    ULONGLONG m_ullNanosBase;  ///< time in ns of the reference point
+    ULONGLONG m_ullScale;      ///< ns per tick, fixed point with TSC_CLOCK_SCALE_SHIFT fractional bits
+};
+
+//------------------------------------------------------------------------------------
+/// Clock reading the invariant time stamp counter (rdtsc), calibrated against the
+/// default clock (CLOCK_MONOTONIC or QueryPerformanceCounter) when it is enabled.
+/// CheckCalibration compares both clocks periodically and slews the conversion so the
+/// timestamps stay monotonic and converge back to the default clock.
+//------------------------------------------------------------------------------------
+class TSCClock
+{
+public:
+    /// Constructor
+    TSCClock();
+
+    /// Check that the time stamp counter is invariant and calibrate it
+    /// \return false if the time stamp counter can't be used, the default clock should be used instead
+    bool Init();
+
+    /// Get the current time
+    /// \return current time in ns, in the time base of the default clock
+    ULONGLONG GetTimeNanos() const
+    {
+        return ToNanos(ReadTSC());
+    }
+
+    /// Convert a time stamp counter value with the active calibration
+    /// \param ullTSC the time stamp counter value
+    /// \return the time in ns, in the time base of the default clock
+    ULONGLONG ToNanos(ULONGLONG ullTSC) const
+    {
+        const TSCCalibration& calibration = m_calibration[m_iActiveCalibration.load(std::memory_order_acquire)];
+        return Convert(calibration, ullTSC);
+    }
+
+    /// Compare the clock with the default clock and correct the drift, does nothing if the
+    /// previous check was less than TSC_CLOCK_CHECK_INTERVAL ago. Called by a single thread
+    void CheckCalibration();
+
+    /// Set the initial calibration from two samples of both clocks, called by Init
+    /// \param ullFirstTSC time stamp counter value of the first sample
+    /// \param ullFirstNanos default clock time of the first sample
+    /// \param ullTSC time stamp counter value of the second sample
+    /// \param ullNanos default clock time of the second sample
+    /// \return false if one of the clocks didn't advance between the samples
+    bool Calibrate(ULONGLONG ullFirstTSC, ULONGLONG ullFirstNanos, ULONGLONG ullTSC, ULONGLONG ullNanos);
+
+    /// Correct the drift from a sample of both clocks, called by CheckCalibration once per interval.
+    /// The conversion is slewed so that it matches the default clock at the end of the next interval
+    /// \param ullTSC time stamp counter value
+    /// \param ullNanos default clock time
+    void Recalibrate(ULONGLONG ullTSC, ULONGLONG ullNanos);
+
+    /// Get the largest drift seen by Recalibrate
+    /// \return the drift in ns
+    ULONGLONG GetMaxDrift() const { return m_ullMaxDrift; }
+
+    /// Log the calibration and the largest drift
+    void LogStatistics() const;
+
+    /// Read the default clock
+    /// \return current time in ns
+    static ULONGLONG GetReferenceTimeNanos();
+
+private:
+    /// Read the time stamp counter
+    /// \return the time stamp counter value
+    static ULONGLONG ReadTSC()
+    {
+#ifdef TSC_CLOCK_SUPPORTED
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    /// Convert a time stamp counter value to ns
+    /// \param calibration the conversion to use
+    /// \param ullTSC the time stamp counter value
+    /// \return the time in ns
+    static ULONGLONG Convert(const TSCCalibration& calibration, ULONGLONG ullTSC)
+    {
+        // the counters of the cores are synchronized, but a thread can read a value slightly older than the reference point
+        if (ullTSC >= calibration.m_ullTSCBase)
+        {
+            return calibration.m_ullNanosBase + Scale(ullTSC - calibration.m_ullTSCBase, calibration.m_ullScale);
+        }
+        else
+        {
+            return calibration.m_ullNanosBase - Scale(calibration.m_ullTSCBase - ullTSC, calibration.m_ullScale);
+        }
+    }
+
+    /// Multiply a number of ticks by a fixed point factor
+    /// \param ullTicks the number of ticks
+    /// \param ullScale ns per tick with TSC_CLOCK_SCALE_SHIFT fractional bits
+    /// \return the number of ns
+    static ULONGLONG Scale(ULONGLONG ullTicks, ULONGLONG ullScale)
+    {
+#if defined(_WIN32) && defined(_M_X64)
+        ULONGLONG ullHigh;
+        ULONGLONG ullLow = _umul128(ullTicks, ullScale, &ullHigh);
+        return (ullHigh << (64 - TSC_CLOCK_SCALE_SHIFT)) | (ullLow >> TSC_CLOCK_SCALE_SHIFT);
+#elif defined(_WIN32)
+        return static_cast<ULONGLONG>(static_cast<double>(ullTicks) * static_cast<double>(ullScale) / (1ULL << TSC_CLOCK_SCALE_SHIFT));
+#else
+        return static_cast<ULONGLONG>((static_cast<unsigned __int128>(ullTicks) * ullScale) >> TSC_CLOCK_SCALE_SHIFT);
+#endif
+    }
+
+    /// Read both clocks at (nearly) the same time
+    /// \param[out] ullTSC time stamp counter value
+    /// \param[out] ullNanos default clock time in ns
+    static void ReadClockPair(ULONGLONG& ullTSC, ULONGLONG& ullNanos);
+
+    /// Check whether the CPU has an invariant time stamp counter
+    /// \return true if the counter runs at a constant rate in all power states
+    static bool IsInvariantTSC();
+
+    /// Publish a new conversion
+    /// \param calibration the conversion
+    void SetCalibration(const TSCCalibration& calibration);
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    TSCClock(const TSCClock& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    TSCClock& operator=(const TSCClock& obj) = delete;
+
+    TSCCalibration   m_calibration[2];        ///< conversions, readers use the active one while the other one is updated
+    std::atomic<int> m_iActiveCalibration;    ///< index of the active conversion
+    ULONGLONG        m_ullFirstTSC;           ///< time stamp counter value of the initial calibration
+    ULONGLONG        m_ullFirstNanos;         ///< default clock time of the initial calibration
+    ULONGLONG        m_ullLastCheck;          ///< default clock time of the previous check
+    ULONGLONG        m_ullMaxDrift;           ///< largest difference in ns between both clocks seen by CheckCalibration
+    ULONGLONG        m_ullNumChecks;          ///< number of calibration checks
+};
+
+// @}
+
+#endif //_TSC_CLOCK_H_
@@ -0,0 +1,135 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class is a per-thread trace entry buffer. The owning thread appends
+///        entries without taking any lock; the timer thread drains them.
+//==============================================================================
+
+#include <new>
+
+#include "ThreadTraceBuffer.h"
+#include "TraceInfoManager.h"
+#include "Logger.h"
+
+using namespace GPULogger;
+
+ThreadTraceBuffer::ThreadTraceBuffer(osThreadId tid) :
+    m_tid(tid),
+    m_pHead(nullptr),
+    m_uiReadIndex(0),
+    m_pTail(nullptr),
+    m_pSpareChunk(nullptr),
+    m_numAppended(0),
+    m_numDrained(0),
+    m_uiRefCount(1),
+    m_bThreadExited(false)
+{
+    m_pTail = new(std::nothrow) Chunk();
+    m_pHead = m_pTail;
+}
+
+ThreadTraceBuffer::~ThreadTraceBuffer()
+{
+    std::list<ITraceEntry*> remaining;
+    Drain(remaining);
+
+    for (std::list<ITraceEntry*>::iterator it = remaining.begin(); it != remaining.end(); ++it)
+    {
+        ITraceEntry* item = *it;
+        SAFE_DELETE(item);
+    }
+
+    while (nullptr != m_pHead)
+    {
+        Chunk* pNext = m_pHead->m_pNext.load(std::memory_order_relaxed);
+        delete m_pHead;
+        m_pHead = pNext;
+    }
+
+    delete m_pSpareChunk.load(std::memory_order_relaxed);
+}
+
+bool ThreadTraceBuffer::Append(ITraceEntry* en)
+{
+    unsigned int uiCount = m_pTail->m_uiCount.load(std::memory_order_relaxed);
+
+    if (THREAD_TRACE_BUFFER_CHUNK_SIZE == uiCount)
+    {
+        // the consumer resets recycled chunks before handing them over
+        Chunk* pChunk = m_pSpareChunk.exchange(nullptr, std::memory_order_acquire);
+
+        if (nullptr == pChunk)
+        {
+            pChunk = new(std::nothrow) Chunk();
+
+            if (nullptr == pChunk)
+            {
+                Log(logERROR, "ThreadTraceBuffer: failed to allocate chunk, trace entry dropped\n");
+                SAFE_DELETE(en);
+                return false;
+            }
+        }
+
+        // After this store the current tail is never touched again by the producer
+        m_pTail->m_pNext.store(pChunk, std::memory_order_release);
+        m_pTail = pChunk;
+        uiCount = 0;
+    }
+
+    m_pTail->m_entries[uiCount] = en;
+    m_pTail->m_uiCount.store(uiCount + 1, std::memory_order_release);
+    m_numAppended++;
+    return true;
+}
+
+size_t ThreadTraceBuffer::Drain(std::list<ITraceEntry*>& entryList)
+{
+    size_t nDrained = 0;
+
+    while (nullptr != m_pHead)
+    {
+        unsigned int uiCount = m_pHead->m_uiCount.load(std::memory_order_acquire);
+
+        for (; m_uiReadIndex < uiCount; ++m_uiReadIndex)
+        {
+            entryList.push_back(m_pHead->m_entries[m_uiReadIndex]);
+            ++nDrained;
+        }
+
+        if (THREAD_TRACE_BUFFER_CHUNK_SIZE != m_uiReadIndex)
+        {
+            break;
+        }
+
+        Chunk* pNext = m_pHead->m_pNext.load(std::memory_order_acquire);
+
+        if (nullptr == pNext)
+        {
+            // chunk is full but the producer hasn't started the next one yet
+            break;
+        }
+
+        Chunk* pDrained = m_pHead;
+        m_pHead = pNext;
+        m_uiReadIndex = 0;
+        RecycleChunk(pDrained);
+    }
+
+    // only the consumer updates the drained count, the producer reads it to compute its fill level
+    m_numDrained.store(m_numDrained.load(std::memory_order_relaxed) + nDrained, std::memory_order_relaxed);
+    return nDrained;
+}
+
+void ThreadTraceBuffer::RecycleChunk(Chunk* pChunk)
+{
+    pChunk->m_uiCount.store(0, std::memory_order_relaxed);
+    pChunk->m_pNext.store(nullptr, std::memory_order_relaxed);
+
+    Chunk* pExpected = nullptr;
+
+    if (!m_pSpareChunk.compare_exchange_strong(pExpected, pChunk, std::memory_order_release, std::memory_order_relaxed))
+    {
+        delete pChunk;
+    }
+}
@@ -0,0 +1,118 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief This class is a per-thread trace entry buffer. The owning thread appends
+///        entries without taking any lock; the timer thread drains them.
+//==============================================================================
+
+#ifndef _THREAD_TRACE_BUFFER_H_
+#define _THREAD_TRACE_BUFFER_H_
+
+/// \defgroup ThreadTraceBuffer ThreadTraceBuffer
+/// This module implements the per-thread trace buffer used by TraceInfoManager
+///
+/// \ingroup Common
+// @{
+
+#include <list>
+#include <atomic>
+
+#include <AMDTOSWrappers/Include/osOSDefinitions.h>
+
+class ITraceEntry;
+
+/// Number of entries stored in one chunk of a ThreadTraceBuffer
+#define THREAD_TRACE_BUFFER_CHUNK_SIZE 256
+
+//------------------------------------------------------------------------------------
+/// Single producer/single consumer list of chunks.
+/// The producer fills the tail chunk and publishes each entry with a release store
+/// of the chunk's entry count. The consumer reads up to the published count and
+/// recycles a chunk once it is full and the producer has moved on to the next one.
+//------------------------------------------------------------------------------------
+class ThreadTraceBuffer
+{
+public:
+    /// Constructor
+    /// \param tid the thread that owns this buffer
+    explicit ThreadTraceBuffer(osThreadId tid);
+
+    /// Destructor, deletes the chunks and any entry that was not drained
+    ~ThreadTraceBuffer();
+
+    /// Check whether the buffer could allocate its first chunk
+    /// \return true if the buffer can be used
+    bool IsValid() const { return nullptr != m_pTail; }
+
+    /// Append an entry, called by the owning thread only
+    /// \param en the trace entry
+    /// \return false if a new chunk could not be allocated (the entry is deleted)
+    bool Append(ITraceEntry* en);
+
+    /// Move all published entries to the end of the specified list, called by one consumer at a time
+    /// \param entryList the list to append the entries to
+    /// \return number of entries moved
+    size_t Drain(std::list<ITraceEntry*>& entryList);
+
+    /// Get the number of entries appended but not drained yet, called by the owning thread only
+    /// \return number of pending entries
+    size_t GetNumPending() const { return m_numAppended - m_numDrained.load(std::memory_order_relaxed); }
+
+    /// Get the thread that owns this buffer
+    /// \return thread id
+    osThreadId GetThreadId() const { return m_tid; }
+
+    /// Add a reference to the buffer, taken by the per-thread cache of the owning thread
+    void AddRef() { m_uiRefCount.fetch_add(1, std::memory_order_relaxed); }
+
+    /// Release a reference to the buffer
+    /// \return true if it was the last reference, the caller then deletes the buffer
+    bool Release() { return 1 == m_uiRefCount.fetch_sub(1, std::memory_order_acq_rel); }
+
+    /// Called by the owning thread when it exits, it no longer appends entries afterwards
+    void SetThreadExited() { m_bThreadExited.store(true, std::memory_order_release); }
+
+    /// Check whether the owning thread has exited, once true the next Drain moves the last entries
+    /// \return true if the owning thread has exited
+    bool IsThreadExited() const { return m_bThreadExited.load(std::memory_order_acquire); }
+
+private:
+    /// Fixed size block of entries
+    struct Chunk
+    {
+        /// Constructor
+        Chunk() : m_uiCount(0), m_pNext(nullptr) {}
+
+        ITraceEntry* m_entries[THREAD_TRACE_BUFFER_CHUNK_SIZE]; ///< entry slots
+        std::atomic<unsigned int> m_uiCount;                     ///< number of published entries
+        std::atomic<Chunk*> m_pNext;                             ///< next chunk, set by the producer once this chunk is full
+    };
+
+    /// Hand a fully drained chunk back to the producer, or free it if a spare chunk is already available
+    /// \param pChunk the chunk
+    void RecycleChunk(Chunk* pChunk);
+
+    /// Disable copy constructor
+    /// \param obj the input object
+    ThreadTraceBuffer(const ThreadTraceBuffer& obj) = delete;
+
+    /// Disable assignment operator
+    /// \param obj the input object
+    /// \return a reference of the object
+    ThreadTraceBuffer& operator=(const ThreadTraceBuffer& obj) = delete;
+
+    osThreadId                m_tid;           ///< owning thread id
+    Chunk*                    m_pHead;         ///< oldest chunk that still holds undrained entries (consumer side)
+    unsigned int              m_uiReadIndex;   ///< next entry to drain in m_pHead (consumer side)
+    Chunk*                    m_pTail;         ///< chunk currently being filled (producer side)
+    std::atomic<Chunk*>       m_pSpareChunk;   ///< drained chunk handed back to the producer so that steady state appends don't allocate
+    size_t                    m_numAppended;   ///< number of entries appended (producer side)
+    std::atomic<size_t>       m_numDrained;    ///< number of entries drained (written by the consumer, read by the producer)
+    std::atomic<unsigned int> m_uiRefCount;    ///< number of references: the manager's list and the owning thread's cache
+    std::atomic<bool>         m_bThreadExited; ///< flag indicating that the owning thread has exited
+};
+
+// @}
+
+#endif //_THREAD_TRACE_BUFFER_H_
@@ -0,0 +1,259 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief Slab allocator used for API trace entry objects
+//==============================================================================
+
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <vector>
+
+#include "TraceEntryAllocator.h"
+#include "Logger.h"
+
+using namespace GPULogger;
+
+struct TraceEntrySlab;
+
+/// Header stored in front of every block
+struct alignas(16) TraceEntryBlockHeader
+{
+    TraceEntrySlab* m_pSlab;     ///< slab the block was carved from, nullptr for blocks allocated from the heap
+};
+
+/// A slab of equally sized blocks
+struct TraceEntrySlab
+{
+    std::atomic<unsigned int> m_uiRefCount;    ///< number of live blocks, plus one while an arena allocates from the slab
+    unsigned int              m_uiBlockSize;   ///< block size including the header
+    unsigned int              m_uiNumBlocks;   ///< number of blocks carved from the slab
+    char*                     m_pNextBlock;    ///< next free byte in m_data, only used by the owning arena
+    alignas(16) char          m_data[TRACE_ENTRY_SLAB_SIZE]; ///< block storage
+};
+
+/// Process-wide list of empty slabs and allocation counters
+struct TraceEntrySlabPool
+{
+    /// Constructor
+    TraceEntrySlabPool() :
+        m_ullBlocksFromSlabs(0),
+        m_ullBlocksFromHeap(0),
+        m_ullSlabsFromHeap(0),
+        m_ullSlabsReused(0),
+        m_ullSlabsReturnedToHeap(0)
+    {
+    }
+
+    std::mutex                         m_mtx;                     ///< mutex used to lock m_freeSlabs
+    std::vector<TraceEntrySlab*>       m_freeSlabs;               ///< empty slabs available for reuse
+    std::atomic<unsigned long long>    m_ullBlocksFromSlabs;      ///< number of blocks carved from retired slabs
+    std::atomic<unsigned long long>    m_ullBlocksFromHeap;       ///< number of blocks too large for any size class
+    std::atomic<unsigned long long>    m_ullSlabsFromHeap;        ///< number of slabs allocated from the heap
+    std::atomic<unsigned long long>    m_ullSlabsReused;          ///< number of slabs taken from m_freeSlabs
+    std::atomic<unsigned long long>    m_ullSlabsReturnedToHeap;  ///< number of empty slabs freed because m_freeSlabs was full
+};
+
+/// Get the slab pool. The pool is intentionally never destroyed so that blocks
+/// freed from static destructors and thread exit handlers still find it
+/// \return the slab pool
+static TraceEntrySlabPool* GetSlabPool()
+{
+    static TraceEntrySlabPool* s_pPool = new TraceEntrySlabPool();
+    return s_pPool;
+}
+
+/// Get an empty slab, from the pool if possible
+/// \param uiBlockSize the block size of the slab
+/// \return the slab (owned by the caller) or nullptr if out of memory
+static TraceEntrySlab* AcquireSlab(unsigned int uiBlockSize)
+{
+    TraceEntrySlabPool* pPool = GetSlabPool();
+    TraceEntrySlab* pSlab = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(pPool->m_mtx);
+
+        if (!pPool->m_freeSlabs.empty())
+        {
+            pSlab = pPool->m_freeSlabs.back();
+            pPool->m_freeSlabs.pop_back();
+        }
+    }
+
+    if (nullptr != pSlab)
+    {
+        pPool->m_ullSlabsReused++;
+    }
+    else
+    {
+        pSlab = new(std::nothrow) TraceEntrySlab();
+
+        if (nullptr == pSlab)
+        {
+            Log(logERROR, "TraceEntryAllocator: failed to allocate slab\n");
+            return nullptr;
+        }
+
+        pPool->m_ullSlabsFromHeap++;
+    }
+
+    pSlab->m_uiRefCount.store(1, std::memory_order_relaxed);
+    pSlab->m_uiBlockSize = uiBlockSize;
+    pSlab->m_uiNumBlocks = 0;
+    pSlab->m_pNextBlock = pSlab->m_data;
+    return pSlab;
+}
+
+/// Drop one reference to a slab, the last reference returns the slab to the pool
+/// \param pSlab the slab
+static void ReleaseSlab(TraceEntrySlab* pSlab)
+{
+    if (1 != pSlab->m_uiRefCount.fetch_sub(1, std::memory_order_acq_rel))
+    {
+        return;
+    }
+
+    TraceEntrySlabPool* pPool = GetSlabPool();
+
+    {
+        std::lock_guard<std::mutex> lock(pPool->m_mtx);
+
+        if (pPool->m_freeSlabs.size() < TRACE_ENTRY_MAX_FREE_SLABS)
+        {
+            pPool->m_freeSlabs.push_back(pSlab);
+            return;
+        }
+    }
+
+    pPool->m_ullSlabsReturnedToHeap++;
+    delete pSlab;
+}
+
+//------------------------------------------------------------------------------------
+/// Per-thread arena holding the slab currently used for each size class
+//------------------------------------------------------------------------------------
+class TraceEntryArena
+{
+public:
+    /// Constructor
+    TraceEntryArena()
+    {
+        for (int i = 0; i < TRACE_ENTRY_NUM_SIZE_CLASSES; i++)
+        {
+            m_pCurrentSlab[i] = nullptr;
+        }
+    }
+
+    /// Destructor, called on thread exit
+    ~TraceEntryArena()
+    {
+        for (int i = 0; i < TRACE_ENTRY_NUM_SIZE_CLASSES; i++)
+        {
+            RetireSlab(i);
+        }
+    }
+
+    /// Allocate a block
+    /// \param uiSizeClass the size class index
+    /// \return the block header or nullptr if out of memory
+    TraceEntryBlockHeader* Allocate(unsigned int uiSizeClass)
+    {
+        unsigned int uiBlockSize = (uiSizeClass + 1) * TRACE_ENTRY_SIZE_CLASS_GRANULARITY;
+        TraceEntrySlab* pSlab = m_pCurrentSlab[uiSizeClass];
+
+        if (nullptr == pSlab || pSlab->m_pNextBlock + uiBlockSize > pSlab->m_data + TRACE_ENTRY_SLAB_SIZE)
+        {
+            RetireSlab(uiSizeClass);
+            pSlab = AcquireSlab(uiBlockSize);
+
+            if (nullptr == pSlab)
+            {
+                return nullptr;
+            }
+
+            m_pCurrentSlab[uiSizeClass] = pSlab;
+        }
+
+        TraceEntryBlockHeader* pHeader = reinterpret_cast<TraceEntryBlockHeader*>(pSlab->m_pNextBlock);
+        pSlab->m_pNextBlock += uiBlockSize;
+        pSlab->m_uiNumBlocks++;
+        pSlab->m_uiRefCount.fetch_add(1, std::memory_order_relaxed);
+        pHeader->m_pSlab = pSlab;
+        return pHeader;
+    }
+
+private:
+    /// Stop allocating from the current slab of a size class and drop the arena's reference to it
+    /// \param uiSizeClass the size class index
+    void RetireSlab(unsigned int uiSizeClass)
+    {
+        TraceEntrySlab* pSlab = m_pCurrentSlab[uiSizeClass];
+
+        if (nullptr != pSlab)
+        {
+            m_pCurrentSlab[uiSizeClass] = nullptr;
+            GetSlabPool()->m_ullBlocksFromSlabs += pSlab->m_uiNumBlocks;
+            ReleaseSlab(pSlab);
+        }
+    }
+
+    TraceEntrySlab* m_pCurrentSlab[TRACE_ENTRY_NUM_SIZE_CLASSES]; ///< current slab of each size class
+};
+
+/// The calling thread's arena
+static thread_local TraceEntryArena s_arena;
+
+void* TraceEntryAllocator::Allocate(size_t size)
+{
+    size_t blockSize = size + sizeof(TraceEntryBlockHeader);
+    size_t sizeClass = (blockSize - 1) / TRACE_ENTRY_SIZE_CLASS_GRANULARITY;
+    TraceEntryBlockHeader* pHeader = nullptr;
+
+    if (sizeClass < TRACE_ENTRY_NUM_SIZE_CLASSES)
+    {
+        pHeader = s_arena.Allocate(static_cast<unsigned int>(sizeClass));
+    }
+    else
+    {
+        pHeader = static_cast<TraceEntryBlockHeader*>(::operator new(blockSize, std::nothrow));
+
+        if (nullptr != pHeader)
+        {
+            pHeader->m_pSlab = nullptr;
+            GetSlabPool()->m_ullBlocksFromHeap++;
+        }
+    }
+
+    return nullptr == pHeader ? nullptr : pHeader + 1;
+}
+
+void TraceEntryAllocator::Free(void* p)
+{
+    if (nullptr == p)
+    {
+        return;
+    }
+
+    TraceEntryBlockHeader* pHeader = static_cast<TraceEntryBlockHeader*>(p) - 1;
+
+    if (nullptr == pHeader->m_pSlab)
+    {
+        ::operator delete(pHeader);
+    }
+    else
+    {
+        ReleaseSlab(pHeader->m_pSlab);
+    }
+}
+
+void TraceEntryAllocator::LogStatistics()
+{
+    TraceEntrySlabPool* pPool = GetSlabPool();
+
+    Log(logMESSAGE, "TraceEntryAllocator: %llu blocks from retired slabs, %llu large blocks from heap\n",
+        pPool->m_ullBlocksFromSlabs.load(), pPool->m_ullBlocksFromHeap.load());
+    Log(logMESSAGE, "TraceEntryAllocator: %llu slabs allocated from heap, %llu slabs reused, %llu slabs returned to heap\n",
+        pPool->m_ullSlabsFromHeap.load(), pPool->m_ullSlabsReused.load(), pPool->m_ullSlabsReturnedToHeap.load());
+}
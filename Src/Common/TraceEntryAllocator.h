@@ -0,0 +1,60 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief Slab allocator used for API trace entry objects
+//==============================================================================
+
+#ifndef _TRACE_ENTRY_ALLOCATOR_H_
+#define _TRACE_ENTRY_ALLOCATOR_H_
+
+/// \defgroup TraceEntryAllocator TraceEntryAllocator
+/// This module provides per-thread, size-class slab arenas for trace entries
+///
+/// \ingroup Common
+// @{
+
+#include <cstddef>
+
+/// Size of one slab, in bytes
+#define TRACE_ENTRY_SLAB_SIZE (64 * 1024)
+
+/// Size class granularity, in bytes
+#define TRACE_ENTRY_SIZE_CLASS_GRANULARITY 64
+
+/// Number of size classes, blocks larger than the largest class are allocated from the heap
+#define TRACE_ENTRY_NUM_SIZE_CLASSES 16
+
+/// Maximum number of empty slabs kept for reuse, the rest are returned to the heap
+#define TRACE_ENTRY_MAX_FREE_SLABS 256
+
+//------------------------------------------------------------------------------------
+/// Allocates trace entries from per-thread slabs, one current slab per size class.
+/// Blocks are carved from a slab with a bump pointer and are never reused individually;
+/// the whole slab is recycled once the allocating thread has moved on to another slab
+/// and every block in it has been freed (typically after a flush deleted the entries).
+/// Blocks can be freed from any thread.
+//------------------------------------------------------------------------------------
+class TraceEntryAllocator
+{
+public:
+    /// Allocate a block
+    /// \param size size of the object
+    /// \return pointer to the block or nullptr if out of memory
+    static void* Allocate(size_t size);
+
+    /// Free a block returned by Allocate
+    /// \param p the block, can be nullptr
+    static void Free(void* p);
+
+    /// Write the allocation counters to the log file
+    static void LogStatistics();
+
+private:
+    /// Disable constructor, all members are static
+    TraceEntryAllocator() = delete;
+};
+
+// @}
+
+#endif //_TRACE_ENTRY_ALLOCATOR_H_
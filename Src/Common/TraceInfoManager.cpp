@@ -15,8 +15,14 @@
 #include <sstream>
 #include <iomanip>
 #include <mutex>
+#include <chrono>
+#include <cstring>
 #include <math.h>
 
+#if defined(_LINUX) || defined(LINUX)
+    #include <signal.h>
+#endif
+
 #include <AMDTOSWrappers/Include/osThread.h>
 
 #include "Defs.h"
@@ -28,11 +34,98 @@
 #include "OSUtils.h"
 #include "StackTracer.h"
 #include "ProfilerOutputFileDefs.h"
+#include "ThreadTraceBuffer.h"
 
 using namespace std;
+using namespace GPULogger;
+
+/// Trace buffers registered by the calling thread, indexed by TraceInfoManager::m_uiIndex and looked up without taking any lock.
+/// When the thread exits its buffers are flagged, the manager deletes them once their last entries have been drained
+struct ThreadTraceBufferCache
+{
+    /// Constructor
+    ThreadTraceBufferCache()
+    {
+        memset(m_pBuffers, 0, sizeof(m_pBuffers));
+    }
+
+    /// Destructor, called when the thread exits
+    ~ThreadTraceBufferCache()
+    {
+        for (unsigned int i = 0; i < TRACE_INFO_MANAGER_MAX_CACHED; i++)
+        {
+            if (nullptr != m_pBuffers[i])
+            {
+                m_pBuffers[i]->SetThreadExited();
+
+                // the manager has been destroyed and left the buffer to the thread
+                if (m_pBuffers[i]->Release())
+                {
+                    delete m_pBuffers[i];
+                }
+
+                m_pBuffers[i] = nullptr;
+            }
+        }
+    }
+
+    ThreadTraceBuffer* m_pBuffers[TRACE_INFO_MANAGER_MAX_CACHED]; ///< buffer of the calling thread for each manager
+};
+
+static thread_local ThreadTraceBufferCache s_threadTraceBufferCache;
+
+#if defined(_LINUX) || defined(LINUX)
+
+/// Signal that dumps the flight recorder windows
+#define FLIGHT_RECORDER_DUMP_SIGNAL SIGUSR2
+
+/// Signal handler requesting a flight recorder dump
+/// \param sig the signal number
+static void FlightRecorderSignalHandler(int sig)
+{
+    SP_UNREFERENCED_PARAMETER(sig);
+    TraceInfoManager::TriggerFlightRecorderDump();
+}
+
+/// Install the flight recorder signal handler, unless the application already handles the signal
+static void InstallFlightRecorderSignalHandler()
+{
+    struct sigaction oldAction;
+
+    if (0 != sigaction(FLIGHT_RECORDER_DUMP_SIGNAL, nullptr, &oldAction) ||
+        0 != (oldAction.sa_flags & SA_SIGINFO) ||
+        SIG_DFL != oldAction.sa_handler)
+    {
+        Log(logWARNING, "Flight recorder: signal %d is handled by the application, the window can't be dumped with a signal\n", FLIGHT_RECORDER_DUMP_SIGNAL);
+        return;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = FlightRecorderSignalHandler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    if (0 == sigaction(FLIGHT_RECORDER_DUMP_SIGNAL, &action, nullptr))
+    {
+        Log(logMESSAGE, "Flight recorder: send signal %d to process %d to dump the trace window\n", FLIGHT_RECORDER_DUMP_SIGNAL, static_cast<int>(osGetCurrentProcessId()));
+    }
+}
+
+#endif
+
+/// Get the current time used by the flight recorder windows
+/// \return time in ms
+static unsigned long long GetFlightRecorderTime()
+{
+    return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
 
 std::string ITraceEntry::s_strParamSeparator = ATP_TRACE_ENTRY_ARG_SEPARATOR;
 
+std::atomic<unsigned int> TraceInfoManager::ms_uiFlightRecorderTriggers(0);
+std::atomic<unsigned int> TraceInfoManager::ms_uiNumManagers(0);
+
 TraceInfoManager::TraceInfoManager(void) :
     m_iActiveMap(0),
     m_bTimeOutMode(false),
@@ -41,17 +134,41 @@ TraceInfoManager::TraceInfoManager(void) :
     m_cListSeparator(LocaleSetting::GetListSeparator()),
     m_tidTimer(0),
     m_bStopped(false),
-    m_timerFunc(nullptr)
+    m_timerFunc(nullptr),
+    m_bFlushRequested(false),
+    m_llPendingEntries(0),
+    m_bDropEntries(false),
+    m_ullDroppedEntries(0),
+    m_ullDelayedEntries(0),
+    m_ullWatermarkFlushes(0),
+    m_ullDeadlineFlushes(0),
+    m_uiFlightRecorderDumps(0),
+    m_ullEvictedEntries(0),
+    m_uiIndex(ms_uiNumManagers.fetch_add(1)),
+    m_bCacheOverflowLogged(false)
 {
 }
 
 TraceInfoManager::~TraceInfoManager(void)
 {
+    std::lock_guard<std::mutex> lock(m_mtxThreadTraceBuffers);
+
+    for (ThreadTraceBufferList::iterator it = m_threadTraceBuffers.begin(); it != m_threadTraceBuffers.end(); ++it)
+    {
+        // a buffer still cached by a running thread is deleted by the thread when it exits
+        if ((*it)->Release())
+        {
+            delete *it;
+        }
+    }
+
+    m_threadTraceBuffers.clear();
 }
 
 void TraceInfoManager::TrySwapBuffer()
 {
     // If nonActive map has pending entries, don't swap buffer
+    // New entries stay in the active map and the per-thread buffers, where they count towards the pending entry limit
     TraceInfoMap& nonActiveMap = m_TraceInfoMap[ 1 - m_iActiveMap ];
 
     for (TraceInfoMap::iterator mapIt = nonActiveMap.begin(); mapIt != nonActiveMap.end(); mapIt++)
@@ -62,24 +179,192 @@ void TraceInfoManager::TrySwapBuffer()
         }
     }
 
-    m_mtx.lock();
-    m_iActiveMap = 1 - m_iActiveMap;
-    m_mtx.unlock();
+    size_t numEntries = 0;
+
+    {
+        // lock m_mtxTracemap as well so that no thread is adding to the map being swapped out
+        std::lock_guard<std::mutex> lock(m_mtxTracemap);
+
+        m_mtx.lock();
+        m_iActiveMap = 1 - m_iActiveMap;
+        m_mtx.unlock();
+
+        TraceInfoMap& swappedMap = m_TraceInfoMap[ 1 - m_iActiveMap ];
+
+        for (TraceInfoMap::iterator mapIt = swappedMap.begin(); mapIt != swappedMap.end(); mapIt++)
+        {
+            numEntries += mapIt->second.size();
+        }
+    }
+
+    // Entries in the per-thread buffers are not in the active map yet, move them directly to the map to be flushed
+    numEntries += DrainThreadTraceBuffers(m_TraceInfoMap[ 1 - m_iActiveMap ]);
+
+    long long llPendingEntries = m_llPendingEntries.fetch_sub(static_cast<long long>(numEntries), std::memory_order_relaxed) - static_cast<long long>(numEntries);
+
+    if (m_bDropEntries.load(std::memory_order_relaxed) &&
+        llPendingEntries <= static_cast<long long>(GlobalSettings::GetInstance()->m_params.m_uiMaxPendingTraceEntries / 2))
+    {
+        m_bDropEntries = false;
+        Log(logMESSAGE, "TraceInfoManager: pending entries flushed, resume recording (%llu entries dropped so far)\n", m_ullDroppedEntries.load());
+    }
+
+    if (IsFlightRecorderMode())
+    {
+        UpdateFlightRecorderWindows(m_TraceInfoMap[ 1 - m_iActiveMap ]);
+    }
+}
+
+bool TraceInfoManager::IsFlightRecorderMode() const
+{
+    const Parameters& params = GlobalSettings::GetInstance()->m_params;
+    return m_bTimeOutMode && (0 != params.m_uiFlightRecorderEntries || 0 != params.m_uiFlightRecorderSeconds);
+}
+
+void TraceInfoManager::TriggerFlightRecorderDump()
+{
+    ms_uiFlightRecorderTriggers.fetch_add(1);
+}
+
+void TraceInfoManager::UpdateFlightRecorderWindows(TraceInfoMap& traceInfoMap)
+{
+    unsigned long long ullNow = GetFlightRecorderTime();
+
+    for (TraceInfoMap::iterator mapIt = traceInfoMap.begin(); mapIt != traceInfoMap.end(); ++mapIt)
+    {
+        if (mapIt->second.empty())
+        {
+            continue;
+        }
+
+        FlightRecorderWindow& window = m_flightRecorderWindows[mapIt->first];
+        FlightRecorderBatch batch;
+        batch.m_ullTime = ullNow;
+        batch.m_numEntries = mapIt->second.size();
+        window.m_batches.push_back(batch);
+        window.m_entries.splice(window.m_entries.end(), mapIt->second);
+    }
+
+    unsigned int uiTriggers = ms_uiFlightRecorderTriggers.load();
+
+    if (uiTriggers != m_uiFlightRecorderDumps)
+    {
+        // hand the windows to FlushTraceData, they are merged into the .atp file like regular fragments
+        size_t numEntries = 0;
+
+        for (FlightRecorderWindowMap::iterator it = m_flightRecorderWindows.begin(); it != m_flightRecorderWindows.end(); ++it)
+        {
+            numEntries += it->second.m_entries.size();
+            list<ITraceEntry*>& threadEntries = traceInfoMap[it->first];
+            threadEntries.splice(threadEntries.end(), it->second.m_entries);
+        }
+
+        m_flightRecorderWindows.clear();
+        m_uiFlightRecorderDumps = uiTriggers;
+        Log(logMESSAGE, "Flight recorder: dumping %llu entries\n", static_cast<unsigned long long>(numEntries));
+        return;
+    }
+
+    for (FlightRecorderWindowMap::iterator it = m_flightRecorderWindows.begin(); it != m_flightRecorderWindows.end(); ++it)
+    {
+        EvictFlightRecorderEntries(it->first, it->second, ullNow);
+    }
+}
+
+void TraceInfoManager::EvictFlightRecorderEntries(osThreadId tid, FlightRecorderWindow& window, unsigned long long ullNow)
+{
+    const Parameters& params = GlobalSettings::GetInstance()->m_params;
+    size_t maxEntries = params.m_uiFlightRecorderEntries;
+    unsigned long long ullMaxAge = params.m_uiFlightRecorderSeconds * 1000ULL;
+
+    while (!window.m_entries.empty())
+    {
+        FlightRecorderBatch& batch = window.m_batches.front();
+        bool bTooMany = 0 != maxEntries && window.m_entries.size() > maxEntries;
+        bool bTooOld = 0 != ullMaxAge && ullNow - batch.m_ullTime > ullMaxAge;
+
+        if (!bTooMany && !bTooOld)
+        {
+            break;
+        }
+
+        if (!ReleaseEvictedEntry(tid, window.m_entries.front()))
+        {
+            break;
+        }
+
+        window.m_entries.pop_front();
+        m_ullEvictedEntries++;
+
+        if (0 == --batch.m_numEntries)
+        {
+            window.m_batches.pop_front();
+        }
+    }
+}
+
+bool TraceInfoManager::ReleaseEvictedEntry(osThreadId tid, ITraceEntry* en)
+{
+    SP_UNREFERENCED_PARAMETER(tid);
+    SAFE_DELETE(en);
+    return true;
+}
+
+void TraceInfoManager::ReleaseFlightRecorderWindows(TraceInfoMap& traceInfoMap)
+{
+    if (!IsFlightRecorderMode())
+    {
+        return;
+    }
+
+    for (FlightRecorderWindowMap::iterator it = m_flightRecorderWindows.begin(); it != m_flightRecorderWindows.end(); ++it)
+    {
+        list<ITraceEntry*>& threadEntries = traceInfoMap[it->first];
+        threadEntries.splice(threadEntries.end(), it->second.m_entries);
+    }
+
+    m_flightRecorderWindows.clear();
+
+    Log(logMESSAGE, "Flight recorder: %u dumps, %llu entries dropped from the windows\n", m_uiFlightRecorderDumps, m_ullEvictedEntries);
 }
 
 bool TraceInfoManager::StartTimer(TimerFunc timerFunc)
 {
     m_timerFunc = timerFunc;
-    return ResumeTimer();
+    m_fragmentWriters.SetBufferSize(GlobalSettings::GetInstance()->m_params.m_uiFragmentBufferSize * 1024);
+    m_fragmentWriters.SetCompression(GlobalSettings::GetInstance()->m_params.m_bCompressOutput);
+    bool retVal = ResumeTimer();
+
+#if defined(_LINUX) || defined(LINUX)
+
+    if (IsFlightRecorderMode())
+    {
+        static std::once_flag signalHandlerFlag;
+        std::call_once(signalHandlerFlag, InstallFlightRecorderSignalHandler);
+    }
+
+#endif
+
+    return retVal;
 }
 
 void TraceInfoManager::StopTimer()
 {
     std::lock_guard<std::mutex> lock(m_mtxStopResume);
 
-    m_bIsRunning = false;
+    {
+        // wake the timer thread if it is waiting in WaitForFlush
+        std::lock_guard<std::mutex> lockRequest(m_mtxFlushRequest);
+        m_bIsRunning = false;
+    }
+
+    m_cvFlushRequest.notify_all();
     OSUtils::Instance()->Join(m_tidTimer);
     m_tidTimer = 0;
+
+    // Flushes done while the timer is stopped close their files when they are done
+    std::lock_guard<std::mutex> lockFlush(m_mtxFlush);
+    m_fragmentWriters.CloseAll();
 }
 
 bool TraceInfoManager::ResumeTimer()
@@ -103,8 +388,138 @@ bool TraceInfoManager::ResumeTimer()
     return retVal;
 }
 
+bool TraceInfoManager::WaitForFlush()
+{
+    // safety net in case interval is zero (it shouldn't be...)
+    unsigned int interval = 0 == m_uiInterval ? 1 : m_uiInterval;
+
+    std::unique_lock<std::mutex> lock(m_mtxFlushRequest);
+
+    bool bRequested = m_cvFlushRequest.wait_for(lock, std::chrono::milliseconds(interval), [this]()
+    {
+        return m_bFlushRequested.load() || !m_bIsRunning;
+    });
+
+    m_bFlushRequested = false;
+
+    if (!m_bIsRunning)
+    {
+        return false;
+    }
+
+    if (bRequested)
+    {
+        m_ullWatermarkFlushes++;
+    }
+    else
+    {
+        m_ullDeadlineFlushes++;
+    }
+
+    lock.unlock();
+
+    // the timer thread is the only caller, it keeps the time stamp counter timer in sync with the default timer
+    OSUtils::Instance()->CheckTSCTimerCalibration();
+
+    return true;
+}
+
+void TraceInfoManager::RequestFlush()
+{
+    // only the first request since the last flush needs to wake the timer thread
+    if (!m_bFlushRequested.exchange(true))
+    {
+        std::lock_guard<std::mutex> lock(m_mtxFlushRequest);
+        m_cvFlushRequest.notify_one();
+    }
+}
+
+bool TraceInfoManager::CheckPendingEntryLimit()
+{
+    long long llMaxPending = static_cast<long long>(GlobalSettings::GetInstance()->m_params.m_uiMaxPendingTraceEntries);
+
+    // the limit only applies while the timer thread is flushing the entries
+    if (0 == llMaxPending || !m_bTimeOutMode || !m_bIsRunning)
+    {
+        return true;
+    }
+
+    if (!m_bDropEntries.load(std::memory_order_relaxed))
+    {
+        if (m_llPendingEntries.load(std::memory_order_relaxed) < llMaxPending)
+        {
+            return true;
+        }
+
+        unsigned int uiTimeout = GlobalSettings::GetInstance()->m_params.m_uiBackpressureTimeout;
+
+        if (uiTimeout > 0)
+        {
+            m_ullDelayedEntries++;
+            RequestFlush();
+
+            for (unsigned int i = 0; i < uiTimeout && m_bIsRunning; i++)
+            {
+                OSUtils::Instance()->SleepMillisecond(1);
+
+                if (m_llPendingEntries.load(std::memory_order_relaxed) < llMaxPending)
+                {
+                    return true;
+                }
+            }
+        }
+
+        // the timer thread can't keep up (or the non-active map can't be flushed yet), stop recording until it catches up
+        if (!m_bDropEntries.exchange(true))
+        {
+            Log(logWARNING, "TraceInfoManager: %lld entries waiting to be flushed, dropping new entries\n", m_llPendingEntries.load());
+        }
+    }
+
+    m_ullDroppedEntries++;
+    return false;
+}
+
+void TraceInfoManager::OnEntryAdded(size_t numThreadEntries)
+{
+    m_llPendingEntries.fetch_add(1, std::memory_order_relaxed);
+
+    unsigned int uiWatermark = GlobalSettings::GetInstance()->m_params.m_uiFlushWatermark;
+
+    // the thread's count only grows by one at a time, so each time it crosses the watermark a single request is made
+    if (m_bTimeOutMode && 0 != uiWatermark && numThreadEntries == uiWatermark)
+    {
+        RequestFlush();
+    }
+}
+
 void TraceInfoManager::AddTraceInfoEntry(ITraceEntry* en)
 {
+    if (GlobalSettings::GetInstance()->m_params.m_bThreadTraceBuffer)
+    {
+        if (m_bStopped.load(std::memory_order_relaxed))
+        {
+            SAFE_DELETE(en);
+            return;
+        }
+
+        en->m_tid = osGetUniqueCurrentThreadId();
+
+        ThreadTraceBuffer* pBuffer = GetThreadTraceBuffer(en->m_tid);
+
+        if (nullptr != pBuffer)
+        {
+            if (pBuffer->Append(en))
+            {
+                OnEntryAdded(pBuffer->GetNumPending());
+            }
+
+            return;
+        }
+
+        // the buffer could not be allocated, fall back to the shared map
+    }
+
     // lock access to m_TraceInfoMap
     std::lock_guard<std::mutex> lock(m_mtxTracemap);
 
@@ -136,12 +551,140 @@ void TraceInfoManager::AddTraceInfoEntry(ITraceEntry* en)
     {
         std::list<ITraceEntry*> list;
         list.push_back(en);
-        activeMap->insert(TraceInfoMapPair(en->m_tid, list));
+        it = activeMap->insert(TraceInfoMapPair(en->m_tid, list)).first;
+    }
+
+    OnEntryAdded(it->second.size());
+}
+
+ThreadTraceBuffer* TraceInfoManager::GetThreadTraceBuffer(osThreadId tid)
+{
+    bool bCached = TRACE_INFO_MANAGER_MAX_CACHED > m_uiIndex;
+
+    if (bCached && nullptr != s_threadTraceBufferCache.m_pBuffers[m_uiIndex])
+    {
+        return s_threadTraceBufferCache.m_pBuffers[m_uiIndex];
+    }
+
+    if (!bCached && !m_bCacheOverflowLogged.exchange(true))
+    {
+        Log(logWARNING, "TraceInfoManager: more than %u managers, the per-thread buffers of manager %u are looked up under a lock\n", TRACE_INFO_MANAGER_MAX_CACHED, m_uiIndex);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mtxThreadTraceBuffers);
+
+    if (!bCached)
+    {
+        // the buffers found by thread id are never flagged as exited, they are deleted with the manager
+        for (ThreadTraceBufferList::iterator it = m_threadTraceBuffers.begin(); it != m_threadTraceBuffers.end(); ++it)
+        {
+            if ((*it)->GetThreadId() == tid)
+            {
+                return *it;
+            }
+        }
+    }
+
+    ThreadTraceBuffer* pBuffer = new(nothrow) ThreadTraceBuffer(tid);
+
+    if (nullptr != pBuffer && !pBuffer->IsValid())
+    {
+        SAFE_DELETE(pBuffer);
+    }
+
+    if (nullptr == pBuffer)
+    {
+        return nullptr;
+    }
+
+    m_threadTraceBuffers.push_back(pBuffer);
+
+    if (bCached)
+    {
+        pBuffer->AddRef();
+        s_threadTraceBufferCache.m_pBuffers[m_uiIndex] = pBuffer;
+    }
+
+    return pBuffer;
+}
+
+size_t TraceInfoManager::DrainThreadTraceBuffers(TraceInfoMap& traceInfoMap)
+{
+    std::lock_guard<std::mutex> lock(m_mtxThreadTraceBuffers);
+    size_t numEntries = 0;
+
+    for (ThreadTraceBufferList::iterator it = m_threadTraceBuffers.begin(); it != m_threadTraceBuffers.end();)
+    {
+        ThreadTraceBuffer* pBuffer = *it;
+        list<ITraceEntry*> entries;
+
+        // checked before draining: the entries appended before the thread exited are all drained below
+        bool bThreadExited = pBuffer->IsThreadExited();
+        size_t numDrained = pBuffer->Drain(entries);
+
+        if (numDrained > 0)
+        {
+            // only add threads that have entries, each list in the map produces fragment files
+            list<ITraceEntry*>& threadEntries = traceInfoMap[pBuffer->GetThreadId()];
+            threadEntries.splice(threadEntries.end(), entries);
+            numEntries += numDrained;
+        }
+
+        if (bThreadExited)
+        {
+            // retire the buffer so that the list only holds the buffers of the running threads
+            it = m_threadTraceBuffers.erase(it);
+
+            if (pBuffer->Release())
+            {
+                delete pBuffer;
+            }
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    return numEntries;
+}
+
+void TraceInfoManager::ReportDroppedEntries()
+{
+    m_llPendingEntries = 0;
+
+    if (!m_bTimeOutMode)
+    {
+        return;
+    }
+
+    Log(logMESSAGE, "TraceInfoManager: %llu flushes triggered by the watermark, %llu by the timer interval\n", m_ullWatermarkFlushes, m_ullDeadlineFlushes);
+
+    unsigned long long ullDropped = m_ullDroppedEntries.exchange(0);
+
+    if (m_ullDelayedEntries > 0 || ullDropped > 0)
+    {
+        Log(logWARNING, "TraceInfoManager: %llu waits for the timer thread, %llu entries dropped because %u entries were waiting to be flushed\n",
+            m_ullDelayedEntries.load(), ullDropped, GlobalSettings::GetInstance()->m_params.m_uiMaxPendingTraceEntries);
+    }
+
+    if (ullDropped > 0)
+    {
+        cout << "Warning: " << ullDropped << " trace entries were dropped because the profiler could not write them to disk fast enough." << endl;
     }
 }
 
 void TraceInfoManager::Release()
 {
+    m_mtxFlush.lock();
+    m_fragmentWriters.CloseAll();
+    m_mtxFlush.unlock();
+
+    ReportDroppedEntries();
+
+    DrainThreadTraceBuffers(m_TraceInfoMap[0]);
+    ReleaseFlightRecorderWindows(m_TraceInfoMap[0]);
+
     for (int i = 0; i < 2; i++)
     {
         for (TraceInfoMap::iterator mapIt = m_TraceInfoMap[i].begin(); mapIt != m_TraceInfoMap[i].end(); mapIt++)
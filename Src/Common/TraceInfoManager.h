@@ -20,7 +20,10 @@
 #include <list>
 #include <map>
 #include <set>
+#include <deque>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 #include <AMDTOSWrappers/Include/osOSDefinitions.h>
 
@@ -28,6 +31,12 @@
 #include "OSUtils.h"
 #include "LocaleSetting.h"
 #include "StackTracer.h"
+#include "FragmentWriterCache.h"
+
+class ThreadTraceBuffer;
+
+/// Number of managers whose per-thread trace buffers are cached by each thread, the trace agents create a few managers each
+#define TRACE_INFO_MANAGER_MAX_CACHED 16
 
 /// Timer function definition
 typedef void (*TimerFunc)(void* param);
@@ -68,6 +77,7 @@ private:
 
 typedef std::map<osThreadId, std::list<ITraceEntry*> > TraceInfoMap;
 typedef std::pair<osThreadId, std::list<ITraceEntry*> > TraceInfoMapPair;
+typedef std::list<ThreadTraceBuffer*> ThreadTraceBufferList;
 
 //------------------------------------------------------------------------------------
 /// TraceInfoManager manages captured apis, events and so on
@@ -94,11 +104,37 @@ public:
     bool StartTimer(TimerFunc timerFunc);
 
     /// Stop timer, call Join to make main thread wait till all I/O are finished
+    /// The fragment files kept open by the timer thread are closed
     void StopTimer();
 
+    /// Called by the timer thread between flushes, waits until a thread has accumulated
+    /// m_uiFlushWatermark pending entries or until the timer interval expires
+    /// \return false if the timer has been stopped
+    bool WaitForFlush();
+
+    /// Wake the timer thread before the timer interval expires
+    void RequestFlush();
+
+    /// Check the limit on the number of entries waiting to be flushed (timeout mode only).
+    /// Once the limit is reached the calling thread waits for the timer thread for up to
+    /// m_uiBackpressureTimeout ms; if the timer thread doesn't catch up, entries are dropped
+    /// until half of the pending entries have been flushed. Only managers whose entries
+    /// are not referenced after being added can drop them, so this is called by the subclasses.
+    /// \return true if the entry can be added, false if the caller should drop it (the drop is counted)
+    bool CheckPendingEntryLimit();
+
     /// Recreates the timer thread after a call to StopTimer
     bool ResumeTimer();
 
+    /// Check whether entries are kept in the flight recorder windows instead of being flushed,
+    /// see m_uiFlightRecorderEntries and m_uiFlightRecorderSeconds (timeout mode only)
+    /// \return true in flight recorder mode
+    bool IsFlightRecorderMode() const;
+
+    /// Request the flight recorder windows of all managers to be written out at their next TrySwapBuffer.
+    /// Only updates an atomic counter, so it can be called from a signal handler
+    static void TriggerFlightRecorderDump();
+
     /// Is it in time out mode
     /// \return true if it is in timer mode
     bool IsTimeOutMode() const
@@ -125,19 +161,20 @@ public:
     /// Try swap active map and non-active map
     /// Active map is the one api entry being stored into
     /// Non-active map is the one to be flushed to disk
+    /// Entries in the per-thread trace buffers are first moved to the non-active map
     /// If non-active map has remaining entries, don't swap maps
     /// else, swap atomically
     void TrySwapBuffer();
 
     /// Stop tracing
-    void StopTracing() { m_bStopped = true; }
+    void StopTracing() { m_bStopped.store(true, std::memory_order_relaxed); }
 
     /// Resume tracing
-    void ResumeTracing() { m_bStopped = false; }
+    void ResumeTracing() { m_bStopped.store(false, std::memory_order_relaxed); }
 
     /// Check whether we are currently tracing
     /// \return true if we are tracing, false otehrwise
-    bool IsTracing() const { return m_bStopped == false; }
+    bool IsTracing() const { return !m_bStopped.load(std::memory_order_relaxed); }
 
 protected:
     /// Disable copy constructor
@@ -149,6 +186,73 @@ protected:
     /// \return lhs
     TraceInfoManager& operator = (const TraceInfoManager& obj) = delete;
 
+    /// Move the entries of all per-thread trace buffers to the specified map.
+    /// The buffers of the threads that have exited are deleted once drained
+    /// \param traceInfoMap the map to add the entries to
+    /// \return number of entries moved
+    size_t DrainThreadTraceBuffers(TraceInfoMap& traceInfoMap);
+
+    /// Get the number of entries added and not yet handed to FlushTraceData
+    /// \return the number of pending entries
+    long long GetNumPendingEntries() const { return m_llPendingEntries.load(std::memory_order_relaxed); }
+
+    /// Count entries removed from the trace maps by the subclasses
+    /// \param numEntries the number of entries
+    void RemovePendingEntries(size_t numEntries) { m_llPendingEntries.fetch_sub(static_cast<long long>(numEntries), std::memory_order_relaxed); }
+
+    /// Called by Release: log the flush scheduler and dropped entry counters, warn the user
+    /// if entries were dropped and reset the pending entry count
+    void ReportDroppedEntries();
+
+    /// Called by Release: move the entries left in the flight recorder windows (recorded after the
+    /// last dump) to the specified map so that they are freed with the other entries
+    /// \param traceInfoMap the map to add the entries to
+    void ReleaseFlightRecorderWindows(TraceInfoMap& traceInfoMap);
+
+    /// Called when the flight recorder drops the oldest entry of a thread's window
+    /// \param tid the thread id
+    /// \param en the entry
+    /// \return false if the entry is still referenced and can't be dropped yet, the window then keeps it and all newer entries
+    virtual bool ReleaseEvictedEntry(osThreadId tid, ITraceEntry* en);
+
+private:
+    /// Entries added to a flight recorder window by one TrySwapBuffer call
+    struct FlightRecorderBatch
+    {
+        unsigned long long m_ullTime;     ///< time in ms at which the entries were added to the window
+        size_t             m_numEntries;  ///< number of entries of the batch still in the window
+    };
+
+    /// Most recent entries of a thread, oldest first
+    struct FlightRecorderWindow
+    {
+        std::list<ITraceEntry*>         m_entries;  ///< entries
+        std::deque<FlightRecorderBatch> m_batches;  ///< batches the entries were added in, used for time based eviction
+    };
+
+    typedef std::map<osThreadId, FlightRecorderWindow> FlightRecorderWindowMap;
+
+    /// Called by TrySwapBuffer in flight recorder mode: move the swapped entries to the windows and drop the
+    /// oldest ones, or move the windows back to the swapped map if a dump was triggered
+    /// \param traceInfoMap the map swapped out for flushing
+    void UpdateFlightRecorderWindows(TraceInfoMap& traceInfoMap);
+
+    /// Drop the oldest entries of a window until it holds at most m_uiFlightRecorderEntries entries
+    /// and no entry older than m_uiFlightRecorderSeconds
+    /// \param tid the thread id
+    /// \param window the window
+    /// \param ullNow current time in ms
+    void EvictFlightRecorderEntries(osThreadId tid, FlightRecorderWindow& window, unsigned long long ullNow);
+
+    /// Get the trace buffer of the calling thread, registering a new one if needed
+    /// \param tid the calling thread id
+    /// \return the trace buffer or nullptr if it could not be created
+    ThreadTraceBuffer* GetThreadTraceBuffer(osThreadId tid);
+
+    /// Count an added entry and wake the timer thread if the adding thread reached the flush watermark
+    /// \param numThreadEntries number of pending entries of the adding thread, including the new one
+    void OnEntryAdded(size_t numThreadEntries);
+
 protected:
     TraceInfoMap m_TraceInfoMap[2];     ///< stl map that maintains all captured apis
     int m_iActiveMap;                   ///< active map index
@@ -161,8 +265,30 @@ protected:
     unsigned int m_uiInterval;          ///< Timer interval
     char m_cListSeparator;              ///< the list separator for the current locale
     THREADHANDLE m_tidTimer;            ///< ThreadID of timer thread
-    bool m_bStopped;                    ///< A flag indicating whether trace is stopped or not
+    std::atomic<bool> m_bStopped;       ///< A flag indicating whether trace is stopped or not, read without lock by the threads adding entries
     TimerFunc m_timerFunc;              ///< The timer function used for flushing data
+    FragmentWriterCache m_fragmentWriters; ///< fragment files kept open between flushes, locked by m_mtxFlush
+
+private:
+    ThreadTraceBufferList m_threadTraceBuffers; ///< per-thread trace buffers registered with this manager
+    std::mutex m_mtxThreadTraceBuffers;         ///< mutex used to lock m_threadTraceBuffers and serialize draining
+    std::mutex m_mtxFlushRequest;               ///< mutex used with m_cvFlushRequest, also protects the m_bIsRunning update in StopTimer
+    std::condition_variable m_cvFlushRequest;   ///< signaled when a flush is requested or the timer is stopped
+    std::atomic<bool> m_bFlushRequested;        ///< flag indicating that a thread reached the flush watermark since the last flush
+    std::atomic<long long> m_llPendingEntries;  ///< number of entries added and not yet handed to FlushTraceData
+    std::atomic<bool> m_bDropEntries;           ///< flag indicating that the pending entry limit was reached and the timer thread couldn't catch up
+    std::atomic<unsigned long long> m_ullDroppedEntries;  ///< number of entries dropped because of the pending entry limit
+    std::atomic<unsigned long long> m_ullDelayedEntries;  ///< number of times a thread waited for the timer thread because of the pending entry limit
+    unsigned long long m_ullWatermarkFlushes;   ///< number of flushes triggered by the watermark, only used by the timer thread
+    unsigned long long m_ullDeadlineFlushes;    ///< number of flushes triggered by the timer interval, only used by the timer thread
+    FlightRecorderWindowMap m_flightRecorderWindows; ///< per-thread windows of the most recent entries, only used by the thread calling TrySwapBuffer
+    unsigned int m_uiFlightRecorderDumps;       ///< value of ms_uiFlightRecorderTriggers when the windows were last dumped
+    unsigned long long m_ullEvictedEntries;     ///< number of entries dropped from the flight recorder windows
+    const unsigned int m_uiIndex;               ///< index of the manager in the per-thread buffer caches, the buffers of the managers above TRACE_INFO_MANAGER_MAX_CACHED are looked up under m_mtxThreadTraceBuffers
+    std::atomic<bool> m_bCacheOverflowLogged;   ///< flag indicating that the per-thread buffer cache overflow has been logged
+
+    static std::atomic<unsigned int> ms_uiFlightRecorderTriggers; ///< number of flight recorder dumps requested
+    static std::atomic<unsigned int> ms_uiNumManagers;            ///< number of managers created, gives each manager its index
 };
 
 // @}
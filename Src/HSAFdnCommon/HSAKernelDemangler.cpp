@@ -7,89 +7,186 @@
 
 #include "HSAKernelDemangler.h"
 
-#include <sstream>
-#include <fstream>
-#include <unordered_map>
-#include <mutex>
-#include "Logger.h"
+#include <cctype>
+#include <cxxabi.h>
+#include <cstdlib>
+#include <cstring>
 #include "GlobalSettings.h"
-#include <cstdio>
-#include "FileUtils.h"
 #include "Defs.h"
 #include "StringUtils.h"
+#include "ConcurrentHashMap.h"
 
+/// Demangled names of the kernels seen so far, a kernel name already demangled is found without taking a lock
+static ConcurrentHashMap<std::string, std::string> gs_demangledKernelsMap;
 
-static std::unordered_map<std::string, std::string> gs_demangledKernelsMap;
-static std::mutex gs_demanglerMutex;
+/// Check whether a character can be part of an identifier
+/// \param c the character
+/// \return true if c is a letter, a digit or an underscore
+static bool IsIdentifierChar(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
 
-std::string DemangleKernelName(std::string& kernelName)
+/// Remove the return type, the parameters and the qualifiers of a demangled function name,
+/// the kernel name is reported the way "c++filt -p" prints it
+/// \param strName the demangled name
+/// \return the name without the function signature
+static std::string RemoveFunctionSignature(const std::string& strName)
 {
-    std::lock_guard<std::mutex> lock(gs_demanglerMutex);
-    std::string demangledKernelName;
+    static const std::string s_strAnonymousNamespace = "(anonymous namespace)";
+    static const std::string s_strOperator = "operator";
+
+    std::string strRet = strName;
+
+    // clone suffix of the symbol name (e.g. ".kd"), " [clone .kd]"
+    size_t pos = strRet.find(" [clone ");
 
-    if (gs_demangledKernelsMap.count(kernelName) > 0)
+    if (pos != std::string::npos)
     {
-        demangledKernelName = gs_demangledKernelsMap[kernelName];
+        strRet.erase(pos);
     }
-    else
+
+    // The parameters of the function are the first parenthesis following the name outside of template arguments,
+    // e.g. "max<void (*)(int)>(void (*)(int))". The other parentheses outside of template arguments group the
+    // declarator of the return type, e.g. "void (*get<int>(int))(float)", the name is inside of them.
+    size_t nameStart = 0;
+    bool bInOperator = false;
+    int depth = 0;
+
+    for (pos = 0; pos < strRet.size(); pos++)
     {
-        demangledKernelName = kernelName;
+        char c = strRet[pos];
 
-        if (!GlobalSettings::GetInstance()->m_params.m_bDisableKernelDemangling && !system("which c++filt > /dev/null 2>&1"))
+        if (c == '(' && strRet.compare(pos, s_strAnonymousNamespace.size(), s_strAnonymousNamespace) == 0)
         {
-            std::string tempMangledKernelNameFile = FileUtils::GetDefaultOutputPath() + "/rcp_mangled_kernel";
-            std::string tempDemangledKernelNameFile = FileUtils::GetDefaultOutputPath() + "/rcp_demangled_kernel";
+            pos += s_strAnonymousNamespace.size() - 1;
+            continue;
+        }
 
-            if ('Z' == demangledKernelName.at(0))
+        if (depth == 0 && strRet.compare(pos, s_strOperator.size(), s_strOperator) == 0 &&
+            (pos == 0 || !IsIdentifierChar(strRet[pos - 1])) &&
+            (pos + s_strOperator.size() == strRet.size() || !IsIdentifierChar(strRet[pos + s_strOperator.size()])))
+        {
+            // the symbol of an operator is part of its name, including "()" and "<" (e.g. "operator< <int>(int, int)")
+            pos += s_strOperator.size();
+
+            if (strRet.compare(pos, 2, "()") == 0)
             {
-                demangledKernelName.insert(demangledKernelName.begin(), '_');
+                pos += 2;
             }
-
-            std::ofstream fout(tempMangledKernelNameFile);
-
-            if (fout.is_open())
+            else
             {
-                fout << demangledKernelName;
+                while (pos < strRet.size() && strchr("+-*/%^&|~!=<>,[]", strRet[pos]) != nullptr)
+                {
+                    pos++;
+                }
             }
 
-            fout.close();
+            bInOperator = true;
+            pos--;
+            continue;
+        }
 
-            std::stringstream demanglingCommand;
-            demanglingCommand << "c++filt -p" << " < " << tempMangledKernelNameFile << " > " << tempDemangledKernelNameFile;
-            int retCode = system(demanglingCommand.str().c_str());
+        switch (c)
+        {
+            case '<':
+            case '[':
+            case '{':
+                depth++;
+                break;
+
+            case '>':
+            case ']':
+            case '}':
+                depth--;
+                break;
+
+            case '(':
+                if (depth == 0)
+                {
+                    char prev = pos > 0 ? strRet[pos - 1] : ' ';
+
+                    if (IsIdentifierChar(prev) || prev == '>' || prev == ']' || (bInOperator && prev == ')'))
+                    {
+                        return strRet.substr(nameStart, pos - nameStart);
+                    }
+
+                    nameStart = pos + 1;
+                }
+                else
+                {
+                    depth++;
+                }
+
+                break;
+
+            case ')':
+                if (depth > 0)
+                {
+                    depth--;
+                }
+
+                break;
+
+            case ' ':
+            case '*':
+            case '&':
+                // "operator new", "operator delete[]" or a conversion operator, e.g. "operator unsigned int"
+                if (depth == 0 && !bInOperator)
+                {
+                    nameStart = pos + 1;
+                }
+
+                break;
+
+            default:
+                break;
+        }
+    }
 
-            if (retCode != 0)
-            {
-                GPULogger::Log(GPULogger::logERROR, "Unable to demangle the kernel Name\n");
-            }
+    // data symbols don't have any parameters
+    return strRet;
+}
 
-            std::ifstream fin(tempDemangledKernelNameFile);
+std::string DemangleKernelName(const std::string& kernelName)
+{
+    std::string demangledKernelName;
 
-            if (fin.is_open())
-            {
-                getline(fin, demangledKernelName);
-            }
+    if (gs_demangledKernelsMap.Find(kernelName, demangledKernelName))
+    {
+        return demangledKernelName;
+    }
 
-            fin.close();
+    demangledKernelName = kernelName;
 
-#ifndef _DEBUG
-            bool success = std::remove(tempMangledKernelNameFile.c_str()) == 0 ? true : false;
-            success &= std::remove(tempDemangledKernelNameFile.c_str()) == 0 ? true : false;
+    if (!GlobalSettings::GetInstance()->m_params.m_bDisableKernelDemangling && !demangledKernelName.empty())
+    {
+        std::string mangledKernelName = demangledKernelName;
 
-            if (!success)
+        if ('Z' == mangledKernelName.at(0))
+        {
+            mangledKernelName.insert(mangledKernelName.begin(), '_');
+        }
+
+        int status = 0;
+        char* szDemangledName = abi::__cxa_demangle(mangledKernelName.c_str(), nullptr, nullptr, &status);
+
+        if (nullptr != szDemangledName)
+        {
+            if (0 == status)
             {
-                GPULogger::Log(GPULogger::logERROR, "Unable to delete the temporary files %s %s", tempMangledKernelNameFile.c_str(), tempDemangledKernelNameFile.c_str());
+                demangledKernelName = RemoveFunctionSignature(szDemangledName);
             }
 
-#endif
-
+            free(szDemangledName);
         }
+    }
 
-        demangledKernelName = StringUtils::Replace(demangledKernelName, " ", std::string(SPACE));
-        demangledKernelName = StringUtils::Replace(demangledKernelName, ",", std::string(COMMA));
+    demangledKernelName = StringUtils::Replace(demangledKernelName, " ", std::string(SPACE));
+    demangledKernelName = StringUtils::Replace(demangledKernelName, ",", std::string(COMMA));
 
-        gs_demangledKernelsMap[kernelName] = demangledKernelName;
-    }
+    // another thread may have demangled the same name in the meantime, both results are the same
+    std::string storedKernelName;
 
-    return demangledKernelName;
+    return gs_demangledKernelsMap.Insert(kernelName, demangledKernelName, storedKernelName) ? storedKernelName : demangledKernelName;
 }
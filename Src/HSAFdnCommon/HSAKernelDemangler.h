@@ -10,9 +10,9 @@
 
 #include <string>
 
-/// Demangles the kernel name if mangled
+/// Demangles the kernel name if mangled, the names are demangled in-process and cached
 /// \param kernelname kernel name
-/// \return demangled kernel name using c++filt
-std::string DemangleKernelName(std::string& kernelName);
+/// \return demangled kernel name without the function signature (as printed by "c++filt -p")
+std::string DemangleKernelName(const std::string& kernelName);
 
 #endif
\ No newline at end of file
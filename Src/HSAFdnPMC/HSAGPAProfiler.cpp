@@ -269,6 +269,9 @@ bool HSAGPAProfiler::Init(const Parameters& params, std::string& strErrorOut)
         // Set list separator
         KernelProfileResultManager::Instance()->SetListSeparator(params.m_cOutputSeparator);
 
+        // Compress the kernel profile output
+        KernelProfileResultManager::Instance()->SetCompression(params.m_bCompressOutput);
+
         // Init CSV file header and column row
         InitHeader();
 
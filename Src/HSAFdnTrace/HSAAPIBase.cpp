@@ -8,6 +8,7 @@
 #include "HSAFunctionDefs.h"
 #include "HSAAPIBase.h"
 #include "HSATraceStringUtils.h"
+#include "HSAFdnAPIInfoManager.h"
 
 HSAAPIBase::HSAAPIBase() :
     APIBase(),
@@ -30,21 +31,19 @@ void HSAAPIBase::WriteAPIEntry(std::ostream& sout)
     }
 
     sout << m_strName << " ( ";
-    sout << ToString() << " )";
+    sout << GetArgString() << " )";
 }
 
-void HSAAPIBase::CreateStackEntry()
+StackEntry* HSAAPIBase::CreateStackEntry(std::vector<StackEntry>& stack)
 {
+    StackEntry* pStackEntry = NULL;
+
 #ifdef WIN32
+    SP_UNREFERENCED_PARAMETER(stack);
     SP_TODO("need to implement CreateStackEntry on Windows");
 #else
 
-    if (m_pStackEntry != NULL)
-    {
-        return;
-    }
-
-    for (std::vector<StackEntry>::iterator it = m_stack.begin(); it != m_stack.end(); ++it)
+    for (std::vector<StackEntry>::iterator it = stack.begin(); it != stack.end(); ++it)
     {
         if (it->m_strModName.empty())
         {
@@ -55,11 +54,11 @@ void HSAAPIBase::CreateStackEntry()
         if (it->m_strModName.find(HSA_TRACE_AGENT_DLL) == std::string::npos && it->m_strModName.find("hsa-runtime") == std::string::npos)
         {
             StackTracer::Instance()->GetSymbolName(it->m_dwAddress, *it);
-            m_pStackEntry = new(std::nothrow) StackEntry(*it);
+            pStackEntry = new(std::nothrow) StackEntry(*it);
 
-            if (m_pStackEntry != NULL)
+            if (pStackEntry != NULL)
             {
-                m_pStackEntry->m_strSymName = "NA";
+                pStackEntry->m_strSymName = "NA";
             }
 
             break;
@@ -67,16 +66,8 @@ void HSAAPIBase::CreateStackEntry()
     }
 
 #endif
-}
 
-void HSAAPIBase::WriteStackEntry(std::ostream& sout)
-{
-    if (m_pStackEntry == NULL)
-    {
-        CreateStackEntry();
-    }
-
-    APIBase::WriteStackEntry(sout);
+    return pStackEntry;
 }
 
 bool HSAAPIBase::WriteTimestampEntry(std::ostream& sout, bool bTimeout)
@@ -102,3 +93,29 @@ bool HSAAPIBase::WriteTimestampEntry(std::ostream& sout, bool bTimeout)
 
     return true;
 }
+
+bool HSAAPIBase::IsPollable() const
+{
+    return HSAAPIInfoManager::Instance()->IsPollable(m_type);
+}
+
+bool HSAAPIBase::IsRepeatOf(const APIBase* pPrevious) const
+{
+    const HSAAPIBase* pPreviousCall = dynamic_cast<const HSAAPIBase*>(pPrevious);
+
+    return nullptr != pPreviousCall &&
+           m_type == pPreviousCall->m_type &&
+           GetRepeatKey() == pPreviousCall->GetRepeatKey();
+}
+
+const std::string& HSAAPIBase::GetRepeatKey() const
+{
+    if (m_strRepeatKey.empty())
+    {
+        // the generated trace classes only expose their parameters and return value formatted
+        HSAAPIBase* pThis = const_cast<HSAAPIBase*>(this);
+        m_strRepeatKey = pThis->GetRetString() + " = " + pThis->ToString();
+    }
+
+    return m_strRepeatKey;
+}
@@ -28,16 +28,21 @@ public:
     /// \param sout output stream
     void WriteAPIEntry(std::ostream& sout);
 
-    /// Write stack entry
-    /// \param sout output stream
-    void WriteStackEntry(std::ostream& sout);
-
     /// Write timestamp entry
     /// \param sout output stream
     /// \param bTimeout a flag indicating output mode
     /// \return True if timestamps are ready
     bool WriteTimestampEntry(std::ostream& sout, bool bTimeout);
 
+    /// Check whether the API is in the pollable API table of HSAAPIInfoManager
+    /// \return true if the API is pollable
+    bool IsPollable() const;
+
+    /// Check whether the call repeats a previous call to the same API
+    /// \param pPrevious the previous call
+    /// \return true if the parameters and the return value are the same
+    bool IsRepeatOf(const APIBase* pPrevious) const;
+
 public:
     HSA_API_Type m_type;             ///< api type enum
 
@@ -52,7 +57,15 @@ private:
     HSAAPIBase& operator=(const HSAAPIBase& obj);
 
     /// Creates the stack entry (on-demand)
-    void CreateStackEntry();
+    /// \param stack the stack trace of the call site
+    /// \return a new stack entry or NULL if none was found
+    StackEntry* CreateStackEntry(std::vector<StackEntry>& stack);
+
+    /// Get the formatted return value and parameters the repeated calls are compared with, formatted once per entry
+    /// \return the formatted return value and parameters
+    const std::string& GetRepeatKey() const;
+
+    mutable std::string m_strRepeatKey; ///< formatted return value and parameters of a pollable call, empty until GetRepeatKey is called
 };
 
 #endif // _HSA_API_BASE_H_
@@ -18,6 +18,7 @@
 #include <Defs.h>
 #include <ATPFileUtils.h>
 #include <ProfilerOutputFileDefs.h>
+#include <CompressedStream.h>
 
 #include "HSAAtpFile.h"
 #include "../HSAFdnCommon/HSAFunctionDefsUtils.h"
@@ -35,7 +36,7 @@ static const std::string s_HSA_KERNEL_TIMESTAMP_OUTPUT = HSA_PART_NAME ATP_KERNE
 #define MAX_LINE_SIZE 2048
 
 HSAAtpFilePart::HSAAtpFilePart(const Config& config, bool shouldReleaseMemory)
-    : IAtpFilePart(config, shouldReleaseMemory), m_dispatchIndex(0)
+    : IAtpFilePart(config, shouldReleaseMemory), m_dispatchIndex(0), m_bAPISampled(false)
 {
     m_strPartName = s_PART_NAME;
     m_sections.push_back(s_HSA_TRACE_OUTPUT);
@@ -57,6 +58,11 @@ void HSAAtpFilePart::WriteHeaderSection(SP_fileStream& sout)
     std::set<std::string> excludedAPIs;
     ReadExcludedAPIs(m_config.strAPIFilterFile, excludedAPIs);
     WriteExcludedAPIs(sout, "HSA", excludedAPIs);
+
+    if (HasAPISamplingDirectives(m_config.strAPIFilterFile))
+    {
+        sout << "HSA" << FILE_HEADER_API_SAMPLING << "=True" << std::endl;
+    }
 }
 
 bool HSAAtpFilePart::WriteContentSection(SP_fileStream& sout, const std::string& strTmpFilePath, const std::string& strPID)
@@ -506,6 +512,22 @@ bool HSAAtpFilePart::Parse(std::istream& in, std::string& outErrorMsg)
                             if (nameEndIndex + argListLength < apiTraceStr.size())
                             {
                                 pAPIInfo->m_argList = StringUtils::Trim(apiTraceStr.substr(nameEndIndex + 2, argListLength - 2));
+
+                                // Parse and remove the comment of a collapsed run of calls
+                                size_t commentStart = pAPIInfo->m_argList.find("/*");
+
+                                if (commentStart != string::npos)
+                                {
+                                    size_t commentEnd = pAPIInfo->m_argList.find("*/", commentStart);
+
+                                    if (commentEnd != string::npos)
+                                    {
+                                        pAPIInfo->ParseRepeatedCallComment(pAPIInfo->m_argList.substr(commentStart + 2, commentEnd - commentStart - 2));
+                                    }
+
+                                    pAPIInfo->m_argList = StringUtils::Trim(pAPIInfo->m_argList.substr(0, commentStart));
+                                }
+
                                 pAPIInfo->ParseArgList();
                             }
                         }
@@ -619,6 +641,10 @@ bool HSAAtpFilePart::ParseHeader(const std::string& strKey, const std::string& s
     {
         StringUtils::ParseMajorMinorVersion(strVal, m_atpMajorVer, m_atpMinorVer);
     }
+    else if (std::string::npos != strKey.find("HSA" FILE_HEADER_API_SAMPLING))
+    {
+        m_bAPISampled = strVal.find("True") != std::string::npos;
+    }
 
     return true;
 }
@@ -716,7 +742,7 @@ bool HSAAtpFilePart::UpdateTmpTimestampFiles(const std::string& strTmpFilePath,
 bool HSAAtpFilePart::LoadAsyncCopyTimestamps(const std::string& strFile, ThreadCopyItemMap& threadCopyItemMap)
 {
     char buf[MAX_LINE_SIZE];
-    ifstream fin(strFile.c_str());
+    InputFileStream fin(strFile.c_str());
 
     if (!fin.is_open())
     {
@@ -48,6 +48,10 @@ public:
     /// \return True if succeeded
     bool ParseHeader(const std::string& strKey, const std::string& strVal) override;
 
+    /// Check whether calls were left out of the trace by an API sampling policy
+    /// \return true if the API summary has to be built from the API statistics file
+    bool IsAPISampled() const { return m_bAPISampled; }
+
 protected:
     /// Parse host side timestamp
     /// \param buf Input string
@@ -116,6 +120,7 @@ private:
     unsigned int        m_dispatchIndex;       ///< dispatch index, incremented while parsing kernel dispatch timestamps
     unsigned int        m_atpMajorVer;         ///< major version of the .atp file
     unsigned int        m_atpMinorVer;         ///< minor version of the .atp file
+    bool                m_bAPISampled;         ///< flag indicating whether the trace was recorded with an API sampling policy
 };
 
 #endif //_HSA_ATP_FILE_H_
@@ -31,16 +31,32 @@ using namespace std;
 
 std::mutex HSAAPIInfoManager::ms_asyncTimeStampsMtx;
 
+/// Get the name of an HSA API type, used by the API statistics
+/// \param uiAPIType the API type
+/// \return the API name
+static std::string GetHSAAPIStatisticsName(unsigned int uiAPIType)
+{
+    return HSATraceStringUtils::GetHSAAPINameString(static_cast<HSA_API_Type>(uiAPIType));
+}
+
 AsyncCopyInfoList HSAAPIInfoManager::ms_asyncCopyInfoList;
 
 HSAAPIInfoManager::HSAAPIInfoManager(void) : m_tracedApiCount(0), m_queueCreationCount(0)
 {
     m_strTraceModuleName = "hsa";
+    m_apiStatistics.Init(HSA_API_Type_Non_API_First, GetHSAAPIStatisticsName);
+    m_apiSampler.Init(HSA_API_Type_Non_API_First, GetHSAAPIStatisticsName);
 
     // add APIs that we should always intercept...
     m_mustInterceptAPIs.insert(HSA_API_Type_hsa_queue_create);               // needed so we can create a profiled queue for kernel timestamps
     m_mustInterceptAPIs.insert(HSA_API_Type_hsa_executable_get_symbol);      // needed to extract kernel name
     m_mustInterceptAPIs.insert(HSA_API_Type_hsa_executable_symbol_get_info); // needed to extract kernel name
+
+    // add APIs that applications call in polling loops, their runs of identical calls are collapsed
+    m_pollableAPIs.insert(HSA_API_Type_hsa_signal_load_scacquire);
+    m_pollableAPIs.insert(HSA_API_Type_hsa_signal_load_relaxed);
+    m_pollableAPIs.insert(HSA_API_Type_hsa_signal_wait_scacquire);
+    m_pollableAPIs.insert(HSA_API_Type_hsa_signal_wait_relaxed);
     m_pDelayTimer = nullptr;
     m_pDurationTimer = nullptr;
     m_bNoHSATransferTime = false;
@@ -84,17 +100,17 @@ void HSAAPIInfoManager::FlushNonAPITimestampData(const osProcessId& pid)
 
         if (ms_asyncCopyInfoList.size() > 0)
         {
-            string tmpAsyncCopyTimestampFile = GetTempFileName(pid, 0, TMP_ASYNC_COPY_TIME_STAMP_EXT);
-            ofstream foutCopyTS(tmpAsyncCopyTimestampFile.c_str(), fstream::out | fstream::app);
+            std::ostream* pFoutCopyTS = m_fragmentWriters.GetWriter(GetTempFileName(pid, 0, TMP_ASYNC_COPY_TIME_STAMP_EXT));
 
-            for (auto asyncCopyInfo : ms_asyncCopyInfoList)
+            if (nullptr != pFoutCopyTS)
             {
-                WriteAsyncCopyTimestamp(foutCopyTS, asyncCopyInfo);
-                foutCopyTS << std::endl;
+                for (auto asyncCopyInfo : ms_asyncCopyInfoList)
+                {
+                    WriteAsyncCopyTimestamp(*pFoutCopyTS, asyncCopyInfo);
+                    *pFoutCopyTS << '\n';
+                }
             }
 
-            foutCopyTS.close();
-
             for (auto it = ms_asyncCopyInfoList.begin(); it != ms_asyncCopyInfoList.end(); ++it)
             {
                 delete (*it);
@@ -107,8 +123,12 @@ void HSAAPIInfoManager::FlushNonAPITimestampData(const osProcessId& pid)
     {
         std::lock_guard<std::mutex> lock(m_packetTraceMtx);
 
-        string tmpAqlTraceFile = GetTempFileName(pid, 0, TMP_KERNEL_TIME_STAMP_EXT);
-        ofstream foutAqlTrace(tmpAqlTraceFile.c_str(), fstream::out | fstream::app);
+        std::ostream* pFoutAqlTrace = m_fragmentWriters.GetWriter(GetTempFileName(pid, 0, TMP_KERNEL_TIME_STAMP_EXT));
+
+        if (nullptr == pFoutAqlTrace)
+        {
+            return;
+        }
 
         PacketList notReadyPackets;
 
@@ -116,8 +136,8 @@ void HSAAPIInfoManager::FlushNonAPITimestampData(const osProcessId& pid)
         {
             if ((*it)->m_isReady)
             {
-                (*it)->WritePacketEntry(foutAqlTrace);
-                foutAqlTrace << std::endl;
+                (*it)->WritePacketEntry(*pFoutAqlTrace);
+                *pFoutAqlTrace << '\n';
                 delete(*it);
             }
             else
@@ -126,8 +146,6 @@ void HSAAPIInfoManager::FlushNonAPITimestampData(const osProcessId& pid)
             }
         }
 
-        foutAqlTrace.close();
-
         // assign not-ready packets for the next time we flush
         m_packetList = notReadyPackets;
     }
@@ -157,6 +175,11 @@ bool HSAAPIInfoManager::ShouldIntercept(HSA_API_Type type) const
     return !IsInFilterList(type) || m_mustInterceptAPIs.find(type) != m_mustInterceptAPIs.end();
 }
 
+bool HSAAPIInfoManager::IsPollable(HSA_API_Type type) const
+{
+    return m_pollableAPIs.find(type) != m_pollableAPIs.end();
+}
+
 bool HSAAPIInfoManager::IsCapReached() const
 {
     return m_tracedApiCount >= GlobalSettings::GetInstance()->m_params.m_uiMaxNumOfAPICalls;
@@ -474,9 +497,33 @@ void HSAAPIInfoManager::startTimer(ProfilerTimerType timerType)
 void HSAAPIInfoManager::AddAPIInfoEntry(APIBase* pApi)
 {
     HSAAPIBase* hsaAPI = dynamic_cast<HSAAPIBase*>(pApi);
+
+    bool bAPIStatisticsOnly = GlobalSettings::GetInstance()->m_params.m_bAPIStatisticsOnly;
+
+    if ((bAPIStatisticsOnly || m_apiSampler.IsEnabled()) && !IsInFilterList(hsaAPI->m_type) && IsTracing())
+    {
+        m_apiStatistics.AddCall(hsaAPI->m_type, hsaAPI->m_ullStart, hsaAPI->m_ullEnd);
+    }
+
+    if (bAPIStatisticsOnly)
+    {
+        SAFE_DELETE(hsaAPI);
+        return;
+    }
+
+    bool bSampled = true;
+
+    if (m_apiSampler.IsEnabled())
+    {
+        // async copies are always recorded, rcprof matches the transfer timestamps with their API entries
+        bSampled = HSA_API_Type_hsa_amd_memory_async_copy == hsaAPI->m_type ||
+                   HSA_API_Type_hsa_amd_memory_async_copy_rect == hsaAPI->m_type ||
+                   m_apiSampler.ShouldRecord(hsaAPI->m_type, hsaAPI->m_ullStart, hsaAPI->m_ullEnd);
+    }
+
     bool isCapReached = IsCapReached();
 
-    if (isCapReached || IsInFilterList(hsaAPI->m_type) || !IsTracing())
+    if (isCapReached || IsInFilterList(hsaAPI->m_type) || !IsTracing() || !bSampled || !CheckPendingEntryLimit())
     {
         if (isCapReached)
         {
@@ -485,6 +532,11 @@ void HSAAPIInfoManager::AddAPIInfoEntry(APIBase* pApi)
 
         SAFE_DELETE(hsaAPI);
     }
+    else if (CollapseRepeatedCall(hsaAPI))
+    {
+        // the call repeats the previous hsa_signal_load_* or hsa_signal_wait_* call of the thread, which now accounts for it
+        SAFE_DELETE(hsaAPI);
+    }
     else
     {
         APIInfoManagerBase::AddTraceInfoEntry(hsaAPI);
@@ -92,6 +92,11 @@ public:
     /// \return true if API should be intercepted
     bool ShouldIntercept(HSA_API_Type type) const;
 
+    /// Check if applications call the specified API in polling loops (see APIBase::IsPollable)
+    /// \param type HSA function type
+    /// \return true if the consecutive identical calls to the API are collapsed
+    bool IsPollable(HSA_API_Type type) const;
+
     /// Adds the specified queue to the queue map
     /// \param pQueue the queue to add
     void AddQueue(const hsa_queue_t* pQueue);
@@ -212,6 +217,7 @@ private:
     unsigned int           m_tracedApiCount;                ///< number of APIs that have been traced, used to support max apis to trace option
     std::set<HSA_API_Type> m_filterAPIs;                    ///< HSA APIs that are not traced due to API filtering
     std::set<HSA_API_Type> m_mustInterceptAPIs;             ///< HSA APIs that must be intercepted (even when they are filtered out and not traced)
+    std::set<HSA_API_Type> m_pollableAPIs;                  ///< HSA APIs that applications call in polling loops
     QueueIdMap             m_queueIdMap;                    ///< map of a queue to that queue's index (basically creation order)
     uint64_t               m_queueCreationCount;            ///< count of queues created
     std::mutex             m_queueMapMtx;                   ///< mutex to guard access to m_queueIdMap
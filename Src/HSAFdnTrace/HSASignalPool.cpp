@@ -5,12 +5,53 @@
 /// \brief  This file contains a signal pool class
 //==============================================================================
 
+#include <algorithm>
+#include <new>
+
 #include "Defs.h"
 #include "AutoGenerated/HSATraceInterception.h"
 #include "HSASignalPool.h"
 #include <Logger.h>
 
-HSASignalPool::HSASignalPool()
+const size_t HSASignalPool::s_THREAD_CACHE_SIZE;
+const size_t HSASignalPool::s_MIN_POOL_SIZE;
+const size_t HSASignalPool::s_MAX_POOL_SIZE;
+const unsigned int HSASignalPool::s_RESIZE_INTERVAL;
+
+/// Owner of the signal cache of a thread, returns the cached signals to the pool when the thread exits
+struct HSASignalThreadCacheOwner
+{
+    /// Constructor
+    HSASignalThreadCacheOwner() : m_pCache(nullptr)
+    {
+    }
+
+    /// Destructor
+    ~HSASignalThreadCacheOwner()
+    {
+        if (nullptr != m_pCache)
+        {
+            HSASignalPool::Instance()->RemoveThreadCache(m_pCache);
+            m_pCache = nullptr;
+        }
+    }
+
+    HSASignalPool::ThreadCache* m_pCache; ///< signal cache of the thread, nullptr if the thread never used the pool
+};
+
+static thread_local HSASignalThreadCacheOwner t_signalCacheOwner;
+
+HSASignalPool::HSASignalPool() :
+    m_poolLimit(s_MIN_POOL_SIZE),
+    m_peakInFlight(0),
+    m_maxInFlight(0),
+    m_numTransfers(0),
+    m_ullPrewarmed(0),
+    m_ullDestroyed(0),
+    m_generation(0),
+    m_ullExitedAcquired(0),
+    m_ullExitedReleased(0),
+    m_ullExitedMisses(0)
 {
 }
 
@@ -21,20 +62,22 @@ HSASignalPool::~HSASignalPool()
 
 void HSASignalPool::Clear()
 {
-    size_t poolSize = m_signalPool.size();
+    std::vector<hsa_signal_t> signals;
 
-    for (size_t i = 0; i < poolSize; i++)
     {
-        g_pRealCoreFunctions->hsa_signal_destroy_fn(m_signalPool.top());
-        m_signalPool.pop();
+        std::lock_guard<std::mutex> lock(m_signalPoolMtx);
+        m_signalPool.swap(signals);
+        m_generation++;
     }
 
-    SpAssert(m_signalPool.empty())
+    DestroySignals(signals);
 }
 
 bool HSASignalPool::AcquireSignal(hsa_signal_value_t initialValue, hsa_signal_t& signal)
 {
-    if (0 == m_signalPool.size())
+    ThreadCache* pCache = GetThreadCache();
+
+    if (nullptr == pCache)
     {
         hsa_status_t status = g_pRealCoreFunctions->hsa_signal_create_fn(initialValue, 0, nullptr, &signal);
         SpAssert(HSA_STATUS_SUCCESS == status);
@@ -42,36 +85,269 @@ bool HSASignalPool::AcquireSignal(hsa_signal_value_t initialValue, hsa_signal_t&
         return HSA_STATUS_SUCCESS == status;
     }
 
+    if (0 == pCache->m_numSignals)
     {
-        std::lock_guard<std::mutex> lock(m_signalPoolMtx);
+        RefillThreadCache(pCache);
+    }
 
-        if (0 == m_signalPool.size())
-        {
-            hsa_status_t status = g_pRealCoreFunctions->hsa_signal_create_fn(initialValue, 0, nullptr, &signal);
-            SpAssert(HSA_STATUS_SUCCESS == status);
+    if (0 == pCache->m_numSignals)
+    {
+        hsa_status_t status = g_pRealCoreFunctions->hsa_signal_create_fn(initialValue, 0, nullptr, &signal);
+        SpAssert(HSA_STATUS_SUCCESS == status);
 
-            return HSA_STATUS_SUCCESS == status;
+        if (HSA_STATUS_SUCCESS != status)
+        {
+            return false;
         }
 
-        signal = m_signalPool.top();
-        m_signalPool.pop();
+        pCache->m_ullMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        pCache->m_numSignals--;
+        signal = pCache->m_signals[pCache->m_numSignals];
         g_pRealCoreFunctions->hsa_signal_store_relaxed_fn(signal, initialValue);
-
-        return true;
     }
+
+    pCache->m_ullAcquired.fetch_add(1, std::memory_order_relaxed);
+    return true;
 }
 
 bool HSASignalPool::ReleaseSignal(hsa_signal_t signal)
 {
-    if (s_MAX_POOL_SIZE < m_signalPool.size())
+    ThreadCache* pCache = GetThreadCache();
+
+    if (nullptr == pCache)
     {
         g_pRealCoreFunctions->hsa_signal_destroy_fn(signal);
+        return true;
     }
-    else
+
+    if (s_THREAD_CACHE_SIZE == pCache->m_numSignals)
     {
-        std::lock_guard<std::mutex> lock(m_signalPoolMtx);
-        m_signalPool.push(signal);
+        SpillThreadCache(pCache);
     }
 
+    pCache->m_signals[pCache->m_numSignals] = signal;
+    pCache->m_numSignals++;
+    pCache->m_ullReleased.fetch_add(1, std::memory_order_relaxed);
+
     return true;
 }
+
+void HSASignalPool::Prewarm(size_t numSignals)
+{
+    size_t numToCreate = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_signalPoolMtx);
+        numSignals = std::min(numSignals, m_poolLimit);
+
+        if (m_signalPool.size() < numSignals)
+        {
+            numToCreate = numSignals - m_signalPool.size();
+        }
+    }
+
+    std::vector<hsa_signal_t> signals;
+    signals.reserve(numToCreate);
+
+    for (size_t i = 0; i < numToCreate; i++)
+    {
+        hsa_signal_t signal;
+
+        if (HSA_STATUS_SUCCESS != g_pRealCoreFunctions->hsa_signal_create_fn(0, 0, nullptr, &signal))
+        {
+            GPULogger::Log(GPULogger::logERROR, "HSASignalPool: unable to create signal\n");
+            break;
+        }
+
+        signals.push_back(signal);
+    }
+
+    std::vector<hsa_signal_t> excessSignals;
+
+    {
+        std::lock_guard<std::mutex> lock(m_signalPoolMtx);
+        m_signalPool.insert(m_signalPool.end(), signals.begin(), signals.end());
+        m_ullPrewarmed += signals.size();
+
+        // other threads may have released signals in the meantime
+        if (m_signalPool.size() > m_poolLimit)
+        {
+            excessSignals.assign(m_signalPool.begin() + m_poolLimit, m_signalPool.end());
+            m_signalPool.resize(m_poolLimit);
+            m_ullDestroyed += excessSignals.size();
+        }
+    }
+
+    DestroySignals(excessSignals);
+}
+
+void HSASignalPool::LogStatistics()
+{
+    unsigned long long ullAcquired = 0;
+    unsigned long long ullMisses = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_threadCachesMtx);
+        ullAcquired = m_ullExitedAcquired;
+        ullMisses = m_ullExitedMisses;
+
+        for (std::vector<ThreadCache*>::iterator it = m_threadCaches.begin(); it != m_threadCaches.end(); ++it)
+        {
+            ullAcquired += (*it)->m_ullAcquired.load(std::memory_order_relaxed);
+            ullMisses += (*it)->m_ullMisses.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_signalPoolMtx);
+
+    GPULogger::Log(GPULogger::logMESSAGE, "HSASignalPool: %llu signals acquired, %llu hits, %llu misses, %llu signals prewarmed, %llu signals destroyed above the pool limit\n",
+                   ullAcquired, ullAcquired - ullMisses, ullMisses, m_ullPrewarmed, m_ullDestroyed);
+    GPULogger::Log(GPULogger::logMESSAGE, "HSASignalPool: peak of %llu signals in flight, pool limit %llu signals\n",
+                   static_cast<unsigned long long>(m_maxInFlight), static_cast<unsigned long long>(m_poolLimit));
+}
+
+HSASignalPool::ThreadCache* HSASignalPool::GetThreadCache()
+{
+    ThreadCache* pCache = t_signalCacheOwner.m_pCache;
+    unsigned int generation = m_generation.load(std::memory_order_acquire);
+
+    if (nullptr != pCache)
+    {
+        if (pCache->m_generation != generation)
+        {
+            pCache->m_numSignals = 0;
+            pCache->m_generation = generation;
+        }
+
+        return pCache;
+    }
+
+    pCache = new(std::nothrow) ThreadCache(generation);
+
+    if (nullptr == pCache)
+    {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_threadCachesMtx);
+        m_threadCaches.push_back(pCache);
+    }
+
+    t_signalCacheOwner.m_pCache = pCache;
+    return pCache;
+}
+
+void HSASignalPool::RemoveThreadCache(ThreadCache* pCache)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_threadCachesMtx);
+        m_threadCaches.erase(std::remove(m_threadCaches.begin(), m_threadCaches.end(), pCache), m_threadCaches.end());
+        m_ullExitedAcquired += pCache->m_ullAcquired.load(std::memory_order_relaxed);
+        m_ullExitedReleased += pCache->m_ullReleased.load(std::memory_order_relaxed);
+        m_ullExitedMisses += pCache->m_ullMisses.load(std::memory_order_relaxed);
+    }
+
+    {
+        // the signals are kept even above the limit, the runtime may already be shut down when the last threads exit
+        std::lock_guard<std::mutex> lock(m_signalPoolMtx);
+
+        if (pCache->m_generation == m_generation.load(std::memory_order_relaxed))
+        {
+            m_signalPool.insert(m_signalPool.end(), pCache->m_signals, pCache->m_signals + pCache->m_numSignals);
+        }
+    }
+
+    delete pCache;
+}
+
+void HSASignalPool::RefillThreadCache(ThreadCache* pCache)
+{
+    std::vector<hsa_signal_t> excessSignals;
+
+    {
+        std::lock_guard<std::mutex> lock(m_signalPoolMtx);
+        UpdatePoolLimit(excessSignals);
+
+        size_t numSignals = std::min(m_signalPool.size(), s_THREAD_CACHE_SIZE / 2);
+        std::copy(m_signalPool.end() - numSignals, m_signalPool.end(), pCache->m_signals);
+        m_signalPool.resize(m_signalPool.size() - numSignals);
+        pCache->m_numSignals = numSignals;
+    }
+
+    DestroySignals(excessSignals);
+}
+
+void HSASignalPool::SpillThreadCache(ThreadCache* pCache)
+{
+    std::vector<hsa_signal_t> excessSignals;
+    size_t numSignals = pCache->m_numSignals / 2;
+
+    pCache->m_numSignals -= numSignals;
+
+    {
+        std::lock_guard<std::mutex> lock(m_signalPoolMtx);
+        m_signalPool.insert(m_signalPool.end(), pCache->m_signals + pCache->m_numSignals, pCache->m_signals + pCache->m_numSignals + numSignals);
+        UpdatePoolLimit(excessSignals);
+    }
+
+    DestroySignals(excessSignals);
+}
+
+void HSASignalPool::UpdatePoolLimit(std::vector<hsa_signal_t>& excessSignals)
+{
+    size_t numInFlight = GetNumInFlight();
+
+    m_peakInFlight = std::max(m_peakInFlight, numInFlight);
+    m_maxInFlight = std::max(m_maxInFlight, numInFlight);
+
+    // grow as soon as more signals are in flight, so none of them is destroyed when they are released
+    if (m_peakInFlight > m_poolLimit)
+    {
+        m_poolLimit = std::min(m_peakInFlight, s_MAX_POOL_SIZE);
+    }
+
+    m_numTransfers++;
+
+    // shrink slowly once the application has fewer signals in flight
+    if (s_RESIZE_INTERVAL <= m_numTransfers)
+    {
+        m_poolLimit = std::max(std::max(m_peakInFlight, m_poolLimit / 2), s_MIN_POOL_SIZE);
+        m_peakInFlight = numInFlight;
+        m_numTransfers = 0;
+    }
+
+    if (m_signalPool.size() > m_poolLimit)
+    {
+        excessSignals.assign(m_signalPool.begin() + m_poolLimit, m_signalPool.end());
+        m_signalPool.resize(m_poolLimit);
+        m_ullDestroyed += excessSignals.size();
+    }
+}
+
+size_t HSASignalPool::GetNumInFlight()
+{
+    std::lock_guard<std::mutex> lock(m_threadCachesMtx);
+    unsigned long long ullAcquired = m_ullExitedAcquired;
+    unsigned long long ullReleased = m_ullExitedReleased;
+
+    for (std::vector<ThreadCache*>::iterator it = m_threadCaches.begin(); it != m_threadCaches.end(); ++it)
+    {
+        ullAcquired += (*it)->m_ullAcquired.load(std::memory_order_relaxed);
+        ullReleased += (*it)->m_ullReleased.load(std::memory_order_relaxed);
+    }
+
+    // the counters of the other threads may be read before their latest update
+    return ullAcquired > ullReleased ? static_cast<size_t>(ullAcquired - ullReleased) : 0;
+}
+
+void HSASignalPool::DestroySignals(const std::vector<hsa_signal_t>& signals)
+{
+    for (std::vector<hsa_signal_t>::const_iterator it = signals.begin(); it != signals.end(); ++it)
+    {
+        g_pRealCoreFunctions->hsa_signal_destroy_fn(*it);
+    }
+}
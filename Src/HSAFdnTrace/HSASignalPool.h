@@ -8,18 +8,29 @@
 #ifndef _HSA_SIGNAL_POOL_H_
 #define _HSA_SIGNAL_POOL_H_
 
-#include <stack>
+#include <vector>
 #include <mutex>
+#include <atomic>
 
 #include "hsa.h"
 
 #include <TSingleton.h>
 
+struct HSASignalThreadCacheOwner;
+
 /// Singleton class to manage hsa signals (allows recycling of no-longer used
 /// signals to avoid overhead of constantly creating/destroying signals)
+///
+/// Each thread acquires and releases signals through its own cache. A thread that
+/// runs out of signals takes a batch from the global pool, a thread whose cache is
+/// full (e.g. the thread completing the signals acquired by other threads) moves a
+/// batch to the global pool, so the pool mutex is only taken once per batch.
+/// The global pool keeps as many unused signals as the peak number of signals
+/// in flight (acquired and not yet released) observed recently.
 class HSASignalPool : public TSingleton<HSASignalPool>
 {
     friend class TSingleton<HSASignalPool>;
+    friend struct HSASignalThreadCacheOwner;
 
 public:
     /// Destructor
@@ -39,21 +50,93 @@ public:
     /// \return true if a signal is released
     bool ReleaseSignal(hsa_signal_t signal);
 
-    /// Destroys all signals in the pool and clears the pool
+    /// Creates unused signals ahead of the first dispatches of a queue.
+    /// The pool never holds more unused signals than its current limit
+    /// \param numSignals the number of unused signals the pool should hold
+    void Prewarm(size_t numSignals);
+
+    /// Destroys all signals in the pool and clears the pool. The signals
+    /// cached by the threads are dropped the next time the threads use the
+    /// pool, the runtime destroys them when it shuts down
     void Clear();
 
+    /// Writes the pool hit/miss counters to the log
+    void LogStatistics();
+
 private:
-    static const size_t s_MAX_POOL_SIZE = 100; ///< only keep 100 unused signals in the pool
+    static const size_t s_THREAD_CACHE_SIZE = 32;       ///< number of signals a thread keeps in its cache, half of them are moved to or from the global pool at once
+    static const size_t s_MIN_POOL_SIZE = 100;          ///< the global pool keeps at least 100 unused signals
+    static const size_t s_MAX_POOL_SIZE = 4096;         ///< the global pool keeps at most 4096 unused signals
+    static const unsigned int s_RESIZE_INTERVAL = 64;   ///< number of batches moved to or from the global pool between two decays of its limit
+
+    /// Signal cache of a thread, only used by the thread
+    struct ThreadCache
+    {
+        /// Constructor
+        /// \param generation the generation of the pool the cache is created in
+        ThreadCache(unsigned int generation) : m_numSignals(0), m_generation(generation), m_ullAcquired(0), m_ullReleased(0), m_ullMisses(0)
+        {
+        }
+
+        hsa_signal_t                       m_signals[s_THREAD_CACHE_SIZE]; ///< unused signals of the thread
+        size_t                             m_numSignals;                   ///< number of unused signals of the thread
+        unsigned int                       m_generation;                   ///< generation of the pool the signals were taken from
+        std::atomic<unsigned long long>    m_ullAcquired;                  ///< number of signals acquired by the thread
+        std::atomic<unsigned long long>    m_ullReleased;                  ///< number of signals released by the thread
+        std::atomic<unsigned long long>    m_ullMisses;                    ///< number of signals created because the thread cache and the global pool were empty
+    };
 
     /// Constructor
     HSASignalPool();
 
+    /// Get the cache of the calling thread, drop its signals if the pool has been cleared since they were cached
+    /// \return the cache, nullptr if it could not be allocated
+    ThreadCache* GetThreadCache();
+
+    /// Called when a thread exits, moves the signals of its cache to the global pool
+    /// \param pCache the cache of the thread
+    void RemoveThreadCache(ThreadCache* pCache);
+
+    /// Move a batch of signals from the global pool to an empty thread cache
+    /// \param pCache the cache of the calling thread
+    void RefillThreadCache(ThreadCache* pCache);
+
+    /// Move half the signals of a full thread cache to the global pool
+    /// \param pCache the cache of the calling thread
+    void SpillThreadCache(ThreadCache* pCache);
+
+    /// Adapt the limit of the global pool to the number of signals in flight and remove the signals above the limit.
+    /// Called with m_signalPoolMtx locked
+    /// \param[out] excessSignals the signals above the limit, destroyed by the caller once the mutex is unlocked
+    void UpdatePoolLimit(std::vector<hsa_signal_t>& excessSignals);
+
+    /// Get the number of signals acquired and not yet released
+    /// \return the number of signals in flight
+    size_t GetNumInFlight();
+
+    /// Destroy signals
+    /// \param signals the signals to destroy
+    void DestroySignals(const std::vector<hsa_signal_t>& signals);
+
     /// Remove copy constructor and assignment operator
     HSASignalPool(const HSASignalPool&) = delete;
     const HSASignalPool& operator=(const HSASignalPool&) = delete;
 
-    std::stack<hsa_signal_t> m_signalPool;    ///< stack of created-and-no-longer-used signals
-    std::mutex     m_signalPoolMtx;           ///< mutex to protect access to m_signalPool
+    std::vector<hsa_signal_t>  m_signalPool;              ///< stack of created-and-no-longer-used signals
+    size_t                     m_poolLimit;               ///< maximum number of signals in m_signalPool
+    size_t                     m_peakInFlight;            ///< peak number of signals in flight since the last decay of m_poolLimit
+    size_t                     m_maxInFlight;             ///< peak number of signals in flight since the pool was created
+    unsigned int               m_numTransfers;            ///< number of batches moved to or from m_signalPool since the last decay of m_poolLimit
+    unsigned long long         m_ullPrewarmed;            ///< number of signals created by Prewarm
+    unsigned long long         m_ullDestroyed;            ///< number of signals destroyed because the pool was above its limit
+    std::atomic<unsigned int>  m_generation;              ///< incremented by Clear, signals cached before are no longer valid
+    std::mutex                 m_signalPoolMtx;           ///< mutex to protect access to m_signalPool and its limit and counters
+
+    std::vector<ThreadCache*>  m_threadCaches;            ///< caches of the running threads
+    unsigned long long         m_ullExitedAcquired;       ///< number of signals acquired by the threads that exited
+    unsigned long long         m_ullExitedReleased;       ///< number of signals released by the threads that exited
+    unsigned long long         m_ullExitedMisses;         ///< number of signals created by the threads that exited
+    std::mutex                 m_threadCachesMtx;         ///< mutex to protect access to m_threadCaches and the counters of the exited threads, locked after m_signalPoolMtx
 };
 
 #endif // _HSA_SIGNAL_POOL_H_
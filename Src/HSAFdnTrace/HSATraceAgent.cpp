@@ -15,7 +15,9 @@
 #include <Logger.h>
 #include <FileUtils.h>
 #include <GlobalSettings.h>
+#include <OSUtils.h>
 #include <StackTracer.h>
+#include <TraceEntryAllocator.h>
 
 #include "HSAAgentUtils.h"
 
@@ -31,37 +33,22 @@ void TimerThread(void* param)
 {
     SP_UNREFERENCED_PARAMETER(param);
 
-    unsigned int interval = HSAAPIInfoManager::Instance()->GetInterval();
-
-    if (interval == 0)
+    // flush when a thread reaches the flush watermark or when the timer interval expires
+    while (HSAAPIInfoManager::Instance()->WaitForFlush())
     {
-        interval = 1; // safety net in case interval is zero (it shouldn't be...)
-    }
-
-    const unsigned int sleepInterval = interval < 10 ? interval : 10; // sleep at most 10 ms at a time
-    const unsigned int sleepsBeforeFlush = sleepInterval == 0 ? 1 : interval / sleepInterval;
-
-    unsigned int iterationNum = 1;
-
-    while (HSAAPIInfoManager::Instance()->IsRunning())
-    {
-        OSUtils::Instance()->SleepMillisecond(sleepInterval);
-
-        if (iterationNum == sleepsBeforeFlush)
-        {
-            iterationNum = 1;
-            HSAAPIInfoManager::Instance()->TrySwapBuffer();
-            HSAAPIInfoManager::Instance()->FlushTraceData();
-        }
-        else
-        {
-            iterationNum++;
-        }
+        HSAAPIInfoManager::Instance()->TrySwapBuffer();
+        HSAAPIInfoManager::Instance()->FlushTraceData();
     }
 }
 
 extern "C" DLL_PUBLIC void amdtCodeXLStopProfiling()
 {
+    if (HSAAPIInfoManager::Instance()->IsFlightRecorderMode())
+    {
+        // write the calls that led up to this point
+        TraceInfoManager::TriggerFlightRecorderDump();
+    }
+
     HSAAPIInfoManager::Instance()->StopTracing();
 }
 
@@ -117,6 +104,7 @@ extern "C" bool DLL_PUBLIC OnLoad(void* pTable, uint64_t runtimeVersion, uint64_
     }
 
     GlobalSettings::GetInstance()->m_params = params;
+    OSUtils::Instance()->SetupTSCTimer(params);
     HSAAPIInfoManager::Instance()->SetOutputFile(params.m_strOutputFile);
 
     if (!params.m_strAPIFilterFile.empty())
@@ -130,6 +118,7 @@ extern "C" bool DLL_PUBLIC OnLoad(void* pTable, uint64_t runtimeVersion, uint64_
     }
 
     StackTracer::Instance()->InitSymPath();
+    StackTracer::Instance()->SetOfflineSymbols(params.m_bOfflineSymbols);
 
     if (params.m_bTimeOutBasedOutput)
     {
@@ -219,6 +208,7 @@ extern "C" void DLL_PUBLIC OnUnload()
     }
 
     HSASignalQueue::Instance()->Clear();
+    HSASignalPool::Instance()->LogStatistics();
     HSASignalPool::Instance()->Clear();
 
     if (HSA_STATUS_SUCCESS != retVal)
@@ -248,5 +238,9 @@ extern "C" void DLL_PUBLIC OnUnloadTool()
         HSAAPIInfoManager::Instance()->ResumeTimer();
     }
 
+    HSAAPIInfoManager::Instance()->LogAPISamplingSummary();
+    TraceEntryAllocator::LogStatistics();
+    OSUtils::Instance()->LogTSCTimerStatistics();
+
     DoneHSAAPIInterceptTrace();
 }
\ No newline at end of file
@@ -93,7 +93,6 @@ void HSA_APITrace_hsa_queue_create_PostCallHelper(hsa_status_t retVal, hsa_agent
                                                   void* data), void* data, uint32_t private_segment_size, uint32_t group_segment_size, hsa_queue_t** queue)
 {
     SP_UNREFERENCED_PARAMETER(agent);
-    SP_UNREFERENCED_PARAMETER(size);
     SP_UNREFERENCED_PARAMETER(type);
     SP_UNREFERENCED_PARAMETER(callback);
     SP_UNREFERENCED_PARAMETER(data);
@@ -105,9 +104,16 @@ void HSA_APITrace_hsa_queue_create_PostCallHelper(hsa_status_t retVal, hsa_agent
         g_pRealAmdExtFunctions->hsa_amd_profiling_async_copy_enable_fn(true);
         HSAAPIInfoManager::Instance()->AddQueue(*queue);
 
+        // the completion signals of the async copies are replaced by pool signals, create them before the first copies
+        if (!HSAAPIInfoManager::Instance()->IsHsaTransferTimeDisabled())
+        {
+            HSASignalPool::Instance()->Prewarm(size);
+        }
+
         ROCProfilerModule* pROCProfilerModule = HSARTModuleLoader<ROCProfilerModule>::Instance()->GetHSARTModule();
 
-        if (nullptr != pROCProfilerModule && pROCProfilerModule->IsModuleLoaded())
+        // kernel dispatches are not traced when only the API statistics are collected
+        if (nullptr != pROCProfilerModule && pROCProfilerModule->IsModuleLoaded() && !GlobalSettings::GetInstance()->m_params.m_bAPIStatisticsOnly)
         {
             rocprofiler_queue_callbacks_t queueCallbacks{};
             queueCallbacks.dispatch = DispatchCallback;
@@ -0,0 +1,263 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Unit tests of the block compressed streams
+//==============================================================================
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "UnitTest.h"
+#include "CompressedStream.h"
+#include "BaseParser.h"
+
+/// Size of the blocks written by the tests, small enough to get many blocks from little data
+static const size_t TEST_BLOCK_SIZE = 4096;
+
+/// Parser giving the tests access to the line reading functions of BaseParser
+class TestLineParser : public BaseParser<int>
+{
+public:
+    using BaseParser<int>::ReadLine;
+    using BaseParser<int>::RewindToPreviousPos;
+};
+
+/// Generate random bytes, they can't be compressed
+/// \param size the number of bytes
+/// \param seed the random seed
+/// \return the data
+static std::string GetRandomData(size_t size, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::string data(size, '\0');
+
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = static_cast<char>(rng() & 0xFF);
+    }
+
+    return data;
+}
+
+/// Generate lines similar to the trace fragments
+/// \param numLines the number of lines
+/// \return the data
+static std::string GetTextData(size_t numLines)
+{
+    std::mt19937 rng(1);
+    std::ostringstream ss;
+
+    for (size_t i = 0; i < numLines; i++)
+    {
+        ss << "clEnqueueNDRangeKernel  " << 1000000 + i * 17 << "  " << 1000000 + i * 17 + rng() % 5000
+           << "  CL_SUCCESS  0x" << std::hex << (0x7f0000 + rng() % 16) << std::dec << '\n';
+    }
+
+    return ss.str();
+}
+
+/// Compress data, the stream is flushed after each chunk
+/// \param data the data
+/// \param chunkSizes the sizes of the chunks written between the flushes, the rest is written at once
+/// \param[out] storedBytes the size of the compressed data
+/// \return the compressed data
+static std::string Compress(const std::string& data, const std::vector<size_t>& chunkSizes, unsigned long long& storedBytes)
+{
+    std::ostringstream out(std::ios_base::out | std::ios_base::binary);
+    size_t pos = 0;
+
+    {
+        CompressedOutputBuffer buffer(TEST_BLOCK_SIZE);
+        buffer.Attach(out);
+
+        for (std::vector<size_t>::const_iterator it = chunkSizes.begin(); it != chunkSizes.end() && pos < data.size(); ++it)
+        {
+            size_t size = std::min(*it, data.size() - pos);
+            out.write(data.data() + pos, static_cast<std::streamsize>(size));
+            out.flush();
+            pos += size;
+        }
+
+        out.write(data.data() + pos, static_cast<std::streamsize>(data.size() - pos));
+        out.flush();
+        storedBytes = buffer.GetStoredBytes();
+    }
+
+    return out.str();
+}
+
+/// Read all the data of a stream
+/// \param in the stream
+/// \return the data
+static std::string ReadAll(std::istream& in)
+{
+    std::ostringstream ss;
+    char buf[1000];
+
+    while (in.read(buf, sizeof(buf)) || in.gcount() > 0)
+    {
+        ss.write(buf, in.gcount());
+    }
+
+    return ss.str();
+}
+
+/// Decompress data
+/// \param compressed the compressed data
+/// \return the data
+static std::string Decompress(const std::string& compressed)
+{
+    std::stringbuf source(compressed, std::ios_base::in | std::ios_base::binary);
+    DecompressedInputBuffer buffer;
+
+    if (!buffer.Attach(&source))
+    {
+        return std::string();
+    }
+
+    std::istream in(&buffer);
+    return ReadAll(in);
+}
+
+UNIT_TEST(CompressedStream_RandomDataIsStored)
+{
+    std::string data = GetRandomData(10 * TEST_BLOCK_SIZE + 123, 7);
+    unsigned long long storedBytes = 0;
+    std::string compressed = Compress(data, std::vector<size_t>(), storedBytes);
+
+    // incompressible blocks are stored as is, behind their header
+    size_t numBlocks = (data.size() + TEST_BLOCK_SIZE - 1) / TEST_BLOCK_SIZE;
+    UNIT_TEST_CHECK_EQUAL(data.size() + numBlocks * COMPRESSED_BLOCK_HEADER_SIZE, compressed.size());
+    UNIT_TEST_CHECK_EQUAL(compressed.size(), storedBytes);
+    UNIT_TEST_CHECK(data == Decompress(compressed));
+}
+
+UNIT_TEST(CompressedStream_TextDataIsCompressed)
+{
+    std::string data = GetTextData(5000);
+    unsigned long long storedBytes = 0;
+    std::string compressed = Compress(data, std::vector<size_t>(), storedBytes);
+
+    UNIT_TEST_CHECK(compressed.size() < data.size() / 2);
+    UNIT_TEST_CHECK(data == Decompress(compressed));
+}
+
+UNIT_TEST(CompressedStream_FlushesEndBlocks)
+{
+    // short blocks, empty flushes, blocks of exactly the block size and a match spanning a flush
+    std::string data = GetTextData(500) + GetRandomData(3 * TEST_BLOCK_SIZE, 11) + GetTextData(500);
+    size_t sizes[] = { 1, 0, 5, TEST_BLOCK_SIZE, TEST_BLOCK_SIZE + 1, 0, 17, 2 * TEST_BLOCK_SIZE, 3, 100, 1000 };
+    std::vector<size_t> chunkSizes(sizes, sizes + sizeof(sizes) / sizeof(sizes[0]));
+
+    std::mt19937 rng(3);
+
+    for (int i = 0; i < 50; i++)
+    {
+        chunkSizes.push_back(rng() % 300);
+    }
+
+    unsigned long long storedBytes = 0;
+    std::string compressed = Compress(data, chunkSizes, storedBytes);
+
+    UNIT_TEST_CHECK_EQUAL(compressed.size(), storedBytes);
+    UNIT_TEST_CHECK(data == Decompress(compressed));
+
+    // a file the agent appended to is read as one stream
+    std::string appended = GetRandomData(1000, 5);
+    std::string compressedAppended = Compress(appended, std::vector<size_t>(), storedBytes);
+    UNIT_TEST_CHECK(data + appended == Decompress(compressed + compressedAppended));
+}
+
+UNIT_TEST(CompressedStream_SeekAndTell)
+{
+    std::string data = GetTextData(3000);
+    unsigned long long storedBytes = 0;
+    std::vector<size_t> chunkSizes(20, 777);
+    std::string compressed = Compress(data, chunkSizes, storedBytes);
+
+    std::stringbuf source(compressed, std::ios_base::in | std::ios_base::binary);
+    DecompressedInputBuffer buffer;
+    UNIT_TEST_CHECK(buffer.Attach(&source));
+    std::istream in(&buffer);
+
+    // the parsers read each line twice when they find the start of the next section
+    TestLineParser parser;
+    std::istringstream expected(data);
+    std::string strLine;
+    std::string strExpectedLine;
+    std::string strRereadLine;
+    size_t numLines = 0;
+
+    while (std::getline(expected, strExpectedLine))
+    {
+        UNIT_TEST_CHECK_EQUAL(static_cast<long long>(expected.tellg()) - static_cast<long long>(strExpectedLine.size()) - 1, static_cast<long long>(in.tellg()));
+        UNIT_TEST_CHECK(parser.ReadLine(in, strLine));
+        UNIT_TEST_CHECK_EQUAL(strExpectedLine, strLine);
+        UNIT_TEST_CHECK(parser.RewindToPreviousPos(in));
+        UNIT_TEST_CHECK(!parser.RewindToPreviousPos(in));
+        UNIT_TEST_CHECK(parser.ReadLine(in, strRereadLine));
+        UNIT_TEST_CHECK_EQUAL(strExpectedLine, strRereadLine);
+        numLines++;
+    }
+
+    UNIT_TEST_CHECK_EQUAL(3000u, numLines);
+
+    // random positions, backwards and forwards across the blocks
+    std::mt19937 rng(9);
+    in.clear();
+
+    for (int i = 0; i < 200; i++)
+    {
+        size_t pos = rng() % data.size();
+        char ch = 0;
+
+        UNIT_TEST_CHECK(in.seekg(static_cast<std::streamoff>(pos)));
+        UNIT_TEST_CHECK_EQUAL(static_cast<long long>(pos), static_cast<long long>(in.tellg()));
+        UNIT_TEST_CHECK(in.get(ch));
+        UNIT_TEST_CHECK_EQUAL(data[pos], ch);
+        UNIT_TEST_CHECK(in.seekg(-1, std::ios_base::cur));
+        UNIT_TEST_CHECK_EQUAL(static_cast<long long>(pos), static_cast<long long>(in.tellg()));
+    }
+
+    // the end of the data is a valid position, past it is not
+    UNIT_TEST_CHECK(in.seekg(static_cast<std::streamoff>(data.size())));
+    UNIT_TEST_CHECK_EQUAL(std::char_traits<char>::eof(), in.peek());
+    in.clear();
+    UNIT_TEST_CHECK(!in.seekg(static_cast<std::streamoff>(data.size() + 1)));
+}
+
+UNIT_TEST(CompressedStream_InputFileStream)
+{
+    const char* szFileName = "RCPUnitTests_CompressedStream.tmp";
+    std::string data = GetTextData(2000);
+
+    {
+        std::ofstream fout(szFileName, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+        fout << data;
+    }
+
+    // text files are read as is
+    {
+        InputFileStream fin(szFileName);
+        UNIT_TEST_CHECK(fin.is_open());
+        UNIT_TEST_CHECK(!fin.IsCompressed());
+        UNIT_TEST_CHECK(data == ReadAll(fin));
+    }
+
+    UNIT_TEST_CHECK(CompressedOutputBuffer::CompressFile(szFileName));
+
+    {
+        InputFileStream fin(szFileName);
+        UNIT_TEST_CHECK(fin.is_open());
+        UNIT_TEST_CHECK(fin.IsCompressed());
+        UNIT_TEST_CHECK(data == ReadAll(fin));
+    }
+
+    std::remove(szFileName);
+}
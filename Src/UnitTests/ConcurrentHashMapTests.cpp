@@ -0,0 +1,177 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Unit tests of ConcurrentHashMap and DeferredReclaimer
+//==============================================================================
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "UnitTest.h"
+#include "ConcurrentHashMap.h"
+
+UNIT_TEST(ConcurrentHashMap_SetFindRemove)
+{
+    ConcurrentHashMap<const void*, unsigned int> map;
+    int handles[3];
+    unsigned int uiValue = 0;
+
+    UNIT_TEST_CHECK(!map.Find(&handles[0], uiValue));
+    UNIT_TEST_CHECK(map.Set(&handles[0], 1));
+    UNIT_TEST_CHECK(map.Set(&handles[1], 2));
+    UNIT_TEST_CHECK_EQUAL(2u, map.GetSize());
+
+    UNIT_TEST_CHECK(map.Find(&handles[0], uiValue));
+    UNIT_TEST_CHECK_EQUAL(1u, uiValue);
+
+    // a released handle reused by a new object gets the new value
+    UNIT_TEST_CHECK(map.Set(&handles[0], 3));
+    UNIT_TEST_CHECK(map.Find(&handles[0], uiValue));
+    UNIT_TEST_CHECK_EQUAL(3u, uiValue);
+    UNIT_TEST_CHECK_EQUAL(2u, map.GetSize());
+
+    UNIT_TEST_CHECK(map.Remove(&handles[0]));
+    UNIT_TEST_CHECK(!map.Remove(&handles[0]));
+    UNIT_TEST_CHECK(!map.Remove(&handles[2]));
+    UNIT_TEST_CHECK(!map.Find(&handles[0], uiValue));
+    UNIT_TEST_CHECK(map.Find(&handles[1], uiValue));
+    UNIT_TEST_CHECK_EQUAL(2u, uiValue);
+    UNIT_TEST_CHECK_EQUAL(1u, map.GetSize());
+
+    map.Clear();
+    UNIT_TEST_CHECK(!map.Find(&handles[1], uiValue));
+    UNIT_TEST_CHECK_EQUAL(0u, map.GetSize());
+}
+
+UNIT_TEST(ConcurrentHashMap_InsertKeepsFirstValue)
+{
+    ConcurrentHashMap<std::string, std::string> map;
+    std::string strValue;
+
+    UNIT_TEST_CHECK(map.Insert("_Z6kernelPfi", "kernel", strValue));
+    UNIT_TEST_CHECK_EQUAL(std::string("kernel"), strValue);
+    UNIT_TEST_CHECK(map.Insert("_Z6kernelPfi", "other", strValue));
+    UNIT_TEST_CHECK_EQUAL(std::string("kernel"), strValue);
+    UNIT_TEST_CHECK(map.Find("_Z6kernelPfi", strValue));
+    UNIT_TEST_CHECK_EQUAL(std::string("kernel"), strValue);
+}
+
+UNIT_TEST(ConcurrentHashMap_Grow)
+{
+    ConcurrentHashMap<size_t, size_t> map;
+    const size_t numKeys = 100000;
+
+    for (size_t i = 0; i < numKeys; i++)
+    {
+        map.Set(i * 64, i);
+    }
+
+    UNIT_TEST_CHECK_EQUAL(numKeys, map.GetSize());
+    UNIT_TEST_CHECK(map.GetNumBuckets() * CONCURRENT_HASH_MAP_MAX_LOAD >= numKeys);
+
+    size_t numFound = 0;
+
+    for (size_t i = 0; i < numKeys; i++)
+    {
+        size_t value = 0;
+
+        if (map.Find(i * 64, value) && value == i)
+        {
+            numFound++;
+        }
+    }
+
+    UNIT_TEST_CHECK_EQUAL(numKeys, numFound);
+
+    for (size_t i = 0; i < numKeys; i += 2)
+    {
+        map.Remove(i * 64);
+    }
+
+    UNIT_TEST_CHECK_EQUAL(numKeys / 2, map.GetSize());
+}
+
+UNIT_TEST(DeferredReclaimer_ReclaimAfterReadSection)
+{
+    ConcurrentHashMap<const void*, unsigned int> map;
+    int handle = 0;
+
+    DeferredReclaimer::Instance()->Reclaim();
+    size_t numRetired = DeferredReclaimer::Instance()->GetNumRetired();
+
+    map.Set(&handle, 1);
+
+    {
+        // the entry removed while a read section is open is kept until the section ends
+        DeferredReclaimer::ReadSection section;
+        map.Remove(&handle);
+        DeferredReclaimer::Instance()->Reclaim();
+        UNIT_TEST_CHECK_EQUAL(numRetired + 1, DeferredReclaimer::Instance()->GetNumRetired());
+    }
+
+    DeferredReclaimer::Instance()->Reclaim();
+    UNIT_TEST_CHECK_EQUAL(0u, DeferredReclaimer::Instance()->GetNumRetired());
+}
+
+UNIT_TEST(ConcurrentHashMap_ConcurrentReadersAndWriter)
+{
+    // readers look up the handles while a writer registers, replaces and removes them,
+    // a handle is either not found or found with one of the values it was given
+    ConcurrentHashMap<size_t, size_t> map;
+    const size_t numKeys = 4096;
+    const unsigned int numReaders = 4;
+    std::atomic<bool> bStop(false);
+    std::atomic<size_t> numBadValues(0);
+    std::vector<std::thread> readers;
+
+    for (unsigned int i = 0; i < numReaders; i++)
+    {
+        readers.push_back(std::thread([&map, &bStop, &numBadValues, numKeys]()
+        {
+            while (!bStop.load(std::memory_order_relaxed))
+            {
+                for (size_t key = 0; key < numKeys; key++)
+                {
+                    size_t value = 0;
+
+                    if (map.Find(key, value) && value % numKeys != key)
+                    {
+                        numBadValues.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }));
+    }
+
+    for (size_t round = 0; round < 16; round++)
+    {
+        for (size_t key = 0; key < numKeys; key++)
+        {
+            map.Set(key, key + round * numKeys);
+        }
+
+        for (size_t key = round % 2; key < numKeys; key += 2)
+        {
+            map.Remove(key);
+        }
+
+        if (round % 4 == 3)
+        {
+            map.Clear();
+        }
+    }
+
+    bStop.store(true);
+
+    for (std::vector<std::thread>::iterator it = readers.begin(); it != readers.end(); ++it)
+    {
+        it->join();
+    }
+
+    UNIT_TEST_CHECK_EQUAL(0u, numBadValues.load());
+
+    DeferredReclaimer::Instance()->Reclaim();
+    UNIT_TEST_CHECK_EQUAL(0u, DeferredReclaimer::Instance()->GetNumRetired());
+}
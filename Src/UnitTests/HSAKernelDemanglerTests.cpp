@@ -0,0 +1,87 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Unit tests of the HSA kernel name demangler
+//==============================================================================
+
+#include "UnitTest.h"
+#include "HSAKernelDemangler.h"
+#include "Defs.h"
+
+/// Demangled names are reported the way "c++filt -p" prints them, spaces and commas are replaced for the output files
+/// \param strName the name printed by c++filt -p
+/// \return the name returned by DemangleKernelName
+static std::string ExpectedName(const std::string& strName)
+{
+    std::string strRet;
+
+    for (std::string::const_iterator it = strName.begin(); it != strName.end(); ++it)
+    {
+        if (*it == ' ')
+        {
+            strRet += SPACE;
+        }
+        else if (*it == ',')
+        {
+            strRet += COMMA;
+        }
+        else
+        {
+            strRet += *it;
+        }
+    }
+
+    return strRet;
+}
+
+UNIT_TEST(DemangleKernelName_CName)
+{
+    UNIT_TEST_CHECK_EQUAL(std::string("vector_add"), DemangleKernelName("vector_add"));
+}
+
+UNIT_TEST(DemangleKernelName_Function)
+{
+    UNIT_TEST_CHECK_EQUAL(std::string("kernel"), DemangleKernelName("_Z6kernelPfi"));
+    UNIT_TEST_CHECK_EQUAL(std::string("kernel"), DemangleKernelName("Z6kernelPfi"));
+    UNIT_TEST_CHECK_EQUAL(std::string("Foo::bar"), DemangleKernelName("_ZNK3Foo3barEv"));
+    UNIT_TEST_CHECK_EQUAL(ExpectedName("(anonymous namespace)::foo"), DemangleKernelName("_ZN12_GLOBAL__N_13fooEi"));
+}
+
+UNIT_TEST(DemangleKernelName_Template)
+{
+    UNIT_TEST_CHECK_EQUAL(std::string("saxpy<float>"), DemangleKernelName("_Z5saxpyIfEvT_PKS0_PS0_"));
+    UNIT_TEST_CHECK_EQUAL(std::string("ns::kernel<4>"), DemangleKernelName("_ZN2ns6kernelILi4EEEvPfRKS1_"));
+    UNIT_TEST_CHECK_EQUAL(ExpectedName("foo<int, double>"), DemangleKernelName("_Z3fooIJidEEvDpT_"));
+}
+
+UNIT_TEST(DemangleKernelName_ParenthesesInTemplateArguments)
+{
+    // the parameters are the parentheses following the name, not the last ones
+    UNIT_TEST_CHECK_EQUAL(ExpectedName("max<void (*)(int)>"), DemangleKernelName("_Z3maxIPFviEET_S2_"));
+}
+
+UNIT_TEST(DemangleKernelName_FunctionPointerReturnType)
+{
+    UNIT_TEST_CHECK_EQUAL(std::string("get<int>"), DemangleKernelName("_Z3getIiEPFvfEi"));
+}
+
+UNIT_TEST(DemangleKernelName_Operator)
+{
+    UNIT_TEST_CHECK_EQUAL(std::string("Foo::operator()"), DemangleKernelName("_ZN3FooclEi"));
+    UNIT_TEST_CHECK_EQUAL(ExpectedName("operator< <int>"), DemangleKernelName("_ZltIiEbT_S0_"));
+    UNIT_TEST_CHECK_EQUAL(ExpectedName("Foo::operator int"), DemangleKernelName("_ZN3FoocviEv"));
+    UNIT_TEST_CHECK_EQUAL(ExpectedName("main::{lambda(int)#1}::operator()"), DemangleKernelName("_ZZ4mainENKUliE_clEi"));
+}
+
+UNIT_TEST(DemangleKernelName_CloneSuffix)
+{
+    UNIT_TEST_CHECK_EQUAL(std::string("kernel"), DemangleKernelName("_Z6kernelPfi.kd"));
+}
+
+UNIT_TEST(DemangleKernelName_Cached)
+{
+    // the second lookup is served by the cache and must return the same name
+    std::string strFirst = DemangleKernelName("_Z3maxIPFviEET_S2_");
+    UNIT_TEST_CHECK_EQUAL(strFirst, DemangleKernelName("_Z3maxIPFviEET_S2_"));
+}
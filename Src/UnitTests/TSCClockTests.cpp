@@ -0,0 +1,211 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Unit tests of the calibration of TSCClock against simulated clocks
+//==============================================================================
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "UnitTest.h"
+#include "TSCClock.h"
+
+/// Interval between two calibration checks in ns
+static const ULONGLONG CHECK_INTERVAL_NANOS = TSC_CLOCK_CHECK_INTERVAL * 1000000ULL;
+
+/// Time stamp counter and default clock of a simulated machine. The counter runs
+/// at a constant rate, the default clock can run at a different rate (slewed by NTP)
+/// or jump forward
+class SimulatedClocks
+{
+public:
+    /// Constructor
+    /// \param dTicksPerNano the counter frequency in GHz
+    SimulatedClocks(double dTicksPerNano) :
+        m_dTicksPerNano(dTicksPerNano),
+        m_dReferenceRate(1.0),
+        m_ullTSC(1000000000ULL),
+        m_dNanos(5000000000.0)
+    {
+    }
+
+    /// Set the rate of the default clock
+    /// \param dPPM the difference with the counter rate in parts per million
+    void SetReferenceDrift(double dPPM) { m_dReferenceRate = 1.0 + dPPM * 1e-6; }
+
+    /// Advance both clocks
+    /// \param ullTicks the number of counter ticks
+    void Advance(ULONGLONG ullTicks)
+    {
+        m_ullTSC += ullTicks;
+        m_dNanos += static_cast<double>(ullTicks) / m_dTicksPerNano * m_dReferenceRate;
+    }
+
+    /// Advance both clocks by a duration of the default clock
+    /// \param ullNanos the duration in ns
+    void AdvanceNanos(ULONGLONG ullNanos)
+    {
+        Advance(static_cast<ULONGLONG>(static_cast<double>(ullNanos) / m_dReferenceRate * m_dTicksPerNano));
+    }
+
+    /// Move the default clock forward
+    /// \param ullNanos the jump in ns
+    void Jump(ULONGLONG ullNanos) { m_dNanos += static_cast<double>(ullNanos); }
+
+    /// Get the counter value
+    /// \return the counter value
+    ULONGLONG GetTSC() const { return m_ullTSC; }
+
+    /// Get the default clock time
+    /// \return the time in ns
+    ULONGLONG GetNanos() const { return static_cast<ULONGLONG>(m_dNanos); }
+
+private:
+    double    m_dTicksPerNano;   ///< counter frequency in GHz
+    double    m_dReferenceRate;  ///< ns of the default clock per ns of the counter
+    ULONGLONG m_ullTSC;          ///< counter value
+    double    m_dNanos;          ///< default clock time
+};
+
+/// Calibrate a clock like TSCClock::Init, 20 ms apart
+/// \param clock the clock
+/// \param clocks the simulated clocks
+/// \return true if the calibration succeeded
+static bool Calibrate(TSCClock& clock, SimulatedClocks& clocks)
+{
+    ULONGLONG ullFirstTSC = clocks.GetTSC();
+    ULONGLONG ullFirstNanos = clocks.GetNanos();
+    clocks.AdvanceNanos(TSC_CLOCK_CALIBRATION_TIME * 1000000ULL);
+    return clock.Calibrate(ullFirstTSC, ullFirstNanos, clocks.GetTSC(), clocks.GetNanos());
+}
+
+/// Get the difference between the converted counter and the default clock
+/// \param clock the clock
+/// \param clocks the simulated clocks
+/// \return the difference in ns
+static long long GetError(const TSCClock& clock, const SimulatedClocks& clocks)
+{
+    return static_cast<long long>(clock.ToNanos(clocks.GetTSC()) - clocks.GetNanos());
+}
+
+/// Run the clocks for a number of calibration intervals, converting the counter in small steps
+/// \param clock the clock
+/// \param clocks the simulated clocks
+/// \param numIntervals the number of intervals
+/// \param[in,out] ullLastNanos the last converted time, checked to never go back
+/// \param[out] llLastError the error before the last recalibration
+/// \return false if a converted time went back
+static bool RunIntervals(TSCClock& clock, SimulatedClocks& clocks, int numIntervals, ULONGLONG& ullLastNanos, long long& llLastError)
+{
+    const int STEPS_PER_INTERVAL = 100;
+    bool bMonotonic = true;
+
+    for (int i = 0; i < numIntervals; i++)
+    {
+        for (int step = 0; step < STEPS_PER_INTERVAL; step++)
+        {
+            clocks.AdvanceNanos(CHECK_INTERVAL_NANOS / STEPS_PER_INTERVAL);
+            ULONGLONG ullNanos = clock.ToNanos(clocks.GetTSC());
+            bMonotonic = bMonotonic && ullNanos >= ullLastNanos;
+            ullLastNanos = ullNanos;
+        }
+
+        llLastError = GetError(clock, clocks);
+        clock.Recalibrate(clocks.GetTSC(), clocks.GetNanos());
+
+        // the conversion of the same counter value can't go back when the calibration changes
+        ULONGLONG ullNanos = clock.ToNanos(clocks.GetTSC());
+        bMonotonic = bMonotonic && ullNanos >= ullLastNanos;
+        ullLastNanos = ullNanos;
+    }
+
+    return bMonotonic;
+}
+
+UNIT_TEST(TSCClock_Calibrate)
+{
+    TSCClock clock;
+    SimulatedClocks clocks(3.0);
+
+    UNIT_TEST_CHECK(!clock.Calibrate(100, 200, 100, 300));
+    UNIT_TEST_CHECK(!clock.Calibrate(100, 200, 150, 200));
+    UNIT_TEST_CHECK(Calibrate(clock, clocks));
+    UNIT_TEST_CHECK(std::abs(GetError(clock, clocks)) <= 1);
+
+    // 1 s later at 3 GHz
+    clocks.Advance(3000000000ULL);
+    UNIT_TEST_CHECK(std::abs(GetError(clock, clocks)) <= 10);
+
+    // a counter value read just before the reference point of the calibration
+    UNIT_TEST_CHECK_EQUAL(clock.ToNanos(clocks.GetTSC()) - 1000, clock.ToNanos(clocks.GetTSC() - 3000));
+}
+
+UNIT_TEST(TSCClock_NoDrift)
+{
+    TSCClock clock;
+    SimulatedClocks clocks(2.5);
+    ULONGLONG ullLastNanos = 0;
+    long long llLastError = 0;
+
+    UNIT_TEST_CHECK(Calibrate(clock, clocks));
+    UNIT_TEST_CHECK(RunIntervals(clock, clocks, 20, ullLastNanos, llLastError));
+    UNIT_TEST_CHECK(clock.GetMaxDrift() <= 10);
+}
+
+UNIT_TEST(TSCClock_SlewsDrift)
+{
+    TSCClock clock;
+    SimulatedClocks clocks(3.0);
+    ULONGLONG ullLastNanos = 0;
+    long long llLastError = 0;
+
+    UNIT_TEST_CHECK(Calibrate(clock, clocks));
+
+    // the default clock is slewed by 200 ppm after the calibration: up to 200 us of drift per interval
+    clocks.SetReferenceDrift(200.0);
+    UNIT_TEST_CHECK(RunIntervals(clock, clocks, 3, ullLastNanos, llLastError));
+    UNIT_TEST_CHECK(clock.GetMaxDrift() > 100000);
+    UNIT_TEST_CHECK(clock.GetMaxDrift() < 250000);
+
+    // the long term rate converges to the new rate, the timestamps stay monotonic while the drift is absorbed
+    UNIT_TEST_CHECK(RunIntervals(clock, clocks, 600, ullLastNanos, llLastError));
+    UNIT_TEST_CHECK(std::abs(llLastError) < 2000);
+    UNIT_TEST_CHECK(clock.GetMaxDrift() < 250000);
+
+    // the slew matches the default clock at the end of the next interval
+    long long llError = 0;
+    UNIT_TEST_CHECK(RunIntervals(clock, clocks, 1, ullLastNanos, llError));
+    UNIT_TEST_CHECK(std::abs(llError) <= std::max(std::abs(llLastError), 100LL));
+
+    // the default clock is slewed back the other way, the long term rate lags behind: the drift of
+    // each interval is bounded by the difference of rates and is still absorbed without going back
+    clocks.SetReferenceDrift(-200.0);
+    UNIT_TEST_CHECK(RunIntervals(clock, clocks, 600, ullLastNanos, llLastError));
+    UNIT_TEST_CHECK(std::abs(llLastError) < 450000);
+    UNIT_TEST_CHECK(clock.GetMaxDrift() > 250000);
+    UNIT_TEST_CHECK(clock.GetMaxDrift() < 450000);
+}
+
+UNIT_TEST(TSCClock_ResetsAfterJump)
+{
+    TSCClock clock;
+    SimulatedClocks clocks(3.0);
+    ULONGLONG ullLastNanos = 0;
+    long long llLastError = 0;
+
+    UNIT_TEST_CHECK(Calibrate(clock, clocks));
+    UNIT_TEST_CHECK(RunIntervals(clock, clocks, 2, ullLastNanos, llLastError));
+
+    // a drift larger than half an interval isn't slewed, the calibration is reset to the default clock
+    clocks.AdvanceNanos(CHECK_INTERVAL_NANOS);
+    clocks.Jump(CHECK_INTERVAL_NANOS);
+    clock.Recalibrate(clocks.GetTSC(), clocks.GetNanos());
+    UNIT_TEST_CHECK(std::abs(GetError(clock, clocks)) <= 1);
+    UNIT_TEST_CHECK(clock.GetMaxDrift() >= CHECK_INTERVAL_NANOS - 10);
+
+    // a counter value older than the initial calibration is ignored
+    ULONGLONG ullNanos = clock.ToNanos(clocks.GetTSC());
+    clock.Recalibrate(1, clocks.GetNanos() + CHECK_INTERVAL_NANOS);
+    UNIT_TEST_CHECK_EQUAL(ullNanos, clock.ToNanos(clocks.GetTSC()));
+}
@@ -0,0 +1,57 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Minimal unit test registration and check macros of RCPUnitTests
+//==============================================================================
+
+#ifndef _UNIT_TEST_H_
+#define _UNIT_TEST_H_
+
+#include <string>
+#include <sstream>
+
+/// Unit test function
+typedef void (*UnitTestFunc)();
+
+/// Register a unit test, called by the UNIT_TEST macro during static initialization
+/// \param szName the name of the test
+/// \param func the test function
+/// \return true
+bool RegisterUnitTest(const char* szName, UnitTestFunc func);
+
+/// Report a failed check of the running test, called by the UNIT_TEST_CHECK macros
+/// \param szFile the source file of the check
+/// \param line the line of the check
+/// \param strMessage the description of the failure
+void ReportUnitTestFailure(const char* szFile, int line, const std::string& strMessage);
+
+/// Define and register a unit test
+#define UNIT_TEST(name)                                                          \
+    static void name();                                                          \
+    static const bool name##_registered = RegisterUnitTest(#name, name);         \
+    static void name()
+
+/// Check a condition, the test continues after a failed check
+#define UNIT_TEST_CHECK(cond)                                                    \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            ReportUnitTestFailure(__FILE__, __LINE__, #cond);                    \
+        }                                                                        \
+    } while (0)
+
+/// Check that two values are equal, the values are printed when they are not
+#define UNIT_TEST_CHECK_EQUAL(expected, actual)                                  \
+    do                                                                           \
+    {                                                                            \
+        if (!((expected) == (actual)))                                           \
+        {                                                                        \
+            std::ostringstream ss;                                               \
+            ss << #actual << " is " << (actual) << ", expected " << (expected);  \
+            ReportUnitTestFailure(__FILE__, __LINE__, ss.str());                 \
+        }                                                                        \
+    } while (0)
+
+#endif // _UNIT_TEST_H_
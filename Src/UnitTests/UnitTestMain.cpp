@@ -0,0 +1,81 @@
+//==============================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools Team
+/// \file
+/// \brief  Entry point of RCPUnitTests, runs the registered unit tests
+//==============================================================================
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "UnitTest.h"
+
+/// Registered unit test
+struct UnitTestInfo
+{
+    const char*  m_szName;  ///< name of the test
+    UnitTestFunc m_func;    ///< test function
+};
+
+/// Get the registered unit tests, constructed on first use since the tests register during static initialization
+/// \return the unit tests
+static std::vector<UnitTestInfo>& GetUnitTests()
+{
+    static std::vector<UnitTestInfo> s_unitTests;
+    return s_unitTests;
+}
+
+/// Number of failed checks of the running test
+static unsigned int s_numFailures = 0;
+
+bool RegisterUnitTest(const char* szName, UnitTestFunc func)
+{
+    UnitTestInfo info = { szName, func };
+    GetUnitTests().push_back(info);
+    return true;
+}
+
+void ReportUnitTestFailure(const char* szFile, int line, const std::string& strMessage)
+{
+    printf("%s:%d: check failed: %s\n", szFile, line, strMessage.c_str());
+    s_numFailures++;
+}
+
+/// Runs all unit tests, or the tests whose name contains one of the arguments
+/// \return the number of failed tests
+int main(int argc, char* argv[])
+{
+    unsigned int numRun = 0;
+    unsigned int numFailed = 0;
+
+    for (std::vector<UnitTestInfo>::const_iterator it = GetUnitTests().begin(); it != GetUnitTests().end(); ++it)
+    {
+        bool bSelected = argc < 2;
+
+        for (int i = 1; i < argc && !bSelected; i++)
+        {
+            bSelected = strstr(it->m_szName, argv[i]) != nullptr;
+        }
+
+        if (!bSelected)
+        {
+            continue;
+        }
+
+        s_numFailures = 0;
+        it->m_func();
+        numRun++;
+
+        if (s_numFailures > 0)
+        {
+            numFailed++;
+        }
+
+        printf("[%s] %s\n", s_numFailures > 0 ? "FAILED" : "PASSED", it->m_szName);
+    }
+
+    printf("%u tests run, %u failed\n", numRun, numFailed);
+
+    return static_cast<int>(numFailed);
+}
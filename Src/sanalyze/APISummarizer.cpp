@@ -8,6 +8,7 @@
 #include <iostream>
 #include <set>
 #include <fstream>
+#include <cmath>
 #include "APISummarizer.h"
 #include "AnalyzerHTMLUtils.h"
 #include "../Common/Logger.h"
@@ -46,11 +47,16 @@ void APISummarizer<T>::OnParse(T* pAPIInfo, bool& stopParsing)
     }
     else
     {
-        duration = pAPIInfo->m_ullEnd - pAPIInfo->m_ullStart;
+        duration = pAPIInfo->GetTotalTime();
     }
 
     m_ullTotalTime += duration;
 
+    // an entry collapsing a run of identical calls counts as that many calls, each taking the average time of the run
+    ULONGLONG numCalls = pAPIInfo->m_uiRepeatCount > 0 ? pAPIInfo->m_uiRepeatCount : 1;
+    ULONGLONG totalDuration = duration;
+    duration /= numCalls;
+
     if (pAPIInfo->m_strName.length() > 0)
     {
         APICountMap::iterator it = m_APICountMap.find(pAPIInfo->m_strName);
@@ -59,8 +65,8 @@ void APISummarizer<T>::OnParse(T* pAPIInfo, bool& stopParsing)
         {
             APISummaryItems si;
             si.strName = pAPIInfo->m_strName;
-            si.uiNumCalls = 1;
-            si.ullTotalTime = duration;
+            si.ullNumCalls = numCalls;
+            si.ullTotalTime = totalDuration;
             si.ullAve = si.ullMax = duration;
             si.uiMaxCallIndex = pAPIInfo->m_uiSeqID;
             si.uiMinCallIndex = pAPIInfo->m_uiSeqID;
@@ -78,8 +84,8 @@ void APISummarizer<T>::OnParse(T* pAPIInfo, bool& stopParsing)
         else
         {
             APISummaryItems& si = it->second;
-            si.ullTotalTime += duration;
-            si.uiNumCalls++;
+            si.ullTotalTime += totalDuration;
+            si.ullNumCalls += numCalls;
 
             if (duration > si.ullMax)
             {
@@ -94,7 +100,7 @@ void APISummarizer<T>::OnParse(T* pAPIInfo, bool& stopParsing)
                 si.minTid = pAPIInfo->m_tid;
             }
 
-            si.ullAve = si.ullTotalTime / si.uiNumCalls;
+            si.ullAve = si.ullTotalTime / si.ullNumCalls;
         }
     }
 }
@@ -105,12 +111,12 @@ void APISummarizer<T>::Debug()
     //unsigned int sum = 0;
     //for( APICountMap::iterator it = m_APICountMap.begin(); it != m_APICountMap.end(); it++ )
     //{
-    //   cout << "# of " << it->first << " = " << it->second.uiNumCalls << endl;
+    //   cout << "# of " << it->first << " = " << it->second.ullNumCalls << endl;
     //   cout << "Total time " << it->first << " = " << it->second.ullTotalTime << endl;
     //   cout << "Max time " << it->first << " = " << it->second.ullMax << endl;
     //   cout << "Min time " << it->first << " = " << it->second.ullMin << endl;
     //   cout << "Ave time " << it->first << " = " << it->second.ullAve << endl;
-    //   sum += it->second.uiNumCalls;
+    //   sum += it->second.ullNumCalls;
     //}
     //cout << "Total = " << sum << endl;
 
@@ -123,7 +129,7 @@ void APISummarizer<T>::Debug()
 
     for (multiset<APISummaryItems*, MemberCmp<APISummaryItems, ULONGLONG, &APISummaryItems::ullTotalTime> >::iterator it = sortedList.begin(); it != sortedList.end(); it++)
     {
-        cout << (*it)->strName << " | " << (*it)->uiNumCalls << " | " << (*it)->ullMin << " | " << (*it)->ullMax << " | " << (*it)->ullAve << endl;
+        cout << (*it)->strName << " | " << (*it)->ullNumCalls << " | " << (*it)->ullMin << " | " << (*it)->ullMax << " | " << (*it)->ullAve << endl;
     }
 }
 
@@ -137,6 +143,9 @@ void APISummarizer<T>::GenerateHTMLTable(std::ostream& sout)
         sortedList.insert(&it->second);
     }
 
+    // the calls aren't available when the statistics were loaded from an API statistics file
+    bool bFromAPIStatistics = !m_APIHistogramMap.empty();
+
     HTMLTable table;
     table.AddColumn("API Name")
     .AddColumn("Cumulative Time(ms)", true, true)
@@ -146,6 +155,12 @@ void APISummarizer<T>::GenerateHTMLTable(std::ostream& sout)
     .AddColumn("Max Time(ms)", true, true)
     .AddColumn("Min Time(ms)", true, true);
 
+    if (bFromAPIStatistics)
+    {
+        table.AddColumn("Median Time(ms, approx.)", true, true)
+        .AddColumn("99th Percentile Time(ms, approx.)", true, true);
+    }
+
     for (multiset<APISummaryItems*, MemberCmp<APISummaryItems, ULONGLONG, &APISummaryItems::ullTotalTime> >::reverse_iterator it = sortedList.rbegin(); it != sortedList.rend(); it++)
     {
         HTMLTableRow row(&table);
@@ -154,17 +169,9 @@ void APISummarizer<T>::GenerateHTMLTable(std::ostream& sout)
         row.AddItem(1, StringUtils::NanosecToMillisec((*it)->ullTotalTime));
         double percentage = ((double)(*it)->ullTotalTime / (double)m_ullTotalTime) * 100.0;
         row.AddItem(2, StringUtils::ToStringPrecision(percentage, 5));
-        row.AddItem(3, StringUtils::ToString((*it)->uiNumCalls));
+        row.AddItem(3, StringUtils::ToString((*it)->ullNumCalls));
         row.AddItem(4, StringUtils::NanosecToMillisec((*it)->ullAve));
 
-        std::string keyValues;
-        keyValues = GenerateHTMLKeyValue(gs_THREAD_ID_TAG, (*it)->maxTid);
-        keyValues = AppendHTMLKeyValue(keyValues, GenerateHTMLKeyValue(gs_SEQUENCE_ID_TAG, (*it)->uiMaxCallIndex));
-        keyValues = AppendHTMLKeyValue(keyValues, GenerateHTMLKeyValue(gs_VIEW_TAG, gs_VIEW_TIMELINE_HOST_TAG));
-        std::string hRef = GenerateHref(keyValues, StringUtils::NanosecToMillisec((*it)->ullMax));
-
-        row.AddItem(5, hRef);
-
         // if all instances of this API reported zero (or negative) time, then show zero for the minimum -- see bug 6307
         ULONGLONG min = (*it)->ullMin;
 
@@ -173,6 +180,26 @@ void APISummarizer<T>::GenerateHTMLTable(std::ostream& sout)
             min = 0;
         }
 
+        if (bFromAPIStatistics)
+        {
+            const std::vector<ULONGLONG>& histogram = m_APIHistogramMap[(*it)->strName];
+
+            row.AddItem(5, StringUtils::NanosecToMillisec((*it)->ullMax));
+            row.AddItem(6, StringUtils::NanosecToMillisec(min));
+            row.AddItem(7, StringUtils::NanosecToMillisec(GetHistogramPercentile(**it, histogram, 50.0)));
+            row.AddItem(8, StringUtils::NanosecToMillisec(GetHistogramPercentile(**it, histogram, 99.0)));
+            table.AddRow(row);
+            continue;
+        }
+
+        std::string keyValues;
+        keyValues = GenerateHTMLKeyValue(gs_THREAD_ID_TAG, (*it)->maxTid);
+        keyValues = AppendHTMLKeyValue(keyValues, GenerateHTMLKeyValue(gs_SEQUENCE_ID_TAG, (*it)->uiMaxCallIndex));
+        keyValues = AppendHTMLKeyValue(keyValues, GenerateHTMLKeyValue(gs_VIEW_TAG, gs_VIEW_TIMELINE_HOST_TAG));
+        std::string hRef = GenerateHref(keyValues, StringUtils::NanosecToMillisec((*it)->ullMax));
+
+        row.AddItem(5, hRef);
+
         keyValues = GenerateHTMLKeyValue(gs_THREAD_ID_TAG, (*it)->minTid);
         keyValues = AppendHTMLKeyValue(keyValues, GenerateHTMLKeyValue(gs_SEQUENCE_ID_TAG, (*it)->uiMinCallIndex));
         keyValues = AppendHTMLKeyValue(keyValues, GenerateHTMLKeyValue(gs_VIEW_TAG, gs_VIEW_TIMELINE_HOST_TAG));
@@ -221,5 +248,73 @@ bool APISummarizer<T>::GenerateHTMLPage(const char* szFileName)
     return retVal;
 }
 
+template<class T>
+void APISummarizer<T>::LoadAPIStatistics(const std::vector<APIStatisticsRecord>& records)
+{
+    m_APICountMap.clear();
+    m_APIHistogramMap.clear();
+    m_ullTotalTime = 0;
+
+    for (std::vector<APIStatisticsRecord>::const_iterator it = records.begin(); it != records.end(); ++it)
+    {
+        if (it->m_strName.empty() || 0 == it->m_ullNumCalls)
+        {
+            continue;
+        }
+
+        APISummaryItems& si = m_APICountMap[it->m_strName];
+        si.strName = it->m_strName;
+        si.ullNumCalls = it->m_ullNumCalls;
+        si.ullTotalTime = it->m_ullTotalTime;
+        si.ullMax = it->m_ullMaxTime;
+        si.ullAve = it->m_ullTotalTime / it->m_ullNumCalls;
+
+        // a zero min time means that all calls took 0 ns, see GenerateHTMLTable
+        if (0 != it->m_ullMinTime)
+        {
+            si.ullMin = it->m_ullMinTime;
+        }
+
+        m_APIHistogramMap[it->m_strName] = it->m_histogram;
+        m_ullTotalTime += it->m_ullTotalTime;
+    }
+}
+
+template<class T>
+ULONGLONG APISummarizer<T>::GetHistogramPercentile(const APISummaryItems& item, const std::vector<ULONGLONG>& histogram, double percentile)
+{
+    ULONGLONG ullTarget = static_cast<ULONGLONG>(ceil(item.ullNumCalls * percentile / 100.0));
+    ULONGLONG ullCount = 0;
+    ULONGLONG ullValue = item.ullMax;
+
+    for (unsigned int uiBin = 0; uiBin < histogram.size(); uiBin++)
+    {
+        ullCount += histogram[uiBin];
+
+        if (ullCount >= ullTarget)
+        {
+            // upper bound of the bin, the last bin has no upper bound
+            if (uiBin + 1 < histogram.size())
+            {
+                ullValue = APIStatistics::GetHistogramBinStart(uiBin + 1);
+            }
+
+            break;
+        }
+    }
+
+    if (ullValue > item.ullMax)
+    {
+        ullValue = item.ullMax;
+    }
+
+    if (ullValue < item.ullMin && item.ullMin != (ULONGLONG) - 1)
+    {
+        ullValue = item.ullMin;
+    }
+
+    return ullValue;
+}
+
 template class APISummarizer<CLAPIInfo>;
 template class APISummarizer<HSAAPIInfo>;
@@ -10,6 +10,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <AMDTOSWrappers/Include/osOSDefinitions.h>
 
@@ -17,6 +18,7 @@
 #include "../HSAFdnTrace/HSAAPIInfo.h"
 #include "../Common/IParserListener.h"
 #include "../Common/OSUtils.h"
+#include "../Common/APIStatistics.h"
 
 //------------------------------------------------------------------------------------
 /// API Summary Items struct
@@ -24,7 +26,7 @@
 struct APISummaryItems
 {
     std::string strName;         ///< API name
-    unsigned int uiNumCalls;     ///< Number of Calls
+    ULONGLONG ullNumCalls;       ///< Number of Calls
     unsigned int uiNumErrors;    ///< Number of Errors
     ULONGLONG ullTotalTime;      ///< Total time
     ULONGLONG ullMax;            ///< Max time
@@ -39,7 +41,8 @@ struct APISummaryItems
     APISummaryItems()
     {
         strName.clear();
-        uiNumCalls = uiNumErrors = 0;
+        ullNumCalls = 0;
+        uiNumErrors = 0;
         ullTotalTime = 0;
         ullMax = 0;
         ullMin = (ULONGLONG) - 1; // init to maximum ulonglong
@@ -55,7 +58,7 @@ struct APISummaryItems
     APISummaryItems(const APISummaryItems& obj)
     {
         strName = obj.strName;
-        uiNumCalls = obj.uiNumCalls;
+        ullNumCalls = obj.ullNumCalls;
         uiNumErrors = obj.uiNumErrors;
         ullTotalTime = obj.ullTotalTime;
         ullMax = obj.ullMax;
@@ -75,7 +78,7 @@ struct APISummaryItems
         if (this != &obj)
         {
             strName = obj.strName;
-            uiNumCalls = obj.uiNumCalls;
+            ullNumCalls = obj.ullNumCalls;
             uiNumErrors = obj.uiNumErrors;
             ullTotalTime = obj.ullTotalTime;
             ullMax = obj.ullMax;
@@ -125,6 +128,12 @@ public:
     /// \return true if the page was generated, false otherwise
     bool GenerateHTMLPage(const char* szFileName);
 
+    /// Load the statistics read from an API statistics (.apistats) file instead of parsing an atp file.
+    /// Replaces the summary of the parsed entries, which only covers the recorded calls of a sampled trace.
+    /// The min/max times can't be linked to a call and the page gets approximate percentile columns instead
+    /// \param records the statistics of each API
+    void LoadAPIStatistics(const std::vector<APIStatisticsRecord>& records);
+
 protected:
     APICountMap m_APICountMap;       /// API map key = API Name
 private:
@@ -137,7 +146,15 @@ private:
     /// \return ref to itself
     const APISummarizer& operator = (const APISummarizer& obj);
 
+    /// Get an approximate percentile of the call durations of an API from its latency histogram
+    /// \param item the API summary item
+    /// \param histogram the latency histogram of the API
+    /// \param percentile the percentile in [0, 100]
+    /// \return the upper bound of the histogram bin containing the percentile, clamped to the min and max time
+    static ULONGLONG GetHistogramPercentile(const APISummaryItems& item, const std::vector<ULONGLONG>& histogram, double percentile);
+
     ULONGLONG m_ullTotalTime;  ///< Cumulative total time of all API calls (used to calculate % time of each API call)
+    std::map<std::string, std::vector<ULONGLONG> > m_APIHistogramMap; ///< Latency histograms loaded from an API statistics file, key = API Name
 };
 
 typedef class APISummarizer<CLAPIInfo> CLAPISummarizer;
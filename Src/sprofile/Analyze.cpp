@@ -28,6 +28,27 @@
 #include "../sanalyze/HSAObjRefTracker.h"
 #include "../Common/FileUtils.h"
 #include "../Common/HTMLTable.h"
+#include "../Common/APIStatistics.h"
+#include "../Common/ProfilerOutputFileDefs.h"
+
+/// Replace the API summary of a sampled trace with the statistics of all calls
+/// \param strStatisticsFile the API statistics file written by the agent
+/// \param apiSum the API summarizer
+template <class T>
+static void LoadSampledAPIStatistics(const std::string& strStatisticsFile, APISummarizer<T>& apiSum)
+{
+    std::string strModuleName;
+    std::vector<APIStatisticsRecord> records;
+
+    if (FileUtils::FileExist(strStatisticsFile) && APIStatistics::ReadFromFile(strStatisticsFile, strModuleName, records))
+    {
+        apiSum.LoadAPIStatistics(records);
+    }
+    else
+    {
+        std::cout << "Unable to read API statistics file: " << strStatisticsFile << ". The API summary only includes the sampled API calls." << std::endl;
+    }
+}
 
 bool APITraceAnalyze(const Config& config)
 {
@@ -163,6 +184,19 @@ bool APITraceAnalyze(const Config& config)
 
     if (config.analyzeOps.bAPISummary)
     {
+        // the agents count all calls of a sampled trace in <base>.<modName>.apistats
+        std::string strBaseFile = FileUtils::GetBaseFileName(config.analyzeOps.strAtpFile);
+
+        if (clFile.IsAPISampled())
+        {
+            LoadSampledAPIStatistics(strBaseFile + "." + CL_PART_NAME + "." + API_STATISTICS_EXT, clApiSum);
+        }
+
+        if (hsaTrace.IsAPISampled())
+        {
+            LoadSampledAPIStatistics(strBaseFile + "." + HSA_PART_NAME + "." + API_STATISTICS_EXT, hsaApiSum);
+        }
+
         summaryPagesGenerated |= clApiSum.GenerateHTMLPage((filePrefix + CLAPI_SUM).c_str());
         summaryPagesGenerated |= hsaApiSum.GenerateHTMLPage((filePrefix + HSAAPI_SUM).c_str());
         anySummaryPageShouldBeGenerated = true;
@@ -225,3 +259,85 @@ bool APITraceAnalyze(const Config& config)
 
     return true;
 }
+
+bool APIStatisticsAnalyze(const Config& config)
+{
+    std::string strInputFile = config.analyzeOps.strAtpFile;
+    std::vector<std::string> statisticsFiles;
+    std::string strBaseFile;
+
+    if (FileUtils::GetFileExtension(strInputFile) == API_STATISTICS_EXT)
+    {
+        // <base>.<modName>.apistats
+        statisticsFiles.push_back(strInputFile);
+        strBaseFile = FileUtils::GetBaseFileName(FileUtils::GetBaseFileName(strInputFile));
+    }
+    else
+    {
+        // the agents write <base>.ocl.apistats and <base>.hsa.apistats, see APIInfoManagerBase::SetOutputFile
+        std::string strExtension = FileUtils::GetFileExtension(strInputFile);
+        bool bStripExtension = strExtension == TRACE_EXT || strExtension == OCCUPANCY_EXT || strExtension == PERF_COUNTER_EXT;
+        strBaseFile = bStripExtension ? FileUtils::GetBaseFileName(strInputFile) : strInputFile;
+        statisticsFiles.push_back(strBaseFile + "." + CL_PART_NAME + "." + API_STATISTICS_EXT);
+        statisticsFiles.push_back(strBaseFile + "." + HSA_PART_NAME + "." + API_STATISTICS_EXT);
+    }
+
+    CLAPISummarizer clApiSum;
+    HSAAPISummarizer hsaApiSum;
+    bool bFileLoaded = false;
+
+    std::cout << "Generating summary pages...\n";
+
+    for (std::vector<std::string>::const_iterator it = statisticsFiles.begin(); it != statisticsFiles.end(); ++it)
+    {
+        if (!FileUtils::FileExist(*it))
+        {
+            continue;
+        }
+
+        std::string strModuleName;
+        std::vector<APIStatisticsRecord> records;
+
+        if (!APIStatistics::ReadFromFile(*it, strModuleName, records))
+        {
+            std::cout << "Unable to read API statistics file: " << *it << std::endl;
+            continue;
+        }
+
+        if (strModuleName == CL_PART_NAME)
+        {
+            clApiSum.LoadAPIStatistics(records);
+        }
+        else if (strModuleName == HSA_PART_NAME)
+        {
+            hsaApiSum.LoadAPIStatistics(records);
+        }
+
+        bFileLoaded = true;
+    }
+
+    if (!bFileLoaded)
+    {
+        std::cout << "Unable to find API statistics file for: " << strInputFile << std::endl;
+        return false;
+    }
+
+    if (!config.analyzeOps.bAPISummary)
+    {
+        std::cout << "Only the API summary pages can be generated from API statistics files\n";
+        return true;
+    }
+
+    std::string filePrefix = strBaseFile + '.';
+    bool summaryPagesGenerated = false;
+
+    summaryPagesGenerated |= clApiSum.GenerateHTMLPage((filePrefix + CLAPI_SUM).c_str());
+    summaryPagesGenerated |= hsaApiSum.GenerateHTMLPage((filePrefix + HSAAPI_SUM).c_str());
+
+    if (!summaryPagesGenerated)
+    {
+        std::cout << "No summary pages generated\n";
+    }
+
+    return true;
+}
@@ -31,4 +31,9 @@
 
 bool APITraceAnalyze(const Config& config);
 
+/// Generate the API summary pages from the API statistics (.apistats) files written in API statistics mode
+/// \param config the config, analyzeOps.strAtpFile is either the trace output file or an .apistats file
+/// \return true if the statistics files could be read
+bool APIStatisticsAnalyze(const Config& config);
+
 #endif //_ANALYZE_H_
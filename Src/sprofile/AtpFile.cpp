@@ -13,6 +13,7 @@
 #include "../Common/StringUtils.h"
 #include "../Common/FileUtils.h"
 #include "../Common/ATPFileUtils.h"
+#include "../Common/CompressedStream.h"
 
 #include <AMDTOSWrappers/Include/osFilePath.h>
 #include <AMDTOSWrappers/Include/osFile.h>
@@ -153,6 +154,11 @@ void AtpFileWriter::SaveToAtpFile()
         {
             remove(strOutputFile.c_str());
         }
+        else if (m_config.bCompressOutput)
+        {
+            // SP_fileStream is a wide stream on Windows, so the text is compressed once the file is complete
+            CompressedOutputBuffer::CompressFile(strOutputFile);
+        }
     }
     else
     {
@@ -254,7 +254,35 @@ void CheckOutputFile(const Config& configInner)
     std::string strOutputFile("");
     std::string strRequiredExt("");
 
-    if (configInner.bTrace || configInner.bHSATrace || configInner.bMergeMode)
+    if ((configInner.bTrace || configInner.bHSATrace) && configInner.bAPIStatisticsOnly)
+    {
+        // the agents write <base>.<modName>.apistats instead of trace fragments
+        strOutputFile = FileUtils::GetBaseFileName(GetExpectedOutputFile(configInner.strOutputFile, TRACE_EXT));
+        std::vector<std::string> statisticsFiles;
+
+        if (configInner.bTrace)
+        {
+            statisticsFiles.push_back(strOutputFile + "." + CL_PART_NAME + "." + API_STATISTICS_EXT);
+        }
+
+        if (configInner.bHSATrace)
+        {
+            statisticsFiles.push_back(strOutputFile + "." + HSA_PART_NAME + "." + API_STATISTICS_EXT);
+        }
+
+        for (std::vector<std::string>::const_iterator it = statisticsFiles.begin(); it != statisticsFiles.end(); ++it)
+        {
+            if (FileUtils::FileExist(*it))
+            {
+                std::cout << "Session output path: " << *it << std::endl;
+            }
+            else
+            {
+                std::cout << "Failed to generate profile result " << *it << "." << std::endl;
+            }
+        }
+    }
+    else if (configInner.bTrace || configInner.bHSATrace || configInner.bMergeMode)
     {
         strRequiredExt.assign(TRACE_EXT);
         strOutputFile = GetExpectedOutputFile(configInner.strOutputFile, strRequiredExt);
@@ -572,11 +600,14 @@ int ProfileApplication(const std::string& strCounterFile, const int& profilerBit
     params.m_bQueryRetStat = config.bQueryRetStat;
     params.m_bCollapseClGetEventInfo = config.bCollapseClGetEventInfo;
     params.m_bUserTimer = config.bUserTimer;
+    params.m_bTSCTimer = config.bTSCTimer;
+    params.m_bCompressOutput = config.bCompressOutput;
+    params.m_bOfflineSymbols = config.bOfflineSymbols;
     params.m_strTimerDLLFile = config.strTimerDLLFile;
     params.m_strUserTimerFn = config.strUserTimerFn;
     params.m_strUserTimerInitFn = config.strUserTimerInitFn;
     params.m_strUserTimerDestroyFn = config.strUserTimerDestroyFn;
-    params.m_bStackTrace = config.bSym;
+    params.m_bStackTrace = config.bSym && !config.bAPIStatisticsOnly;
     params.m_uiMaxNumOfAPICalls = config.uiMaxNumOfAPICalls;
     params.m_uiMaxKernels = config.uiMaxKernels;
     params.m_bKernelOccupancy = config.bOccupancy;
@@ -599,7 +630,18 @@ int ProfileApplication(const std::string& strCounterFile, const int& profilerBit
     params.m_uiForcedGpuIndex = config.uiForcedGpuIndex;
     params.m_bAqlPacketTracing = config.bAqlPacketTracing;
     params.m_bDisableKernelDemangling = config.bDisableKernelDemangling;
-    params.m_bNoHSATransferTime = config.bNoHSATransferTime;
+    params.m_bAPIStatisticsOnly = config.bAPIStatisticsOnly;
+    // async copies are not traced when only the API statistics are collected
+    params.m_bNoHSATransferTime = config.bNoHSATransferTime || config.bAPIStatisticsOnly;
+    params.m_bThreadTraceBuffer = !config.bNoThreadTraceBuffer;
+    params.m_uiFragmentBufferSize = config.uiFragmentBufferSize;
+    params.m_uiFlushWatermark = config.uiFlushWatermark;
+    params.m_uiMaxPendingTraceEntries = config.uiMaxPendingTraceEntries;
+    params.m_uiSpillEntryThreshold = config.uiSpillEntryThreshold;
+    params.m_uiBackpressureTimeout = config.uiBackpressureTimeout;
+    params.m_uiFlightRecorderEntries = config.uiFlightRecorderEntries;
+    params.m_uiFlightRecorderSeconds = config.uiFlightRecorderSeconds;
+    params.m_uiFlightRecorderLatencyTrigger = config.uiFlightRecorderLatencyTrigger;
 
 #ifdef AMDT_INTERNAL
 
@@ -910,7 +952,9 @@ int ProcessCommandLine(const std::string& strCounterFile)
     //----------------------------------------
     if (config.bAnalyze)
     {
-        if (!APITraceAnalyze(config))
+        bool bAPIStatistics = config.bAPIStatisticsOnly || FileUtils::GetFileExtension(config.analyzeOps.strAtpFile) == API_STATISTICS_EXT;
+
+        if (!(bAPIStatistics ? APIStatisticsAnalyze(config) : APITraceAnalyze(config)))
         {
             std::cout << "\nFailed to generate summary pages\n";
             retVal = -1;
@@ -989,6 +1033,7 @@ bool MergeKernelProfileOutputFiles(std::vector<std::string> counterFileList,
             }
 
             CSVFileWriter mergedFileWriter(collatedOutputFileName);
+            mergedFileWriter.SetCompression(config.bCompressOutput);
             std::map<std::string, std::vector<int>> counterColumns;
             std::map<std::string, std::vector<int>>::iterator counterColumnsIterator;
             std::vector<std::string> csvFileColumns;
@@ -1387,7 +1432,8 @@ static void MergeTraceFile(int sig)
 {
     SP_UNREFERENCED_PARAMETER(sig);
 
-    if ((config.bTrace || config.bHSATrace || config.bMergeMode) && processId > 0)
+    // nothing to merge when only the API statistics are collected
+    if ((config.bTrace || config.bHSATrace || config.bMergeMode) && !config.bAPIStatisticsOnly && processId > 0)
     {
         std::string pid = StringUtils::ToString(processId);
         AtpFileWriter writer(config, pid);
@@ -1504,7 +1550,7 @@ static bool SetHSAServer(const gtString& strDirPathUnicode)
 
     OSUtils::Instance()->SetEnvVar(HSA_ENABLE_PROFILING_ENV_VAR, strServerPath.c_str());
 
-    if (config.bHSATrace)
+    if (config.bHSATrace && !config.bAPIStatisticsOnly)
     {
         OSUtils::Instance()->SetEnvVar(ROCP_TIMESTAMP_ON_ENV_VAR_NAME, "1");
     }
@@ -158,7 +158,7 @@ bool ParseCmdLine(int argc, wchar_t* argv[], Config& configOut)
 
         po::options_description apiTraceOpt("Application Trace mode options (for --apitrace or --hsatrace)");
         apiTraceOpt.add_options()
-        ("apifilterfile,F", po::value<string>(), "Path to the API filter file which contains a list of OpenCL or HSA APIs to be filtered out when performing an API trace.")
+        ("apifilterfile,F", po::value<string>(), "Path to the API filter file which contains a list of OpenCL or HSA APIs to be filtered out when performing an API trace. The file can also contain API sampling directives: SampleRate=<API|*>,<N> records one in N calls, SampleBudget=<API|*>,<calls>[,<ms>] records at most <calls> calls per time window (default 1000 ms), SampleLatency=<us> always records slower calls and SampleFirstCalls=<N> always records the first N calls of each API (default 10). The API summary of a sampled trace is built from the .apistats file, which counts all calls.")
 #ifdef _WIN32
         ("interval,i", po::value<unsigned int>()->default_value(DEFAULT_TIMEOUT_INTERVAL), "Timeout interval in milliseconds. Ignored when not using timeout mode.")
 #else
@@ -168,7 +168,11 @@ bool ParseCmdLine(int argc, wchar_t* argv[], Config& configOut)
         ("timeout,m", "Flush Trace data periodically, default timeout interval is 100 milliseconds (can be changed with -i option).")
 #endif
         ("maxapicalls,M", po::value<unsigned int>()->default_value(1000000), "Maximum number of API calls.")
-        ("nocollapse,n", "Do not collapse consecutive identical clGetEventInfo calls into a single call in the trace output.")
+        ("nocollapse,n", "Do not collapse consecutive identical calls to the polling APIs (clGetEventInfo, hsa_signal_load_*, hsa_signal_wait_*) into a single call in the trace output.")
+        ("apistatsonly", "Only collect per-API statistics (number of calls, total/min/max time and a latency histogram) instead of a full API trace. The statistics are written to a .apistats file whose size doesn't depend on the length of the run. Use with --tracesummary (-t) to generate the API summary pages.")
+        ("flightrecorder", po::value<unsigned int>(), "Flight recorder mode: only keep the N most recent API calls of each thread in memory and write them to the trace when a dump is triggered (SIGUSR2 on Linux, amdtCodeXLStopProfiling or --flightrecorderlatency). Enables timeout mode.")
+        ("flightrecorderseconds", po::value<unsigned int>(), "Flight recorder mode: only keep the API calls of the last T seconds in memory. Can be combined with --flightrecorder.")
+        ("flightrecorderlatency", po::value<unsigned int>(), "Trigger a flight recorder dump when an API call takes longer than the specified number of microseconds.")
         ("ret,r", "Always include the OpenCL API return code in API trace even if client application doesn't query it.")
         ("sym,y", "Include symbol information for each API in the .atp file.");
 
@@ -193,7 +197,7 @@ bool ParseCmdLine(int argc, wchar_t* argv[], Config& configOut)
 
         po::options_description traceSummaryOpt("Trace Summary mode options (for --tracesummary)");
         traceSummaryOpt.add_options()
-        ("atpfile,a", po::value<string>(), "Path to the .atp file from which to generate summary pages. Optional when performing an API trace. Required if --tracesummary is specified when not performing an API trace.")
+        ("atpfile,a", po::value<string>(), "Path to the .atp file (or .apistats file written with --apistatsonly) from which to generate summary pages. Optional when performing an API trace. Required if --tracesummary is specified when not performing an API trace.")
         ("apirulesfile,R", po::value<string>(), "Path to OpenCL API analyzer configuration file. If not specified, all rules are enabled.");
 
         po::options_description occupancyDisplayOpt("Occupancy display mode options (for --occupancydisplay)");
@@ -213,6 +217,15 @@ bool ParseCmdLine(int argc, wchar_t* argv[], Config& configOut)
         ("__nodetours__", "Don't launch application using detours.")
         ("__nostableclocks__", "Disable calling VkStableClocks.")
         ("__nohsatransfertime__", "Disable collection of HSA data transfer timing data.")
+        ("__tsctimer__", "Use the invariant CPU time stamp counter (rdtsc) for API timestamps, calibrated against the default timer. Reverts to the default timer if the counter is not invariant.")
+        ("__compress__", "Write the tmp trace fragments, the .atp file and the kernel profile .csv files as independently compressed blocks. rcprof, sanalyze and the ProfileDataParser library read the compressed files transparently.")
+        ("__offlinesymbols__", "Record the stack traces (--sym) as raw return addresses and a map of the loaded modules with their build IDs. rcprof resolves the source lines when it merges the stack traces, the application doesn't pay for symbolization. Linux only.")
+        ("__nothreadtracebuffer__", "Store API trace entries in the shared, locked trace map instead of per-thread buffers.")
+        ("__fragmentbuffersize__", po::value<unsigned int>(), "Buffer size in KB of the tmp fragment files kept open in timeout mode. 0 reopens the files on every flush.")
+        ("__flushwatermark__", po::value<unsigned int>(), "Number of pending trace entries of a thread that triggers a flush before the timeout interval expires. 0 flushes on the interval only.")
+        ("__maxpendingentries__", po::value<unsigned int>(), "Maximum number of trace entries waiting to be flushed in timeout mode. Entries are dropped (and counted) beyond this limit. 0 for no limit.")
+        ("__spillentrythreshold__", po::value<unsigned int>(), "Number of pending trace entries that triggers a spill when timeout mode is off: the completed entries are written to temporary spill files by a background thread and copied to the trace file at exit. This is an entry count, not a memory limit; entries that are not completed yet stay in memory. 0 keeps all entries in memory.")
+        ("__backpressuretimeout__", po::value<unsigned int>(), "Time in milliseconds an application thread waits for a flush once the pending trace entry limit is reached, before entries are dropped.")
         ("__forcesinglegpu__", po::value<unsigned int>(), "Override profiler agents discovery to only expose a single GPU to the application. The argument is the device index (0-based).");
 
         // all options available from command line
@@ -381,6 +394,7 @@ bool ParseCmdLine(int argc, wchar_t* argv[], Config& configOut)
         configOut.bSym = unicodeOptionsMap.count("sym") > 0;
 
         configOut.bCollapseClGetEventInfo = unicodeOptionsMap.count("nocollapse") == 0;
+        configOut.bAPIStatisticsOnly = unicodeOptionsMap.count("apistatsonly") > 0;
 
 #ifdef _WIN32
         configOut.bTimeOut = unicodeOptionsMap.count("timeout") > 0;
@@ -401,6 +415,48 @@ bool ParseCmdLine(int argc, wchar_t* argv[], Config& configOut)
             configOut.uiTimeOutInterval = DEFAULT_TIMEOUT_INTERVAL;
         }
 
+        if (unicodeOptionsMap.count("flightrecorder") > 0)
+        {
+            wstring valueStr = unicodeOptionsMap["flightrecorder"];
+            string valueStrConverted;
+            StringUtils::WideStringToUtf8String(valueStr, valueStrConverted);
+            configOut.uiFlightRecorderEntries = boost::lexical_cast<unsigned int>(valueStrConverted.c_str());
+        }
+        else
+        {
+            configOut.uiFlightRecorderEntries = 0;
+        }
+
+        if (unicodeOptionsMap.count("flightrecorderseconds") > 0)
+        {
+            wstring valueStr = unicodeOptionsMap["flightrecorderseconds"];
+            string valueStrConverted;
+            StringUtils::WideStringToUtf8String(valueStr, valueStrConverted);
+            configOut.uiFlightRecorderSeconds = boost::lexical_cast<unsigned int>(valueStrConverted.c_str());
+        }
+        else
+        {
+            configOut.uiFlightRecorderSeconds = 0;
+        }
+
+        if (unicodeOptionsMap.count("flightrecorderlatency") > 0)
+        {
+            wstring valueStr = unicodeOptionsMap["flightrecorderlatency"];
+            string valueStrConverted;
+            StringUtils::WideStringToUtf8String(valueStr, valueStrConverted);
+            configOut.uiFlightRecorderLatencyTrigger = boost::lexical_cast<unsigned int>(valueStrConverted.c_str());
+        }
+        else
+        {
+            configOut.uiFlightRecorderLatencyTrigger = 0;
+        }
+
+        if (configOut.uiFlightRecorderEntries > 0 || configOut.uiFlightRecorderSeconds > 0)
+        {
+            // the windows are maintained by the timer thread
+            configOut.bTimeOut = true;
+        }
+
 
         if (unicodeOptionsMap.count("startdelay") > 0)
         {
@@ -792,6 +848,74 @@ bool ParseCmdLine(int argc, wchar_t* argv[], Config& configOut)
 
         configOut.bNoHSATransferTime = unicodeOptionsMap.count("__nohsatransfertime__") > 0;
 
+        configOut.bTSCTimer = unicodeOptionsMap.count("__tsctimer__") > 0;
+
+        configOut.bCompressOutput = unicodeOptionsMap.count("__compress__") > 0;
+
+        configOut.bOfflineSymbols = unicodeOptionsMap.count("__offlinesymbols__") > 0;
+
+        configOut.bNoThreadTraceBuffer = unicodeOptionsMap.count("__nothreadtracebuffer__") > 0;
+
+        if (unicodeOptionsMap.count("__fragmentbuffersize__") > 0)
+        {
+            wstring valueStr = unicodeOptionsMap["__fragmentbuffersize__"];
+            string valueStrConverted;
+            StringUtils::WideStringToUtf8String(valueStr, valueStrConverted);
+            configOut.uiFragmentBufferSize = boost::lexical_cast<unsigned int>(valueStrConverted.c_str());
+        }
+        else
+        {
+            configOut.uiFragmentBufferSize = DEFAULT_FRAGMENT_BUFFER_SIZE;
+        }
+
+        if (unicodeOptionsMap.count("__flushwatermark__") > 0)
+        {
+            wstring valueStr = unicodeOptionsMap["__flushwatermark__"];
+            string valueStrConverted;
+            StringUtils::WideStringToUtf8String(valueStr, valueStrConverted);
+            configOut.uiFlushWatermark = boost::lexical_cast<unsigned int>(valueStrConverted.c_str());
+        }
+        else
+        {
+            configOut.uiFlushWatermark = DEFAULT_FLUSH_WATERMARK;
+        }
+
+        if (unicodeOptionsMap.count("__maxpendingentries__") > 0)
+        {
+            wstring valueStr = unicodeOptionsMap["__maxpendingentries__"];
+            string valueStrConverted;
+            StringUtils::WideStringToUtf8String(valueStr, valueStrConverted);
+            configOut.uiMaxPendingTraceEntries = boost::lexical_cast<unsigned int>(valueStrConverted.c_str());
+        }
+        else
+        {
+            configOut.uiMaxPendingTraceEntries = DEFAULT_MAX_PENDING_TRACE_ENTRIES;
+        }
+
+        if (unicodeOptionsMap.count("__spillentrythreshold__") > 0)
+        {
+            wstring valueStr = unicodeOptionsMap["__spillentrythreshold__"];
+            string valueStrConverted;
+            StringUtils::WideStringToUtf8String(valueStr, valueStrConverted);
+            configOut.uiSpillEntryThreshold = boost::lexical_cast<unsigned int>(valueStrConverted.c_str());
+        }
+        else
+        {
+            configOut.uiSpillEntryThreshold = DEFAULT_SPILL_ENTRY_THRESHOLD;
+        }
+
+        if (unicodeOptionsMap.count("__backpressuretimeout__") > 0)
+        {
+            wstring valueStr = unicodeOptionsMap["__backpressuretimeout__"];
+            string valueStrConverted;
+            StringUtils::WideStringToUtf8String(valueStr, valueStrConverted);
+            configOut.uiBackpressureTimeout = boost::lexical_cast<unsigned int>(valueStrConverted.c_str());
+        }
+        else
+        {
+            configOut.uiBackpressureTimeout = DEFAULT_BACKPRESSURE_TIMEOUT;
+        }
+
         if (configOut.bForceSingleGPU)
         {
             wstring valueStr = unicodeOptionsMap["__forcesinglegpu__"];